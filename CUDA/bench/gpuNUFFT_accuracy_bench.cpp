@@ -0,0 +1,408 @@
+/**
+ * \file gpuNUFFT_accuracy_bench.cpp
+ * \brief Accuracy of the host gridding operator against the exact NUDFT and
+ * runtime of both for small problems.
+ *
+ * For every combination of kernel width, oversampling factor and kernel lookup
+ * table size (relative to the default size) the relative error of the forward
+ * and adjoint gridding operation with respect to performHostNUDFTForward and
+ * performHostNUDFTAdj is reported. The second part compares the creation and
+ * runtime of the gridding operator and the HostNUDFTOperator for sample counts
+ * from 16 to 65536, i.e. shows up to which sample count the direct evaluation
+ * is faster (see HOST_NUDFT_CROSSOVER_SAMPLES).
+ * With --interp linear the compact table of calculateKernelSizeLinInt is
+ * interpolated linearly instead of the nearest neighbor lookup, LUT factors
+ * then refer to the compact default size.
+ *
+ * Writes one JSON document to stdout (or the file given by --output).
+ *
+ * Usage: gpuNUFFT_accuracy_bench [--dims 2|3] [--size N] [--samples M]
+ *                                [--kw KW[,KW...]] [--osf OSF[,OSF...]]
+ *                                [--lut F[,F...]] [--kernel kb|es]
+ *                                [--interp nn|linear]
+ *                                [--reps R] [--threads T] [--output FILE]
+ */
+#include "gpuNUFFT_operator_factory.hpp"
+#include "host_nudft.hpp"
+#include "host_parallel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct AccuracyConfig
+{
+  int dims;
+  IndType size;
+  IndType samples;
+  std::vector<double> kernelWidths;
+  std::vector<double> osfs;
+  std::vector<double> lutFactors;
+  gpuNUFFT::KernelType kernelType;
+  bool linearInterpolation;
+  int reps;
+};
+
+double now()
+{
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::vector<double> parseList(const char *value)
+{
+  std::vector<double> list;
+  std::string s = value;
+  size_t begin = 0;
+  while (begin <= s.size())
+  {
+    size_t end = s.find(',', begin);
+    if (end == std::string::npos)
+      end = s.size();
+    if (end > begin)
+      list.push_back(atof(s.substr(begin, end - begin).c_str()));
+    begin = end + 1;
+  }
+  return list;
+}
+
+/** \brief Uniformly distributed sample coordinates in [-0.5,0.5), structure
+ * of arrays layout */
+std::vector<DType> createTrajectory(IndType count, int dims)
+{
+  std::vector<DType> k(count * dims);
+  unsigned seed = 42;
+  for (IndType i = 0; i < k.size(); i++)
+  {
+    seed = seed * 1103515245u + 12345u;
+    k[i] = (DType)((seed >> 8) % 1000000) / (DType)1000000.0 - (DType)0.5;
+  }
+  return k;
+}
+
+std::vector<DType2> createData(IndType count)
+{
+  std::vector<DType2> data(count);
+  for (IndType i = 0; i < count; i++)
+  {
+    data[i].x = (DType)cos(0.37 * i);
+    data[i].y = (DType)sin(0.11 * i);
+  }
+  return data;
+}
+
+double relativeError(const CufftType *a, const CufftType *b, IndType count)
+{
+  double diff = 0.0;
+  double norm = 0.0;
+  for (IndType i = 0; i < count; i++)
+  {
+    double dx = a[i].x - b[i].x;
+    double dy = a[i].y - b[i].y;
+    diff += dx * dx + dy * dy;
+    norm += (double)b[i].x * b[i].x + (double)b[i].y * b[i].y;
+  }
+  return std::sqrt(diff / norm);
+}
+
+gpuNUFFT::Dimensions imageDims(const AccuracyConfig &config)
+{
+  return gpuNUFFT::Dimensions(config.size, config.size,
+                              config.dims == 3 ? config.size : 0);
+}
+
+void runAccuracy(FILE *out, const AccuracyConfig &config)
+{
+  gpuNUFFT::Dimensions imgDims = imageDims(config);
+  IndType imgCnt = imgDims.count();
+  IndType coordCnt = config.samples;
+
+  std::vector<DType> coords = createTrajectory(coordCnt, config.dims);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  std::vector<DType2> img = createData(imgCnt);
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  std::vector<DType2> data = createData(coordCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+
+  std::vector<CufftType> forwardRef(coordCnt);
+  gpuNUFFT::performHostNUDFTForward(&img[0], &coords[0], coordCnt, 1, imgDims,
+                                    &forwardRef[0]);
+  std::vector<CufftType> adjointRef(imgCnt);
+  gpuNUFFT::performHostNUDFTAdj(&data[0], &coords[0], coordCnt, 1, imgDims,
+                                &adjointRef[0]);
+
+  fprintf(out, "  \"accuracy\": [\n");
+  bool first = true;
+  for (size_t w = 0; w < config.kernelWidths.size(); w++)
+    for (size_t o = 0; o < config.osfs.size(); o++)
+      for (size_t l = 0; l < config.lutFactors.size(); l++)
+      {
+        IndType kernelWidth = (IndType)config.kernelWidths[w];
+        DType osf = (DType)config.osfs[o];
+        IndType defaultSize =
+            config.linearInterpolation
+                ? (IndType)calculateKernelSizeLinInt(osf, (DType)kernelWidth)
+                : (IndType)calculateGrid3KernelSize(osf, (DType)kernelWidth);
+        IndType lutSize = std::max<IndType>(
+            2, (IndType)(config.lutFactors[l] * defaultSize + 0.5));
+
+        gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+        factory.setUseHostBackend(true);
+        factory.setKernelType(config.kernelType);
+        factory.setUseLinearKernelInterpolation(config.linearInterpolation);
+        factory.setKernelLookupTableSize(lutSize);
+        gpuNUFFT::GpuNUFFTOperator *op = factory.createGpuNUFFTOperator(
+            kSpaceTraj, kernelWidth, 8, osf, imgDims);
+
+        gpuNUFFT::Array<CufftType> forward =
+            op->performForwardGpuNUFFT(imgArray);
+        gpuNUFFT::Array<CufftType> adjoint = op->performGpuNUFFTAdj(dataArray);
+
+        fprintf(out,
+                "%s    { \"kernel_width\": %u, \"osf\": %g, "
+                "\"lut_size\": %u, \"default_lut_size\": %u, "
+                "\"grid_size\": %u, \"forward_rel_error\": %.6e, "
+                "\"adjoint_rel_error\": %.6e }",
+                first ? "" : ",\n", kernelWidth, osf, lutSize, defaultSize,
+                op->getGridDims().width,
+                relativeError(forward.data, &forwardRef[0], coordCnt),
+                relativeError(adjoint.data, &adjointRef[0], imgCnt));
+        first = false;
+
+        free(forward.data);
+        free(adjoint.data);
+        delete op;
+      }
+  fprintf(out, "\n  ],\n");
+}
+
+double timeOperator(gpuNUFFT::GpuNUFFTOperator *op,
+                    gpuNUFFT::Array<DType2> &imgArray,
+                    gpuNUFFT::Array<DType2> &dataArray,
+                    gpuNUFFT::Array<CufftType> &imgOut,
+                    gpuNUFFT::Array<CufftType> &dataOut, int reps,
+                    double &forwardTime)
+{
+  double adjointTime = 1e30;
+  forwardTime = 1e30;
+  for (int rep = 0; rep < reps; rep++)
+  {
+    double t0 = now();
+    op->performGpuNUFFTAdj(dataArray, imgOut);
+    double t1 = now();
+    op->performForwardGpuNUFFT(imgArray, dataOut);
+    double t2 = now();
+    adjointTime = std::min(adjointTime, t1 - t0);
+    forwardTime = std::min(forwardTime, t2 - t1);
+  }
+  return adjointTime;
+}
+
+void runTiming(FILE *out, const AccuracyConfig &config)
+{
+  gpuNUFFT::Dimensions imgDims = imageDims(config);
+  IndType imgCnt = imgDims.count();
+  IndType kernelWidth = (IndType)config.kernelWidths.back();
+  DType osf = (DType)config.osfs.back();
+
+  fprintf(out, "  \"timing\": [\n");
+  bool first = true;
+  for (IndType coordCnt = 16; coordCnt <= 65536; coordCnt *= 4)
+  {
+    std::vector<DType> coords = createTrajectory(coordCnt, config.dims);
+    gpuNUFFT::Array<DType> kSpaceTraj;
+    kSpaceTraj.data = &coords[0];
+    kSpaceTraj.dim.length = coordCnt;
+
+    std::vector<DType2> img = createData(imgCnt);
+    gpuNUFFT::Array<DType2> imgArray;
+    imgArray.data = &img[0];
+    imgArray.dim = imgDims;
+    std::vector<DType2> data = createData(coordCnt);
+    gpuNUFFT::Array<DType2> dataArray;
+    dataArray.data = &data[0];
+    dataArray.dim.length = coordCnt;
+
+    std::vector<CufftType> imgOutData(imgCnt);
+    gpuNUFFT::Array<CufftType> imgOut;
+    imgOut.data = &imgOutData[0];
+    imgOut.dim = imgDims;
+    std::vector<CufftType> dataOutData(coordCnt);
+    gpuNUFFT::Array<CufftType> dataOut;
+    dataOut.data = &dataOutData[0];
+    dataOut.dim.length = coordCnt;
+
+    gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+    factory.setUseHostBackend(true);
+    factory.setKernelType(config.kernelType);
+    factory.setUseLinearKernelInterpolation(config.linearInterpolation);
+    double t0 = now();
+    gpuNUFFT::GpuNUFFTOperator *griddingOp = factory.createGpuNUFFTOperator(
+        kSpaceTraj, kernelWidth, 8, osf, imgDims);
+    double griddingCreate = now() - t0;
+    factory.setUseHostNUDFT(true);
+    t0 = now();
+    gpuNUFFT::GpuNUFFTOperator *nudftOp = factory.createGpuNUFFTOperator(
+        kSpaceTraj, kernelWidth, 8, osf, imgDims);
+    double nudftCreate = now() - t0;
+
+    double griddingForward, nudftForward;
+    double griddingAdjoint = timeOperator(griddingOp, imgArray, dataArray,
+                                          imgOut, dataOut, config.reps,
+                                          griddingForward);
+    double nudftAdjoint = timeOperator(nudftOp, imgArray, dataArray, imgOut,
+                                       dataOut, config.reps, nudftForward);
+
+    fprintf(out,
+            "%s    { \"samples\": %u, \"gridding_create_s\": %.9f, "
+            "\"gridding_adjoint_s\": %.9f, \"gridding_forward_s\": %.9f, "
+            "\"nudft_create_s\": %.9f, \"nudft_adjoint_s\": %.9f, "
+            "\"nudft_forward_s\": %.9f }",
+            first ? "" : ",\n", coordCnt, griddingCreate, griddingAdjoint,
+            griddingForward, nudftCreate, nudftAdjoint, nudftForward);
+    first = false;
+
+    delete griddingOp;
+    delete nudftOp;
+  }
+  fprintf(out, "\n  ]\n");
+}
+
+void usage()
+{
+  fprintf(stderr,
+          "usage: gpuNUFFT_accuracy_bench [--dims 2|3] [--size N] "
+          "[--samples M] [--kw KW[,KW...]] [--osf OSF[,OSF...]] "
+          "[--lut F[,F...]] [--kernel kb|es] [--interp nn|linear] "
+          "[--reps R] [--threads T] [--output FILE]\n");
+}
+}
+
+int main(int argc, char *argv[])
+{
+  AccuracyConfig config;
+  config.dims = 2;
+  config.size = 0;
+  config.samples = 0;
+  config.kernelWidths = parseList("3,4,5,6,7");
+  config.osfs = parseList("1.25,1.5,2");
+  config.lutFactors = parseList("0.25,0.5,1,2");
+  config.kernelType = gpuNUFFT::KAISER_BESSEL;
+  config.linearInterpolation = false;
+  config.reps = 3;
+  const char *outputFile = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h")
+    {
+      usage();
+      return 0;
+    }
+    if (i + 1 >= argc)
+    {
+      usage();
+      return 1;
+    }
+    const char *value = argv[++i];
+    if (arg == "--dims")
+      config.dims = atoi(value);
+    else if (arg == "--size")
+      config.size = (IndType)atoi(value);
+    else if (arg == "--samples")
+      config.samples = (IndType)atoi(value);
+    else if (arg == "--kw")
+      config.kernelWidths = parseList(value);
+    else if (arg == "--osf")
+      config.osfs = parseList(value);
+    else if (arg == "--lut")
+      config.lutFactors = parseList(value);
+    else if (arg == "--kernel" && std::string(value) == "kb")
+      config.kernelType = gpuNUFFT::KAISER_BESSEL;
+    else if (arg == "--kernel" && std::string(value) == "es")
+      config.kernelType = gpuNUFFT::EXPONENTIAL_OF_SEMICIRCLE;
+    else if (arg == "--interp" && std::string(value) == "nn")
+      config.linearInterpolation = false;
+    else if (arg == "--interp" && std::string(value) == "linear")
+      config.linearInterpolation = true;
+    else if (arg == "--reps")
+      config.reps = std::max(1, atoi(value));
+    else if (arg == "--threads")
+      gpuNUFFT::setHostThreadCount(atoi(value));
+    else if (arg == "--output")
+      outputFile = value;
+    else
+    {
+      usage();
+      return 1;
+    }
+  }
+
+  if ((config.dims != 2 && config.dims != 3) || config.kernelWidths.empty() ||
+      config.osfs.empty() || config.lutFactors.empty())
+  {
+    usage();
+    return 1;
+  }
+  if (config.size == 0)
+    config.size = config.dims == 2 ? 64 : 16;
+  if (config.samples == 0)
+    config.samples = 4096;
+
+  FILE *out = stdout;
+  if (outputFile != NULL)
+  {
+    out = fopen(outputFile, "w");
+    if (out == NULL)
+    {
+      fprintf(stderr, "cannot open %s\n", outputFile);
+      return 1;
+    }
+  }
+
+  fprintf(out, "{\n");
+  fprintf(out, "  \"benchmark\": \"gpuNUFFT_accuracy_bench\",\n");
+  fprintf(out, "  \"precision\": \"%s\",\n",
+          sizeof(DType) == sizeof(double) ? "double" : "float");
+  fprintf(out, "  \"threads\": %d,\n", gpuNUFFT::getHostThreadCount());
+  fprintf(out, "  \"kernel\": \"%s\",\n",
+          config.kernelType == gpuNUFFT::KAISER_BESSEL ? "kaiser_bessel"
+                                                       : "exp_semicircle");
+  fprintf(out, "  \"interpolation\": \"%s\",\n",
+          config.linearInterpolation ? "linear" : "nearest_neighbor");
+  fprintf(out, "  \"dims\": %d,\n", config.dims);
+  fprintf(out, "  \"image_size\": %u,\n", config.size);
+  fprintf(out, "  \"samples\": %u,\n", config.samples);
+
+  int result = 0;
+  try
+  {
+    runAccuracy(out, config);
+    runTiming(out, config);
+  }
+  catch (std::exception &e)
+  {
+    fprintf(stderr, "gpuNUFFT_accuracy_bench: %s\n", e.what());
+    result = 1;
+  }
+
+  fprintf(out, "}\n");
+  if (out != stdout)
+    fclose(out);
+  return result;
+}
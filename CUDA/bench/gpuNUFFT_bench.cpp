@@ -0,0 +1,1738 @@
+/**
+ * \file gpuNUFFT_bench.cpp
+ * \brief Benchmark of the precomputation and host gridding stages on
+ * synthetic trajectories.
+ *
+ * Writes one JSON document with the timings of each stage to stdout (or the
+ * file given by --output). Every stage is repeated --reps times and the fastest
+ * run is reported.
+ *
+ * Usage: gpuNUFFT_bench [--traj radial|spiral|stack|random] [--dims 2|3]
+ *                       [--size N] [--samples M] [--coils C] [--kw KW]
+ *                       [--osf OSF] [--sw SW] [--reps R] [--threads T]
+ *                       [--output FILE]
+ *
+ * Without --traj and --dims all trajectories are run in 2-d and 3-d.
+ *
+ * The section "kernel_cache" reports the construction time of a 3-d texture
+ * operator with and without its lookup table in the KernelLookupTableCache and
+ * the memory shared instead of copied.
+ *
+ * The section "pruned_fft" compares the full 3-d host FFT of the oversampled
+ * grid with the pruned transforms of the forward (zero padded input) and
+ * adjoint (cropped output) gridding.
+ *
+ * The section "fused_image" compares the separate adjoint passes after the
+ * FFT (two FFT shifts, crop, scaling, deapodization, sensitivities) with the
+ * single pass of performHostFusedCrop, each with its time and bandwidth.
+ *
+ * The section "coil_compression" grids 32 synthetic coils of a 2-d random
+ * trajectory with the sensitivity weighted adjoint and reports, per amount of
+ * virtual coils K of a HostCoilCompression computed from the k-space center,
+ * the adjoint time including the compression and the relative error against
+ * the adjoint of all physical coils.
+ *
+ * The section "stack_of_stars" compares the 3-d host operator of a stack of
+ * radial spokes (--coils coils, default 32^3 image) with the
+ * HostStackOfStarsOperator of the shared 2-d trajectory, i.e. factory, adjoint
+ * and forward times and the relative difference of the adjoint images.
+ *
+ * The section "roi_adjoint" compares the sensitivity combined adjoint of a
+ * 3-d random trajectory (--coils coils, default 48^3 image) with the adjoint
+ * of centered boxes (regions of interest) of 1/2, 1/4 and 1/8 of the image
+ * width, each with the relative difference to the box of the full image.
+ *
+ * The section "sample_subset" compares the adjoint of all samples of a 2-d
+ * random trajectory (default 128^2 image) with the adjoint of the subsets of
+ * every 2nd, 4th, 8th and 16th sample on the same operator.
+ *
+ * The section "trajectory_gradient" compares the forward operation of a 2-d
+ * random trajectory (default 128^2 image) with the forward operation yielding
+ * the derivatives with respect to kx and ky as well, and with the five forward
+ * operations of central differences (without the construction of the shifted
+ * operators).
+ *
+ * The section "gather_adjoint" compares the adjoint gridding (convolution
+ * only) of a 3-d random trajectory (default 32^3 image) by the plane phased
+ * scatter and by the tile gather of HostGpuNUFFTOperator::setGatherConvolution
+ * at the same thread count, 1 and --threads, with the relative difference of
+ * the grids and whether the grids are bit identical to those of 1 thread.
+ * The tile lists of the gather are built by the first operation and excluded
+ * from the timing, like the sector data of the scatter.
+ *
+ * The section "sharded_adjoint" reports the adjoint gridding (convolution
+ * only) of a 3-d random trajectory (default 48^3 image) by 1, 2 and 4
+ * processes of HostGpuNUFFTOperator::setShardProcessCount, with the relative
+ * difference to the grid of 1 process.
+ *
+ * The section "partitioned_operator" compares the adjoint and forward
+ * operation of a 3-d random trajectory (default 32^3 image) with those of a
+ * HostPartitionedOperator of 2 and 4 slabs, with the halo and the relative
+ * differences.
+ */
+#include "gpuNUFFT_operator_factory.hpp"
+#include "host_gpuNUFFT_operator.hpp"
+#include "host_gpuNUFFT_kernels.hpp"
+#include "host_fft.hpp"
+#include "host_parallel.hpp"
+#include "host_coil_compression.hpp"
+#include "host_stack_operator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+struct BenchConfig
+{
+  std::string traj;
+  int dims;
+  IndType size;
+  IndType samples;
+  IndType coils;
+  IndType kernelWidth;
+  DType osf;
+  IndType sectorWidth;
+  int reps;
+};
+
+struct StageResult
+{
+  std::string name;
+  double seconds;
+  double samples;
+  double bytes;
+};
+
+/** \brief Exposes the precomputation stages of the factory */
+class BenchOperatorFactory : public gpuNUFFT::GpuNUFFTOperatorFactory
+{
+ public:
+  BenchOperatorFactory() : GpuNUFFTOperatorFactory(false, false, false)
+  {
+    setUseHostBackend(true);
+  }
+
+  using GpuNUFFTOperatorFactory::createNewGpuNUFFTOperator;
+  using GpuNUFFTOperatorFactory::assignSectors;
+  using GpuNUFFTOperatorFactory::sortVector;
+  using GpuNUFFTOperatorFactory::initCoordsData;
+  using GpuNUFFTOperatorFactory::initDataIndices;
+  using GpuNUFFTOperatorFactory::computeSectorDataCount;
+  using GpuNUFFTOperatorFactory::computeSectorCenters;
+  using GpuNUFFTOperatorFactory::computeSectorCenters2D;
+  using GpuNUFFTOperatorFactory::computeDeapodizationFunction;
+};
+
+double now()
+{
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t peakResidentBytes()
+{
+#ifndef WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef __APPLE__
+  return (size_t)usage.ru_maxrss;
+#else
+  return (size_t)usage.ru_maxrss * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+// readout of length readout along dir through (0,0,kz), coordinates in
+// [-0.5,0.5)
+void addSpoke(std::vector<DType> &k, const double *dir, int dims,
+              IndType readout, double kz)
+{
+  for (IndType i = 0; i < readout; i++)
+  {
+    double r = ((double)i - readout / 2.0) / readout;
+    k.push_back((DType)(r * dir[0]));
+    k.push_back((DType)(r * dir[1]));
+    if (dims == 3)
+      k.push_back((DType)(r * dir[2] + kz));
+  }
+}
+
+void addSpiral(std::vector<DType> &k, IndType interleaves, IndType length,
+               double turns, int dims, double kz)
+{
+  for (IndType l = 0; l < interleaves; l++)
+    for (IndType i = 0; i < length; i++)
+    {
+      double t = (double)i / length;
+      double phi = 2.0 * M_PI * (turns * t + (double)l / interleaves);
+      k.push_back((DType)(0.5 * t * cos(phi)));
+      k.push_back((DType)(0.5 * t * sin(phi)));
+      if (dims == 3)
+        k.push_back((DType)kz);
+    }
+}
+
+/** \brief Interleaved (x,y[,z]) coordinates of the synthetic trajectory,
+ * approximately config.samples samples */
+std::vector<DType> createTrajectory(const BenchConfig &config)
+{
+  std::vector<DType> k;
+  int dims = config.dims;
+  IndType n = config.size;
+  IndType readout = 2 * n;
+  IndType partitions = dims == 3 ? n : 1;
+
+  if (config.traj == "radial")
+  {
+    IndType spokes = std::max<IndType>(1, config.samples / readout);
+    for (IndType s = 0; s < spokes; s++)
+    {
+      double dir[3] = { 0.0, 0.0, 0.0 };
+      if (dims == 2)
+      {
+        double phi = M_PI * s / spokes;
+        dir[0] = cos(phi);
+        dir[1] = sin(phi);
+      }
+      else
+      {
+        // 3-d golden means kooshball
+        double kz = 2.0 * fmod(s * 0.4656, 1.0) - 1.0;
+        double phi = 2.0 * M_PI * fmod(s * 0.6823, 1.0);
+        double rxy = sqrt(std::max(0.0, 1.0 - kz * kz));
+        dir[0] = rxy * cos(phi);
+        dir[1] = rxy * sin(phi);
+        dir[2] = kz;
+      }
+      addSpoke(k, dir, dims, readout, 0.0);
+    }
+  }
+  else if (config.traj == "stack")
+  {
+    if (dims != 3)
+      throw std::invalid_argument("stack-of-stars requires --dims 3");
+    IndType spokes =
+        std::max<IndType>(1, config.samples / (readout * partitions));
+    for (IndType p = 0; p < partitions; p++)
+    {
+      double kz = ((double)p - partitions / 2.0) / partitions;
+      for (IndType s = 0; s < spokes; s++)
+      {
+        double phi = M_PI * s / spokes;
+        double dir[3] = { cos(phi), sin(phi), 0.0 };
+        addSpoke(k, dir, dims, readout, kz);
+      }
+    }
+  }
+  else if (config.traj == "spiral")
+  {
+    // stack of spirals in 3-d
+    IndType interleaves = 16;
+    IndType length =
+        std::max<IndType>(1, config.samples / (interleaves * partitions));
+    double turns = (double)n / (2.0 * interleaves);
+    for (IndType p = 0; p < partitions; p++)
+      addSpiral(k, interleaves, length, turns, dims,
+                ((double)p - partitions / 2.0) / partitions);
+  }
+  else if (config.traj == "random")
+  {
+    unsigned seed = 42;
+    k.resize(config.samples * dims);
+    for (IndType i = 0; i < k.size(); i++)
+    {
+      seed = seed * 1103515245u + 12345u;
+      k[i] = (DType)((seed >> 8) % 1000000) / (DType)1000000.0 - (DType)0.5;
+    }
+  }
+  else
+    throw std::invalid_argument("unknown trajectory " + config.traj);
+
+  return k;
+}
+
+/** \brief Convert interleaved coordinates into the structure of arrays layout
+ * expected by the factory */
+std::vector<DType> toPlanar(const std::vector<DType> &k, int dims)
+{
+  IndType count = k.size() / dims;
+  std::vector<DType> planar(k.size());
+  for (IndType i = 0; i < count; i++)
+    for (int d = 0; d < dims; d++)
+      planar[i + d * count] = k[i * dims + d];
+  return planar;
+}
+
+void addStage(std::vector<StageResult> &stages, const char *name,
+              double seconds, double samples, double bytes)
+{
+  StageResult s;
+  s.name = name;
+  s.seconds = seconds;
+  s.samples = samples;
+  s.bytes = bytes;
+  stages.push_back(s);
+}
+
+void runFactoryStages(const BenchConfig &config, gpuNUFFT::Array<DType> &traj,
+                      gpuNUFFT::Dimensions imgDims,
+                      std::vector<StageResult> &stages)
+{
+  BenchOperatorFactory factory;
+  IndType coordCnt = traj.count();
+  double coordBytes = (double)coordCnt * config.dims * sizeof(DType);
+  double tAssign = 1e30, tSort = 1e30, tPermute = 1e30, tCount = 1e30;
+  double tCenters = 1e30, tDeapo = 1e30, tTotal = 1e30;
+  IndType sectorCnt = 0;
+
+  for (int rep = 0; rep < config.reps; rep++)
+  {
+    gpuNUFFT::GpuNUFFTOperator *op = factory.createNewGpuNUFFTOperator(
+        config.kernelWidth, config.sectorWidth, config.osf, imgDims);
+
+    double t0 = now();
+    gpuNUFFT::Array<IndType> assignedSectors =
+        factory.assignSectors(op, traj);
+    double t1 = now();
+    std::vector<gpuNUFFT::IndPair> sorted =
+        factory.sortVector<IndType>(assignedSectors);
+    double t2 = now();
+
+    gpuNUFFT::Array<DType> trajSorted =
+        factory.initCoordsData(op, coordCnt);
+    gpuNUFFT::Array<IndType> dataIndices =
+        factory.initDataIndices(op, coordCnt);
+    double t3 = now();
+    for (IndType i = 0; i < coordCnt; i++)
+    {
+      for (int d = 0; d < config.dims; d++)
+        trajSorted.data[i + d * coordCnt] =
+            traj.data[sorted[i].first + d * coordCnt];
+      dataIndices.data[i] = sorted[i].first;
+      assignedSectors.data[i] = sorted[i].second;
+    }
+    double t4 = now();
+
+    gpuNUFFT::Array<IndType> sectorDataCount =
+        factory.computeSectorDataCount(op, assignedSectors);
+    op->setSectorDataCount(sectorDataCount);
+    double t5 = now();
+    gpuNUFFT::Array<IndType> sectorCenters =
+        config.dims == 3 ? factory.computeSectorCenters(op)
+                         : factory.computeSectorCenters2D(op);
+    op->setSectorCenters(sectorCenters);
+    double t6 = now();
+    gpuNUFFT::Array<DType> deapo = factory.computeDeapodizationFunction(
+        config.kernelWidth, config.osf, imgDims);
+    double t7 = now();
+
+    tAssign = std::min(tAssign, t1 - t0);
+    tSort = std::min(tSort, t2 - t1);
+    tPermute = std::min(tPermute, t4 - t3);
+    tCount = std::min(tCount, t5 - t4);
+    tCenters = std::min(tCenters, t6 - t5);
+    tDeapo = std::min(tDeapo, t7 - t6);
+    sectorCnt = sectorCenters.count();
+
+    op->setKSpaceTraj(trajSorted);
+    op->setDataIndices(dataIndices);
+    op->setDeapodizationFunction(deapo);
+    free(assignedSectors.data);
+    delete op;
+
+    double t8 = now();
+    gpuNUFFT::GpuNUFFTOperator *fullOp =
+        factory.createGpuNUFFTOperator(traj, config.kernelWidth,
+                                       config.sectorWidth, config.osf,
+                                       imgDims);
+    tTotal = std::min(tTotal, now() - t8);
+    delete fullOp;
+  }
+
+  double n = (double)coordCnt;
+  addStage(stages, "factory_assign", tAssign, n,
+           coordBytes + n * sizeof(IndType));
+  addStage(stages, "factory_sort", tSort, n,
+           n * (sizeof(IndType) + sizeof(gpuNUFFT::IndPair)));
+  addStage(stages, "factory_permute", tPermute, n,
+           2.0 * coordBytes + n * (sizeof(gpuNUFFT::IndPair) +
+                                   2.0 * sizeof(IndType)));
+  addStage(stages, "factory_count", tCount, n,
+           n * sizeof(IndType) + (double)sectorCnt * sizeof(IndType));
+  addStage(stages, "factory_centers", tCenters, n,
+           (double)sectorCnt * sizeof(IndType));
+  addStage(stages, "factory_deapo", tDeapo, n,
+           (double)imgDims.count() * sizeof(DType));
+  addStage(stages, "factory_total", tTotal, n, coordBytes);
+}
+
+void runGriddingStages(const BenchConfig &config,
+                       gpuNUFFT::Array<DType> &traj,
+                       gpuNUFFT::Dimensions imgDims,
+                       std::vector<StageResult> &stages)
+{
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *op =
+      static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(
+          factory.createGpuNUFFTOperator(traj, config.kernelWidth,
+                                         config.sectorWidth, config.osf,
+                                         imgDims));
+
+  IndType coordCnt = traj.count();
+  IndType imgCnt = imgDims.count();
+  IndType gridCnt = op->getGridDims().count();
+  IndType coils = config.coils;
+
+  std::vector<DType2> kspace(coordCnt * coils);
+  for (IndType i = 0; i < kspace.size(); i++)
+  {
+    kspace[i].x = (DType)cos(0.37 * i);
+    kspace[i].y = (DType)sin(0.11 * i);
+  }
+  gpuNUFFT::Array<DType2> kspaceArray;
+  kspaceArray.data = &kspace[0];
+  kspaceArray.dim.length = coordCnt;
+  kspaceArray.dim.channels = coils;
+
+  std::vector<CufftType> grid(gridCnt * coils);
+  gpuNUFFT::Array<CufftType> gridArray;
+  gridArray.data = &grid[0];
+  gridArray.dim = op->getGridDims();
+  gridArray.dim.channels = coils;
+
+  std::vector<CufftType> img(imgCnt * coils);
+  gpuNUFFT::Array<CufftType> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  imgArray.dim.channels = coils;
+
+  std::vector<CufftType> kspaceOut(coordCnt * coils);
+  gpuNUFFT::Array<CufftType> kspaceOutArray;
+  kspaceOutArray.data = &kspaceOut[0];
+  kspaceOutArray.dim = kspaceArray.dim;
+
+  gpuNUFFT::HostGpuNUFFTWorkspace *ws = op->createWorkspace((int)coils);
+
+  double tConv = 1e30, tFFT = 1e30, tAdj = 1e30, tForw = 1e30;
+  double tSelect = 1e30, tWrite = 1e30;
+  std::vector<DType2> sortedData(coordCnt * coils);
+  gpuNUFFT::Array<IndType> dataIndices = op->getDataIndices();
+
+  for (int rep = 0; rep < config.reps; rep++)
+  {
+    double t0 = now();
+    op->performGpuNUFFTAdj(kspaceArray, gridArray, *ws,
+                           gpuNUFFT::CONVOLUTION);
+    double t1 = now();
+    op->performGpuNUFFTAdj(kspaceArray, gridArray, *ws, gpuNUFFT::FFT);
+    double t2 = now();
+    op->performGpuNUFFTAdj(kspaceArray, imgArray, *ws);
+    double t3 = now();
+    gpuNUFFT::Array<DType2> imgIn;
+    imgIn.data = &img[0];
+    imgIn.dim = imgArray.dim;
+    op->performForwardGpuNUFFT(imgIn, kspaceOutArray, *ws);
+    double t4 = now();
+    selectOrderedHost(&kspace[0], dataIndices.data, &sortedData[0],
+                      (int)coordCnt, (int)coils);
+    double t5 = now();
+    writeOrderedHost(&sortedData[0], dataIndices.data, &kspaceOut[0],
+                     (int)coordCnt, (int)coils);
+    double t6 = now();
+
+    tConv = std::min(tConv, t1 - t0);
+    tFFT = std::min(tFFT, t2 - t1);
+    tAdj = std::min(tAdj, t3 - t2);
+    tForw = std::min(tForw, t4 - t3);
+    tSelect = std::min(tSelect, t5 - t4);
+    tWrite = std::min(tWrite, t6 - t5);
+  }
+
+  double n = (double)coordCnt * coils;
+  double sampleBytes =
+      n * sizeof(DType2) + (double)coordCnt * config.dims * sizeof(DType);
+  double gridBytes = (double)gridCnt * coils * sizeof(CufftType);
+  double imgBytes = (double)imgCnt * coils * sizeof(CufftType);
+  double permBytes = 2.0 * n * sizeof(DType2) + coordCnt * sizeof(IndType);
+
+  addStage(stages, "adjoint_convolution", tConv, n, sampleBytes + gridBytes);
+  // includes convolution, the FFT alone is the difference to the former
+  addStage(stages, "adjoint_convolution_fft", tFFT, n,
+           sampleBytes + 3.0 * gridBytes);
+  addStage(stages, "adjoint_total", tAdj, n,
+           sampleBytes + 4.0 * gridBytes + imgBytes);
+  addStage(stages, "forward_total", tForw, n,
+           sampleBytes + 4.0 * gridBytes + imgBytes);
+  addStage(stages, "permute_select_ordered", tSelect, n, permBytes);
+  addStage(stages, "permute_write_ordered", tWrite, n, permBytes);
+
+  delete ws;
+  delete op;
+}
+
+void writeRun(FILE *out, const BenchConfig &config, IndType samples,
+              const std::vector<StageResult> &stages, bool last)
+{
+  fprintf(out, "    {\n");
+  fprintf(out, "      \"trajectory\": \"%s\",\n", config.traj.c_str());
+  fprintf(out, "      \"dims\": %d,\n", config.dims);
+  fprintf(out, "      \"image_size\": %u,\n", config.size);
+  fprintf(out, "      \"samples\": %u,\n", samples);
+  fprintf(out, "      \"coils\": %u,\n", config.coils);
+  fprintf(out, "      \"kernel_width\": %u,\n", config.kernelWidth);
+  fprintf(out, "      \"osf\": %g,\n", config.osf);
+  fprintf(out, "      \"sector_width\": %u,\n", config.sectorWidth);
+  fprintf(out, "      \"peak_memory_bytes\": %lu,\n",
+          (unsigned long)peakResidentBytes());
+  fprintf(out, "      \"stages\": {\n");
+  for (size_t i = 0; i < stages.size(); i++)
+  {
+    const StageResult &s = stages[i];
+    double sec = s.seconds > 0.0 ? s.seconds : 1e-12;
+    fprintf(out,
+            "        \"%s\": { \"seconds\": %.9f, \"samples_per_s\": %.6e, "
+            "\"bytes_per_s\": %.6e }%s\n",
+            s.name.c_str(), s.seconds, s.samples / sec, s.bytes / sec,
+            i + 1 < stages.size() ? "," : "");
+  }
+  fprintf(out, "      }\n");
+  fprintf(out, "    }%s\n", last ? "" : ",");
+}
+
+void writeKernelCache(FILE *out, const BenchConfig &config)
+{
+  IndType size = config.size > 0 ? config.size : 32;
+  gpuNUFFT::Dimensions imgDims(size, size, size);
+  gpuNUFFT::KernelLookupTableCache::releaseUnused();
+
+  double tCold = 1e30, tWarm = 1e30;
+  gpuNUFFT::Array<DType> kern;
+  for (int rep = 0; rep < config.reps; rep++)
+  {
+    double t0 = now();
+    gpuNUFFT::TextureGpuNUFFTOperator *first =
+        new gpuNUFFT::TextureGpuNUFFTOperator(config.kernelWidth,
+                                              config.sectorWidth, config.osf,
+                                              imgDims,
+                                              gpuNUFFT::TEXTURE3D_LOOKUP);
+    double t1 = now();
+    gpuNUFFT::TextureGpuNUFFTOperator *second =
+        new gpuNUFFT::TextureGpuNUFFTOperator(config.kernelWidth,
+                                              config.sectorWidth, config.osf,
+                                              imgDims,
+                                              gpuNUFFT::TEXTURE3D_LOOKUP);
+    double t2 = now();
+    kern = second->getKernel();
+    delete first;
+    delete second;
+    gpuNUFFT::KernelLookupTableCache::releaseUnused();
+
+    tCold = std::min(tCold, t1 - t0);
+    tWarm = std::min(tWarm, t2 - t1);
+  }
+
+  fprintf(out, "  \"kernel_cache\": {\n");
+  fprintf(out, "    \"operator\": \"texture3d\",\n");
+  fprintf(out, "    \"lookup_table_size\": %u,\n", kern.dim.width);
+  fprintf(out, "    \"table_bytes\": %lu,\n",
+          (unsigned long)(kern.count() * sizeof(DType)));
+  fprintf(out, "    \"construction_cold_s\": %.9f,\n", tCold);
+  fprintf(out, "    \"construction_cached_s\": %.9f,\n", tWarm);
+  fprintf(out, "    \"saved_bytes_total\": %llu\n",
+          gpuNUFFT::KernelLookupTableCache::getStats().savedBytes);
+  fprintf(out, "  },\n");
+}
+
+void writePrunedFFT(FILE *out, const BenchConfig &config)
+{
+  IndType size = config.size > 0 ? config.size : 32;
+  gpuNUFFT::Dimensions imgDims(size, size, size);
+  gpuNUFFT::Dimensions gridDims = imgDims * config.osf;
+  gpuNUFFT::HostFFTPlan plan(gridDims);
+
+  // image region after padding and inverse shift, see
+  // computeHostShiftedImageOffset
+  IndType3 offset;
+  IndType off = (IndType)(size * (config.osf - 1.0f) / (DType)2);
+  offset.x = offset.y = offset.z =
+      (off + gridDims.width - gridDims.width / 2) % gridDims.width;
+  plan.setPruningRegion(offset, imgDims);
+
+  std::vector<CufftType> grid(gridDims.count());
+  const gpuNUFFT::HostFFTPruning modes[3] = {
+    gpuNUFFT::HOST_FFT_NO_PRUNING, gpuNUFFT::HOST_FFT_PRUNE_INPUT,
+    gpuNUFFT::HOST_FFT_PRUNE_OUTPUT
+  };
+  double t[3] = { 1e30, 1e30, 1e30 };
+  for (int rep = 0; rep < config.reps; rep++)
+    for (int m = 0; m < 3; m++)
+    {
+      std::fill(grid.begin(), grid.end(), CufftType());
+      double t0 = now();
+      plan.execute(&grid[0], 1, gpuNUFFT::HOST_FFT_FORWARD, modes[m]);
+      t[m] = std::min(t[m], now() - t0);
+    }
+
+  fprintf(out, "  \"pruned_fft\": {\n");
+  fprintf(out, "    \"grid\": [%u, %u, %u],\n", gridDims.width,
+          gridDims.height, gridDims.depth);
+  fprintf(out, "    \"full_s\": %.9f,\n", t[0]);
+  fprintf(out, "    \"pruned_input_s\": %.9f,\n", t[1]);
+  fprintf(out, "    \"pruned_output_s\": %.9f,\n", t[2]);
+  fprintf(out, "    \"speedup_input\": %.3f,\n", t[0] / t[1]);
+  fprintf(out, "    \"speedup_output\": %.3f\n", t[0] / t[2]);
+  fprintf(out, "  },\n");
+}
+
+void writeFusedImage(FILE *out, const BenchConfig &config)
+{
+  IndType size = config.size > 0 ? config.size : 32;
+  int coils = (int)config.coils;
+  gpuNUFFT::Dimensions imgDims(size, size, size);
+  gpuNUFFT::Dimensions gridDims = imgDims * config.osf;
+  IndType imgCnt = imgDims.count();
+  IndType gridCnt = gridDims.count();
+
+  gpuNUFFT::GpuNUFFTInfo gi_host;
+  memset(&gi_host, 0, sizeof(gi_host));
+  gi_host.osr = config.osf;
+  gi_host.n_coils_cc = coils;
+  gi_host.imgDims.x = gi_host.imgDims.y = gi_host.imgDims.z = size;
+  gi_host.im_width_dim = imgCnt;
+  gi_host.gridDims.x = gridDims.width;
+  gi_host.gridDims.y = gridDims.height;
+  gi_host.gridDims.z = gridDims.depth;
+  gi_host.gridDims_count = gridCnt;
+  if (!isHostFusedImagePassSupported(&gi_host))
+    return;
+
+  std::vector<CufftType> grid(gridCnt * coils);
+  std::vector<CufftType> img(imgCnt * coils);
+  std::vector<CufftType> sum(imgCnt);
+  std::vector<DType> deapo(imgCnt, (DType)1.0);
+  std::vector<DType2> sens(imgCnt * coils);
+  for (size_t i = 0; i < grid.size(); i++)
+  {
+    grid[i].x = (DType)(i % 7);
+    grid[i].y = (DType)(i % 5);
+  }
+  for (size_t i = 0; i < sens.size(); i++)
+  {
+    sens[i].x = (DType)1.0;
+    sens[i].y = (DType)0.0;
+  }
+
+  const char *names[] = { "fft_shift", "crop", "scaling", "deapodization",
+                          "sensitivity", "fused" };
+  double gridBytes = (double)gridCnt * coils * sizeof(CufftType);
+  double imgBytes = (double)imgCnt * coils * sizeof(CufftType);
+  double bytes[] = { 4 * gridBytes, 2 * imgBytes, 2 * imgBytes,
+                     2 * imgBytes + imgCnt * sizeof(DType),
+                     5 * imgBytes,
+                     5 * imgBytes + imgCnt * sizeof(DType) };
+  double t[6] = { 1e30, 1e30, 1e30, 1e30, 1e30, 1e30 };
+  for (int rep = 0; rep < config.reps; rep++)
+  {
+    double t0 = now();
+    // the shift is applied before and after the FFT
+    performHostFFTShift(&grid[0], gpuNUFFT::INVERSE, gridDims, &gi_host);
+    performHostFFTShift(&grid[0], gpuNUFFT::INVERSE, gridDims, &gi_host);
+    double t1 = now();
+    performHostCrop(&grid[0], &img[0], &gi_host);
+    double t2 = now();
+    performHostFFTScaling(&img[0], imgCnt, &gi_host);
+    double t3 = now();
+    performHostDeapodization(&img[0], &deapo[0], &gi_host);
+    double t4 = now();
+    performHostSensMul(&img[0], &sens[0], &gi_host, true);
+    performHostSensSum(&img[0], &sum[0], &gi_host);
+    double t5 = now();
+    performHostFusedCrop(&grid[0], NULL, &deapo[0], &sens[0], &sum[0],
+                         &gi_host);
+    double t6 = now();
+
+    t[0] = std::min(t[0], t1 - t0);
+    t[1] = std::min(t[1], t2 - t1);
+    t[2] = std::min(t[2], t3 - t2);
+    t[3] = std::min(t[3], t4 - t3);
+    t[4] = std::min(t[4], t5 - t4);
+    t[5] = std::min(t[5], t6 - t5);
+  }
+
+  double separate = t[0] + t[1] + t[2] + t[3] + t[4];
+  fprintf(out, "  \"fused_image\": {\n");
+  fprintf(out, "    \"grid\": [%u, %u, %u],\n", gridDims.width,
+          gridDims.height, gridDims.depth);
+  fprintf(out, "    \"coils\": %d,\n", coils);
+  fprintf(out, "    \"stages\": [\n");
+  for (int i = 0; i < 6; i++)
+    fprintf(out,
+            "      {\"name\": \"%s\", \"seconds\": %.9f, \"bytes\": %.0f, "
+            "\"gb_per_s\": %.3f}%s\n",
+            names[i], t[i], bytes[i], bytes[i] / t[i] * 1e-9,
+            i < 5 ? "," : "");
+  fprintf(out, "    ],\n");
+  fprintf(out, "    \"separate_s\": %.9f,\n", separate);
+  fprintf(out, "    \"speedup\": %.3f\n", separate / t[5]);
+  fprintf(out, "  },\n");
+}
+
+void writeCoilCompression(FILE *out, const BenchConfig &config)
+{
+  IndType size = config.size > 0 ? config.size : 128;
+  IndType coils = 32;
+  IndType samples = size * size;
+  gpuNUFFT::Dimensions imgDims(size, size);
+  IndType imgCnt = imgDims.count();
+
+  std::vector<DType> coords(2 * samples);
+  unsigned seed = 42;
+  for (size_t i = 0; i < coords.size(); i++)
+  {
+    seed = seed * 1103515245u + 12345u;
+    coords[i] = (DType)((seed >> 8) % 100000) / (DType)100000.0 - (DType)0.5;
+  }
+  gpuNUFFT::Array<DType> traj;
+  traj.data = &coords[0];
+  traj.dim.length = samples;
+
+  // smooth coil profiles placed on a circle around a disc phantom
+  std::vector<DType2> sens(imgCnt * coils);
+  std::vector<DType2> img(imgCnt);
+  for (IndType y = 0; y < size; y++)
+    for (IndType x = 0; x < size; x++)
+    {
+      double px = (x + 0.5) / size - 0.5, py = (y + 0.5) / size - 0.5;
+      img[y * size + x].x = (DType)(px * px + py * py < 0.16 ? 1.0 : 0.0);
+      img[y * size + x].y = (DType)0.0;
+      for (IndType c = 0; c < coils; c++)
+      {
+        double phi = 2.0 * M_PI * c / coils;
+        double dx = px - 0.6 * cos(phi), dy = py - 0.6 * sin(phi);
+        double mag = exp(-(dx * dx + dy * dy) / 0.18);
+        double phase = 3.0 * (dx * cos(phi) + dy * sin(phi));
+        sens[c * imgCnt + y * size + x].x = (DType)(mag * cos(phase));
+        sens[c * imgCnt + y * size + x].y = (DType)(mag * sin(phase));
+      }
+    }
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coils;
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+
+  gpuNUFFT::Array<DType> densArray;
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *op =
+      (gpuNUFFT::HostGpuNUFFTOperator *)factory.createGpuNUFFTOperator(
+          traj, densArray, sensArray, config.kernelWidth, config.sectorWidth,
+          config.osf, imgDims);
+  op->setCoilBatchSize(4);
+
+  gpuNUFFT::Array<CufftType> kspace = op->performForwardGpuNUFFT(imgArray);
+  gpuNUFFT::Array<DType2> data;
+  data.data = kspace.data;
+  data.dim = kspace.dim;
+
+  // calibration region |k| < 0.1
+  std::vector<IndType> calibIndices;
+  for (IndType i = 0; i < samples; i++)
+    if (coords[i] * coords[i] + coords[samples + i] * coords[samples + i] <
+        0.01f)
+      calibIndices.push_back(i);
+  IndType calibCount = calibIndices.size();
+  std::vector<DType2> calib(calibCount * coils);
+  for (IndType c = 0; c < coils; c++)
+    for (IndType i = 0; i < calibCount; i++)
+      calib[c * calibCount + i] = data.data[c * samples + calibIndices[i]];
+  gpuNUFFT::Array<DType2> calibArray;
+  calibArray.data = &calib[0];
+  calibArray.dim.length = calibCount;
+  calibArray.dim.channels = coils;
+
+  gpuNUFFT::Array<CufftType> ref;
+  ref.dim = imgDims;
+  ref.data = (CufftType *)malloc(imgCnt * sizeof(CufftType));
+  gpuNUFFT::Array<CufftType> res;
+  res.dim = imgDims;
+  res.data = (CufftType *)malloc(imgCnt * sizeof(CufftType));
+
+  double tFull = 1e30;
+  for (int rep = 0; rep < config.reps; rep++)
+  {
+    double t0 = now();
+    op->performGpuNUFFTAdj(data, ref);
+    tFull = std::min(tFull, now() - t0);
+  }
+
+  fprintf(out, "  \"coil_compression\": {\n");
+  fprintf(out, "    \"image\": [%u, %u],\n", size, size);
+  fprintf(out, "    \"samples\": %u,\n", samples);
+  fprintf(out, "    \"physical_coils\": %u,\n", coils);
+  fprintf(out, "    \"calibration_samples\": %u,\n", calibCount);
+  fprintf(out, "    \"adjoint_s\": %.9f,\n", tFull);
+  fprintf(out, "    \"virtual_coils\": [\n");
+  const IndType virtualCoils[] = { 16, 12, 8, 6, 4, 2 };
+  for (int v = 0; v < 6; v++)
+  {
+    double t0 = now();
+    gpuNUFFT::HostCoilCompression compression(calibArray, virtualCoils[v]);
+    double tSetup = now() - t0;
+    op->setCoilCompression(&compression);
+
+    double tAdj = 1e30;
+    for (int rep = 0; rep < config.reps; rep++)
+    {
+      t0 = now();
+      op->performGpuNUFFTAdj(data, res);
+      tAdj = std::min(tAdj, now() - t0);
+    }
+    op->setCoilCompression(NULL);
+
+    double diff = 0.0, norm = 0.0;
+    for (IndType i = 0; i < imgCnt; i++)
+    {
+      double dx = res.data[i].x - ref.data[i].x;
+      double dy = res.data[i].y - ref.data[i].y;
+      diff += dx * dx + dy * dy;
+      norm += (double)ref.data[i].x * ref.data[i].x +
+              (double)ref.data[i].y * ref.data[i].y;
+    }
+    fprintf(out,
+            "      {\"k\": %u, \"setup_s\": %.9f, \"adjoint_s\": %.9f, "
+            "\"speedup\": %.3f, \"retained_energy\": %.9f, "
+            "\"relative_error\": %.3e}%s\n",
+            virtualCoils[v], tSetup, tAdj, tFull / tAdj,
+            compression.getRetainedEnergy(), sqrt(diff / norm),
+            v < 5 ? "," : "");
+  }
+  fprintf(out, "    ]\n");
+  fprintf(out, "  },\n");
+
+  free(kspace.data);
+  free(ref.data);
+  free(res.data);
+  delete op;
+}
+
+void writeStackOfStars(FILE *out, const BenchConfig &config)
+{
+  BenchConfig stack = config;
+  stack.traj = "stack";
+  stack.dims = 3;
+  stack.size = config.size > 0 ? config.size : 32;
+  stack.samples = stack.size * stack.size * stack.size / 2;
+  IndType size = stack.size;
+  IndType coils = config.coils;
+
+  std::vector<DType> k = createTrajectory(stack);
+  std::vector<DType> planar = toPlanar(k, 3);
+  gpuNUFFT::Array<DType> traj;
+  traj.data = &planar[0];
+  traj.dim.length = planar.size() / 3;
+  IndType samples = traj.count();
+
+  // the partitions share the 2-d trajectory of the first one
+  IndType sliceSamples = samples / size;
+  std::vector<DType> sliceCoords(2 * sliceSamples);
+  for (IndType i = 0; i < sliceSamples; i++)
+  {
+    sliceCoords[i] = planar[i];
+    sliceCoords[sliceSamples + i] = planar[samples + i];
+  }
+  gpuNUFFT::Array<DType> sliceTraj;
+  sliceTraj.data = &sliceCoords[0];
+  sliceTraj.dim.length = sliceSamples;
+
+  gpuNUFFT::Dimensions imgDims(size, size, size);
+  gpuNUFFT::Array<DType> densArray;
+  gpuNUFFT::Array<DType2> sensArray;
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+
+  double t0 = now();
+  gpuNUFFT::GpuNUFFTOperator *op = factory.createGpuNUFFTOperator(
+      traj, densArray, sensArray, config.kernelWidth, config.sectorWidth,
+      config.osf, imgDims);
+  double tFactory = now() - t0;
+  t0 = now();
+  gpuNUFFT::HostStackOfStarsOperator *stackOp =
+      factory.createStackOfStarsOperator(sliceTraj, densArray, sensArray,
+                                         config.kernelWidth,
+                                         config.sectorWidth, config.osf,
+                                         imgDims);
+  double tStackFactory = now() - t0;
+
+  std::vector<DType2> data(samples * coils);
+  for (IndType i = 0; i < data.size(); i++)
+  {
+    data[i].x = (DType)cos(0.37 * i);
+    data[i].y = (DType)sin(0.11 * i);
+  }
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = samples;
+  dataArray.dim.channels = coils;
+
+  gpuNUFFT::Array<CufftType> ref;
+  ref.dim = imgDims;
+  ref.dim.channels = coils;
+  ref.data = (CufftType *)malloc(ref.count() * sizeof(CufftType));
+  gpuNUFFT::Array<CufftType> res;
+  res.dim = ref.dim;
+  res.data = (CufftType *)malloc(res.count() * sizeof(CufftType));
+  gpuNUFFT::Array<CufftType> kspace;
+  kspace.dim = dataArray.dim;
+  kspace.data = (CufftType *)malloc(kspace.count() * sizeof(CufftType));
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = (DType2 *)ref.data;
+  imgArray.dim = ref.dim;
+
+  double tAdj = 1e30, tStackAdj = 1e30, tFwd = 1e30, tStackFwd = 1e30;
+  for (int rep = 0; rep < config.reps; rep++)
+  {
+    t0 = now();
+    op->performGpuNUFFTAdj(dataArray, ref);
+    tAdj = std::min(tAdj, now() - t0);
+    t0 = now();
+    stackOp->performGpuNUFFTAdj(dataArray, res);
+    tStackAdj = std::min(tStackAdj, now() - t0);
+  }
+  for (int rep = 0; rep < config.reps; rep++)
+  {
+    t0 = now();
+    op->performForwardGpuNUFFT(imgArray, kspace);
+    tFwd = std::min(tFwd, now() - t0);
+    t0 = now();
+    stackOp->performForwardGpuNUFFT(imgArray, kspace);
+    tStackFwd = std::min(tStackFwd, now() - t0);
+  }
+
+  double diff = 0.0, norm = 0.0;
+  for (IndType i = 0; i < ref.count(); i++)
+  {
+    double dx = res.data[i].x - ref.data[i].x;
+    double dy = res.data[i].y - ref.data[i].y;
+    diff += dx * dx + dy * dy;
+    norm += (double)ref.data[i].x * ref.data[i].x +
+            (double)ref.data[i].y * ref.data[i].y;
+  }
+
+  fprintf(out, "  \"stack_of_stars\": {\n");
+  fprintf(out, "    \"image\": [%u, %u, %u],\n", size, size, size);
+  fprintf(out, "    \"samples\": %u,\n", samples);
+  fprintf(out, "    \"coils\": %u,\n", coils);
+  fprintf(out,
+          "    \"operator_3d\": {\"factory_s\": %.9f, \"adjoint_s\": %.9f, "
+          "\"forward_s\": %.9f},\n",
+          tFactory, tAdj, tFwd);
+  fprintf(out,
+          "    \"hybrid\": {\"factory_s\": %.9f, \"adjoint_s\": %.9f, "
+          "\"forward_s\": %.9f},\n",
+          tStackFactory, tStackAdj, tStackFwd);
+  fprintf(out,
+          "    \"adjoint_speedup\": %.3f,\n    \"forward_speedup\": %.3f,\n",
+          tAdj / tStackAdj, tFwd / tStackFwd);
+  fprintf(out, "    \"relative_difference\": %.3e\n", sqrt(diff / norm));
+  fprintf(out, "  },\n");
+
+  free(ref.data);
+  free(res.data);
+  free(kspace.data);
+  delete stackOp;
+  delete op;
+}
+
+void writeRegionAdjoint(FILE *out, const BenchConfig &config)
+{
+  BenchConfig region = config;
+  region.traj = "random";
+  region.dims = 3;
+  region.size = config.size > 0 ? config.size : 48;
+  region.samples = region.size * region.size * region.size / 4;
+  IndType size = region.size;
+  IndType coils = config.coils;
+
+  std::vector<DType> k = createTrajectory(region);
+  std::vector<DType> planar = toPlanar(k, 3);
+  gpuNUFFT::Array<DType> traj;
+  traj.data = &planar[0];
+  traj.dim.length = planar.size() / 3;
+  IndType samples = traj.count();
+
+  gpuNUFFT::Dimensions imgDims(size, size, size);
+  std::vector<DType2> sens(imgDims.count() * coils);
+  for (IndType i = 0; i < sens.size(); i++)
+  {
+    sens[i].x = (DType)(1.0 + 0.5 * cos(0.013 * i));
+    sens[i].y = (DType)(0.5 * sin(0.007 * i));
+  }
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coils;
+  gpuNUFFT::Array<DType> densArray;
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *op =
+      (gpuNUFFT::HostGpuNUFFTOperator *)factory.createGpuNUFFTOperator(
+          traj, densArray, sensArray, config.kernelWidth, config.sectorWidth,
+          config.osf, imgDims);
+
+  std::vector<DType2> data(samples * coils);
+  for (IndType i = 0; i < data.size(); i++)
+  {
+    data[i].x = (DType)cos(0.37 * i);
+    data[i].y = (DType)sin(0.11 * i);
+  }
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = samples;
+  dataArray.dim.channels = coils;
+
+  gpuNUFFT::Array<CufftType> full;
+  full.dim = imgDims;
+  full.data = (CufftType *)malloc(full.count() * sizeof(CufftType));
+  double tFull = 1e30;
+  for (int rep = 0; rep < config.reps; rep++)
+  {
+    double t0 = now();
+    op->performGpuNUFFTAdj(dataArray, full);
+    tFull = std::min(tFull, now() - t0);
+  }
+
+  fprintf(out, "  \"roi_adjoint\": {\n");
+  fprintf(out, "    \"image\": [%u, %u, %u],\n", size, size, size);
+  fprintf(out, "    \"samples\": %u,\n", samples);
+  fprintf(out, "    \"coils\": %u,\n", coils);
+  fprintf(out, "    \"adjoint_s\": %.9f,\n", tFull);
+  fprintf(out, "    \"boxes\": [\n");
+  // centered cubes of 1/2, 1/4 and 1/8 of the image width
+  const IndType divisors[] = { 2, 4, 8 };
+  for (int b = 0; b < 3; b++)
+  {
+    IndType width = std::max(size / divisors[b], (IndType)1);
+    gpuNUFFT::Dimensions roiDims(width, width, width);
+    IndType3 roiOffset;
+    roiOffset.x = roiOffset.y = roiOffset.z = (size - width) / 2;
+    gpuNUFFT::Array<CufftType> roi;
+    roi.dim = roiDims;
+    roi.data = (CufftType *)malloc(roi.count() * sizeof(CufftType));
+
+    double tRoi = 1e30;
+    for (int rep = 0; rep < config.reps; rep++)
+    {
+      double t0 = now();
+      op->performGpuNUFFTAdj(dataArray, roi, roiOffset, roiDims);
+      tRoi = std::min(tRoi, now() - t0);
+    }
+
+    double diff = 0.0, norm = 0.0;
+    for (IndType i = 0; i < roi.count(); i++)
+    {
+      IndType x = roiOffset.x + i % width;
+      IndType y = roiOffset.y + (i / width) % width;
+      IndType z = roiOffset.z + i / (width * width);
+      CufftType ref = full.data[x + size * (y + size * z)];
+      double dx = roi.data[i].x - ref.x;
+      double dy = roi.data[i].y - ref.y;
+      diff += dx * dx + dy * dy;
+      norm += (double)ref.x * ref.x + (double)ref.y * ref.y;
+    }
+    fprintf(out,
+            "      {\"box\": [%u, %u, %u], \"adjoint_s\": %.9f, "
+            "\"speedup\": %.3f, \"relative_difference\": %.3e}%s\n",
+            width, width, width, tRoi, tFull / tRoi, sqrt(diff / norm),
+            b < 2 ? "," : "");
+    free(roi.data);
+  }
+  fprintf(out, "    ]\n");
+  fprintf(out, "  },\n");
+
+  free(full.data);
+  delete op;
+}
+
+void writeSampleSubset(FILE *out, const BenchConfig &config)
+{
+  BenchConfig subset = config;
+  subset.traj = "random";
+  subset.dims = 2;
+  subset.size = config.size > 0 ? config.size : 128;
+  subset.samples = subset.size * subset.size;
+  IndType size = subset.size;
+  IndType coils = config.coils;
+
+  std::vector<DType> k = createTrajectory(subset);
+  std::vector<DType> planar = toPlanar(k, 2);
+  gpuNUFFT::Array<DType> traj;
+  traj.data = &planar[0];
+  traj.dim.length = planar.size() / 2;
+  IndType samples = traj.count();
+
+  gpuNUFFT::Dimensions imgDims(size, size);
+  gpuNUFFT::Array<DType> densArray;
+  gpuNUFFT::Array<DType2> sensArray;
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *op =
+      (gpuNUFFT::HostGpuNUFFTOperator *)factory.createGpuNUFFTOperator(
+          traj, densArray, sensArray, config.kernelWidth, config.sectorWidth,
+          config.osf, imgDims);
+
+  std::vector<DType2> data(samples * coils);
+  for (IndType i = 0; i < data.size(); i++)
+  {
+    data[i].x = (DType)cos(0.37 * i);
+    data[i].y = (DType)sin(0.11 * i);
+  }
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = samples;
+  dataArray.dim.channels = coils;
+
+  gpuNUFFT::Array<CufftType> img;
+  img.dim = imgDims;
+  img.dim.channels = coils;
+  img.data = (CufftType *)malloc(img.count() * sizeof(CufftType));
+  double tFull = 1e30;
+  for (int rep = 0; rep < config.reps; rep++)
+  {
+    double t0 = now();
+    op->performGpuNUFFTAdj(dataArray, img);
+    tFull = std::min(tFull, now() - t0);
+  }
+
+  fprintf(out, "  \"sample_subset\": {\n");
+  fprintf(out, "    \"image\": [%u, %u],\n", size, size);
+  fprintf(out, "    \"samples\": %u,\n", samples);
+  fprintf(out, "    \"coils\": %u,\n", coils);
+  fprintf(out, "    \"adjoint_s\": %.9f,\n", tFull);
+  fprintf(out, "    \"subsets\": [\n");
+  // every n-th sample
+  const IndType strides[] = { 2, 4, 8, 16 };
+  for (int s = 0; s < 4; s++)
+  {
+    IndType count = (samples + strides[s] - 1) / strides[s];
+    std::vector<IndType> indices(count);
+    std::vector<DType2> subsetData(count * coils);
+    for (IndType j = 0; j < count; j++)
+    {
+      indices[j] = j * strides[s];
+      for (IndType c = 0; c < coils; c++)
+        subsetData[j + c * count] = data[indices[j] + c * samples];
+    }
+    gpuNUFFT::Array<IndType> indexArray;
+    indexArray.data = &indices[0];
+    indexArray.dim.length = count;
+    gpuNUFFT::Array<DType2> subsetArray;
+    subsetArray.data = &subsetData[0];
+    subsetArray.dim.length = count;
+    subsetArray.dim.channels = coils;
+
+    double tSubset = 1e30;
+    for (int rep = 0; rep < config.reps; rep++)
+    {
+      double t0 = now();
+      op->performGpuNUFFTAdj(subsetArray, img, indexArray);
+      tSubset = std::min(tSubset, now() - t0);
+    }
+    fprintf(out,
+            "      {\"stride\": %u, \"samples\": %u, \"adjoint_s\": %.9f, "
+            "\"speedup\": %.3f}%s\n",
+            strides[s], count, tSubset, tFull / tSubset, s < 3 ? "," : "");
+  }
+  fprintf(out, "    ]\n");
+  fprintf(out, "  },\n");
+
+  free(img.data);
+  delete op;
+}
+
+void writeTrajectoryGradient(FILE *out, const BenchConfig &config)
+{
+  BenchConfig gradient = config;
+  gradient.traj = "random";
+  gradient.dims = 2;
+  gradient.size = config.size > 0 ? config.size : 128;
+  gradient.samples = gradient.size * gradient.size;
+  IndType size = gradient.size;
+  IndType coils = config.coils;
+
+  std::vector<DType> k = createTrajectory(gradient);
+  std::vector<DType> planar = toPlanar(k, 2);
+  gpuNUFFT::Array<DType> traj;
+  traj.data = &planar[0];
+  traj.dim.length = planar.size() / 2;
+  IndType samples = traj.count();
+
+  gpuNUFFT::Dimensions imgDims(size, size);
+  gpuNUFFT::Array<DType> densArray;
+  gpuNUFFT::Array<DType2> sensArray;
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *op =
+      (gpuNUFFT::HostGpuNUFFTOperator *)factory.createGpuNUFFTOperator(
+          traj, densArray, sensArray, config.kernelWidth, config.sectorWidth,
+          config.osf, imgDims);
+
+  std::vector<DType2> img(imgDims.count() * coils);
+  for (IndType i = 0; i < img.size(); i++)
+  {
+    img[i].x = (DType)cos(0.37 * i);
+    img[i].y = (DType)sin(0.11 * i);
+  }
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  imgArray.dim.channels = coils;
+
+  std::vector<CufftType> data(samples * coils);
+  gpuNUFFT::Array<CufftType> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = samples;
+  dataArray.dim.channels = coils;
+  std::vector<CufftType> derivatives(2 * samples * coils);
+  gpuNUFFT::Array<CufftType> gradientArray;
+  gradientArray.data = &derivatives[0];
+  gradientArray.dim = dataArray.dim;
+  gradientArray.dim.frames = 2;
+
+  double tForward = 1e30, tGradient = 1e30;
+  for (int rep = 0; rep < config.reps; rep++)
+  {
+    double t0 = now();
+    op->performForwardGpuNUFFT(imgArray, dataArray);
+    tForward = std::min(tForward, now() - t0);
+    t0 = now();
+    op->performForwardGpuNUFFTGradient(imgArray, dataArray, gradientArray);
+    tGradient = std::min(tGradient, now() - t0);
+  }
+  // central differences need two forward operations per dimension in
+  // addition to the samples themselves
+  double tDifferences = 5.0 * tForward;
+
+  fprintf(out, "  \"trajectory_gradient\": {\n");
+  fprintf(out, "    \"image\": [%u, %u],\n", size, size);
+  fprintf(out, "    \"samples\": %u,\n", samples);
+  fprintf(out, "    \"coils\": %u,\n", coils);
+  fprintf(out, "    \"forward_s\": %.9f,\n", tForward);
+  fprintf(out, "    \"gradient_s\": %.9f,\n", tGradient);
+  fprintf(out, "    \"central_differences_s\": %.9f,\n", tDifferences);
+  fprintf(out, "    \"speedup\": %.3f\n", tDifferences / tGradient);
+  fprintf(out, "  },\n");
+
+  delete op;
+}
+
+void writeGatherAdjoint(FILE *out, const BenchConfig &config)
+{
+  BenchConfig gather = config;
+  gather.traj = "random";
+  gather.dims = 3;
+  gather.size = config.size > 0 ? config.size : 32;
+  gather.samples = gather.size * gather.size * gather.size / 2;
+  IndType size = gather.size;
+  IndType coils = config.coils;
+
+  std::vector<DType> k = createTrajectory(gather);
+  std::vector<DType> planar = toPlanar(k, 3);
+  gpuNUFFT::Array<DType> traj;
+  traj.data = &planar[0];
+  traj.dim.length = planar.size() / 3;
+  IndType samples = traj.count();
+
+  gpuNUFFT::Dimensions imgDims(size, size, size);
+  gpuNUFFT::Array<DType> densArray;
+  gpuNUFFT::Array<DType2> sensArray;
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *op =
+      (gpuNUFFT::HostGpuNUFFTOperator *)factory.createGpuNUFFTOperator(
+          traj, densArray, sensArray, config.kernelWidth, config.sectorWidth,
+          config.osf, imgDims);
+
+  std::vector<DType2> data(samples * coils);
+  for (IndType i = 0; i < data.size(); i++)
+  {
+    data[i].x = (DType)cos(0.37 * i);
+    data[i].y = (DType)sin(0.11 * i);
+  }
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = samples;
+  dataArray.dim.channels = coils;
+
+  // gridding only, the FFT and image passes are the same for both modes
+  IndType gridCount = op->getGridDims().count() * coils;
+  std::vector<CufftType> scatter(gridCount), grid(gridCount), first,
+      firstScatter;
+  gpuNUFFT::Array<CufftType> gridArray;
+  gridArray.dim = op->getGridDims();
+  gridArray.dim.channels = coils;
+
+  int threads = gpuNUFFT::getHostThreadCount();
+  const int threadCounts[] = { 1, threads };
+  fprintf(out, "  \"gather_adjoint\": {\n");
+  fprintf(out, "    \"image\": [%u, %u, %u],\n", size, size, size);
+  fprintf(out, "    \"samples\": %u,\n", samples);
+  fprintf(out, "    \"coils\": %u,\n", coils);
+  fprintf(out, "    \"runs\": [\n");
+
+  // builds the tile lists which all further gather operations reuse
+  op->setGatherConvolution(true);
+  gridArray.data = &grid[0];
+  op->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+
+  for (int t = 0; t < 2; t++)
+  {
+    // both modes run on the same amount of threads
+    gpuNUFFT::setHostThreadCount(threadCounts[t]);
+    double tScatter = 1e30, tGather = 1e30;
+    for (int rep = 0; rep < config.reps; rep++)
+    {
+      op->setGatherConvolution(false);
+      gridArray.data = &scatter[0];
+      double t0 = now();
+      op->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+      tScatter = std::min(tScatter, now() - t0);
+
+      op->setGatherConvolution(true);
+      gridArray.data = &grid[0];
+      t0 = now();
+      op->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+      tGather = std::min(tGather, now() - t0);
+    }
+    if (t == 0)
+    {
+      first = grid;
+      firstScatter = scatter;
+    }
+
+    double diff = 0.0, norm = 0.0;
+    for (IndType i = 0; i < gridCount; i++)
+    {
+      double dx = grid[i].x - scatter[i].x, dy = grid[i].y - scatter[i].y;
+      diff += dx * dx + dy * dy;
+      norm += (double)scatter[i].x * scatter[i].x +
+              (double)scatter[i].y * scatter[i].y;
+    }
+    bool identical =
+        memcmp(&first[0], &grid[0], gridCount * sizeof(CufftType)) == 0;
+    bool scatterIdentical = memcmp(&firstScatter[0], &scatter[0],
+                                   gridCount * sizeof(CufftType)) == 0;
+    fprintf(out,
+            "      {\"threads\": %d, \"scatter_s\": %.9f, \"gather_s\": %.9f, "
+            "\"scatter_samples_per_s\": %.1f, "
+            "\"gather_samples_per_s\": %.1f, \"rel_diff\": %.3e, "
+            "\"identical_to_1_thread\": %s, "
+            "\"scatter_identical_to_1_thread\": %s}%s\n",
+            threadCounts[t], tScatter, tGather, samples * coils / tScatter,
+            samples * coils / tGather, norm > 0 ? sqrt(diff / norm) : 0.0,
+            identical ? "true" : "false", scatterIdentical ? "true" : "false",
+            t == 0 ? "," : "");
+  }
+  fprintf(out, "    ]\n");
+  fprintf(out, "  },\n");
+  gpuNUFFT::setHostThreadCount(threads);
+
+  delete op;
+}
+
+void writeShardedAdjoint(FILE *out, const BenchConfig &config)
+{
+  BenchConfig sharded = config;
+  sharded.traj = "random";
+  sharded.dims = 3;
+  sharded.size = config.size > 0 ? config.size : 48;
+  sharded.samples = sharded.size * sharded.size * sharded.size / 2;
+  IndType size = sharded.size;
+  IndType coils = config.coils;
+
+  std::vector<DType> k = createTrajectory(sharded);
+  std::vector<DType> planar = toPlanar(k, 3);
+  gpuNUFFT::Array<DType> traj;
+  traj.data = &planar[0];
+  traj.dim.length = planar.size() / 3;
+  IndType samples = traj.count();
+
+  gpuNUFFT::Dimensions imgDims(size, size, size);
+  gpuNUFFT::Array<DType> densArray;
+  gpuNUFFT::Array<DType2> sensArray;
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *op =
+      (gpuNUFFT::HostGpuNUFFTOperator *)factory.createGpuNUFFTOperator(
+          traj, densArray, sensArray, config.kernelWidth, config.sectorWidth,
+          config.osf, imgDims);
+
+  std::vector<DType2> data(samples * coils);
+  for (IndType i = 0; i < data.size(); i++)
+  {
+    data[i].x = (DType)cos(0.37 * i);
+    data[i].y = (DType)sin(0.11 * i);
+  }
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = samples;
+  dataArray.dim.channels = coils;
+
+  // gridding only, the FFT and image passes run in the calling process
+  IndType gridCount = op->getGridDims().count() * coils;
+  std::vector<CufftType> reference(gridCount), grid(gridCount);
+  gpuNUFFT::Array<CufftType> gridArray;
+  gridArray.dim = op->getGridDims();
+  gridArray.dim.channels = coils;
+
+  const int processCounts[] = { 1, 2, 4 };
+  fprintf(out, "  \"sharded_adjoint\": {\n");
+  fprintf(out, "    \"image\": [%u, %u, %u],\n", size, size, size);
+  fprintf(out, "    \"samples\": %u,\n", samples);
+  fprintf(out, "    \"coils\": %u,\n", coils);
+  fprintf(out, "    \"runs\": [\n");
+  for (int p = 0; p < 3; p++)
+  {
+    op->setShardProcessCount(processCounts[p]);
+    gridArray.data = p == 0 ? &reference[0] : &grid[0];
+    double tConvolution = 1e30;
+    for (int rep = 0; rep < config.reps; rep++)
+    {
+      double t0 = now();
+      op->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+      tConvolution = std::min(tConvolution, now() - t0);
+    }
+
+    double diff = 0.0, norm = 0.0;
+    for (IndType i = 0; p > 0 && i < gridCount; i++)
+    {
+      double dx = grid[i].x - reference[i].x;
+      double dy = grid[i].y - reference[i].y;
+      diff += dx * dx + dy * dy;
+      norm += (double)reference[i].x * reference[i].x +
+              (double)reference[i].y * reference[i].y;
+    }
+    fprintf(out,
+            "      {\"processes\": %d, \"convolution_s\": %.9f, "
+            "\"samples_per_s\": %.1f, \"rel_diff\": %.3e}%s\n",
+            processCounts[p], tConvolution, samples * coils / tConvolution,
+            norm > 0 ? sqrt(diff / norm) : 0.0, p < 2 ? "," : "");
+  }
+  fprintf(out, "    ]\n");
+  fprintf(out, "  },\n");
+
+  delete op;
+}
+
+void writePartitionedOperator(FILE *out, const BenchConfig &config)
+{
+  BenchConfig partitioned = config;
+  partitioned.traj = "random";
+  partitioned.dims = 3;
+  partitioned.size = config.size > 0 ? config.size : 32;
+  partitioned.samples = partitioned.size * partitioned.size *
+                        partitioned.size / 2;
+  IndType size = partitioned.size;
+  IndType coils = config.coils;
+
+  std::vector<DType> k = createTrajectory(partitioned);
+  std::vector<DType> planar = toPlanar(k, 3);
+  gpuNUFFT::Array<DType> traj;
+  traj.data = &planar[0];
+  traj.dim.length = planar.size() / 3;
+  IndType samples = traj.count();
+
+  gpuNUFFT::Dimensions imgDims(size, size, size);
+  gpuNUFFT::Array<DType> densArray;
+  gpuNUFFT::Array<DType2> sensArray;
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::GpuNUFFTOperator *op = factory.createGpuNUFFTOperator(
+      traj, densArray, sensArray, config.kernelWidth, config.sectorWidth,
+      config.osf, imgDims);
+
+  std::vector<DType2> data(samples * coils);
+  for (IndType i = 0; i < data.size(); i++)
+  {
+    data[i].x = (DType)cos(0.37 * i);
+    data[i].y = (DType)sin(0.11 * i);
+  }
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = samples;
+  dataArray.dim.channels = coils;
+  std::vector<DType2> img(imgDims.count() * coils);
+  for (IndType i = 0; i < img.size(); i++)
+  {
+    img[i].x = (DType)cos(0.23 * i);
+    img[i].y = (DType)sin(0.19 * i);
+  }
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  imgArray.dim.channels = coils;
+
+  gpuNUFFT::Array<CufftType> adjointRef = op->performGpuNUFFTAdj(dataArray);
+  gpuNUFFT::Array<CufftType> forwardRef = op->performForwardGpuNUFFT(imgArray);
+  double tAdjointRef = 1e30, tForwardRef = 1e30;
+  for (int rep = 0; rep < config.reps; rep++)
+  {
+    double t0 = now();
+    op->performGpuNUFFTAdj(dataArray, adjointRef);
+    tAdjointRef = std::min(tAdjointRef, now() - t0);
+    t0 = now();
+    op->performForwardGpuNUFFT(imgArray, forwardRef);
+    tForwardRef = std::min(tForwardRef, now() - t0);
+  }
+
+  const IndType partitionCounts[] = { 2, 4 };
+  fprintf(out, "  \"partitioned_operator\": {\n");
+  fprintf(out, "    \"image\": [%u, %u, %u],\n", size, size, size);
+  fprintf(out, "    \"samples\": %u,\n", samples);
+  fprintf(out, "    \"coils\": %u,\n", coils);
+  fprintf(out, "    \"adjoint_s\": %.9f,\n", tAdjointRef);
+  fprintf(out, "    \"forward_s\": %.9f,\n", tForwardRef);
+  fprintf(out, "    \"runs\": [\n");
+  for (int n = 0; n < 2; n++)
+  {
+    gpuNUFFT::HostPartitionedOperator *partOp =
+        factory.createPartitionedOperator(
+            traj, densArray, sensArray, partitionCounts[n], config.kernelWidth,
+            config.sectorWidth, config.osf, imgDims);
+    gpuNUFFT::Array<CufftType> adjoint = partOp->performGpuNUFFTAdj(dataArray);
+    gpuNUFFT::Array<CufftType> forward =
+        partOp->performForwardGpuNUFFT(imgArray);
+    double tAdjoint = 1e30, tForward = 1e30;
+    for (int rep = 0; rep < config.reps; rep++)
+    {
+      double t0 = now();
+      partOp->performGpuNUFFTAdj(dataArray, adjoint);
+      tAdjoint = std::min(tAdjoint, now() - t0);
+      t0 = now();
+      partOp->performForwardGpuNUFFT(imgArray, forward);
+      tForward = std::min(tForward, now() - t0);
+    }
+
+    double diffAdjoint = 0.0, normAdjoint = 0.0;
+    for (IndType i = 0; i < adjoint.count(); i++)
+    {
+      double dx = adjoint.data[i].x - adjointRef.data[i].x;
+      double dy = adjoint.data[i].y - adjointRef.data[i].y;
+      diffAdjoint += dx * dx + dy * dy;
+      normAdjoint += (double)adjointRef.data[i].x * adjointRef.data[i].x +
+                     (double)adjointRef.data[i].y * adjointRef.data[i].y;
+    }
+    double diffForward = 0.0, normForward = 0.0;
+    for (IndType i = 0; i < forward.count(); i++)
+    {
+      double dx = forward.data[i].x - forwardRef.data[i].x;
+      double dy = forward.data[i].y - forwardRef.data[i].y;
+      diffForward += dx * dx + dy * dy;
+      normForward += (double)forwardRef.data[i].x * forwardRef.data[i].x +
+                     (double)forwardRef.data[i].y * forwardRef.data[i].y;
+    }
+    fprintf(out,
+            "      {\"partitions\": %u, \"halo\": %u, \"adjoint_s\": %.9f, "
+            "\"forward_s\": %.9f, \"adjoint_rel_diff\": %.3e, "
+            "\"forward_rel_diff\": %.3e}%s\n",
+            partitionCounts[n], partOp->getHalo(), tAdjoint, tForward,
+            normAdjoint > 0 ? sqrt(diffAdjoint / normAdjoint) : 0.0,
+            normForward > 0 ? sqrt(diffForward / normForward) : 0.0,
+            n == 0 ? "," : "");
+    free(adjoint.data);
+    free(forward.data);
+    delete partOp;
+  }
+  fprintf(out, "    ]\n");
+  fprintf(out, "  },\n");
+
+  free(adjointRef.data);
+  free(forwardRef.data);
+  delete op;
+}
+
+void usage()
+{
+  fprintf(stderr,
+          "usage: gpuNUFFT_bench [--traj radial|spiral|stack|random] "
+          "[--dims 2|3] [--size N] [--samples M] [--coils C] [--kw KW] "
+          "[--osf OSF] [--sw SW] [--reps R] [--threads T] "
+          "[--output FILE]\n");
+}
+}
+
+int main(int argc, char *argv[])
+{
+  BenchConfig base;
+  base.dims = 0;
+  base.size = 0;
+  base.samples = 0;
+  base.coils = 1;
+  base.kernelWidth = 3;
+  base.osf = 2.0;
+  base.sectorWidth = 8;
+  base.reps = 3;
+  const char *outputFile = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h")
+    {
+      usage();
+      return 0;
+    }
+    if (i + 1 >= argc)
+    {
+      usage();
+      return 1;
+    }
+    const char *value = argv[++i];
+    if (arg == "--traj")
+      base.traj = value;
+    else if (arg == "--dims")
+      base.dims = atoi(value);
+    else if (arg == "--size")
+      base.size = (IndType)atoi(value);
+    else if (arg == "--samples")
+      base.samples = (IndType)atoi(value);
+    else if (arg == "--coils")
+      base.coils = (IndType)atoi(value);
+    else if (arg == "--kw")
+      base.kernelWidth = (IndType)atoi(value);
+    else if (arg == "--osf")
+      base.osf = (DType)atof(value);
+    else if (arg == "--sw")
+      base.sectorWidth = (IndType)atoi(value);
+    else if (arg == "--reps")
+      base.reps = std::max(1, atoi(value));
+    else if (arg == "--threads")
+      gpuNUFFT::setHostThreadCount(atoi(value));
+    else if (arg == "--output")
+      outputFile = value;
+    else
+    {
+      usage();
+      return 1;
+    }
+  }
+
+  std::vector<BenchConfig> configs;
+  const char *trajs[] = { "radial", "spiral", "stack", "random" };
+  for (int dims = 2; dims <= 3; dims++)
+  {
+    if (base.dims != 0 && base.dims != dims)
+      continue;
+    for (int t = 0; t < 4; t++)
+    {
+      if (!base.traj.empty() && base.traj != trajs[t])
+        continue;
+      if (dims == 2 && std::string(trajs[t]) == "stack")
+        continue;
+      BenchConfig config = base;
+      config.traj = trajs[t];
+      config.dims = dims;
+      if (config.size == 0)
+        config.size = dims == 2 ? 128 : 32;
+      if (config.samples == 0)
+        config.samples = dims == 2 ? config.size * config.size
+                                   : config.size * config.size * config.size /
+                                         2;
+      configs.push_back(config);
+    }
+  }
+
+  FILE *out = stdout;
+  if (outputFile != NULL)
+  {
+    out = fopen(outputFile, "w");
+    if (out == NULL)
+    {
+      fprintf(stderr, "cannot open %s\n", outputFile);
+      return 1;
+    }
+  }
+
+  fprintf(out, "{\n");
+  fprintf(out, "  \"benchmark\": \"gpuNUFFT_bench\",\n");
+  fprintf(out, "  \"precision\": \"%s\",\n",
+          sizeof(DType) == sizeof(double) ? "double" : "float");
+  fprintf(out, "  \"threads\": %d,\n", gpuNUFFT::getHostThreadCount());
+
+  int result = 0;
+  try
+  {
+    // prints nothing if the construction fails
+    writeKernelCache(out, base);
+    writePrunedFFT(out, base);
+    writeFusedImage(out, base);
+    writeCoilCompression(out, base);
+    writeStackOfStars(out, base);
+    writeRegionAdjoint(out, base);
+    writeSampleSubset(out, base);
+    writeTrajectoryGradient(out, base);
+    writeGatherAdjoint(out, base);
+    writeShardedAdjoint(out, base);
+    writePartitionedOperator(out, base);
+  }
+  catch (std::exception &e)
+  {
+    fprintf(stderr, "gpuNUFFT_bench: %s\n", e.what());
+    result = 1;
+  }
+
+  fprintf(out, "  \"runs\": [\n");
+  try
+  {
+    for (size_t c = 0; c < configs.size(); c++)
+    {
+      std::vector<DType> k = createTrajectory(configs[c]);
+      std::vector<DType> planar = toPlanar(k, configs[c].dims);
+      gpuNUFFT::Array<DType> traj;
+      traj.data = &planar[0];
+      traj.dim.length = planar.size() / configs[c].dims;
+
+      gpuNUFFT::Dimensions imgDims(configs[c].size, configs[c].size,
+                                   configs[c].dims == 3 ? configs[c].size
+                                                        : 0);
+
+      std::vector<StageResult> stages;
+      runFactoryStages(configs[c], traj, imgDims, stages);
+      runGriddingStages(configs[c], traj, imgDims, stages);
+      writeRun(out, configs[c], traj.count(), stages,
+               c + 1 == configs.size());
+    }
+  }
+  catch (std::exception &e)
+  {
+    fprintf(stderr, "gpuNUFFT_bench: %s\n", e.what());
+    result = 1;
+  }
+
+  fprintf(out, "  ]\n}\n");
+  if (out != stdout)
+    fclose(out);
+  return result;
+}
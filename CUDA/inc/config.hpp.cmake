@@ -2,7 +2,11 @@
 
 #ifndef CONFIG_H
 #define CONFIG_H
+#ifdef GPUNUFFT_HOST_ONLY
+#include "host_cuda_compat.hpp"
+#else
 #include "cufft.h"
+#endif
 
 /**
  * @file
@@ -1,10 +1,14 @@
 #ifndef CUDA_UTILS_HPP
 #define CUDA_UTILS_HPP
 
+#ifdef GPUNUFFT_HOST_ONLY
+#include "host_cuda_compat.hpp"
+#else
 #include <cuda.h>
 #include <cuda_runtime.h>
-#include <stdio.h>
 #include "cufft.h"
+#endif
+#include <stdio.h>
 #include "gpuNUFFT_utils.hpp"
 #include "gpuNUFFT_operator.hpp"
 #include <stdarg.h>
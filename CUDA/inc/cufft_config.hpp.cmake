@@ -2,7 +2,11 @@
 #ifndef CUFFT_CONFIG_H
 #define CUFFT_CONFIG_H
 #include "config.hpp"
+#ifdef GPUNUFFT_HOST_ONLY
+#include "host_cuda_compat.hpp"
+#else
 #include "cufft.h"
+#endif
 
 /**
  * @file
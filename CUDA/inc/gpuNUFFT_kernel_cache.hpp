@@ -0,0 +1,80 @@
+#ifndef GPUNUFFT_KERNEL_CACHE_H_INCLUDED
+#define GPUNUFFT_KERNEL_CACHE_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+
+/**
+ * @file
+ * \brief Process-wide cache of immutable interpolation kernel lookup tables.
+ */
+
+namespace gpuNUFFT
+{
+/** \brief Usage statistics of the KernelLookupTableCache */
+struct KernelLookupTableCacheStats
+{
+  KernelLookupTableCacheStats()
+    : tables(0), bytes(0), hits(0), misses(0), savedBytes(0)
+  {
+  }
+
+  /** \brief Amount of cached tables */
+  IndType tables;
+  /** \brief Memory held by the cached tables */
+  unsigned long long bytes;
+  /** \brief Requests served by an existing table */
+  unsigned long long hits;
+  /** \brief Requests which required computing a new table */
+  unsigned long long misses;
+  /** \brief Memory not allocated due to shared tables, sum over all hits */
+  unsigned long long savedBytes;
+};
+
+/**
+ * \brief Thread-safe, process-wide cache of kernel lookup tables
+ *
+ * Tables are computed once per key (kernel type, kernel width, oversampling
+ * factor, size per dimension, dimension count) by load1DKernel, load2DKernel or
+ * load3DKernel and shared by all operators requesting the same key, e.g. the
+ * gridding operator and its temporary deapodization operator or several
+ * operators of the same trajectory type. The 3-d table of texture operators
+ * holds size^3 entries, thus sharing avoids both the repeated evaluation and
+ * the memory of identical copies.
+ *
+ * The returned tables must not be modified. Each acquire has to be balanced by
+ * a release. Unreferenced tables stay cached (memoized) until
+ * releaseUnused is called.
+ */
+class KernelLookupTableCache
+{
+ public:
+  /** \brief Get the table of the given key, compute it if not cached yet
+   *
+   * @param kernelWidth    kernel width in grid units
+   * @param osf            oversampling factor
+   * @param size           table entries per dimension, at least 2
+   * @param dimensionCount 1, 2 or 3
+   * @param kernelType     interpolation kernel family
+   * @return table of size^dimensionCount entries
+   * @throws std::invalid_argument for invalid sizes or dimension counts
+   */
+  static const DType *acquire(IndType kernelWidth, DType osf, IndType size,
+                              int dimensionCount,
+                              KernelType kernelType = KAISER_BESSEL);
+
+  /** \brief Drop one reference of a table returned by acquire
+   *
+   * NULL and tables which are not part of the cache are ignored, so that
+   * release is safe to call from destructors.
+   */
+  static void release(const DType *table);
+
+  /** \brief Free all tables which are not referenced by any operator */
+  static void releaseUnused();
+
+  /** \brief Current usage statistics */
+  static KernelLookupTableCacheStats getStats();
+};
+}
+
+#endif  // GPUNUFFT_KERNEL_CACHE_H_INCLUDED
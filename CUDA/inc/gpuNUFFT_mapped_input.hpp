@@ -0,0 +1,156 @@
+#ifndef GPUNUFFT_MAPPED_INPUT_H_INCLUDED
+#define GPUNUFFT_MAPPED_INPUT_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+#include <string>
+
+namespace gpuNUFFT
+{
+/** \brief Read-only memory mapping of a whole file.
+ *
+ * Pages are loaded on first access by the operating system. Ranges can be
+ * announced ahead of use (prefetch) and handed back after use (release) in
+ * order to keep the resident set of large inputs bounded.
+ */
+class MappedFile
+{
+ public:
+  /** \brief Map file read-only
+   *
+   * @throws std::runtime_error if the file cannot be opened or mapped
+   */
+  MappedFile(const std::string &fileName);
+
+  ~MappedFile();
+
+  /** \brief Pointer to the first byte of the mapping */
+  const char *getData() const
+  {
+    return data;
+  }
+
+  /** \brief File size in bytes */
+  size_t getSize() const
+  {
+    return size;
+  }
+
+  /** \brief Announce that the byte range will be accessed soon (read-ahead) */
+  void prefetch(size_t offset, size_t length) const;
+
+  /** \brief Allow the OS to drop the resident pages of the byte range */
+  void release(size_t offset, size_t length) const;
+
+ private:
+  MappedFile(const MappedFile &);
+  MappedFile &operator=(const MappedFile &);
+
+  char *data;
+  size_t size;
+};
+
+/** \brief Streaming input of trajectory, density and k-space data from raw
+ *binary files.
+ *
+ * All files are expected in the in-memory layouts of gpuNUFFT:
+ *
+ * - trajectory: DType, structure of arrays (x1,...,xn,y1,...,yn(,z1,...,zn))
+ * - k-space data: DType2, coil-major (all samples of coil 0, then coil 1, ...)
+ * - density compensation (optional): DType, one value per sample
+ *
+ * The sample count is derived from the trajectory file size, the coil count
+ * from the k-space file size.
+ *
+ * The returned arrays point directly into the mappings and are valid as long as
+ * the MappedInputSource exists. They must not be freed or modified.
+ *
+ * @see GpuNUFFTOperatorFactory::createGpuNUFFTOperator
+ * @see HostGpuNUFFTOperator::performGpuNUFFTAdj
+ */
+class MappedInputSource
+{
+ public:
+  /** \brief Map input files
+   *
+   * @param trajFile   trajectory file
+   * @param kspaceFile k-space data file
+   * @param dimCount   dimension count of trajectory (2 or 3)
+   * @param densFile   density compensation file, empty if not present
+   *
+   * @throws std::invalid_argument if the file sizes do not match
+   */
+  MappedInputSource(const std::string &trajFile, const std::string &kspaceFile,
+                    int dimCount, const std::string &densFile = "");
+
+  ~MappedInputSource();
+
+  /** \brief Trajectory view, dim.length = sample count */
+  Array<DType> getKSpaceTraj();
+
+  /** \brief Density compensation view, empty array if not present */
+  Array<DType> getDens();
+
+  /** \brief k-space view of count consecutive coils starting at coil */
+  Array<DType2> getCoilData(IndType coil, IndType count = 1);
+
+  /** \brief Read-ahead of the trajectory and density samples
+   * [offset,offset+count) in all dimensions */
+  void prefetchTraj(IndType offset, IndType count);
+
+  /** \brief Release the trajectory and density samples [offset,offset+count) */
+  void releaseTraj(IndType offset, IndType count);
+
+  /** \brief Read-ahead of count coils starting at coil */
+  void prefetchCoils(IndType coil, IndType count = 1);
+
+  /** \brief Release count coils starting at coil */
+  void releaseCoils(IndType coil, IndType count = 1);
+
+  IndType getSampleCount()
+  {
+    return sampleCount;
+  }
+
+  IndType getCoilCount()
+  {
+    return coilCount;
+  }
+
+  int getDimensionCount()
+  {
+    return dimCount;
+  }
+
+  bool hasDens()
+  {
+    return dens != NULL;
+  }
+
+  /** \brief Amount of samples processed per block when the trajectory is
+   * consumed sequentially */
+  IndType getChunkSize()
+  {
+    return chunkSize;
+  }
+
+  void setChunkSize(IndType chunkSize)
+  {
+    this->chunkSize = chunkSize > 0 ? chunkSize : 1;
+  }
+
+ private:
+  MappedInputSource(const MappedInputSource &);
+  MappedInputSource &operator=(const MappedInputSource &);
+
+  MappedFile *traj;
+  MappedFile *kspace;
+  MappedFile *dens;
+
+  int dimCount;
+  IndType sampleCount;
+  IndType coilCount;
+  IndType chunkSize;
+};
+}
+
+#endif  // GPUNUFFT_MAPPED_INPUT_H_INCLUDED
@@ -4,6 +4,8 @@
 #include "gpuNUFFT_types.hpp"
 #include "gpuNUFFT_kernels.hpp"
 #include "config.hpp"
+#include "gpuNUFFT_profiler.hpp"
+#include "gpuNUFFT_kernel_cache.hpp"
 #include <cstdlib>
 #include <iostream>
 
@@ -48,7 +50,8 @@ class GpuNUFFTOperator
       debugTiming(DEBUG), sens_d(NULL), crds_d(NULL), density_comp_d(NULL),
       deapo_d(NULL), gdata_d(NULL), sector_centers_d(NULL), sectors_d(NULL),
       data_indices_d(NULL), data_sorted_d(NULL), allocatedCoils(0),
-      matlabSharedMem(matlabSharedMem)
+      matlabSharedMem(matlabSharedMem), profiler(NULL), lookupTableSize(0),
+      kernelType(KAISER_BESSEL)
   {
     if (loadKernel)
       initKernel();
@@ -61,7 +64,7 @@ class GpuNUFFTOperator
 
   virtual ~GpuNUFFTOperator()
   {
-    freeLocalMemberArray(this->kernel.data);
+    KernelLookupTableCache::release(this->kernel.data);
 
     if (!matlabSharedMem) {
       freeLocalMemberArray(this->deapo.data);
@@ -111,6 +114,13 @@ class GpuNUFFTOperator
     this->deapo= deapo;
   }
 
+  /** \brief Attach profiler recording the stages of all subsequent
+   *operations, NULL to detach. The profiler is not owned. */
+  void setProfiler(Profiler *profiler)
+  {
+    this->profiler = profiler;
+  }
+
   void setImageDims(Dimensions dims)
   {
     this->imgDims = dims;
@@ -147,10 +157,51 @@ class GpuNUFFTOperator
   {
     return this->kernelWidth;
   }
+
+  /** \brief Kernel width per dimension, the depth is 0 for 2-d problems.
+   *
+   * Equal to getKernelWidth in all dimensions unless per-axis widths are set
+   * (HostGpuNUFFTOperator::setKernelWidths).
+   */
+  Dimensions getKernelWidths();
+
+  /** \brief Set amount of kernel lookup table entries (per dimension) and
+   *reload the table, 0 restores the default size derived from the maximum
+   *aliasing error (calculateGrid3KernelSize).
+   *
+   * Operators using the constant memory lookup table (DEFAULT, BALANCED)
+   * support at most 10000 entries.
+   *
+   * @throws std::invalid_argument
+   */
+  void setKernelLookupTableSize(IndType lookupTableSize);
+
+  /** \brief Explicitly set lookup table size, 0 if the default is used */
+  IndType getKernelLookupTableSize()
+  {
+    return this->lookupTableSize;
+  }
+
+  /** \brief Select the interpolation kernel family and reload the lookup
+   *table.
+   *
+   * The deapodization function has to match the kernel, thus the kernel type
+   * is usually selected by GpuNUFFTOperatorFactory::setKernelType.
+   */
+  void setKernelType(KernelType kernelType);
+
+  KernelType getKernelType()
+  {
+    return this->kernelType;
+  }
   IndType getSectorWidth()
   {
     return this->sectorWidth;
   }
+  DType getOsf()
+  {
+    return this->osf;
+  }
 
   Dimensions getImageDims()
   {
@@ -184,6 +235,11 @@ class GpuNUFFTOperator
     return this->dataIndices;
   }
 
+  Profiler *getProfiler()
+  {
+    return this->profiler;
+  }
+
   bool is2DProcessing()
   {
     return this->imgDims.depth == 0;
@@ -361,7 +417,8 @@ class GpuNUFFTOperator
    * implementation. */
   OperatorType operatorType;
 
-  /** \brief Precomputed interpolation kernel lookup table. */
+  /** \brief Precomputed interpolation kernel lookup table, shared with other
+   * operators via the KernelLookupTableCache, must not be modified. */
   Array<DType> kernel;
 
   /** \brief k space trajectory. Array of coordinates.
@@ -422,6 +479,9 @@ class GpuNUFFTOperator
   /** \brief Width of kernel in grid units */
   IndType kernelWidth;
 
+  /** \brief Width of kernel per dimension, 0 entries use kernelWidth */
+  Dimensions kernelWidths;
+
   /** \brief Sector size in grid units */
   IndType sectorWidth;
 
@@ -438,6 +498,15 @@ class GpuNUFFTOperator
   */
   bool matlabSharedMem;
 
+  /** \brief Attached profiler, NULL if none */
+  Profiler *profiler;
+
+  /** \brief Explicit kernel lookup table size, 0 for default */
+  IndType lookupTableSize;
+
+  /** \brief Interpolation kernel family */
+  KernelType kernelType;
+
   /** \brief Return Grid Width (ImageWidth * osf) */
   IndType getGridWidth()
   {
@@ -452,6 +521,10 @@ class GpuNUFFTOperator
   template <typename T>
   void writeOrdered(Array<T> &destArray, T *sortedArray, int offset = 0);
 
+  /** \brief Lookup table size used if no explicit size is set, derived from
+   *the maximum aliasing error (calculateGrid3KernelSize). */
+  virtual IndType getDefaultKernelLookupTableSize();
+
   /** \brief Precompute interpolation kernel lookup table. */
   virtual void initKernel();
 
@@ -6,6 +6,13 @@
 #include "balanced_gpuNUFFT_operator.hpp"
 #include "texture_gpuNUFFT_operator.hpp"
 #include "balanced_texture_gpuNUFFT_operator.hpp"
+#include "host_gpuNUFFT_operator.hpp"
+#include "host_nudft_operator.hpp"
+#include "host_stack_operator.hpp"
+#include "host_time_segmented_operator.hpp"
+#include "host_partitioned_operator.hpp"
+#include "gpuNUFFT_mapped_input.hpp"
+#include "gpuNUFFT_planner.hpp"
 #include <algorithm>  // std::sort
 #include <vector>     // std::vector
 #include <string>
@@ -14,6 +21,14 @@
 #include "cuda_utils.hpp"
 #include "precomp_utils.hpp"
 
+/** \brief Initial host backend selection of the factory, the host-only build
+ * provides no gpu operators. */
+#ifdef GPUNUFFT_HOST_ONLY
+#define GPUNUFFT_DEFAULT_HOST_BACKEND true
+#else
+#define GPUNUFFT_DEFAULT_HOST_BACKEND false
+#endif
+
 namespace gpuNUFFT
 {
 /** \brief Manages the initialization of the GpuNUFFT Operator and its sub
@@ -58,7 +73,9 @@ class GpuNUFFTOperatorFactory
   GpuNUFFTOperatorFactory(const bool useTextures = true, const bool useGpu = true,
                           bool balanceWorkload = true, bool matlabSharedMem = false)
     : useTextures(useTextures), useGpu(useGpu), balanceWorkload(balanceWorkload),
-    matlabSharedMem(matlabSharedMem)
+    matlabSharedMem(matlabSharedMem), useHostBackend(GPUNUFFT_DEFAULT_HOST_BACKEND), useHostNUDFT(false),
+    hostNUDFTSampleLimit(0), useDeapodization(true),
+    useLinearKernelInterpolation(false), kernelWidths(), lookupTableSize(0), kernelType(KAISER_BESSEL), profiler(NULL)
   {
   }
 
@@ -122,6 +139,148 @@ class GpuNUFFTOperatorFactory
                          const IndType &sectorWidth, const DType &osf,
                          Dimensions &imgDims);
 
+  /** \brief Create GpuNUFFT Operator reaching a relative error tolerance.
+    *
+    * Kernel width, oversampling ratio and kernel lookup table size are chosen
+    *by planGpuNUFFTOperator instead of being passed explicitly.
+    *
+    * @param kSpaceTraj     coordinate array of sample locations
+    * @param densCompData   data for density compensation
+    * @param sensData       coil sensitivity data
+    * @param tolerance      target relative error, (0,1)
+    * @param sectorWidth    sector width
+    * @param imgDims        image dimensions (problem size)
+    * @throws std::invalid_argument if the tolerance cannot be reached
+   */
+  GpuNUFFTOperator *
+  createGpuNUFFTOperator(Array<DType> &kSpaceTraj, Array<DType> &densCompData,
+                         Array<DType2> &sensData, double tolerance,
+                         const IndType &sectorWidth, Dimensions &imgDims);
+
+  /** \brief Create GpuNUFFT Operator reaching a relative error tolerance.
+    *
+    * @see createGpuNUFFTOperator(Array<DType> &, Array<DType> &,
+    *Array<DType2> &, double, const IndType &, Dimensions &)
+   */
+  GpuNUFFTOperator *createGpuNUFFTOperator(Array<DType> &kSpaceTraj,
+                                           double tolerance,
+                                           const IndType &sectorWidth,
+                                           Dimensions &imgDims);
+
+  /** \brief Create hybrid operator of stack-of-stars / stack-of-spirals data.
+    *
+    * The 2-d trajectory shared by all partitions is precomputed like a 2-d
+    *GpuNUFFTOperator, i.e. by the 2-d sector assignment and sector centers, on
+    *the host backend regardless of setUseHostBackend. z is Cartesian and
+    *transformed by a plain 1-d FFT without oversampling.
+    *
+    * @param kSpaceTraj     2-d coordinate array (x,y) of one partition
+    * @param densCompData   data for density compensation of one partition
+    * @param sensData       coil sensitivity data of the stack, not copied
+    * @param kernelWidth    interpolation kernel size in grid units
+    * @param sectorWidth    sector width
+    * @param osf            grid oversampling ratio in x and y
+    * @param imgDims        image dimensions, depth = amount of partitions
+    * @see HostStackOfStarsOperator
+   */
+  HostStackOfStarsOperator *createStackOfStarsOperator(
+      Array<DType> &kSpaceTraj, Array<DType> &densCompData,
+      Array<DType2> &sensData, const IndType &kernelWidth,
+      const IndType &sectorWidth, const DType &osf, Dimensions &imgDims);
+
+  /** \brief Create off-resonance corrected operator by time segmentation.
+    *
+    * The trajectory is precomputed once on the host backend regardless of
+    *setUseHostBackend, all segments share the resulting operator.
+    *
+    * @param kSpaceTraj     coordinate array of sample locations
+    * @param densCompData   data for density compensation
+    * @param sensData       coil sensitivity data, not copied
+    * @param fieldMap       off-resonance in rad/s per pixel, not copied
+    * @param readoutTimes   readout time in s per sample, trajectory order
+    * @param segments       amount of time segments L
+    * @param kernelWidth    interpolation kernel size in grid units
+    * @param sectorWidth    sector width
+    * @param osf            grid oversampling ratio
+    * @param imgDims        image dimensions (problem size)
+    * @see HostTimeSegmentedOperator
+   */
+  HostTimeSegmentedOperator *createTimeSegmentedOperator(
+      Array<DType> &kSpaceTraj, Array<DType> &densCompData,
+      Array<DType2> &sensData, Array<DType> &fieldMap,
+      Array<DType> &readoutTimes, IndType segments,
+      const IndType &kernelWidth, const IndType &sectorWidth, const DType &osf,
+      Dimensions &imgDims);
+
+  /** \brief Create operator whose convolution is split over independent
+    *backends by slabs of sectors.
+    *
+    * The trajectory is precomputed on the host backend regardless of
+    *setUseHostBackend, first for all samples, then for the samples of each
+    *slab, which are contiguous in the sorted order of the operator of all
+    *samples.
+    *
+    * @param kSpaceTraj     coordinate array of sample locations
+    * @param densCompData   data for density compensation
+    * @param sensData       coil sensitivity data, not copied
+    * @param partitions     amount of slabs and backends
+    * @param kernelWidth    interpolation kernel size in grid units
+    * @param sectorWidth    sector width
+    * @param osf            grid oversampling ratio
+    * @param imgDims        image dimensions (problem size)
+    * @see HostPartitionedOperator
+   */
+  HostPartitionedOperator *createPartitionedOperator(
+      Array<DType> &kSpaceTraj, Array<DType> &densCompData,
+      Array<DType2> &sensData, IndType partitions, const IndType &kernelWidth,
+      const IndType &sectorWidth, const DType &osf, Dimensions &imgDims);
+
+  /** \brief Cheapest gridding parameters reaching a relative error tolerance
+    *with the current kernel type and lookup mode of the factory.
+    *
+    * Linear table interpolation is assumed for texture operators and for host
+    *operators with setUseLinearKernelInterpolation. The table size is limited
+    *to 10000 entries (constant memory of the gpu kernels), 256 entries per
+    *dimension for texture operators.
+    *
+    * @param tolerance      target relative error, (0,1)
+    * @param sampleCount    amount of k-space samples
+    * @param imgDims        image dimensions (problem size)
+    * @see planGpuNUFFT
+   */
+  GpuNUFFTPlan planGpuNUFFTOperator(double tolerance, IndType sampleCount,
+                                    Dimensions &imgDims);
+
+  /** \brief Create GpuNUFFT Operator from memory mapped input files.
+    *
+    * The trajectory and density compensation data are consumed sequentially
+    * in blocks of input.getChunkSize() samples, which are read ahead and
+    * released after use. Thus only the sorted copies owned by the operator
+    * and the current blocks of the input files are kept in memory.
+    *
+    * The sector assignment is always performed on the host.
+    *
+    * @param input          mapped trajectory, density and k-space files
+    * @param sensData       coil sensitivity data
+    * @param kernelWidth    interpolation kernel size in grid units
+    * @param sectorWidth    sector width
+    * @param osf            grid oversampling ratio
+    * @param imgDims        image dimensions (problem size)
+   */
+  GpuNUFFTOperator *
+  createGpuNUFFTOperator(MappedInputSource &input, Array<DType2> &sensData,
+                         const IndType &kernelWidth, const IndType &sectorWidth,
+                         const DType &osf, Dimensions &imgDims);
+
+  /** \brief Create GpuNUFFT Operator from memory mapped input files.
+    *
+    * @see createGpuNUFFTOperator(MappedInputSource &, Array<DType2> &, ...)
+   */
+  GpuNUFFTOperator *
+  createGpuNUFFTOperator(MappedInputSource &input, const IndType &kernelWidth,
+                         const IndType &sectorWidth, const DType &osf,
+                         Dimensions &imgDims);
+
   /** \brief Load GpuNUFFT Operator from previously computed mappings.
     *
     * Based on a previously performed mapping the GpuNUFFTOperator can be
@@ -175,7 +334,96 @@ class GpuNUFFTOperatorFactory
 
   void setBalanceWorkload(bool balanceWorkload);
 
+  /** \brief Create HostGpuNUFFTOperator instances and perform all
+    *precomputation steps on the host. Always enabled in the host-only build
+    *(GPUNUFFT_HOST_ONLY), disabling it throws std::invalid_argument there. */
+  void setUseHostBackend(bool useHostBackend);
+
+  /** \brief Create HostNUDFTOperator instances evaluating the exact NUDFT
+    *instead of gridding. Only effective together with setUseHostBackend.
+    *Faster than gridding only up to HOST_NUDFT_CROSSOVER_SAMPLES samples, see
+    *setHostNUDFTSampleLimit. */
+  void setUseHostNUDFT(bool useHostNUDFT);
+
+  /** \brief Create HostNUDFTOperator instances for trajectories of at most
+    *sampleLimit samples and gridding operators otherwise. Only effective
+    *together with setUseHostBackend, 0 (default) disables the selection.
+    *
+    *HOST_NUDFT_CROSSOVER_SAMPLES is the measured crossover. The selection is
+    *not enabled by default since the NUDFT operators provide no intermediate
+    *results (CONVOLUTION, FFT).
+    */
+  void setHostNUDFTSampleLimit(IndType sampleLimit);
+
+  IndType getHostNUDFTSampleLimit()
+  {
+    return this->hostNUDFTSampleLimit;
+  }
+
+  /** \brief Interpolate the compact kernel lookup table linearly in created
+    *HostGpuNUFFTOperator instances. Only effective together with
+    *setUseHostBackend.
+    *
+    * @see HostGpuNUFFTOperator::setLinearKernelInterpolation
+    */
+  void setUseLinearKernelInterpolation(bool useLinearKernelInterpolation);
+
+  /** \brief Set an independent kernel width per dimension of the created
+    *HostGpuNUFFTOperator instances, entries of 0 keep the kernel width passed
+    *to createGpuNUFFTOperator. The deapodization function is computed for the
+    *widths. Only supported by the host backend.
+    *
+    * @see HostGpuNUFFTOperator::setKernelWidths
+    */
+  void setKernelWidths(Dimensions kernelWidths);
+
+  Dimensions getKernelWidths()
+  {
+    return this->kernelWidths;
+  }
+
+  /** \brief Set amount of kernel lookup table entries of all created
+    *operators, 0 selects the default size.
+    *
+    * @see GpuNUFFTOperator::setKernelLookupTableSize
+    */
+  void setKernelLookupTableSize(IndType lookupTableSize);
+
+  /** \brief Select the interpolation kernel family of all created operators.
+    *
+    * The deapodization function of the exponential of semicircle kernel is
+    *computed by numerical 1-d Fourier transform of the kernel
+    *(computeNumericalDeapodizationFunction), the Kaiser-Bessel deapodization
+    *by gridding of a single sample.
+    */
+  void setKernelType(KernelType kernelType);
+
+  KernelType getKernelType()
+  {
+    return this->kernelType;
+  }
+
+  /** \brief Record the precomputation stages in profiler and attach it to
+    *all created operators. NULL to disable, not owned. */
+  void setProfiler(Profiler *profiler);
+
+  Profiler *getProfiler()
+  {
+    return profiler;
+  }
+
  protected:
+  /** \brief Create HostGpuNUFFTOperator without sensitivities, independent
+    *of setUseHostBackend and setUseHostNUDFT
+    *
+    * @param deapodization false to skip the deapodization function, e.g. for
+    *                      operators which only perform the convolution
+    */
+  HostGpuNUFFTOperator *createHostGpuNUFFTOperator(
+      Array<DType> &kSpaceTraj, Array<DType> &densCompData,
+      const IndType &kernelWidth, const IndType &sectorWidth, const DType &osf,
+      Dimensions &imgDims, bool deapodization = true);
+
   /** \brief Assign the samples on the k-space trajectory to its corresponding
     *sector
     *
@@ -184,6 +432,20 @@ class GpuNUFFTOperatorFactory
   Array<IndType> assignSectors(GpuNUFFTOperator *gpuNUFFTOp,
                                Array<DType> &kSpaceTraj);
 
+  /** \brief Assign the samples of the mapped trajectory to its corresponding
+    *sector block by block
+    *
+    * @return array of indices of the assigned sector
+   */
+  Array<IndType> assignSectors(GpuNUFFTOperator *gpuNUFFTOp,
+                               MappedInputSource &input);
+
+  /** \brief Assign the samples [offset,offset+count) of the k-space
+    *trajectory to its corresponding sector on the host */
+  void assignSectorsCPU(GpuNUFFTOperator *gpuNUFFTOp, Array<DType> &kSpaceTraj,
+                        IndType *assignedSectors, IndType offset,
+                        IndType count);
+
   /** \brief Init a linear array of size arrCount */
   template <typename T> Array<T> initLinArray(IndType arrCount);
 
@@ -284,11 +546,14 @@ class GpuNUFFTOperatorFactory
     * - useTextures = true: TextureGpuNUFFTOperator
     * - balanceWorkload + useTextures = true: BalancedTextureGpuNUFFTOperator
     *
+    * @param sampleCount trajectory samples compared with the NUDFT sample
+    *                    limit, 0 if unknown
     * @return New allocated GpuNUFFTOperator or sub class
     */
   GpuNUFFTOperator *createNewGpuNUFFTOperator(IndType kernelWidth,
                                               IndType sectorWidth, DType osf,
-                                              Dimensions imgDims);
+                                              Dimensions imgDims,
+                                              IndType sampleCount = 0);
 
   /**
    * \brief Function to check if the problem will fit into device memory
@@ -308,6 +573,38 @@ class GpuNUFFTOperatorFactory
   gpuNUFFT::Array<DType> computeDeapodizationFunction(const IndType &kernelWidth,
     const DType &osf, gpuNUFFT::Dimensions &imgDims);
 
+  /**
+  * \brief Computation of the deapodization function as reciprocal of the
+  * separable continuous Fourier transform of the interpolation kernel,
+  * evaluated numerically per dimension (kernelFourierTransform)
+  *
+  * @returns scalar array in image dimensions (imgDims)
+  */
+  gpuNUFFT::Array<DType> computeNumericalDeapodizationFunction(
+    const IndType &kernelWidth, const DType &osf,
+    gpuNUFFT::Dimensions &imgDims);
+
+  /** \brief Final precomputation steps shared by all create methods.
+    *
+    * Computes the sector data count, processing order, sector centers and
+    *deapodization function and passes the sorted arrays to the operator.
+    * Frees assignedSectors.
+    */
+  void finalizeGpuNUFFTOperator(GpuNUFFTOperator *gpuNUFFTOp,
+                                Array<IndType> &assignedSectors,
+                                Array<IndType> &dataIndices,
+                                Array<DType> &trajSorted,
+                                Array<DType> &densData,
+                                const IndType &kernelWidth, const DType &osf,
+                                Dimensions &imgDims);
+
+  /** \brief Check whether any kernel width per dimension is set */
+  bool hasKernelWidths()
+  {
+    return kernelWidths.width > 0 || kernelWidths.height > 0 ||
+           kernelWidths.depth > 0;
+  }
+
  private:
   /** \brief Flag to indicate texture interpolation */
   bool useTextures;
@@ -320,6 +617,33 @@ class GpuNUFFTOperatorFactory
 
   /** \brief Flag to indicate shared memory usage with Matlab */
   bool matlabSharedMem;
+
+  /** \brief Flag to indicate host (CPU) operators */
+  bool useHostBackend;
+
+  /** \brief Flag to indicate exact NUDFT host operators */
+  bool useHostNUDFT;
+
+  /** \brief Sample count up to which NUDFT host operators are created */
+  IndType hostNUDFTSampleLimit;
+
+  /** \brief Flag to indicate the computation of the deapodization function */
+  bool useDeapodization;
+
+  /** \brief Flag to indicate linear kernel interpolation of host operators */
+  bool useLinearKernelInterpolation;
+
+  /** \brief Kernel width per dimension of host operators, 0 for default */
+  Dimensions kernelWidths;
+
+  /** \brief Kernel lookup table size, 0 for default */
+  IndType lookupTableSize;
+
+  /** \brief Interpolation kernel family */
+  KernelType kernelType;
+
+  /** \brief Optional profiler, not owned */
+  Profiler *profiler;
 };
 }
 
@@ -0,0 +1,100 @@
+#ifndef GPUNUFFT_PLANNER_H_INCLUDED
+#define GPUNUFFT_PLANNER_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+
+/**
+ * @file
+ * \brief Tolerance driven choice of kernel width, oversampling factor and
+ * kernel lookup table size.
+ */
+
+namespace gpuNUFFT
+{
+/** \brief Gridding parameters selected by planGpuNUFFT */
+struct GpuNUFFTPlan
+{
+  GpuNUFFTPlan()
+    : kernelWidth(0), osf(0), lookupTableSize(0), aliasingError(0),
+      lookupTableError(0), estimatedError(0), estimatedCost(0)
+  {
+  }
+
+  /** \brief Interpolation kernel width in grid units */
+  IndType kernelWidth;
+  /** \brief Grid oversampling ratio */
+  DType osf;
+  /** \brief Kernel lookup table entries */
+  IndType lookupTableSize;
+  /** \brief Estimated relative error caused by the kernel aliasing */
+  double aliasingError;
+  /** \brief Estimated relative error caused by the table lookup */
+  double lookupTableError;
+  /** \brief Sum of aliasing and lookup table error */
+  double estimatedError;
+  /** \brief Estimated cost in units of one FFT butterfly operation */
+  double estimatedCost;
+};
+
+/** \brief Relative aliasing amplitude of the interpolation kernel in one
+ * dimension
+ *
+ * Root mean square over the image frequencies |f| <= 1 / (2 osf) of
+ * sqrt(sum_{p != 0} |Phi(f + p)|^2) / |D(f)|, Phi the continuous Fourier
+ * transform of the kernel (kernelFourierTransform) and D the deapodization
+ * function, see Jackson et al., IEEE TMI 10, 1991 and Beatty et al. IEEE TMI
+ * 24, 2005. For the Kaiser-Bessel kernel D is the transform of the sampled
+ * kernel as computed by gridding a single sample, whose deviation from Phi
+ * adds to the error.
+ */
+double estimateAliasingError(int kernelWidth, DType osf,
+                             KernelType kernelType = KAISER_BESSEL);
+
+/** \brief Relative error of a kernel lookup table of tableSize entries in one
+ * dimension
+ *
+ * Inverts the table densities of calculateGrid3KernelSize (nearest neighbor,
+ * MAXIMUM_ALIASING_ERROR) and calculateKernelSizeLinInt (linear
+ * interpolation, MAXIMUM_ALIASING_ERROR_LIN_INT). The bounds are scaled by 2
+ * (nearest neighbor) and 8 (linear) to cover the measured error of the
+ * gridding implementation, whose tables are indexed by the squared radius.
+ */
+double estimateLookupTableError(IndType tableSize, int kernelWidth, DType osf,
+                                bool linearInterpolation = false);
+
+/** \brief Choose the cheapest gridding parameters reaching a relative error
+ *
+ * All kernel widths from 2 to 16 and oversampling ratios from 1.25 to 2 in
+ * steps of 0.125 are considered, even widths and ratios from 1.5 for the
+ * Kaiser-Bessel kernel, for which the model holds. The error of a candidate is estimated as
+ * sqrt(d) (estimateAliasingError + estimateLookupTableError), d the dimension
+ * count, where the lookup table is sized to the smallest table keeping the
+ * tolerance. Floating point rounding is not part of the model.
+ *
+ * The cost is estimated as the oversampled grid FFT, G sum_d(sum of the prime
+ * factors of the grid width of dimension d) / 2, which equals G log2(G) for
+ * powers of 2 and penalizes sizes with large prime factors, plus the
+ * convolution, convolutionWeight * sampleCount * kernelWidth^d. The default
+ * weight reflects the host gridder, one kernel tap costs about 8 FFT
+ * butterfly units.
+ *
+ * @param tolerance           target relative error, (0,1)
+ * @param imgDims             image dimensions
+ * @param sampleCount         amount of k-space samples
+ * @param kernelType          interpolation kernel family
+ * @param linearInterpolation linear instead of nearest neighbor table lookup
+ * @param convolutionWeight   cost of one kernel tap relative to the FFT
+ * @param maxLookupTableSize  largest admissible table, 10000 entries fit into
+ *                            the constant memory of the gpu kernels
+ * @throws std::invalid_argument if the tolerance is out of range, below
+ *         2e-5 in single precision or cannot be reached by any candidate
+ */
+GpuNUFFTPlan planGpuNUFFT(double tolerance, Dimensions &imgDims,
+                          IndType sampleCount,
+                          KernelType kernelType = KAISER_BESSEL,
+                          bool linearInterpolation = false,
+                          double convolutionWeight = 8.0,
+                          IndType maxLookupTableSize = 10000);
+}
+
+#endif  // GPUNUFFT_PLANNER_H_INCLUDED
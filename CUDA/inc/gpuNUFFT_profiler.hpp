@@ -0,0 +1,231 @@
+#ifndef GPUNUFFT_PROFILER_H_INCLUDED
+#define GPUNUFFT_PROFILER_H_INCLUDED
+
+#include <cstddef>
+
+/**
+ * @file
+ * \brief Runtime switchable per stage timers and counters of operators and
+ * the operator factory.
+ */
+
+namespace gpuNUFFT
+{
+/** \brief Stages recorded by the gpuNUFFT::Profiler */
+enum ProfileStage
+{
+  /** \brief Reordering of k-space data into and out of sector order */
+  PROFILE_SORT,
+  /** \brief Density compensation */
+  PROFILE_DENSITY_COMPENSATION,
+  /** \brief Gridding convolution (adjoint) or interpolation (forward) */
+  PROFILE_CONVOLUTION,
+  /** \brief FFT including shifts, normalization is attributed to crop
+   * (adjoint) and convolution (forward) */
+  PROFILE_FFT,
+  /** \brief Crop (adjoint) or zero padding (forward) */
+  PROFILE_CROP,
+  /** \brief Deapodization */
+  PROFILE_DEAPODIZATION,
+  /** \brief Coil sensitivity multiplication and summation */
+  PROFILE_SENSITIVITY,
+  /** \brief Crop (adjoint) or zero padding (forward) fused with FFT shift,
+   * deapodization and coil sensitivities in a single pass */
+  PROFILE_FUSED_IMAGE,
+  /** \brief Factory: assignment of samples to sectors */
+  PROFILE_FACTORY_ASSIGN,
+  /** \brief Factory: sorting of samples by sector */
+  PROFILE_FACTORY_SORT,
+  /** \brief Factory: sector data count and processing order */
+  PROFILE_FACTORY_COUNT,
+  /** \brief Factory: sector centers */
+  PROFILE_FACTORY_CENTERS,
+  /** \brief Factory: deapodization function */
+  PROFILE_FACTORY_DEAPO,
+  PROFILE_STAGE_COUNT
+};
+
+/** \brief Accumulated counters of one stage */
+struct ProfileCounters
+{
+  ProfileCounters()
+    : wallTime(0.0), cpuTime(0.0), calls(0), samples(0), bytes(0)
+  {
+  }
+
+  /** \brief Elapsed wall clock time in seconds */
+  double wallTime;
+  /** \brief Consumed process CPU time in seconds, all threads */
+  double cpuTime;
+  /** \brief Amount of recorded executions */
+  unsigned long long calls;
+  /** \brief Processed k-space samples (times coils) */
+  unsigned long long samples;
+  /** \brief Bytes read and written */
+  unsigned long long bytes;
+};
+
+/** \brief Receiver of profiling events
+ *
+ * Called synchronously by the thread which executed the stage, i.e. possibly
+ * concurrently if a profiler is shared by operators running on several threads.
+ */
+class ProfileSink
+{
+ public:
+  virtual ~ProfileSink()
+  {
+  }
+
+  /** \brief One execution of stage finished, record contains only this
+   * execution */
+  virtual void stageFinished(ProfileStage stage,
+                             const ProfileCounters &record) = 0;
+
+  /** \brief Host memory of size bytes was allocated */
+  virtual void allocationPerformed(size_t bytes)
+  {
+  }
+};
+
+/**
+ * \brief Per stage wall and CPU timers, sample, byte and allocation counters
+ *
+ * A profiler is attached to operators and the factory by setProfiler. It is
+ * disabled after construction. As long as no profiler is attached or the
+ * attached one is disabled, instrumented code only pays for one pointer and
+ * one flag check per stage.
+ *
+ * Counters are accumulated thread safe and can be queried by getCounters or
+ * forwarded to a ProfileSink. GPU stages are synchronized before their timer is
+ * stopped while profiling is enabled.
+ *
+ * @see ProfileScope
+ */
+class Profiler
+{
+ public:
+  Profiler();
+
+  ~Profiler();
+
+  void setEnabled(bool enabled)
+  {
+    this->enabled = enabled;
+  }
+
+  bool isEnabled() const
+  {
+    return enabled;
+  }
+
+  /** \brief Set sink receiving every record, NULL to disable. Not owned. */
+  void setSink(ProfileSink *sink);
+
+  /** \brief Reset all counters to zero */
+  void reset();
+
+  /** \brief Accumulated counters of stage */
+  ProfileCounters getCounters(ProfileStage stage);
+
+  /** \brief Amount of recorded host allocations */
+  unsigned long long getAllocationCount();
+
+  /** \brief Total size of recorded host allocations in bytes */
+  unsigned long long getAllocatedBytes();
+
+  /** \brief Name of stage, e.g. "convolution" */
+  static const char *getStageName(ProfileStage stage);
+
+  /** \brief Add one execution of stage */
+  void addStage(ProfileStage stage, double wallTime, double cpuTime,
+                unsigned long long samples, unsigned long long bytes);
+
+  /** \brief Add one host allocation */
+  void addAllocation(size_t bytes);
+
+  /** \brief Monotonic wall clock in seconds */
+  static double wallClock();
+
+  /** \brief Process CPU time in seconds */
+  static double cpuClock();
+
+ private:
+  Profiler(const Profiler &);
+  Profiler &operator=(const Profiler &);
+
+  bool enabled;
+
+  ProfileSink *sink;
+
+  ProfileCounters counters[PROFILE_STAGE_COUNT];
+
+  unsigned long long allocationCount;
+  unsigned long long allocatedBytes;
+
+  /** \brief Guards counters, implementation defined */
+  void *lock;
+};
+
+/** \brief Records the enclosing block as one execution of a stage
+ *
+ * Does nothing if profiler is NULL or disabled at construction time.
+ */
+class ProfileScope
+{
+ public:
+  ProfileScope(Profiler *profiler, ProfileStage stage,
+               unsigned long long samples = 0, unsigned long long bytes = 0)
+    : profiler(profiler != NULL && profiler->isEnabled() ? profiler : NULL),
+      stage(stage), samples(samples), bytes(bytes), wallStart(0.0),
+      cpuStart(0.0)
+  {
+    if (this->profiler != NULL)
+    {
+      wallStart = Profiler::wallClock();
+      cpuStart = Profiler::cpuClock();
+    }
+  }
+
+  ~ProfileScope()
+  {
+    stop();
+  }
+
+  /** \brief True if the scope records */
+  bool isActive() const
+  {
+    return profiler != NULL;
+  }
+
+  /** \brief Record the stage now instead of at the end of the scope */
+  void stop()
+  {
+    if (profiler == NULL)
+      return;
+    profiler->addStage(stage, Profiler::wallClock() - wallStart,
+                       Profiler::cpuClock() - cpuStart, samples, bytes);
+    profiler = NULL;
+  }
+
+ private:
+  ProfileScope(const ProfileScope &);
+  ProfileScope &operator=(const ProfileScope &);
+
+  Profiler *profiler;
+  ProfileStage stage;
+  unsigned long long samples;
+  unsigned long long bytes;
+  double wallStart;
+  double cpuStart;
+};
+
+/** \brief Record host allocation if profiler is attached and enabled */
+inline void profileAllocation(Profiler *profiler, size_t bytes)
+{
+  if (profiler != NULL && profiler->isEnabled())
+    profiler->addAllocation(bytes);
+}
+}
+
+#endif  // GPUNUFFT_PROFILER_H_INCLUDED
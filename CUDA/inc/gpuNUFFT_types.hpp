@@ -176,6 +176,21 @@ enum InterpolationType
   TEXTURE3D_LOOKUP
 };
 
+/** \brief Interpolation kernel family
+ *
+ * Both kernels are evaluated into the same lookup tables with respect to the
+ * radius squared, thus all gridding implementations support both.
+ */
+enum KernelType
+{
+  /** \brief Kaiser-Bessel kernel with the shape parameter of Beatty et al. */
+  KAISER_BESSEL,
+  /** \brief Exponential of semicircle kernel exp(beta (sqrt(1 - r^2) - 1)),
+   * see Barnett et al., SIAM J. Sci. Comput. 41, 2019. Accurate at low
+   * oversampling factors, e.g. osf 1.25. */
+  EXPONENTIAL_OF_SEMICIRCLE
+};
+
 /** \brief Gridding step after which the processing is stopped.
  *
  * Neccessary for testing. Default value in the gridding adjoint operations
@@ -209,7 +224,11 @@ enum OperatorType
   BALANCED,
   /** \brief Gridding Operator using load balancing and Texture interpolation on
      GPU. */
-  BALANCED_TEXTURE
+  BALANCED_TEXTURE,
+  /** \brief Gridding Operator executing all steps on the host (CPU). */
+  HOST,
+  /** \brief Operator evaluating the exact NUDFT on the host (CPU). */
+  HOST_NUDFT
 };
 
 /** \brief Struct containing meta information of the current Gridding Problem.
@@ -297,6 +316,9 @@ struct GpuNUFFTInfo
   IndType3 gridDims;
   /**\brief Total amount of grid nodes.*/
   IndType gridDims_count;
+  /**\brief First grid plane along the slowest dimension held by the grid,
+   * which holds gridDims_count nodes from there on (host gridding only).*/
+  int grid_plane_offset;
 
   /**\brief Flag to indicate whether 2-d or 3-d data is processed.*/
   bool is2Dprocessing;
@@ -307,6 +329,27 @@ struct GpuNUFFTInfo
   int sectorsToProcess;
   /**\brief Number of coils processed concurrently */
   int n_coils_cc;
+
+  /**\brief Kernel width per dimension, equal to kernel_width unless per-axis
+   * widths are set (host gridding only).*/
+  IndType3 kernel_width_axis;
+  /**\brief Kernel radius per dimension in grid units.*/
+  DType3 kernel_radius_axis;
+  /**\brief Squared kernel radius per dimension relative to the grid.*/
+  DType3 radiusSquared_axis;
+  /**\brief Distance multiplier per dimension used for interpolation.*/
+  DType3 dist_multiplier_axis;
+  /**\brief Offset of the lookup table of each dimension in the kernel array.*/
+  IndType3 kernel_offset_axis;
+  /**\brief Lookup table entries of each dimension.*/
+  IndType3 kernel_count_axis;
+  /**\brief Shared lookup table of each dimension, NULL to use the table at
+   * kernel_offset_axis of the kernel array (host gridding only).*/
+  const DType *kernel_table_axis[3];
+  /**\brief Maximum index per dimension of the padded sector.*/
+  IndType3 sector_pad_max_axis;
+  /**\brief Offset to zero position inside padded sector per dimension.*/
+  IndType3 sector_offset_axis;
 };
 }
 
@@ -3,10 +3,15 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#ifdef GPUNUFFT_HOST_ONLY
+#include "host_cuda_compat.hpp"
+#else
 #include <cuda.h>
 #include <cuda_runtime.h>
+#endif
 
 #include "config.hpp"
+#include "gpuNUFFT_types.hpp"
 
 #ifdef _WIN32
 #define _USE_MATH_DEFINES
@@ -63,6 +68,39 @@
  * \brief Modified Kaiser Bessel function of zero-th order. */
 DType i0(DType x);
 
+/** \brief Shape parameter beta of the exponential of semicircle kernel
+ * exp(beta (sqrt(1 - r^2) - 1)) for the given width and oversampling ratio.
+ *
+ * beta = 0.97 pi kernel_width (1 - 1 / (2 osr)), see Barnett et al., SIAM J.
+ * Sci. Comput. 41, 2019.
+ */
+DType esKernelBeta(int kernel_width, DType osr);
+
+/** \brief Exponential of semicircle kernel width reaching the relative error
+ * tolerance at the oversampling ratio osr, i.e.
+ * ceil(-ln(tolerance) / (pi sqrt(1 - 1 / osr))) + 1, limited to [2,16].
+ *
+ * The additional grid unit covers the error of the nearest neighbor lookup
+ * table, the estimate of Barnett et al. alone is optimistic by a factor of
+ * about 3.
+ */
+int esKernelWidth(DType tolerance, DType osr);
+
+/** \brief Evaluate the interpolation kernel at radius (relative to the kernel
+ * radius, [0,1])
+ */
+double evaluateKernel(double radius, int kernel_width, DType osr,
+                      gpuNUFFT::KernelType kernelType);
+
+/** \brief Continuous 1-d Fourier transform of the interpolation kernel
+ *
+ * Computes int phi(x) cos(2 pi frequency x) dx over the kernel support
+ * [-kernel_width/2, kernel_width/2] (grid units) by composite Simpson
+ * quadrature, frequency in cycles per grid unit.
+ */
+double kernelFourierTransform(double frequency, int kernel_width, DType osr,
+                              gpuNUFFT::KernelType kernelType);
+
 /*  KERNEL
 *	Summary: Allocates the 3D spherically symmetric kaiser-bessel function
 *	         for kernel table lookup.
@@ -115,19 +153,34 @@ void loadGrid3Kernel(DType *kernTab);
 * respect to the kernel radius squared.
 */
 void load1DKernel(DType *kernTab, long kernel_entries, int kernel_width,
-                  DType osr);
+                  DType osr,
+                  gpuNUFFT::KernelType kernelType = gpuNUFFT::KAISER_BESSEL);
+
+/** \brief Loads the derivative of the kernel table of load1DKernel with
+* respect to the table position, i.e. dT/di at entry i.
+*
+* Together with the table position u = r^2 (kernel_entries - 1) of the radius
+* r the derivative of the kernel value with respect to the sample position
+* follows by the chain rule. The entries are central differences of the
+* continuous kernel, one sided at the table boundaries.
+*/
+void load1DKernelDerivative(
+    DType *derivTab, long kernel_entries, int kernel_width, DType osr,
+    gpuNUFFT::KernelType kernelType = gpuNUFFT::KAISER_BESSEL);
 
 /** \brief Loads a radius of the circularly symmetric kernel into a 2-d array,
 * with
 * respect to the kernel radius squared.
 */
 void load2DKernel(DType *kernTab, long kernel_entries, int kernel_width,
-                  DType osr);
+                  DType osr,
+                  gpuNUFFT::KernelType kernelType = gpuNUFFT::KAISER_BESSEL);
 
 /** \brief Loads a radius of the circularly symmetric kernel into a 3-d array, with
 * respect to the kernel radius squared. 
 */ void
-load3DKernel(DType *kernTab, long kernel_entries, int kernel_width, DType osr);
+load3DKernel(DType *kernTab, long kernel_entries, int kernel_width, DType osr,
+             gpuNUFFT::KernelType kernelType = gpuNUFFT::KAISER_BESSEL);
 
 /** \brief Convert position (x,y,z) to index in linear array */
 __inline__ __device__ __host__ int getIndex(int x, int y, int z, int gwidth)
@@ -180,7 +233,7 @@ getCoordsFromIndex2D(int index, int *x, int *y, int w_x, int w_y)
 }
 
 /** \brief Compute relative grid position of the passed k-space data point. */
-inline __device__ DType mapKSpaceToGrid(DType pos, IndType gridDim,
+__inline__ __device__ __host__ DType mapKSpaceToGrid(DType pos, IndType gridDim,
                                         IndType sectorCenter, int sectorOffset)
 {
   return (pos * (DType)gridDim) + ((DType)0.5 * ((DType)gridDim /*-1*/)) -
@@ -188,7 +241,7 @@ inline __device__ DType mapKSpaceToGrid(DType pos, IndType gridDim,
 }
 
 /** \brief Compute relative k space position of the passed grid position. */
-inline __device__ DType mapGridToKSpace(int gridPos, IndType gridDim,
+__inline__ __device__ __host__ DType mapGridToKSpace(int gridPos, IndType gridDim,
                                         IndType sectorCenter, int sectorOffset)
 {
   return static_cast<DType>((DType)gridPos + (DType)sectorCenter -
@@ -0,0 +1,163 @@
+#ifndef HOST_CG_SENSE_SOLVER_H_INCLUDED
+#define HOST_CG_SENSE_SOLVER_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+#include "gpuNUFFT_operator.hpp"
+#include "host_toeplitz_operator.hpp"
+
+#include <vector>
+
+namespace gpuNUFFT
+{
+/**
+ * \brief Conjugate gradient SENSE reconstruction
+ *
+ * Solves the regularized normal equations
+ *
+ * (A^H A + alpha I) x = A^H y
+ *
+ * with A = sqrt(D) F S, i.e. the forward gridding operation including the
+ * density compensation D and coil sensitivities S set on the operator, cf.
+ * Pruessmann et al., MRM 46:638-651 (2001) and matlab/demo/utils/cg_sense_2d.m.
+ *
+ * The operator is held for the whole lifetime of the solver and all buffers are
+ * allocated once at construction, thus repeated solves only pay for the
+ * operator applications. The vector updates of each iteration are fused into
+ * three multithreaded passes over the image, each computing the required inner
+ * product on the fly.
+ *
+ * A^H A is either evaluated by a forward and adjoint operation of the operator
+ * (any OperatorType, e.g. HOST) or by a HostToeplitzNormalOperator.
+ *
+ * @see HostToeplitzNormalOperator
+ */
+class HostCGSenseSolver
+{
+ public:
+  /** \brief Create solver for gpuNUFFTOp
+   *
+   * The operator is not owned by the solver and has to stay valid.
+   *
+   * @param gpuNUFFTOp    initialized operator
+   * @param alpha         Tikhonov regularization weight
+   * @param tolerance     relative residual norm at which iterations stop
+   * @param maxIterations maximum amount of CG iterations
+   */
+  HostCGSenseSolver(GpuNUFFTOperator *gpuNUFFTOp, DType alpha = 0.0,
+                    DType tolerance = 1e-6, int maxIterations = 10);
+
+  ~HostCGSenseSolver();
+
+  /** \brief Reconstruct an image from the k-space data
+   *
+   * Starts from x = 0.
+   *
+   * @param kspaceData k-space data, one channel per coil sensitivity
+   * @param imgData    preallocated image, imgDims
+   * @return amount of performed iterations
+   */
+  int solve(Array<DType2> kspaceData, Array<CufftType> &imgData);
+
+  /** \brief Reconstruct an image from the k-space data
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   */
+  Array<CufftType> solve(Array<DType2> kspaceData);
+
+  void setAlpha(DType alpha)
+  {
+    this->alpha = alpha;
+  }
+  DType getAlpha()
+  {
+    return alpha;
+  }
+
+  void setTolerance(DType tolerance)
+  {
+    this->tolerance = tolerance;
+  }
+  DType getTolerance()
+  {
+    return tolerance;
+  }
+
+  void setMaxIterations(int maxIterations)
+  {
+    this->maxIterations = maxIterations;
+  }
+  int getMaxIterations()
+  {
+    return maxIterations;
+  }
+
+  /** \brief Evaluate A^H A by a HostToeplitzNormalOperator
+   *
+   * The point spread function is computed on the first call with
+   * useToeplitz = true.
+   */
+  void setUseToeplitz(bool useToeplitz);
+
+  bool getUseToeplitz()
+  {
+    return useToeplitz;
+  }
+
+  /** \brief Iterations performed by the last solve */
+  int getIterationCount()
+  {
+    return iterationCount;
+  }
+
+  /** \brief Relative residual norm |r| / |A^H y| after the last solve */
+  double getResidualNorm()
+  {
+    return residualNorm;
+  }
+
+  /** \brief CG iterations per second of the last solve, without the initial
+   * adjoint operation */
+  double getIterationsPerSecond()
+  {
+    return iterationsPerSecond;
+  }
+
+ private:
+  HostCGSenseSolver(const HostCGSenseSolver &);
+  HostCGSenseSolver &operator=(const HostCGSenseSolver &);
+
+  /** \brief Ap = A^H A p without regularization */
+  void applyNormal(CufftType *p, CufftType *Ap);
+
+  GpuNUFFTOperator *gpuNUFFTOp;
+
+  DType alpha;
+  DType tolerance;
+  int maxIterations;
+
+  bool useToeplitz;
+  HostToeplitzNormalOperator *toeplitzOp;
+
+  Dimensions imgDims;
+  IndType dataCount;
+  IndType n_coils;
+
+  int iterationCount;
+  double residualNorm;
+  double iterationsPerSecond;
+
+  /** \brief Residual, search direction and A^H A p, imgDims each */
+  std::vector<CufftType> r;
+  std::vector<CufftType> p;
+  std::vector<CufftType> Ap;
+
+  /** \brief k-space data of all coils, dataCount * n_coils */
+  std::vector<CufftType> kspace;
+
+  /** \brief Per thread partial inner products */
+  std::vector<double> partialSums;
+};
+}
+
+#endif  // HOST_CG_SENSE_SOLVER_H_INCLUDED
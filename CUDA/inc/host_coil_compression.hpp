@@ -0,0 +1,100 @@
+#ifndef HOST_COIL_COMPRESSION_H_INCLUDED
+#define HOST_COIL_COMPRESSION_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+
+#include <vector>
+
+namespace gpuNUFFT
+{
+/**
+ * \brief PCA coil compression of multi channel data on the host (CPU)
+ *
+ * The calibration data X (samples x physical coils) is decomposed as
+ * X = U Sigma V^H, the K virtual coils are the projections onto the principal
+ * components belonging to the K largest singular values, cf. Huang et al.,
+ * MRI 26:133-141 (2008) and Buehrer et al., MRM 57:1131-1139 (2007):
+ *
+ * y'_k = sum_c A_kc y_c,  A = V_K^T
+ *
+ * A has orthonormal rows. Since gridding is linear in the channels the
+ * compressed sensitivities S'_k = sum_c A_kc S_c yield the adjoint
+ * sum_k conj(S'_k) F^H y'_k = S^H F^H A^H A y, i.e. the adjoint of the data
+ * projected onto the dominant channel subspace. For K equal to the physical
+ * coil count the result is exact.
+ *
+ * Each gridding operation runs on K instead of the physical coil count, the
+ * compression of data and sensitivities is a single multithreaded pass each.
+ *
+ * @see HostGpuNUFFTOperator::setCoilCompression
+ */
+class HostCoilCompression
+{
+ public:
+  /** \brief Compute the compression matrix from calibration data
+   *
+   * @param calibData    calibration data, e.g. the k-space center, one channel
+   *                     per physical coil in the layout of the k-space data
+   * @param virtualCoils amount of virtual coils K, 1 <= K <= physical coils
+   * @throws std::invalid_argument if K is out of range or no calibration
+   *         samples are passed
+   */
+  HostCoilCompression(Array<DType2> calibData, IndType virtualCoils);
+
+  IndType getPhysicalCoils()
+  {
+    return physicalCoils;
+  }
+
+  IndType getVirtualCoils()
+  {
+    return virtualCoils;
+  }
+
+  /** \brief Singular values of the calibration data in descending order, one
+   *per physical coil */
+  const std::vector<double> &getSingularValues()
+  {
+    return singularValues;
+  }
+
+  /** \brief Fraction of the calibration energy kept by the virtual coils,
+   *sum of the K largest squared singular values over the sum of all */
+  double getRetainedEnergy();
+
+  /** \brief Compression matrix A, virtualCoils x physicalCoils, row major */
+  const std::vector<DType2> &getCompressionMatrix()
+  {
+    return matrix;
+  }
+
+  /** \brief Compress multi channel data
+   *
+   * Applies A to each sample, i.e. each k-space sample or sensitivity map
+   * pixel. Does not allocate any memory.
+   *
+   * @param data       data, physical coil count channels
+   * @param compressed preallocated result, virtual coil count channels of the
+   *                   same length
+   * @throws std::invalid_argument if the channel counts do not match
+   */
+  void compress(Array<DType2> data, Array<DType2> &compressed);
+
+  /** \brief Compress multi channel data
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   */
+  Array<DType2> compress(Array<DType2> data);
+
+ private:
+  IndType physicalCoils;
+  IndType virtualCoils;
+
+  std::vector<double> singularValues;
+
+  std::vector<DType2> matrix;
+};
+}
+
+#endif  // HOST_COIL_COMPRESSION_H_INCLUDED
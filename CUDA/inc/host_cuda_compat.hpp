@@ -0,0 +1,131 @@
+#ifndef HOST_CUDA_COMPAT_HPP
+#define HOST_CUDA_COMPAT_HPP
+
+#include <cstddef>
+
+/**
+ * @file
+ * \brief Portable replacement of the CUDA and CUFFT declarations used by the
+ * core library in the host-only build (GPUNUFFT_HOST_ONLY).
+ *
+ * Provides the vector types, the function qualifiers and the subset of the
+ * runtime and CUFFT API referenced by the factory and the operator data
+ * model, so that the host backend compiles and links without the CUDA
+ * toolkit. The runtime functions report cudaErrorNoDevice, the GPU entry
+ * points throw std::runtime_error, see src/cpu/host_cuda_compat.cpp.
+ */
+
+#define __host__
+#define __device__
+#define __global__
+#define __shared__
+#define __constant__
+#define __inline__ inline
+
+/** \brief Host replacement of the CUDA float2 vector type */
+struct float2
+{
+  float x, y;
+};
+
+/** \brief Host replacement of the CUDA float3 vector type */
+struct float3
+{
+  float x, y, z;
+};
+
+/** \brief Host replacement of the CUDA double2 vector type */
+struct double2
+{
+  double x, y;
+};
+
+/** \brief Host replacement of the CUDA double3 vector type */
+struct double3
+{
+  double x, y, z;
+};
+
+/** \brief Host replacement of the CUDA launch configuration type */
+struct dim3
+{
+  unsigned int x, y, z;
+  dim3(unsigned int x = 1, unsigned int y = 1, unsigned int z = 1)
+    : x(x), y(y), z(z)
+  {
+  }
+};
+
+enum cudaError
+{
+  cudaSuccess = 0,
+  cudaErrorNoDevice = 100
+};
+typedef enum cudaError cudaError_t;
+
+enum cudaMemcpyKind
+{
+  cudaMemcpyHostToHost = 0,
+  cudaMemcpyHostToDevice = 1,
+  cudaMemcpyDeviceToHost = 2,
+  cudaMemcpyDeviceToDevice = 3
+};
+
+typedef struct CUevent_st *cudaEvent_t;
+struct cudaArray;
+
+/** \brief Device properties, only the members read by the library */
+struct cudaDeviceProp
+{
+  size_t totalGlobalMem;
+};
+
+cudaError_t cudaMalloc(void **devPtr, size_t size);
+template <typename T> cudaError_t cudaMalloc(T **devPtr, size_t size)
+{
+  return cudaMalloc((void **)devPtr, size);
+}
+cudaError_t cudaFree(void *devPtr);
+cudaError_t cudaMemcpy(void *dst, const void *src, size_t count,
+                       cudaMemcpyKind kind);
+cudaError_t cudaMemset(void *devPtr, int value, size_t count);
+const char *cudaGetErrorString(cudaError_t error);
+cudaError_t cudaGetLastError();
+cudaError_t cudaThreadSynchronize();
+cudaError_t cudaDeviceSynchronize();
+cudaError_t cudaEventCreate(cudaEvent_t *event);
+cudaError_t cudaEventRecord(cudaEvent_t event, int stream = 0);
+cudaError_t cudaEventSynchronize(cudaEvent_t event);
+cudaError_t cudaEventElapsedTime(float *ms, cudaEvent_t start, cudaEvent_t end);
+cudaError_t cudaMemGetInfo(size_t *free, size_t *total);
+cudaError_t cudaGetDeviceProperties(cudaDeviceProp *prop, int device);
+
+typedef float2 cufftComplex;
+typedef double2 cufftDoubleComplex;
+typedef int cufftHandle;
+
+enum cufftResult_t
+{
+  CUFFT_SUCCESS = 0,
+  CUFFT_SETUP_FAILED = 7
+};
+typedef enum cufftResult_t cufftResult;
+
+enum cufftType_t
+{
+  CUFFT_C2C = 0x29,
+  CUFFT_Z2Z = 0x69
+};
+
+#define CUFFT_FORWARD -1
+#define CUFFT_INVERSE 1
+
+cufftResult cufftPlan3d(cufftHandle *plan, int nx, int ny, int nz,
+                        cufftType_t type);
+cufftResult cufftDestroy(cufftHandle plan);
+cufftResult cufftExecC2C(cufftHandle plan, cufftComplex *idata,
+                         cufftComplex *odata, int direction);
+cufftResult cufftExecZ2Z(cufftHandle plan, cufftDoubleComplex *idata,
+                         cufftDoubleComplex *odata, int direction);
+
+#endif  // HOST_CUDA_COMPAT_HPP
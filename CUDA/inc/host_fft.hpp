@@ -0,0 +1,202 @@
+#ifndef HOST_FFT_H_INCLUDED
+#define HOST_FFT_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+#include <vector>
+
+/**
+ * @file
+ * \brief Complex FFT used by the host (CPU) gridding backend.
+ *
+ * Same conventions as the CUFFT calls of the GPU path: in-place, unnormalized,
+ * x as fastest running index.
+ */
+
+namespace gpuNUFFT
+{
+/** \brief Exponent sign of the host FFT, equal to CUFFT_FORWARD and
+ * CUFFT_INVERSE. */
+enum HostFFTDirection
+{
+  HOST_FFT_FORWARD = -1,
+  HOST_FFT_INVERSE = 1
+};
+
+/** \brief Lines of the separable transform skipped by HostFFTPlan, relative
+ * to the pruning region set by HostFFTPlan::setPruningRegion. */
+enum HostFFTPruning
+{
+  /** \brief Transform all lines */
+  HOST_FFT_NO_PRUNING,
+  /** \brief The input is zero outside of the pruning region */
+  HOST_FFT_PRUNE_INPUT,
+  /** \brief Only the output inside of the pruning region is needed, the
+   * remaining output is undefined */
+  HOST_FFT_PRUNE_OUTPUT
+};
+
+/** \brief One dimensional complex FFT of arbitrary length.
+ *
+ * Lengths which factorize into small primes are transformed by a mixed radix
+ * Cooley-Tukey scheme, all other lengths by Bluestein's chirp-z algorithm
+ * on a power of two length.
+ */
+class HostFFTPlan1D
+{
+ public:
+  HostFFTPlan1D(IndType n);
+
+  ~HostFFTPlan1D();
+
+  /** \brief Transform one contiguous line of getLength() elements in place.
+   *
+   * @param line    data to transform
+   * @param scratch buffer of at least getScratchSize() elements
+   * @param dir     transform direction
+   */
+  void execute(CufftType *line, CufftType *scratch,
+               HostFFTDirection dir) const;
+
+  /** \brief Transform length */
+  IndType getLength() const
+  {
+    return n;
+  }
+
+  /** \brief Amount of scratch elements needed by execute() */
+  IndType getScratchSize() const;
+
+ private:
+  HostFFTPlan1D(const HostFFTPlan1D &);
+  HostFFTPlan1D &operator=(const HostFFTPlan1D &);
+
+  void work(CufftType *out, const CufftType *in, IndType fstride,
+            const IndType *factors, CufftType *scratch, bool inverse) const;
+
+  void butterfly2(CufftType *out, IndType fstride, IndType m,
+                  bool inverse) const;
+  void butterfly4(CufftType *out, IndType fstride, IndType m,
+                  bool inverse) const;
+  void butterflyGeneric(CufftType *out, IndType fstride, IndType m,
+                        IndType p, CufftType *scratch, bool inverse) const;
+
+  void executeBluestein(CufftType *line, CufftType *scratch,
+                        bool inverse) const;
+
+  /** \brief Transform length */
+  IndType n;
+
+  /** \brief Radix/remaining length pairs of the mixed radix factorization */
+  std::vector<IndType> factors;
+
+  /** \brief Largest radix in factors */
+  IndType maxRadix;
+
+  /** \brief Forward twiddle factors exp(-2 pi i k / n) */
+  std::vector<CufftType> twiddles;
+
+  /** \brief Power of two sub plan used by Bluestein's algorithm, NULL for
+   * mixed radix lengths */
+  HostFFTPlan1D *bluesteinPlan;
+
+  /** \brief Forward chirp exp(-pi i k^2 / n) */
+  std::vector<CufftType> chirp;
+
+  /** \brief Transformed conjugate chirp for the forward and inverse
+   * direction */
+  std::vector<CufftType> chirpFFTForward, chirpFFTInverse;
+};
+
+/** \brief Separable 2-d or 3-d complex FFT on the host.
+ *
+ * The transform is computed axis by axis with one HostFFTPlan1D per axis.
+ * Lines along y and z are gathered into a contiguous buffer before the 1-d
+ * transform is applied. The lines of each axis are distributed over
+ * getHostThreadCount() threads, each using its own line and scratch buffer.
+ *
+ * Lines known to be zero or not needed are skipped if a pruning region is
+ * set, e.g. the zero padded image of the forward gridding (transformed x, y, z)
+ * or the cropped image of the adjoint gridding (transformed z, y, x). For an
+ * oversampling ratio of 2 in 3-d 7/12 of the line transforms remain.
+ */
+class HostFFTPlan
+{
+ public:
+  /** \brief Create plan for the grid dimensions (depth 0 for 2-d) */
+  HostFFTPlan(Dimensions gridDims);
+
+  ~HostFFTPlan();
+
+  /** \brief Transform one grid in place. */
+  void execute(CufftType *data, HostFFTDirection dir);
+
+  /** \brief Transform one grid in place, skipping the lines outside of the
+   * pruning region. */
+  void execute(CufftType *data, HostFFTDirection dir, HostFFTPruning pruning);
+
+  /** \brief Transform n_grids consecutive grids in place. */
+  void execute(CufftType *data, int n_grids, HostFFTDirection dir,
+               HostFFTPruning pruning = HOST_FFT_NO_PRUNING);
+
+  /** \brief Set the region used by pruned transforms.
+   *
+   * The region covers the indices (offset + i) % n, i < regionDims, of each
+   * axis of length n, i.e. it may wrap around the grid border. Entries of 0
+   * in regionDims cover the whole axis. Defaults to the whole grid.
+   *
+   * @throws std::invalid_argument if the region exceeds the grid
+   */
+  void setPruningRegion(IndType3 offset, Dimensions regionDims);
+
+  /** \brief Set regions of the same size but different offsets for pruned
+   *input (HOST_FFT_PRUNE_INPUT) and pruned output (HOST_FFT_PRUNE_OUTPUT)
+   *
+   * E.g. the image region of an odd grid lies at different offsets before
+   * and after the inverse FFT shift.
+   *
+   * @throws std::invalid_argument if the region exceeds the grid
+   */
+  void setPruningRegion(IndType3 inputOffset, IndType3 outputOffset,
+                        Dimensions regionDims);
+
+  Dimensions getGridDims()
+  {
+    return gridDims;
+  }
+
+ private:
+  HostFFTPlan(const HostFFTPlan &);
+  HostFFTPlan &operator=(const HostFFTPlan &);
+
+  Dimensions gridDims;
+
+  HostFFTPlan1D *planX;
+  HostFFTPlan1D *planY;
+  HostFFTPlan1D *planZ;
+
+  /** \brief Transform the lines of axis (0 x, 1 y, 2 z) in parallel
+   *
+   * The lines are enumerated by the indices of the two remaining axes, each
+   * limited to the pruning region at offsets if the respective flag is set.
+   */
+  void executeAxis(CufftType *data, int axis, bool pruneFirst,
+                   bool pruneSecond, const IndType *offsets,
+                   HostFFTDirection dir);
+
+  /** \brief Pruning regions, (offset + i) % n for i < count per axis, of
+   *the input and of the output */
+  IndType regionOffset[3];
+  IndType regionOutputOffset[3];
+  IndType regionCount[3];
+
+  /** \brief Elements of line buffer and scratch space of one thread */
+  IndType lineSize;
+  IndType scratchSize;
+
+  /** \brief Line buffer and scratch space shared by all axes, one pair per
+   * thread. Grown on demand if the thread count is increased. */
+  std::vector<CufftType> buffers;
+};
+}
+
+#endif  // HOST_FFT_H_INCLUDED
@@ -0,0 +1,281 @@
+#ifndef HOST_GPUNUFFT_KERNELS_H
+#define HOST_GPUNUFFT_KERNELS_H
+#include "gpuNUFFT_utils.hpp"
+#include "gpuNUFFT_types.hpp"
+
+#include <vector>
+
+/**
+ * @file
+ * \brief Host (CPU) implementations of the gridding steps
+ *
+ * Each function mirrors the GPU step of the same name in gpuNUFFT_kernels.hpp,
+ * including memory layout and the processing of gi_host->n_coils_cc coils at
+ * once, so that host and GPU operators yield identical results.
+ *
+ * @see HostGpuNUFFTOperator
+ */
+
+// ADJOINT Operations
+
+/**
+ * \brief Adjoint gridding convolution on the host.
+ *
+ * Samples are processed sector by sector, grid positions outside of the grid
+ * are wrapped to the opposite side like in the GPU kernels. If sectors holds
+ * all sectors of the grid, the planes of sectors along the slowest dimension
+ * are processed in phases, the planes of one phase are far enough apart to
+ * never write the same grid point and run in parallel. The phases depend on
+ * the grid only, the output is bit-reproducible for any thread count.
+ *
+ * @param data            sorted k-space sample data, n_coils_cc * data_count
+ * @param crds            sorted sample coordinates (x1,...,xn,y1,...,yn,z1,...)
+ * @param gdata           output grid, n_coils_cc * gridDims_count
+ * @param kernel          precomputed 1-d interpolation kernel lookup table,
+ *                        interpolated linearly if gi_host->interpolationType
+ *                        is TEXTURE_LOOKUP, nearest neighbor otherwise
+ * @param sectors         data-sector mapping
+ * @param sector_centers  sector centers (x,y,(z))
+ * @param gi_host         info struct with meta information
+ */
+void performHostConvolution(DType2 *data, DType *crds, CufftType *gdata,
+                            DType *kernel, IndType *sectors,
+                            IndType *sector_centers,
+                            gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/**
+ * \brief Tile lists of performHostGatherConvolution
+ *
+ * The grid is split into tiles of sector width, the list of a tile holds the
+ * sectors (holding samples) whose padded region reaches it, in ascending
+ * order. The lists depend on the sectors and the kernel extent only and can
+ * be reused by all adjoint operations on the same trajectory.
+ *
+ * @param tileOffsets     filled with the range [tileOffsets[t],
+ *                        tileOffsets[t + 1]) of tile t in tileSectors
+ * @param tileSectors     filled with the sectors reaching each tile
+ * @see performHostConvolution for the other parameters
+ */
+void buildHostGatherTiles(DType *kernel, IndType *sectors,
+                          IndType *sector_centers,
+                          gpuNUFFT::GpuNUFFTInfo *gi_host,
+                          std::vector<IndType> &tileOffsets,
+                          std::vector<IndType> &tileSectors);
+
+/**
+ * \brief Adjoint gridding convolution on the host, gathered per output tile.
+ *
+ * Yields the result of performHostConvolution without concurrent writes: each
+ * tile of buildHostGatherTiles is processed by one thread and gathers the
+ * contributions of the sectors in its list, in sector and sample order. Every
+ * grid point thus accumulates its contributions in the same order independent
+ * of the thread count, and the output is bit-reproducible.
+ *
+ * @param tileOffsets     tile ranges of buildHostGatherTiles
+ * @param tileSectors     tile lists of buildHostGatherTiles
+ * @param firstSector     first sector to convolve
+ * @param lastSector      end of the sectors to convolve, the sectors of the
+ *                        lists outside of [firstSector, lastSector) are
+ *                        skipped
+ * @see performHostConvolution for the other parameters
+ */
+void performHostGatherConvolution(DType2 *data, DType *crds, CufftType *gdata,
+                                  DType *kernel, IndType *sectors,
+                                  IndType *sector_centers,
+                                  gpuNUFFT::GpuNUFFTInfo *gi_host,
+                                  const std::vector<IndType> &tileOffsets,
+                                  const std::vector<IndType> &tileSectors,
+                                  IndType firstSector, IndType lastSector);
+
+/**
+ * \brief Forward gridding convolution on the host.
+ *
+ * Resamples the grid onto the (sorted) sample positions.
+ *
+ * @param data            output k-space sample data, n_coils_cc * data_count
+ * @param crds            sorted sample coordinates
+ * @param gdata           input grid, n_coils_cc * gridDims_count
+ * @param kernel          precomputed 1-d interpolation kernel lookup table,
+ *                        interpolated linearly if gi_host->interpolationType
+ *                        is TEXTURE_LOOKUP, nearest neighbor otherwise
+ * @param sectors         data-sector mapping
+ * @param sector_centers  sector centers (x,y,(z))
+ * @param gi_host         info struct with meta information
+ */
+void performHostForwardConvolution(CufftType *data, DType *crds,
+                                   CufftType *gdata, DType *kernel,
+                                   IndType *sectors, IndType *sector_centers,
+                                   gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/**
+ * \brief Forward convolution with the derivatives of the samples with respect
+ * to their coordinates, host implementation
+ *
+ * Computes the result of performHostForwardConvolution and dy/dk_x, dy/dk_y
+ * (and dy/dk_z) in the same pass over the sectors, each grid value is read
+ * once for the sample and all derivatives.
+ *
+ * @param data              output k-space sample data, n_coils_cc *
+ *                          data_count
+ * @param gradient          output derivatives, dimension major, n_coils_cc *
+ *                          data_count per dimension
+ * @param crds              sorted sample coordinates
+ * @param gdata             input grid, n_coils_cc * gridDims_count
+ * @param kernel            kernel lookup table(s) of the forward convolution
+ * @param kernelDerivative  derivative table(s) of load1DKernelDerivative,
+ *                          per-axis tables at gi_host->kernel_offset_axis
+ * @param sectors           data-sector mapping
+ * @param sector_centers    sector centers (x,y,(z))
+ * @param gi_host           info struct with meta information
+ */
+void performHostForwardConvolutionGradient(
+    CufftType *data, CufftType *gradient, DType *crds, CufftType *gdata,
+    DType *kernel, DType *kernelDerivative, IndType *sectors,
+    IndType *sector_centers, gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/**
+ * \brief Circular shift of n_coils_cc grids, in place.
+ *
+ * INVERSE shifts by floor(dim/2), FORWARD by ceil(dim/2) per dimension.
+ */
+void performHostFFTShift(CufftType *gdata, gpuNUFFT::FFTShiftDir shift_dir,
+                         gpuNUFFT::Dimensions gridDims,
+                         gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/** \brief Offset of the image region in the oversampled grid after the
+ * inverse FFT shift.
+ *
+ * The region, wrapping around the grid border, holds the non-zero input of
+ * the forward FFT after performHostPadding, see
+ * HostFFTPlan::setPruningRegion.
+ */
+IndType3 computeHostShiftedImageOffset(gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/** \brief Offset of the image region in the output of the adjoint FFT,
+ * i.e. before the inverse FFT shift which precedes performHostCrop.
+ *
+ * Equals computeHostShiftedImageOffset on even grid dimensions and differs
+ * by one on odd ones.
+ */
+IndType3 computeHostAdjointImageOffset(gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/** \brief Crop the center (image size) of n_coils_cc oversampled grids */
+void performHostCrop(CufftType *gdata, CufftType *imdata,
+                     gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/** \brief Check whether performHostFusedCrop and performHostFusedPadding
+ * can replace the FFT shifts, i.e. all grid dimensions are even */
+bool isHostFusedImagePassSupported(gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/**
+ * \brief Crop, FFT scaling, deapodization and coil sensitivity
+ * multiplication of n_coils_cc grids in a single pass.
+ *
+ * Replaces the inverse FFT shifts before and after the inverse FFT: for even
+ * grid dimensions n shift(FFT(shift(g)))[k] equals (-1)^(k + n/2) times
+ * FFT(g)[(k + n/2) % n] per dimension, thus the grids are read at the shifted
+ * positions and the checkerboard sign is folded into the deapodization
+ * factor. Each grid element inside of the image region is read once, each
+ * image element written once.
+ *
+ * @param gdata      inverse transformed grids, not shifted
+ * @param imdata     output images, n_coils_cc * im_width_dim, unused if sens
+ *                   is given
+ * @param deapo      deapodization function, NULL to skip
+ * @param sens       coil sensitivities of the n_coils_cc coils, NULL to skip,
+ *                   the conjugate products are added to imdata_sum
+ * @param imdata_sum coil combined image
+ * @param gi_host    info struct with meta information
+ */
+void performHostFusedCrop(CufftType *gdata, CufftType *imdata, DType *deapo,
+                          DType2 *sens, CufftType *imdata_sum,
+                          gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/**
+ * \brief Crop, FFT scaling, deapodization and coil sensitivity
+ * multiplication of a box of the image region of n_coils_cc grids.
+ *
+ * Same as performHostFusedCrop (or performHostCrop followed by the image
+ * space steps for shifted grids) restricted to the box, only the grid
+ * elements inside of the box are read.
+ *
+ * @param gdata       inverse transformed grids
+ * @param roidata     output boxes, n_coils_cc * box size, unused if sens is
+ *                    given
+ * @param deapo       deapodization function of the whole image, NULL to skip
+ * @param sens        coil sensitivities of the n_coils_cc coils (whole image),
+ *                    NULL to skip, the conjugate products are added to
+ *                    roidata_sum
+ * @param roidata_sum coil combined box
+ * @param roiOffset   image index of the first box element
+ * @param roiDims     box dimensions, depth ignored for 2-d processing
+ * @param shifted     gdata was shifted by performHostFFTShift before and after
+ *                    the FFT, otherwise the grid dimensions have to be even
+ * @param gi_host     info struct with meta information
+ */
+void performHostRegionCrop(CufftType *gdata, CufftType *roidata, DType *deapo,
+                           DType2 *sens, CufftType *roidata_sum,
+                           IndType3 roiOffset, gpuNUFFT::Dimensions roiDims,
+                           bool shifted, gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/** \brief Scale N * n_coils_cc elements by 1/sqrt(im_width_dim) */
+void performHostFFTScaling(CufftType *data, int N,
+                           gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/** \brief Multiply n_coils_cc images with the precomputed deapodization
+ * function */
+void performHostDeapodization(CufftType *imdata, DType *deapo,
+                              gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/** \brief Multiply n_coils_cc images with the coil sensitivities or their
+ * complex conjugate */
+void performHostSensMul(CufftType *imdata, DType2 *sens,
+                        gpuNUFFT::GpuNUFFTInfo *gi_host, bool conjugate);
+
+/** \brief Add n_coils_cc images to imdata_sum */
+void performHostSensSum(CufftType *imdata, CufftType *imdata_sum,
+                        gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/** \brief Multiply n_coils_cc sample sets with sqrt of the density
+ * compensation */
+void performHostDensityCompensation(DType2 *data, DType *density_comp,
+                                    gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+// FORWARD Operations
+
+/** \brief Zero pad n_coils_cc images into the center of the oversampled grids.
+ *
+ * gdata is expected to be zeroed.
+ */
+void performHostPadding(DType2 *imdata, CufftType *gdata,
+                        gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+/**
+ * \brief Coil sensitivity multiplication, deapodization and zero padding of
+ * n_coils_cc images in a single pass.
+ *
+ * Mirror of performHostFusedCrop, the images are written to the shifted grid
+ * positions with the checkerboard sign, so that the forward FFT of gdata
+ * needs no FFT shifts. gdata is expected to be zeroed.
+ *
+ * @param imdata  one image if sens is given, n_coils_cc images otherwise
+ * @param gdata   output grids, n_coils_cc * gridDims_count
+ * @param deapo   deapodization function
+ * @param sens    coil sensitivities of the n_coils_cc coils, NULL to skip
+ * @param gi_host info struct with meta information
+ */
+void performHostFusedPadding(DType2 *imdata, CufftType *gdata, DType *deapo,
+                             DType2 *sens, gpuNUFFT::GpuNUFFTInfo *gi_host);
+
+// Ordering
+
+/** \brief Gather k-space data in sector order, see selectOrderedGPU */
+void selectOrderedHost(DType2 *data, IndType *data_indices,
+                       DType2 *data_sorted, int N, int n_coils_cc);
+
+/** \brief Scatter sector ordered data back to input order, see
+ * writeOrderedGPU */
+void writeOrderedHost(DType2 *data_sorted, IndType *data_indices,
+                      CufftType *data, int N, int n_coils_cc);
+
+#endif  // HOST_GPUNUFFT_KERNELS_H
@@ -0,0 +1,654 @@
+#ifndef HOST_GPUNUFFT_OPERATOR_H_INCLUDED
+#define HOST_GPUNUFFT_OPERATOR_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+#include "gpuNUFFT_operator.hpp"
+#include "gpuNUFFT_mapped_input.hpp"
+#include "host_gpuNUFFT_workspace.hpp"
+#include "host_coil_compression.hpp"
+
+namespace gpuNUFFT
+{
+/**
+ * \brief GpuNUFFTOperator executing all gridding steps on the host (CPU)
+ *
+ * Uses the same precomputed sector mapping, kernel lookup table and
+ * deapodization function as the GPU operators and yields the same results
+ * within floating point accuracy. No CUDA device is required at runtime.
+ *
+ * All intermediate buffers and the FFT plan are kept in a
+ * gpuNUFFT::HostGpuNUFFTWorkspace. Operations either use an explicitly passed
+ * workspace or the internal one of the operator, which is created on first use
+ * and reused by all subsequent calls.
+ *
+ * In addition to the Array based interface the adjoint operation can be fed
+ * from a gpuNUFFT::MappedInputSource, which only keeps the currently processed
+ * coils (and the next batch, read ahead) resident.
+ *
+ * @see GpuNUFFTOperatorFactory::setUseHostBackend
+ */
+class HostGpuNUFFTOperator : public GpuNUFFTOperator
+{
+ public:
+  HostGpuNUFFTOperator(IndType kernelWidth, IndType sectorWidth, DType osf,
+                       Dimensions imgDims, bool matlabSharedMem = false)
+    : GpuNUFFTOperator(kernelWidth, sectorWidth, osf, imgDims, true, HOST,
+                       matlabSharedMem),
+      coilBatchSize(1), workspace(NULL), linearInterpolation(false),
+      gatherConvolution(false), shardProcesses(1), gridPlaneOffset(0),
+      gridPlaneCount(0), kernelDerivative(NULL),
+      coilCompression(NULL), compressedData(NULL), compressedDataCount(0)
+  {
+    for (int d = 0; d < 3; d++)
+      axisKernels[d] = NULL;
+  }
+
+  ~HostGpuNUFFTOperator()
+  {
+    delete workspace;
+    releaseAxisKernels();
+    free(kernelDerivative);
+    free(virtualSens.data);
+    free(compressedData);
+  }
+
+  virtual OperatorType getType()
+  {
+    return gpuNUFFT::HOST;
+  }
+
+  /** \brief Create workspace for this operator
+   *
+   * Has to be called after the operator is completely initialized, i.e. after
+   * creation by the GpuNUFFTOperatorFactory. The returned workspace has to be
+   * deleted by the caller.
+   *
+   * @param coilBatchSize amount of coils processed at once
+   */
+  HostGpuNUFFTWorkspace *createWorkspace(int coilBatchSize = 1);
+
+  /** \brief Set coil batch size of the internal workspace */
+  void setCoilBatchSize(int coilBatchSize);
+
+  int getCoilBatchSize()
+  {
+    return coilBatchSize;
+  }
+
+  /** \brief Select linear interpolation of the kernel lookup table and reload
+   *the table.
+   *
+   * Instead of the nearest neighbor lookup in a table of
+   * calculateGrid3KernelSize entries, the kernel value is interpolated
+   * linearly between the neighboring entries of the compact table of
+   * calculateKernelSizeLinInt entries (e.g. 45 instead of 682 entries for
+   * kernel width 3 and osf 2), which stays resident in the L1 cache.
+   */
+  void setLinearKernelInterpolation(bool linearInterpolation);
+
+  /** \brief Set an independent kernel width per dimension and reload the
+   *lookup tables.
+   *
+   * E.g. thin slab or stack-of-spirals data use a narrow kernel along the short
+   * axis, the amount of grid points touched per sample drops accordingly. Each
+   * dimension uses its own lookup table, the sectors are padded by the width
+   * of the respective dimension. Entries of 0 keep the current kernel width,
+   * the kernel width of the operator (getKernelWidth) becomes the largest of
+   * the widths.
+   *
+   * The deapodization function has to match the widths, thus they are usually
+   * set by GpuNUFFTOperatorFactory::setKernelWidths.
+   *
+   * @throws std::invalid_argument if a width exceeds twice the sector width
+   */
+  void setKernelWidths(Dimensions kernelWidths);
+
+  bool getLinearKernelInterpolation()
+  {
+    return linearInterpolation;
+  }
+
+  /** \brief Select the gather (output driven) adjoint convolution
+   *
+   * Instead of scattering sample by sample into the grid, the grid is split
+   * into tiles which gather the samples of the overlapping sectors in a fixed
+   * order, see performHostGatherConvolution. The tiles are processed in
+   * parallel without concurrent writes, and the adjoint output is bit
+   * identical for any thread count and executor.
+   */
+  void setGatherConvolution(bool gatherConvolution)
+  {
+    this->gatherConvolution = gatherConvolution;
+  }
+
+  bool getGatherConvolution()
+  {
+    return gatherConvolution;
+  }
+
+  /** \brief Shard the adjoint convolution over local processes
+   *
+   * The sectors are split into shardProcesses contiguous ranges holding about
+   * the same amount of samples. Each range is gridded by its own process into
+   * a private grid, the grids are summed by a tree reduction over POSIX shared
+   * memory before the FFT, see hostShardedGridding. This spreads very large
+   * 3-D problems over the memory bandwidth of several processes, e.g. on
+   * different NUMA nodes, of one machine. The sum of the shards differs from
+   * the single process convolution by rounding only and is reproducible for a
+   * fixed amount of processes.
+   *
+   * @param shardProcesses amount of processes, 1 disables sharding
+   * @throws std::invalid_argument if shardProcesses is not in
+   *         [1, HOST_SHARD_MAX_PROCESSES]
+   */
+  void setShardProcessCount(int shardProcesses);
+
+  int getShardProcessCount()
+  {
+    return shardProcesses;
+  }
+
+  /** \brief Restrict the grids to count planes along the slowest dimension
+   *(z in 3-d, y in 2-d) from plane offset on, wrapping around the grid
+   *
+   * The convolution of samples whose kernels only reach these planes, e.g.
+   * those of one slab of a HostPartitionedOperator, needs grids of
+   * getConvolutionGridDims() only. Grid plane offset + n is held by plane n
+   * of the grids. Operations performing the FFT need the full grid.
+   *
+   * @throws std::invalid_argument if count is 0 or exceeds the planes of the
+   *         grid or offset is not a plane of the grid
+   */
+  void setGridPlanes(IndType offset, IndType count);
+
+  /** \brief First grid plane held by the grids, see setGridPlanes */
+  IndType getGridPlaneOffset()
+  {
+    return gridPlaneOffset;
+  }
+
+  /** \brief Dimensions of the grids of the convolution, getGridDims()
+   *unless restricted by setGridPlanes */
+  Dimensions getConvolutionGridDims();
+
+  /** \brief Grid the virtual coils of a coil compression instead of the
+   *physical coils
+   *
+   * The sensitivities set on the operator are compressed once and replaced by
+   * the virtual coil sensitivities, thus the compression has to be set after
+   * setSens. The adjoint operation using the internal workspace compresses
+   * k-space data of the physical coil count on the fly. All other operations,
+   * i.e. those with an explicit workspace, the forward operation and the
+   * mapped input, work on data of the virtual coil count, which is compressed
+   * once by HostCoilCompression::compress, e.g. ahead of an iterative
+   * reconstruction. Without sensitivities the adjoint yields the virtual coil
+   * images.
+   *
+   * @param compression coil compression, not owned, NULL restores the
+   *                    physical coils
+   * @throws std::invalid_argument if the sensitivity channels do not match
+   *         the physical coil count of the compression
+   */
+  void setCoilCompression(HostCoilCompression *compression);
+
+  HostCoilCompression *getCoilCompression()
+  {
+    return coilCompression;
+  }
+
+  using GpuNUFFTOperator::performGpuNUFFTAdj;
+  using GpuNUFFTOperator::performForwardGpuNUFFT;
+
+  /** \brief Perform adjoint gridding operation on the host using the internal
+   *workspace
+   *
+   * @see GpuNUFFTOperator::performGpuNUFFTAdj
+   */
+  virtual void performGpuNUFFTAdj(Array<DType2> kspaceData,
+                                  Array<CufftType> &imgData,
+                                  GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Perform adjoint gridding operation on the host
+   *
+   * Does not allocate any memory.
+   *
+   * @param kspaceData  k-space data
+   * @param imgData     preallocated image data array
+   * @param ws          workspace created by createWorkspace
+   * @param gpuNUFFTOut Stop gridding operation after gpuNUFFT::GpuNUFFTOutput
+   * @throws std::invalid_argument if imgData does not match the output
+   */
+  void performGpuNUFFTAdj(Array<DType2> kspaceData, Array<CufftType> &imgData,
+                          HostGpuNUFFTWorkspace &ws,
+                          GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Perform adjoint gridding operation on the host for a box
+   *(region of interest) of the image only
+   *
+   * The inverse FFT skips all lines that do not intersect the box, crop, FFT
+   * scaling, deapodization and the sensitivity combination process the box
+   * only. The result equals the box cropped from the result of the full
+   * adjoint operation. Does not allocate any memory.
+   *
+   * @param kspaceData k-space data
+   * @param roiData    preallocated box images, one channel if sensitivities
+   *                   are present, otherwise one per coil
+   * @param roiOffset  image index of the first box element
+   * @param roiDims    box dimensions, depth ignored for 2-d images
+   * @param ws         workspace created by createWorkspace
+   * @throws std::invalid_argument if the box exceeds the image or roiData
+   *         does not match the box
+   */
+  void performGpuNUFFTAdj(Array<DType2> kspaceData, Array<CufftType> &roiData,
+                          IndType3 roiOffset, Dimensions roiDims,
+                          HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Perform adjoint gridding operation for a box of the image using
+   *the internal workspace
+   */
+  void performGpuNUFFTAdj(Array<DType2> kspaceData, Array<CufftType> &roiData,
+                          IndType3 roiOffset, Dimensions roiDims);
+
+  /** \brief Perform adjoint gridding operation for a box of the image
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   */
+  Array<CufftType> performGpuNUFFTAdj(Array<DType2> kspaceData,
+                                      IndType3 roiOffset, Dimensions roiDims);
+
+  /** \brief Perform adjoint gridding operation on a subset of the samples
+   *
+   * Only the selected samples are gridded, e.g. for ordered subsets or
+   * stochastic solvers, without creating an operator per subset. The sorted
+   * order and the sample ranges of the sectors holding selected samples are
+   * derived per call in O(M log M) for M selected samples, sectors without
+   * selected samples are skipped. The result equals the adjoint operation of
+   * all samples with the unselected samples set to zero.
+   *
+   * @param kspaceData    k-space data of the selected samples, M per coil in
+   *                      the order of sampleIndices
+   * @param imgData       preallocated image data array
+   * @param sampleIndices strictly ascending trajectory indices of the
+   *                      selected samples, see createSampleIndices
+   * @param ws            workspace created by createWorkspace
+   * @throws std::invalid_argument if the indices are not strictly ascending,
+   *         exceed the trajectory or do not match kspaceData
+   */
+  void performGpuNUFFTAdj(Array<DType2> kspaceData, Array<CufftType> &imgData,
+                          Array<IndType> sampleIndices,
+                          HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Perform adjoint gridding operation on a subset of the samples
+   *using the internal workspace */
+  void performGpuNUFFTAdj(Array<DType2> kspaceData, Array<CufftType> &imgData,
+                          Array<IndType> sampleIndices);
+
+  /** \brief Perform adjoint gridding operation on a subset of the samples
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   */
+  Array<CufftType> performGpuNUFFTAdj(Array<DType2> kspaceData,
+                                      Array<IndType> sampleIndices);
+
+  /** \brief Not supported by the host operator
+   *
+   * @throws std::runtime_error
+   */
+  virtual void performGpuNUFFTAdj(GpuArray<DType2> kspaceData_gpu,
+                                  GpuArray<CufftType> &imgData_gpu,
+                                  GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Perform adjoint gridding operation on memory mapped k-space data
+   *
+   * The coils are processed batch by batch. The next coil batch is prefetched
+   * while the current one is gridded, processed coils are released again.
+   *
+   * @param input       mapped input, sample count has to match the operator
+   * @param imgData     preallocated image data array
+   * @param gpuNUFFTOut Stop gridding operation after gpuNUFFT::GpuNUFFTOutput
+   */
+  void performGpuNUFFTAdj(MappedInputSource &input, Array<CufftType> &imgData,
+                          GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Perform adjoint gridding operation on memory mapped k-space data
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   */
+  Array<CufftType> performGpuNUFFTAdj(MappedInputSource &input,
+                                      GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Perform forward gridding operation on the host using the internal
+   *workspace
+   *
+   * @see GpuNUFFTOperator::performForwardGpuNUFFT
+   */
+  virtual void
+  performForwardGpuNUFFT(Array<DType2> imgData, Array<CufftType> &kspaceData,
+                         GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Perform forward gridding operation on the host
+   *
+   * Does not allocate any memory.
+   *
+   * @param imgData     image data
+   * @param kspaceData  preallocated k-space data array
+   * @param ws          workspace created by createWorkspace
+   * @param gpuNUFFTOut Stop gridding operation after gpuNUFFT::GpuNUFFTOutput
+   */
+  void performForwardGpuNUFFT(Array<DType2> imgData,
+                              Array<CufftType> &kspaceData,
+                              HostGpuNUFFTWorkspace &ws,
+                              GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Perform forward gridding operation on a subset of the samples
+   *
+   * Only the selected samples are computed, see the adjoint subset operation.
+   *
+   * @param imgData       image data
+   * @param kspaceData    preallocated k-space data of the selected samples,
+   *                      M per coil in the order of sampleIndices
+   * @param sampleIndices strictly ascending trajectory indices of the
+   *                      selected samples
+   * @param ws            workspace created by createWorkspace
+   * @throws std::invalid_argument if the indices are not strictly ascending,
+   *         exceed the trajectory or do not match kspaceData
+   */
+  void performForwardGpuNUFFT(Array<DType2> imgData,
+                              Array<CufftType> &kspaceData,
+                              Array<IndType> sampleIndices,
+                              HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Perform forward gridding operation on a subset of the samples
+   *using the internal workspace */
+  void performForwardGpuNUFFT(Array<DType2> imgData,
+                              Array<CufftType> &kspaceData,
+                              Array<IndType> sampleIndices);
+
+  /** \brief Perform forward gridding operation on a subset of the samples
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   */
+  Array<CufftType> performForwardGpuNUFFT(Array<DType2> imgData,
+                                          Array<IndType> sampleIndices);
+
+  /** \brief Perform forward gridding operation and compute the derivatives of
+   *the samples with respect to the trajectory
+   *
+   * Yields the samples y of the forward operation and dy/dk_x, dy/dk_y (and
+   * dy/dk_z) of each sample, e.g. for trajectory optimization or motion
+   * estimation. The derivatives stem from the derivative of the kernel lookup
+   * table and are computed in the same pass over the sectors as the samples,
+   * each grid value is read once. The derivative tables are built by the first
+   * gradient operation. The density compensation is treated as constant.
+   * Does not allocate any memory after the first call.
+   *
+   * @param imgData        image data
+   * @param kspaceData     preallocated k-space data array
+   * @param kspaceGradient preallocated derivatives, dimension major, i.e.
+   *                       the k-space data layout repeated for x, y (and z)
+   * @param ws             workspace created by createWorkspace
+   * @throws std::invalid_argument if kspaceGradient does not match
+   *         kspaceData
+   */
+  void performForwardGpuNUFFTGradient(Array<DType2> imgData,
+                                      Array<CufftType> &kspaceData,
+                                      Array<CufftType> &kspaceGradient,
+                                      HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Perform forward gridding operation and compute the derivatives of
+   *the samples with respect to the trajectory using the internal workspace */
+  void performForwardGpuNUFFTGradient(Array<DType2> imgData,
+                                      Array<CufftType> &kspaceData,
+                                      Array<CufftType> &kspaceGradient);
+
+  /** \brief Perform the steps of the adjoint operation after the
+   *convolution on oversampled grids
+   *
+   * Together with the CONVOLUTION output of performGpuNUFFTAdj this allows
+   * the convolution to be performed elsewhere, e.g. by the backends of a
+   * HostPartitionedOperator, with one FFT for all of them.
+   *
+   * @param gridData    grids, getGridDims() per coil
+   * @param imgData     preallocated output as of performGpuNUFFTAdj
+   * @param gpuNUFFTOut last step, CONVOLUTION copies the grids
+   * @throws std::invalid_argument if the grids do not match the operator
+   */
+  void performGpuNUFFTAdjFromGrid(Array<CufftType> gridData,
+                                  Array<CufftType> &imgData,
+                                  GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Perform the steps of the forward operation before the
+   *convolution, i.e. the oversampled grids of the image
+   *
+   * @param imgData  image, one channel if sensitivities are present,
+   *                 otherwise one per coil
+   * @param gridData preallocated grids, getGridDims() per coil
+   * @throws std::invalid_argument if the grids do not match the operator
+   */
+  void performForwardGpuNUFFTToGrid(Array<DType2> imgData,
+                                    Array<CufftType> &gridData);
+
+  /** \brief Perform the convolution of the forward operation on oversampled
+   *grids, e.g. those of performForwardGpuNUFFTToGrid
+   *
+   * @param gridData   grids, getConvolutionGridDims() per coil
+   * @param kspaceData preallocated k-space data
+   * @throws std::invalid_argument if the arrays do not match the operator
+   */
+  void performForwardGpuNUFFTFromGrid(Array<CufftType> gridData,
+                                      Array<CufftType> &kspaceData);
+
+  /** \brief Trajectory indices of the non-zero entries of a sample mask
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   *
+   * @param mask one entry per trajectory sample
+   */
+  static Array<IndType> createSampleIndices(Array<unsigned char> mask);
+
+  /** \brief Not supported by the host operator
+   *
+   * @throws std::runtime_error
+   */
+  virtual void
+  performForwardGpuNUFFT(GpuArray<DType2> imgData_gpu,
+                         GpuArray<CufftType> &kspaceData_gpu,
+                         GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+ protected:
+  /** \brief Return internal workspace, (re)created if the problem or the coil
+   *batch size changed */
+  HostGpuNUFFTWorkspace &getWorkspace();
+
+  /** \brief Check that the workspace was created for this problem
+   *
+   * @throws std::invalid_argument
+   */
+  void validateWorkspace(HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Check that the grids hold all planes, as needed by the FFT
+   *
+   * @throws std::invalid_argument if restricted by setGridPlanes
+   */
+  void validateFullGrid();
+
+  /** \brief Default lookup table size of the selected interpolation */
+  IndType getDefaultKernelLookupTableSize();
+
+  /** \brief Reload the kernel lookup table(s), invalidates the internal
+   *workspace since it holds the table dependent meta information */
+  void initKernel();
+
+  /** \brief Lookup table size of a kernel of the given width */
+  IndType getKernelLookupTableSize(IndType kernelWidth);
+
+  /** \brief Kernel table passed to the convolution, per-axis tables are
+   *passed by GpuNUFFTInfo::kernel_table_axis of the workspace */
+  DType *getConvolutionKernel()
+  {
+    return this->kernel.data;
+  }
+
+  /** \brief Derivative tables matching the convolution kernel, built on
+   *first use */
+  DType *getConvolutionKernelDerivative();
+
+ private:
+  /** \brief Release the per-axis lookup tables to the cache */
+  void releaseAxisKernels();
+
+  /** \brief Trajectory, sector and ordering arrays of the gridded samples,
+   *either all samples or a subset */
+  struct SampleSelection
+  {
+    DType *crds;
+    DType *dens;
+    /** \brief Sample ranges of the sectors, sector_count + 1 entries */
+    IndType *sectors;
+    IndType *sectorCenters;
+    /** \brief Input index of each sorted sample */
+    IndType *indices;
+    int data_count;
+    int sector_count;
+  };
+
+  /** \brief Selection of all samples of the trajectory */
+  SampleSelection selectAllSamples();
+
+  /** \brief Derive the selection of a subset in the buffers of ws
+   *
+   * @throws std::invalid_argument if the indices are not strictly ascending
+   *         or exceed the trajectory
+   */
+  SampleSelection selectSamples(Array<IndType> sampleIndices,
+                                HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Meta information of ws restricted to the selected samples */
+  GpuNUFFTInfo getSelectionInfo(const SampleSelection &samples,
+                                HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Sort, density compensation and convolution of the selected
+   *samples of the current coil batch into the grids of the workspace */
+  void gridCoils(DType2 *kspaceCoils, const SampleSelection &samples,
+                 HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Build the gather tiles of the selected samples in ws unless ws
+   *holds those of all samples of this operator already */
+  void updateGatherTiles(const SampleSelection &samples, GpuNUFFTInfo *gi_host,
+                         HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Convolution of the selected samples by shardProcesses processes
+   *into the zeroed grids of the workspace */
+  void shardConvolution(DType2 *data_sorted, const SampleSelection &samples,
+                        GpuNUFFTInfo *gi_host, HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Adjoint gridding of the current coil batch starting at coil_it
+   *
+   * Writes CONVOLUTION and FFT results as well as per coil images directly
+   * to imgData, accumulates into the coil sum if sensitivities are present.
+   */
+  void adjointCoils(DType2 *kspaceCoils, int coil_it,
+                    Array<CufftType> &imgData, GpuNUFFTOutput gpuNUFFTOut,
+                    const SampleSelection &samples,
+                    HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Steps of the adjoint after the convolution of the current coil
+   *batch, from the grids of the workspace to FFT or DEAPODIZATION output */
+  void gridToImage(int coil_it, Array<CufftType> &imgData,
+                   GpuNUFFTOutput gpuNUFFTOut, unsigned long long sampleCount,
+                   HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Steps of the forward operation before the convolution of the
+   *current coil batch, from the image to the grids of the workspace */
+  void imageToGrid(Array<DType2> imgData, int coil_it,
+                   unsigned long long sampleCount, HostGpuNUFFTWorkspace &ws);
+
+  /** \brief Forward gridding of all coils of the selected samples
+   *
+   * Computes the derivatives with respect to the trajectory as well if
+   * kspaceGradient is not NULL. The convolution reads the grids of gridData
+   * (gridDims per coil) instead of the transformed image if not NULL.
+   */
+  void forwardCoils(Array<DType2> imgData, Array<CufftType> &kspaceData,
+                    Array<CufftType> *kspaceGradient,
+                    const SampleSelection &samples,
+                    HostGpuNUFFTWorkspace &ws, CufftType *gridData = NULL);
+
+  /** \brief Compress k-space data of the physical coil count to the virtual
+   *coils of the coil compression, otherwise kspaceData is returned */
+  Array<DType2> compressCoils(Array<DType2> kspaceData);
+
+  /** \brief Check the preallocated output of the adjoint operation
+   *
+   * @throws std::invalid_argument if imgData does not match the layout of
+   *         initAdjointOutput
+   */
+  void validateAdjointOutput(IndType n_coils, GpuNUFFTOutput gpuNUFFTOut,
+                             Array<CufftType> &imgData);
+
+  /** \brief Init output array for the adjoint operation */
+  Array<CufftType> initAdjointOutput(IndType n_coils,
+                                     GpuNUFFTOutput gpuNUFFTOut);
+
+  /** \brief Amount of coils processed at once by the internal workspace */
+  int coilBatchSize;
+
+  /** \brief Internal workspace, NULL until first use */
+  HostGpuNUFFTWorkspace *workspace;
+
+  /** \brief Flag to indicate linear interpolation of the kernel table */
+  bool linearInterpolation;
+
+  /** \brief Flag to indicate the gather adjoint convolution */
+  bool gatherConvolution;
+
+  /** \brief Amount of processes of the adjoint convolution */
+  int shardProcesses;
+
+  /** \brief Planes of the grids along the slowest dimension, see
+   *setGridPlanes, 0 for all planes */
+  IndType gridPlaneOffset;
+  IndType gridPlaneCount;
+
+  /** \brief Lookup tables of the x, y and z dimension acquired from
+   *KernelLookupTableCache in case of per-axis kernel widths, NULL otherwise */
+  const DType *axisKernels[3];
+
+  /** \brief Entries of the per-axis lookup tables */
+  IndType axisKernelCounts[3];
+
+  /** \brief Derivative tables of load1DKernelDerivative, the per-axis
+   *tables concatenated, NULL until the first gradient operation */
+  DType *kernelDerivative;
+
+  /** \brief Check that data of n_coils channels can be gridded
+   *
+   * @throws std::invalid_argument if a coil compression is set and n_coils
+   *         differs from its virtual coil count
+   */
+  void validateCoilCount(IndType n_coils);
+
+  /** \brief Coil compression, not owned, NULL if the physical coils are
+   *gridded */
+  HostCoilCompression *coilCompression;
+
+  /** \brief Sensitivities set before the coil compression */
+  Array<DType2> physicalSens;
+
+  /** \brief Compressed sensitivities, owned */
+  Array<DType2> virtualSens;
+
+  /** \brief Compressed k-space data of the internal workspace adjoint */
+  DType2 *compressedData;
+
+  /** \brief Allocated elements of compressedData */
+  IndType compressedDataCount;
+};
+}
+
+#endif  // HOST_GPUNUFFT_OPERATOR_H_INCLUDED
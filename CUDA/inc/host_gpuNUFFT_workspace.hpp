@@ -0,0 +1,107 @@
+#ifndef HOST_GPUNUFFT_WORKSPACE_H_INCLUDED
+#define HOST_GPUNUFFT_WORKSPACE_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+#include "host_fft.hpp"
+#include "host_process_shards.hpp"
+
+#include <vector>
+
+namespace gpuNUFFT
+{
+class HostGpuNUFFTOperator;
+
+/**
+ * \brief Intermediate buffers and FFT plan of the host gridding steps
+ *
+ * A workspace is created once per operator and coil batch size by
+ * HostGpuNUFFTOperator::createWorkspace and can be reused for any number of
+ * adjoint and forward operations. Operations executed with a workspace do not
+ * allocate memory, thus repeated calls, e.g. in iterative reconstructions, only
+ * pay for the gridding steps themselves. Only the buffers of the sample subset
+ * operations grow on demand, i.e. with the first and with larger subsets, as
+ * well as the derivative buffer of the first trajectory gradient operation and
+ * the tile lists of the gather adjoint convolution, built once per trajectory
+ * and per subset operation, and the shared memory of the sharded adjoint
+ * convolution.
+ *
+ * A workspace must not be used by two operations concurrently.
+ *
+ * @see HostGpuNUFFTOperator
+ */
+class HostGpuNUFFTWorkspace
+{
+ public:
+  ~HostGpuNUFFTWorkspace();
+
+  /** \brief Amount of coils processed at once */
+  int getCoilBatchSize()
+  {
+    return coilBatchSize;
+  }
+
+  /** \brief Total size of the intermediate buffers in bytes */
+  size_t getAllocatedBytes();
+
+  friend class HostGpuNUFFTOperator;
+
+ private:
+  /** \brief Create workspace, takes ownership of gi_host */
+  HostGpuNUFFTWorkspace(GpuNUFFTInfo *gi_host, Dimensions gridDims,
+                        int coilBatchSize);
+
+  HostGpuNUFFTWorkspace(const HostGpuNUFFTWorkspace &);
+  HostGpuNUFFTWorkspace &operator=(const HostGpuNUFFTWorkspace &);
+
+  /** \brief Set amount of coils of the current batch */
+  void setConcurrentCoilCount(int n_coils_cc);
+
+  int coilBatchSize;
+
+  /** \brief Meta information, n_coils_cc is set per coil batch */
+  GpuNUFFTInfo *gi_host;
+
+  HostFFTPlan fftPlan;
+
+  /** \brief Sorted k-space samples, data_count * coilBatchSize */
+  DType2 *data_sorted;
+  /** \brief Oversampled grids, gridDims_count * coilBatchSize */
+  CufftType *gdata;
+  /** \brief Coil images, imgDims_count * coilBatchSize */
+  CufftType *imdata;
+  /** \brief Coil combined image, imgDims_count */
+  CufftType *imdata_sum;
+
+  /** \brief Sorted position of each trajectory sample, filled by the first
+   *subset operation */
+  std::vector<IndType> sortedPositions;
+  /** \brief Samples of the current subset operation in sorted order, index
+   *into the subset data */
+  std::vector<IndType> subsetIndices;
+  /** \brief Coordinates (planar) and density of the subset samples */
+  std::vector<DType> subsetCrds;
+  std::vector<DType> subsetDens;
+  /** \brief Sample ranges and centers of the sectors holding subset samples */
+  std::vector<IndType> subsetSectors;
+  std::vector<IndType> subsetSectorCenters;
+
+  /** \brief Derivatives of the gradient operation in sorted order, grown by
+   *the first call */
+  std::vector<CufftType> gradientSorted;
+
+  /** \brief Tiles of the gather adjoint convolution, see
+   *buildHostGatherTiles */
+  std::vector<IndType> gatherTileOffsets;
+  std::vector<IndType> gatherTileSectors;
+  /** \brief Sector data the tiles were built for, NULL if they are not
+   *reusable, i.e. built for a sample subset */
+  const IndType *gatherTileKey;
+
+  /** \brief First sector of each shard of the sharded adjoint convolution */
+  std::vector<IndType> shardSectors;
+  /** \brief Grids of the shards 1.. of the sharded adjoint convolution */
+  HostSharedMemory shardSlabs;
+};
+}
+
+#endif  // HOST_GPUNUFFT_WORKSPACE_H_INCLUDED
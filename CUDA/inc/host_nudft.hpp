@@ -0,0 +1,74 @@
+#ifndef HOST_NUDFT_H_INCLUDED
+#define HOST_NUDFT_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+
+/**
+ * @file
+ * \brief Exact non-uniform discrete Fourier transform on the host (CPU)
+ *
+ * Evaluates the sums approximated by the gridding operators directly, i.e.
+ * without interpolation kernel, oversampled grid and deapodization, using the
+ * same conventions as the operators:
+ *
+ * forward (type 2): data_j = 1/sqrt(N) sum_x img(x) exp(-2 pi i k_j (x - n/2))
+ *
+ * adjoint (type 1): img(x) = 1/sqrt(N) sum_j data_j exp(2 pi i k_j (x - n/2))
+ *
+ * with k_j in [-0.5,0.5) per dimension, x the image index, n/2 = floor(n/2)
+ * the image center per dimension and N the image size.
+ *
+ * The cost is O(N * data_count) per coil, which makes the direct evaluation an
+ * accuracy reference for the gridding operators. It is only faster than
+ * gridding for a few samples, see HOST_NUDFT_CROSSOVER_SAMPLES. The separable
+ * exponentials are generated per axis by complex recurrences (re-seeded
+ * periodically) instead of evaluating sin and cos per term, samples are
+ * processed in blocks sharing these tables, accumulation is performed in double
+ * precision and the work is distributed by hostParallelFor.
+ *
+ * @see HostNUDFTOperator
+ */
+
+/** \brief Sample count up to which the exact NUDFT is faster than gridding
+ *
+ * Measured for the adjoint and forward operation of HostNUDFTOperator and
+ * HostGpuNUFFTOperator (kernel width 3, osf 2, one thread, images of 8^2 to
+ * 64^2 and 8^3 to 32^3 pixels, gpuNUFFT_accuracy_bench): the NUDFT is faster
+ * for up to 32 samples on all sizes and breaks even at 64 to 128 samples,
+ * almost independent of the image size, since the NUDFT grows with samples
+ * times pixels and gridding with the FFT of the oversampled grid. At 256
+ * samples the NUDFT is 2-4 times slower. The creation of a NUDFT operator is
+ * cheaper in any case, it needs no deapodization.
+ */
+#define HOST_NUDFT_CROSSOVER_SAMPLES 32
+
+namespace gpuNUFFT
+{
+/** \brief Adjoint (type 1) NUDFT of n_coils coils
+ *
+ * @param data       k-space data, n_coils * dataCount, coil-major
+ * @param crds       sample coordinates (x1,...,xn,y1,...,yn,z1,...)
+ * @param dataCount  amount of samples
+ * @param n_coils    amount of coils
+ * @param imgDims    image dimensions, depth 0 for 2-d
+ * @param imgData    output images, n_coils * imgDims.count()
+ */
+void performHostNUDFTAdj(const DType2 *data, const DType *crds,
+                         IndType dataCount, IndType n_coils,
+                         const Dimensions &imgDims, CufftType *imgData);
+
+/** \brief Forward (type 2) NUDFT of n_coils coils
+ *
+ * @param imgData    images, n_coils * imgDims.count()
+ * @param crds       sample coordinates (x1,...,xn,y1,...,yn,z1,...)
+ * @param dataCount  amount of samples
+ * @param n_coils    amount of coils
+ * @param imgDims    image dimensions, depth 0 for 2-d
+ * @param data       output k-space data, n_coils * dataCount, coil-major
+ */
+void performHostNUDFTForward(const DType2 *imgData, const DType *crds,
+                             IndType dataCount, IndType n_coils,
+                             const Dimensions &imgDims, CufftType *data);
+}
+
+#endif  // HOST_NUDFT_H_INCLUDED
@@ -0,0 +1,95 @@
+#ifndef HOST_NUDFT_OPERATOR_H_INCLUDED
+#define HOST_NUDFT_OPERATOR_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+#include "gpuNUFFT_operator.hpp"
+
+namespace gpuNUFFT
+{
+/**
+ * \brief GpuNUFFTOperator evaluating the exact NUDFT on the host (CPU)
+ *
+ * Applies density compensation and coil sensitivities like the gridding
+ * operators but replaces convolution, FFT and deapodization by the direct
+ * evaluation of performHostNUDFTAdj and performHostNUDFTForward. The result is
+ * exact up to floating point accuracy and independent of kernel width,
+ * oversampling factor and lookup table size.
+ *
+ * Since the cost grows with the product of sample count and image size, this
+ * operator is only faster than gridding for up to HOST_NUDFT_CROSSOVER_SAMPLES
+ * samples, e.g. navigators, where the FFT of the oversampled grid dominates
+ * gridding. The factory skips the deapodization of these operators. Otherwise
+ * it serves as accuracy reference. Intermediate results of the adjoint
+ * operation (CONVOLUTION, FFT) are not available.
+ *
+ * The profiler stage PROFILE_CONVOLUTION covers the NUDFT, PROFILE_SORT the
+ * reordering including density compensation.
+ *
+ * @see GpuNUFFTOperatorFactory::setUseHostNUDFT
+ */
+class HostNUDFTOperator : public GpuNUFFTOperator
+{
+ public:
+  HostNUDFTOperator(IndType kernelWidth, IndType sectorWidth, DType osf,
+                    Dimensions imgDims, bool matlabSharedMem = false)
+    : GpuNUFFTOperator(kernelWidth, sectorWidth, osf, imgDims, false,
+                       HOST_NUDFT, matlabSharedMem)
+  {
+  }
+
+  ~HostNUDFTOperator()
+  {
+  }
+
+  virtual OperatorType getType()
+  {
+    return gpuNUFFT::HOST_NUDFT;
+  }
+
+  using GpuNUFFTOperator::performGpuNUFFTAdj;
+  using GpuNUFFTOperator::performForwardGpuNUFFT;
+
+  /** \brief Perform adjoint NUDFT on the host
+   *
+   * @throws std::invalid_argument if gpuNUFFTOut is not DEAPODIZATION
+   * @see GpuNUFFTOperator::performGpuNUFFTAdj
+   */
+  virtual void performGpuNUFFTAdj(Array<DType2> kspaceData,
+                                  Array<CufftType> &imgData,
+                                  GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Not supported by the host operator
+   *
+   * @throws std::runtime_error
+   */
+  virtual void performGpuNUFFTAdj(GpuArray<DType2> kspaceData_gpu,
+                                  GpuArray<CufftType> &imgData_gpu,
+                                  GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Perform forward NUDFT on the host
+   *
+   * @see GpuNUFFTOperator::performForwardGpuNUFFT
+   */
+  virtual void
+  performForwardGpuNUFFT(Array<DType2> imgData, Array<CufftType> &kspaceData,
+                         GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Not supported by the host operator
+   *
+   * @throws std::runtime_error
+   */
+  virtual void
+  performForwardGpuNUFFT(GpuArray<DType2> imgData_gpu,
+                         GpuArray<CufftType> &kspaceData_gpu,
+                         GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+ private:
+  /** \brief Check that only the final output is requested
+   *
+   * @throws std::invalid_argument
+   */
+  void validateOutput(GpuNUFFTOutput gpuNUFFTOut);
+};
+}
+
+#endif  // HOST_NUDFT_OPERATOR_H_INCLUDED
@@ -0,0 +1,186 @@
+#ifndef HOST_PARALLEL_H_INCLUDED
+#define HOST_PARALLEL_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+
+#include <exception>
+
+/**
+ * @file
+ * \brief Parallel loop and thread pool used by the host (CPU) backend and the
+ * host stages of the operator factory.
+ */
+
+/** \brief Upper limit of the worker threads of a HostThreadPool */
+#define HOST_THREAD_POOL_MAX_WORKERS 256
+
+namespace gpuNUFFT
+{
+struct HostThreadPoolState;
+
+/** \brief Loop body executed by hostParallelFor
+ *
+ * run() is called once per thread with a contiguous, non-empty index range.
+ * threadId is in [0, n_threads) and may be used to select per thread
+ * buffers.
+ */
+class HostParallelTask
+{
+ public:
+  virtual ~HostParallelTask()
+  {
+  }
+
+  virtual void run(IndType begin, IndType end, int threadId) = 0;
+};
+
+/** \brief Executes the index ranges of hostParallelFor
+ *
+ * All host stages schedule their loops through the executor set by
+ * setHostExecutor, thus a service running several operators concurrently can
+ * bound the total parallelism by one shared executor instead of each call
+ * spawning its own threads.
+ */
+class HostExecutor
+{
+ public:
+  virtual ~HostExecutor()
+  {
+  }
+
+  /** \brief Execute range r = 0..n_ranges-1 of [0, count), see getRange, as
+   *task.run(begin, end, r)
+   *
+   * Returns after all ranges are processed and rethrows the exception of the
+   * first failed range in the calling thread. Ranges are executed by
+   * runRange, n_ranges is in [2, count].
+   */
+  virtual void execute(IndType count, HostParallelTask &task,
+                       int n_ranges) = 0;
+
+  /** \brief Range r of [0, count) split into n_ranges equally sized ranges */
+  static void getRange(IndType count, int n_ranges, int r, IndType &begin,
+                       IndType &end);
+
+  /** \brief Execute range r of the task on the current thread, an exception
+   *is stored in error
+   *
+   * Loops started by the task, e.g. by an operator executed per range, run
+   * serially on the current thread.
+   */
+  static void runRange(HostParallelTask &task, IndType count, int n_ranges,
+                       int r, std::exception_ptr &error);
+};
+
+/**
+ * \brief Work-stealing thread pool
+ *
+ * Each worker owns a queue of ranges. A call distributes its ranges over the
+ * queues of the workers, executes the first range itself and helps with the
+ * queued ranges until all of its ranges are done. Idle workers steal ranges
+ * from the other queues, those of workers on the same NUMA node first. The
+ * amount of ranges of a call, i.e. the n_threads argument of hostParallelFor,
+ * limits its parallelism, the worker count bounds the parallelism of all
+ * concurrent calls to the workers plus the calling threads.
+ *
+ * Optionally each worker is pinned to the CPUs of one NUMA node, the nodes
+ * are assigned round robin. The topology is read from
+ * /sys/devices/system/node on Linux and restricted to the CPU affinity of the
+ * process, other systems and systems without that information are treated as
+ * one node and the workers are not pinned.
+ */
+class HostThreadPool : public HostExecutor
+{
+ public:
+  /** \brief Create pool and start the workers
+   *
+   * @param workerCount amount of worker threads, limited to
+   *                    HOST_THREAD_POOL_MAX_WORKERS
+   * @param pinWorkers  pin the workers to the CPUs of their NUMA node
+   */
+  HostThreadPool(int workerCount, bool pinWorkers = false);
+
+  /** \brief Stop the workers, no call may be in progress */
+  ~HostThreadPool();
+
+  void execute(IndType count, HostParallelTask &task, int n_ranges);
+
+  /** \brief Start additional workers up to workerCount, never stops workers
+   */
+  void reserveWorkers(int workerCount);
+
+  int getWorkerCount();
+
+  /** \brief Amount of NUMA nodes the workers are distributed over */
+  int getNodeCount();
+
+  /** \brief NUMA node of a worker */
+  int getWorkerNode(int worker);
+
+  bool getPinWorkers()
+  {
+    return pinWorkers;
+  }
+
+ private:
+  HostThreadPool(const HostThreadPool &);
+  HostThreadPool &operator=(const HostThreadPool &);
+
+  /** \brief Queues, workers and topology */
+  HostThreadPoolState *state;
+
+  bool pinWorkers;
+};
+
+/** \brief Set amount of threads used by the host backend
+ *
+ * The default executor starts workers up to n_threads - 1 on demand.
+ *
+ * @param n_threads thread count, 0 selects the hardware concurrency
+ */
+void setHostThreadCount(int n_threads);
+
+/** \brief Amount of threads used by the host backend, at least 1 */
+int getHostThreadCount();
+
+/** \brief Run all loops of this process on the calling thread
+ *
+ * Meant for a forked child process, which inherits neither the workers of
+ * the thread pool nor the state of its locks. Only sets a process local
+ * flag, no lock is taken and no thread is started.
+ */
+void setHostSerialProcess();
+
+/** \brief True if the calling thread executes a range of hostParallelFor */
+bool isInsideHostParallelFor();
+
+/** \brief Set the executor of all host stages
+ *
+ * @param executor executor, not owned, has to stay valid until it is
+ *                 replaced, NULL restores the default HostThreadPool
+ */
+void setHostExecutor(HostExecutor *executor);
+
+/** \brief Executor of all host stages, by default a process wide
+ * HostThreadPool with getHostThreadCount() - 1 unpinned workers */
+HostExecutor &getHostExecutor();
+
+/** \brief Split [0, count) into equally sized ranges and execute task on
+ * up to n_threads threads of the host executor, the calling thread included.
+ *
+ * Returns after all ranges are processed. An exception thrown by the task is
+ * rethrown in the calling thread. Loops started from within a task, e.g. by an
+ * operator executed per thread, and all loops of a process marked by
+ * setHostSerialProcess run serially on the calling thread.
+ *
+ * @param count     loop length
+ * @param task      loop body
+ * @param n_threads maximum amount of threads, i.e. ranges
+ */
+void hostParallelFor(IndType count, HostParallelTask &task, int n_threads);
+
+/** \brief hostParallelFor with getHostThreadCount() threads */
+void hostParallelFor(IndType count, HostParallelTask &task);
+}
+
+#endif  // HOST_PARALLEL_H_INCLUDED
@@ -0,0 +1,200 @@
+#ifndef HOST_PARTITIONED_OPERATOR_H_INCLUDED
+#define HOST_PARTITIONED_OPERATOR_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+#include "host_gpuNUFFT_operator.hpp"
+
+#include <vector>
+
+namespace gpuNUFFT
+{
+/**
+ * \brief Operator whose convolution is split over independent backends by
+ *spatially contiguous slabs of sectors, on the host (CPU)
+ *
+ * The sectors of the operator of all samples (the main operator) are split
+ * along the slowest grid dimension (z in 3-d, y in 2-d) into slabs of whole
+ * sector planes holding about the same amount of samples. The samples of
+ * each slab are gridded by their own backend operator, which owns a copy of
+ * its part of the trajectory, its sector mapping and its workspace, thus the
+ * backends share no state and run concurrently.
+ *
+ * The kernel of a sample in slab p only reaches the grid planes of the slab
+ * and a halo of getHalo() planes on both sides (wrapping around the grid),
+ * thus the grids of each backend hold these planes only, see
+ * HostGpuNUFFTOperator::setGridPlanes, and the backends have no
+ * deapodization function. The adjoint adds the backend grids into the grid
+ * of the main operator, which performs the FFT and the image steps once for
+ * all backends, see HostGpuNUFFTOperator::performGpuNUFFTAdjFromGrid. The
+ * forward operation transforms the image once and passes the slab and halo
+ * planes of the grid to each backend, which interpolates its samples, see
+ * HostGpuNUFFTOperator::performForwardGpuNUFFTFromGrid.
+ *
+ * If there are at least as many backends as threads, the backends are
+ * distributed over getHostThreadCount() threads of the host executor, which
+ * e.g. places them on the NUMA nodes of a pinned HostThreadPool. Otherwise
+ * the backends are processed one after another and each gridding step is
+ * parallelized instead.
+ *
+ * The result equals the one of the main operator up to rounding, the order
+ * of summation only depends on the partitioning.
+ *
+ * @see GpuNUFFTOperatorFactory::createPartitionedOperator
+ */
+class HostPartitionedOperator
+{
+ public:
+  /** \brief Create operator from the main operator and the backends
+   *
+   * Restricts the grids of each backend to the slab and halo planes.
+   *
+   * @param gpuNUFFTOp  host operator of all samples, may have sensitivities,
+   *                    owned
+   * @param backends    host operator of the samples of each slab without
+   *                    sensitivities, NULL for slabs without samples, owned
+   * @param slabSectors first sector plane of each slab and the plane count,
+   *                    partition count + 1 entries
+   * @throws std::invalid_argument if the slabs do not match the operators
+   */
+  HostPartitionedOperator(HostGpuNUFFTOperator *gpuNUFFTOp,
+                          const std::vector<HostGpuNUFFTOperator *> &backends,
+                          const std::vector<IndType> &slabSectors);
+
+  ~HostPartitionedOperator();
+
+  /** \brief Split the sectors of op into partitions slabs of about the
+   *same amount of samples
+   *
+   * @param op          operator of all samples
+   * @param partitions  amount of slabs
+   * @param slabSectors first sector plane of each slab and the plane count
+   * @param slabSamples first sorted sample of each slab and the sample count
+   * @throws std::invalid_argument if partitions is 0 or exceeds the amount
+   *         of sector planes
+   */
+  static void computeSlabs(HostGpuNUFFTOperator *op, IndType partitions,
+                           std::vector<IndType> &slabSectors,
+                           std::vector<IndType> &slabSamples);
+
+  /** \brief Perform adjoint operation
+   *
+   * Does not allocate any memory after the first call with the same coil
+   * count.
+   *
+   * @param kspaceData  k-space data
+   * @param imgData     preallocated output as of
+   *                    HostGpuNUFFTOperator::performGpuNUFFTAdj
+   * @param gpuNUFFTOut last step
+   * @throws std::invalid_argument if the data does not match the operator
+   */
+  void performGpuNUFFTAdj(Array<DType2> kspaceData, Array<CufftType> &imgData,
+                          GpuNUFFTOutput gpuNUFFTOut = DEAPODIZATION);
+
+  /** \brief Perform adjoint operation
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   */
+  Array<CufftType> performGpuNUFFTAdj(Array<DType2> kspaceData,
+                                      GpuNUFFTOutput gpuNUFFTOut =
+                                          DEAPODIZATION);
+
+  /** \brief Perform forward operation
+   *
+   * Does not allocate any memory after the first call with the same coil
+   * count.
+   *
+   * @param imgData    image, one channel if sensitivities are present,
+   *                   otherwise one per coil
+   * @param kspaceData preallocated k-space data
+   * @throws std::invalid_argument if the data does not match the operator
+   */
+  void performForwardGpuNUFFT(Array<DType2> imgData,
+                              Array<CufftType> &kspaceData);
+
+  /** \brief Perform forward operation
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually. The coil count is taken from the sensitivities or imgData.
+   */
+  Array<CufftType> performForwardGpuNUFFT(Array<DType2> imgData);
+
+  /** \brief Set coil batch size of the main operator and the backends */
+  void setCoilBatchSize(int coilBatchSize);
+
+  IndType getPartitionCount()
+  {
+    return (IndType)backends.size();
+  }
+
+  /** \brief Backend of slab p, NULL if the slab holds no samples */
+  HostGpuNUFFTOperator *getBackend(IndType p)
+  {
+    return backends[p];
+  }
+
+  /** \brief Grid planes [first, last) of slab p along the slowest
+   *dimension, without halo */
+  void getSlabPlanes(IndType p, IndType &first, IndType &last);
+
+  /** \brief Halo of each slab in grid planes, half the kernel width along
+   *the slowest dimension */
+  IndType getHalo()
+  {
+    return halo;
+  }
+
+  /** \brief Operator of all samples, performs the FFT and image steps */
+  HostGpuNUFFTOperator *getOperator()
+  {
+    return gpuNUFFTOp;
+  }
+
+ private:
+  HostPartitionedOperator(const HostPartitionedOperator &);
+  HostPartitionedOperator &operator=(const HostPartitionedOperator &);
+
+  /** \brief Check the k-space data and allocate the buffers of n_coils */
+  void prepare(IndType n_coils, IndType kspaceCount);
+
+  /** \brief Amount of threads processing backends concurrently */
+  int getBackendThreadCount();
+
+  HostGpuNUFFTOperator *gpuNUFFTOp;
+
+  std::vector<HostGpuNUFFTOperator *> backends;
+
+  /** \brief First sector plane of each slab, partition count + 1 entries */
+  std::vector<IndType> slabSectors;
+
+  /** \brief First sorted sample of each slab, partition count + 1 entries */
+  std::vector<IndType> slabSamples;
+
+  IndType halo;
+
+  /** \brief Grid planes along the slowest dimension and the elements of one
+   *plane */
+  IndType planeCount;
+  IndType planeSize;
+
+  /** \brief Grid planes of a sector plane */
+  IndType sectorWidth;
+
+  /** \brief First grid plane and plane count of the grids of each backend,
+   *0 planes for slabs without samples */
+  std::vector<IndType> gridOffsets;
+  std::vector<IndType> gridPlanes;
+
+  IndType coilCount;
+
+  /** \brief Grids of the main operator, gridDims per coil */
+  std::vector<CufftType> grid;
+
+  /** \brief Grids of each backend, gridPlanes per coil, and k-space data of
+   *each backend */
+  std::vector<std::vector<CufftType> > backendGrids;
+  std::vector<std::vector<DType2> > backendData;
+};
+}
+
+#endif  // HOST_PARTITIONED_OPERATOR_H_INCLUDED
@@ -0,0 +1,97 @@
+#ifndef HOST_PROCESS_SHARDS_H_INCLUDED
+#define HOST_PROCESS_SHARDS_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+
+#include <cstddef>
+
+/**
+ * @file
+ * \brief Gridding of sample shards by local worker processes, the grids of
+ * the shards are reduced over POSIX shared memory.
+ */
+
+/** \brief Upper limit of the processes of hostShardedGridding */
+#define HOST_SHARD_MAX_PROCESSES 64
+
+namespace gpuNUFFT
+{
+/** \brief Shared memory mapping inherited by forked processes
+ *
+ * The memory is a POSIX shared memory object which is unlinked right after
+ * it is mapped, thus it is released with the last mapping, also if a process
+ * terminates abnormally. The mapping only grows and is reused by subsequent
+ * calls.
+ */
+class HostSharedMemory
+{
+ public:
+  HostSharedMemory() : data(NULL), size(0)
+  {
+  }
+
+  ~HostSharedMemory();
+
+  /** \brief Map at least bytes of shared memory, the content is undefined
+   *
+   * @throws std::runtime_error if no shared memory can be mapped
+   */
+  void *reserve(size_t bytes);
+
+  /** \brief Mapped size in bytes */
+  size_t getSize()
+  {
+    return size;
+  }
+
+ private:
+  HostSharedMemory(const HostSharedMemory &);
+  HostSharedMemory &operator=(const HostSharedMemory &);
+
+  void *data;
+
+  size_t size;
+};
+
+/** \brief Gridding of one shard, executed by hostShardedGridding */
+class HostShardTask
+{
+ public:
+  virtual ~HostShardTask()
+  {
+  }
+
+  /** \brief Accumulate shard into slab, which is zeroed */
+  virtual void grid(int shard, CufftType *slab) = 0;
+};
+
+/** \brief Grid shards 0..n_shards-1 by n_shards processes and sum their
+ * slabs into grid
+ *
+ * The calling process grids shard 0 into grid, the other shards are gridded
+ * by forked processes into slabs of shared memory. The processes form a
+ * binary tree: each process forks the upper half of its shards, grids the
+ * lower half, waits for its child and adds the slab of the child into its
+ * own, i.e. the slabs are reduced in log2(n_shards) steps. The summation
+ * order only depends on n_shards.
+ *
+ * The forked processes run the host stages on one thread each and exit
+ * without returning, thus the task must not rely on side effects other than
+ * its slab. No loop of the host executor may be in progress on other
+ * threads. Called from within a loop of hostParallelFor, the shards are
+ * gridded one after the other by the calling process with the same
+ * summation order.
+ *
+ * @param n_shards  amount of shards and processes, 1 grids in process
+ * @param task      gridding of a shard
+ * @param grid      result, slabCount elements
+ * @param slabCount elements of a slab
+ * @param memory    shared memory of the slabs, grown on demand
+ * @throws std::runtime_error if a process fails or cannot access the shared
+ *         memory, the exception of the task in the calling process
+ */
+void hostShardedGridding(int n_shards, HostShardTask &task, CufftType *grid,
+                         IndType slabCount, HostSharedMemory &memory);
+}
+
+#endif  // HOST_PROCESS_SHARDS_H_INCLUDED
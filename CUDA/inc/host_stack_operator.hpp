@@ -0,0 +1,183 @@
+#ifndef HOST_STACK_OPERATOR_H_INCLUDED
+#define HOST_STACK_OPERATOR_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+#include "host_gpuNUFFT_operator.hpp"
+#include "host_fft.hpp"
+
+#include <vector>
+
+namespace gpuNUFFT
+{
+/**
+ * \brief Hybrid operator of stack-of-stars / stack-of-spirals data on the
+ *host (CPU)
+ *
+ * The samples lie on the same 2-d trajectory (kx,ky) in each of P partitions,
+ * which are Cartesian along kz, i.e. kz_p = (p - P/2) / P. Instead of a 3-d
+ * gridding operator with a 3-d sector assignment, a 3-d convolution and an
+ * oversampled 3-d FFT, the operator performs
+ *
+ * adjoint: 1-d IFFT along kz -> 2-d adjoint gridding of each partition
+ *
+ * forward: 2-d forward gridding of each partition -> 1-d FFT along kz
+ *
+ * without any oversampling along z. The 2-d gridding uses one shared
+ * HostGpuNUFFTOperator (the slice operator) created by the 2-d path of the
+ * GpuNUFFTOperatorFactory, the partitions are distributed over
+ * getHostThreadCount() threads, each with its own workspace. If there are less
+ * partitions than threads, the partitions are processed one after another and
+ * each gridding step is parallelized instead.
+ *
+ * The result equals the one of a 3-d operator on the stacked trajectory up to
+ * the gridding error in x and y, the transform along z is exact.
+ *
+ * Layouts (x fastest):
+ * - k-space data: coil, partition, sample of the 2-d trajectory
+ * - image data and sensitivities: coil, z, y, x
+ *
+ * If sensitivities are present the adjoint yields the coil combined image and
+ * the forward operation expects a single image, like GpuNUFFTOperator. The
+ * sensitivity array is not copied and has to stay valid.
+ *
+ * @see GpuNUFFTOperatorFactory::createStackOfStarsOperator
+ */
+class HostStackOfStarsOperator
+{
+ public:
+  /** \brief Create operator from a 2-d slice operator
+   *
+   * @param sliceOp    2-d host operator of the shared trajectory, owned
+   * @param partitions amount of Cartesian partitions P
+   * @param sensData   coil sensitivities, imgDims of the stack per coil, may
+   *                   be empty
+   * @throws std::invalid_argument if sliceOp is 3-d or has sensitivities or
+   *         if no partitions are passed
+   */
+  HostStackOfStarsOperator(HostGpuNUFFTOperator *sliceOp, IndType partitions,
+                           Array<DType2> sensData);
+
+  ~HostStackOfStarsOperator();
+
+  /** \brief Perform adjoint operation
+   *
+   * Does not allocate any memory after the first call with the same coil
+   * count.
+   *
+   * @param kspaceData k-space data, sample count * P per coil
+   * @param imgData    preallocated image, one channel if sensitivities are
+   *                   present, otherwise one per coil
+   * @throws std::invalid_argument if the data does not match the operator
+   */
+  void performGpuNUFFTAdj(Array<DType2> kspaceData, Array<CufftType> &imgData);
+
+  /** \brief Perform adjoint operation
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   */
+  Array<CufftType> performGpuNUFFTAdj(Array<DType2> kspaceData);
+
+  /** \brief Perform forward operation
+   *
+   * Does not allocate any memory after the first call with the same coil
+   * count.
+   *
+   * @param imgData    image, one channel if sensitivities are present,
+   *                   otherwise one per coil
+   * @param kspaceData preallocated k-space data, sample count * P per coil
+   * @throws std::invalid_argument if the data does not match the operator
+   */
+  void performForwardGpuNUFFT(Array<DType2> imgData,
+                              Array<CufftType> &kspaceData);
+
+  /** \brief Perform forward operation
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually. The coil count is taken from the sensitivities or imgData.
+   */
+  Array<CufftType> performForwardGpuNUFFT(Array<DType2> imgData);
+
+  /** \brief Set coil batch size of the workspaces of the slice operator */
+  void setCoilBatchSize(int coilBatchSize);
+
+  int getCoilBatchSize()
+  {
+    return coilBatchSize;
+  }
+
+  /** \brief Image dimensions, depth equal to the partition count */
+  Dimensions getImageDims()
+  {
+    return imgDims;
+  }
+
+  IndType getPartitionCount()
+  {
+    return partitions;
+  }
+
+  /** \brief Amount of samples of the 2-d trajectory, i.e. per partition */
+  IndType getSampleCount()
+  {
+    return sampleCount;
+  }
+
+  /** \brief 2-d operator shared by all partitions */
+  HostGpuNUFFTOperator *getSliceOperator()
+  {
+    return sliceOp;
+  }
+
+  bool applySensData()
+  {
+    return sens.data != NULL && sens.count() > 1;
+  }
+
+ private:
+  HostStackOfStarsOperator(const HostStackOfStarsOperator &);
+  HostStackOfStarsOperator &operator=(const HostStackOfStarsOperator &);
+
+  /** \brief Check coil count and sizes, allocate the buffers of n_coils
+   *coils and the workspaces of n_threads threads */
+  void prepare(IndType n_coils, IndType kspaceCount, IndType imgCount,
+               int n_threads);
+
+  /** \brief 1-d FFT of all kz lines from src to dst, dst layout either
+   *partition major (toHybrid) or coil major */
+  void transformPartitions(const DType2 *src, DType2 *dst, IndType n_coils,
+                           bool toHybrid, HostFFTDirection dir);
+
+  /** \brief Amount of threads processing partitions concurrently */
+  int getPartitionThreadCount();
+
+  HostGpuNUFFTOperator *sliceOp;
+
+  IndType partitions;
+
+  IndType sampleCount;
+
+  Dimensions imgDims;
+
+  /** \brief Coil sensitivities, not owned */
+  Array<DType2> sens;
+
+  int coilBatchSize;
+
+  HostFFTPlan1D zPlan;
+
+  /** \brief One workspace of the slice operator per partition thread */
+  std::vector<HostGpuNUFFTWorkspace *> workspaces;
+
+  /** \brief Data after the transform along kz, partition, coil, sample */
+  std::vector<DType2> hybridData;
+
+  /** \brief Coil images of one partition per partition thread */
+  std::vector<DType2> coilImages;
+
+  /** \brief Line and scratch buffers of the kz transform per thread */
+  std::vector<CufftType> lineBuffers;
+};
+}
+
+#endif  // HOST_STACK_OPERATOR_H_INCLUDED
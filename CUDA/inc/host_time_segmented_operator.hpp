@@ -0,0 +1,181 @@
+#ifndef HOST_TIME_SEGMENTED_OPERATOR_H_INCLUDED
+#define HOST_TIME_SEGMENTED_OPERATOR_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+#include "host_gpuNUFFT_operator.hpp"
+
+#include <vector>
+
+/** \brief Amount of histogram bins of the field map used to fit the
+ * time segmentation interpolators */
+#define HOST_TIME_SEGMENT_HISTOGRAM_BINS 64
+
+namespace gpuNUFFT
+{
+/**
+ * \brief Off-resonance corrected operator by time segmentation on the host
+ *(CPU)
+ *
+ * Models the signal of long readouts, e.g. spirals, in the presence of an
+ * off-resonance field map w(x) (rad/s) and the readout time t_j (s) of each
+ * sample:
+ *
+ * y_j = 1/sqrt(N) sum_x S(x) img(x) exp(-i w(x) t_j) exp(-2 pi i k_j x)
+ *
+ * The time dependent phase is approximated by L segments at the times tau_l
+ * spread evenly over the readout,
+ *
+ * exp(-i w t_j) ~ sum_l b_jl exp(-i w tau_l),
+ *
+ * with the least squares interpolators b_jl over a histogram of the field map,
+ * cf. Sutton et al., IEEE TMI 22:178-188 (2003). Forward and adjoint then
+ * consist of L NUFFTs weighted by b_jl in k-space and exp(-+i w tau_l) in
+ * image space:
+ *
+ * y = sum_l diag(b_l) F (exp(-i w tau_l) S img)
+ *
+ * All segments share one HostGpuNUFFTOperator, i.e. one sort, sector mapping,
+ * kernel lookup table and deapodization function. The L segments of a coil
+ * are passed to the operator as L channels and processed in batches like
+ * coils, by default all at once, thus the per segment overhead is limited to
+ * the convolution and the FFT.
+ *
+ * The field map and sensitivity arrays are not copied and have to stay valid.
+ *
+ * @see GpuNUFFTOperatorFactory::createTimeSegmentedOperator
+ */
+class HostTimeSegmentedOperator
+{
+ public:
+  /** \brief Compute the segmentation of the readout
+   *
+   * @param gpuNUFFTOp   host operator of the trajectory without
+   *                     sensitivities, owned
+   * @param sensData     coil sensitivities, may be empty
+   * @param fieldMap     off-resonance in rad/s, image dimensions
+   * @param readoutTimes readout time in s of each sample, trajectory order
+   * @param segments     amount of time segments L
+   * @throws std::invalid_argument if the arrays do not match the operator,
+   *         the operator has sensitivities or no segment is requested
+   */
+  HostTimeSegmentedOperator(HostGpuNUFFTOperator *gpuNUFFTOp,
+                            Array<DType2> sensData, Array<DType> fieldMap,
+                            Array<DType> readoutTimes, IndType segments);
+
+  ~HostTimeSegmentedOperator();
+
+  /** \brief Perform adjoint operation
+   *
+   * Does not allocate any memory after the first call.
+   *
+   * @param kspaceData k-space data
+   * @param imgData    preallocated image, one channel if sensitivities are
+   *                   present, otherwise one per coil
+   * @throws std::invalid_argument if the data does not match the operator
+   */
+  void performGpuNUFFTAdj(Array<DType2> kspaceData, Array<CufftType> &imgData);
+
+  /** \brief Perform adjoint operation
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   */
+  Array<CufftType> performGpuNUFFTAdj(Array<DType2> kspaceData);
+
+  /** \brief Perform forward operation
+   *
+   * Does not allocate any memory after the first call.
+   *
+   * @param imgData    image, one channel if sensitivities are present,
+   *                   otherwise one per coil
+   * @param kspaceData preallocated k-space data
+   * @throws std::invalid_argument if the data does not match the operator
+   */
+  void performForwardGpuNUFFT(Array<DType2> imgData,
+                              Array<CufftType> &kspaceData);
+
+  /** \brief Perform forward operation
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   */
+  Array<CufftType> performForwardGpuNUFFT(Array<DType2> imgData);
+
+  IndType getSegmentCount()
+  {
+    return segments;
+  }
+
+  /** \brief Segment times tau_l in s */
+  const std::vector<double> &getSegmentTimes()
+  {
+    return segmentTimes;
+  }
+
+  /** \brief Interpolators b_jl, segment major, trajectory order */
+  const std::vector<DType2> &getInterpolators()
+  {
+    return interpolators;
+  }
+
+  /** \brief Largest relative RMS error of the approximation of
+   *exp(-i w t_j) over the field map histogram among all samples */
+  double getInterpolationError()
+  {
+    return interpolationError;
+  }
+
+  /** \brief Operator shared by the segments, e.g. to select the coil
+   *(segment) batch size */
+  HostGpuNUFFTOperator *getOperator()
+  {
+    return gpuNUFFTOp;
+  }
+
+  bool applySensData()
+  {
+    return sens.data != NULL && sens.count() > 1;
+  }
+
+ private:
+  HostTimeSegmentedOperator(const HostTimeSegmentedOperator &);
+  HostTimeSegmentedOperator &operator=(const HostTimeSegmentedOperator &);
+
+  /** \brief Fit the interpolators to the field map histogram */
+  void initInterpolators(Array<DType> readoutTimes);
+
+  /** \brief Check sizes of k-space and image data of n_coils coils */
+  void validate(IndType n_coils, IndType kspaceCount, IndType imgCount);
+
+  HostGpuNUFFTOperator *gpuNUFFTOp;
+
+  IndType segments;
+
+  IndType sampleCount;
+
+  Dimensions imgDims;
+
+  /** \brief Coil sensitivities, not owned */
+  Array<DType2> sens;
+
+  /** \brief Field map, not owned */
+  Array<DType> fieldMap;
+
+  std::vector<double> segmentTimes;
+
+  std::vector<DType2> interpolators;
+
+  /** \brief exp(i w tau_l) per segment and pixel */
+  std::vector<DType2> phases;
+
+  double interpolationError;
+
+  /** \brief Weighted k-space data of the segments of one coil */
+  std::vector<DType2> segmentData;
+
+  /** \brief Images of the segments of one coil */
+  std::vector<DType2> segmentImages;
+};
+}
+
+#endif  // HOST_TIME_SEGMENTED_OPERATOR_H_INCLUDED
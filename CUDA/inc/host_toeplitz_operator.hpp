@@ -0,0 +1,106 @@
+#ifndef HOST_TOEPLITZ_OPERATOR_H_INCLUDED
+#define HOST_TOEPLITZ_OPERATOR_H_INCLUDED
+
+#include "gpuNUFFT_types.hpp"
+#include "gpuNUFFT_operator.hpp"
+#include "host_fft.hpp"
+
+namespace gpuNUFFT
+{
+/**
+ * \brief Normal operator A^H A of a GpuNUFFTOperator evaluated by FFTs on the
+ *host (CPU)
+ *
+ * For a fixed trajectory and density compensation the composition of forward
+ * and adjoint gridding is a convolution of the image with the point spread
+ * function (PSF) of the sampling pattern. The PSF is computed once on a grid
+ * of twice the image size by one adjoint operation of a unit k-space signal.
+ * Afterwards each application only consists of
+ *
+ * pad -> FFT -> multiplication with the transformed PSF -> IFFT -> crop
+ *
+ * per coil, i.e. no gridding convolution has to be performed, which makes it
+ * well suited for iterative reconstructions like CG-SENSE. If coil
+ * sensitivities are set on the operator the result is
+ * sum_c conj(S_c) * A^H A (S_c * x).
+ *
+ * The trajectory, density compensation and sensitivity data are read from the
+ * operator at construction time. The sensitivity array is not copied and has
+ * to stay valid.
+ *
+ * @see GpuNUFFTOperatorFactory
+ */
+class HostToeplitzNormalOperator
+{
+ public:
+  /** \brief Precompute the PSF of gpuNUFFTOp
+   *
+   * gpuNUFFTOp may be of any OperatorType, the PSF is computed by a temporary
+   * host operator using the same kernel width, sector width and oversampling
+   * factor.
+   */
+  HostToeplitzNormalOperator(GpuNUFFTOperator *gpuNUFFTOp);
+
+  ~HostToeplitzNormalOperator();
+
+  /** \brief Apply the normal operator
+   *
+   * Does not allocate any memory.
+   *
+   * @param imgData image, imgDims
+   * @param outData preallocated result, imgDims
+   */
+  void apply(Array<DType2> imgData, Array<CufftType> &outData);
+
+  /** \brief Apply the normal operator
+   *
+   * The memory for the output array is allocated automatically but has to be
+   *freed manually.
+   */
+  Array<CufftType> apply(Array<DType2> imgData);
+
+  Dimensions getImageDims()
+  {
+    return imgDims;
+  }
+
+  /** \brief Dimensions of the zero padded grid, twice the image dimensions */
+  Dimensions getPaddedDims()
+  {
+    return padDims;
+  }
+
+  /** \brief Total size of the PSF and intermediate buffers in bytes */
+  size_t getAllocatedBytes();
+
+ private:
+  HostToeplitzNormalOperator(const HostToeplitzNormalOperator &);
+  HostToeplitzNormalOperator &operator=(const HostToeplitzNormalOperator &);
+
+  /** \brief Compute the transformed PSF kernel_fft */
+  void initKernel(GpuNUFFTOperator *gpuNUFFTOp);
+
+  /** \brief Convolve x with the PSF, result accumulated into out
+   *
+   * If sensData is not NULL x is multiplied by sensData before and the result
+   * by its conjugate after the convolution.
+   */
+  void convolve(DType2 *x, DType2 *sensData, CufftType *out);
+
+  Dimensions imgDims;
+  Dimensions padDims;
+
+  /** \brief Coil sensitivities, not owned */
+  Array<DType2> sens;
+
+  HostFFTPlan fftPlan;
+
+  /** \brief FFT of the PSF, scaled by the inverse FFT normalization */
+  CufftType *kernel_fft;
+
+  /** \brief Zero padded image of one coil */
+  CufftType *padded;
+};
+}
+
+#endif  // HOST_TOEPLITZ_OPERATOR_H_INCLUDED
@@ -1,16 +1,152 @@
 #include "gpuNUFFT_cpu.hpp"
+#include "host_parallel.hpp"
+
+namespace
+{
+// grids the data of the sectors [begin, end) into their own padded sector
+// grid, the sectors are independent
+class SectorGriddingTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  SectorGriddingTask(DType *data, DType *crds, DType *kernel, int *sectors,
+                     int *sector_centers, DType **sdata, int sector_dim,
+                     int sector_pad_width, int sector_offset, int width,
+                     DType kernel_radius, DType radiusSquared,
+                     DType dist_multiplier)
+    : data(data), crds(crds), kernelTab(kernel), sectors(sectors),
+      sector_centers(sector_centers), sdata(sdata), sector_dim(sector_dim),
+      sector_pad_width(sector_pad_width), sector_offset(sector_offset),
+      width(width), kernel_radius(kernel_radius),
+      radiusSquared(radiusSquared), dist_multiplier(dist_multiplier)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    int imin, imax, jmin, jmax, kmin, kmax, i, j, k, ind;
+    DType x, y, z, ix, jy, kz;
+
+    /* kr */
+    DType dx_sqr, dy_sqr, dz_sqr, val;
+    int center_x, center_y, center_z, max_x, max_y, max_z;
+
+    for (int sec = (int)begin; sec < (int)end; sec++)
+    {
+      sdata[sec] = (DType *)calloc(sector_dim * 2, sizeof(DType));  // 5*5*5 * 2
+      assert(sdata[sec] != NULL);
+
+      center_x = sector_centers[sec * 3];
+      center_y = sector_centers[sec * 3 + 1];
+      center_z = sector_centers[sec * 3 + 2];
+
+      if (DEBUG)
+        printf("handling center (%d,%d,%d) in sector %d\n", center_x, center_y,
+               center_z, sec);
+
+      for (int data_cnt = sectors[sec]; data_cnt < sectors[sec + 1]; data_cnt++)
+      {
+        if (DEBUG)
+          printf("handling %d data point = %f\n", data_cnt + 1,
+                 data[2 * data_cnt]);
+
+        x = crds[3 * data_cnt];
+        y = crds[3 * data_cnt + 1];
+        z = crds[3 * data_cnt + 2];
+        if (DEBUG)
+          printf("data k-space coords (%f, %f, %f)\n", x, y, z);
+
+        max_x = sector_pad_width - 1;
+        max_y = sector_pad_width - 1;
+        max_z = sector_pad_width - 1;
+
+        /* set the boundaries of final dataset for gpuNUFFT this point */
+        ix = (x + 0.5f) * (width)-center_x + sector_offset;
+        set_minmax(&ix, &imin, &imax, max_x, kernel_radius);
+        if (DEBUG)
+          printf("ix=%f, imin = %d, imax = %d, max_x = %d\n", ix, imin, imax,
+                 max_x);
+        jy = (y + 0.5f) * (width)-center_y + sector_offset;
+        set_minmax(&jy, &jmin, &jmax, max_y, kernel_radius);
+        kz = (z + 0.5f) * (width)-center_z + sector_offset;
+        set_minmax(&kz, &kmin, &kmax, max_z, kernel_radius);
+
+        if (DEBUG)
+          printf("sector grid position of data point: %f,%f,%f\n", ix, jy, kz);
+
+        /* grid this point onto the neighboring cartesian points */
+        for (k = kmin; k <= kmax; k++)
+        {
+          kz = static_cast<DType>((k + center_z - sector_offset)) /
+                   static_cast<DType>((width)) -
+               0.5f;  //(k - center_z) *width_inv;
+          dz_sqr = kz - z;
+          dz_sqr *= dz_sqr;
+          if (dz_sqr < radiusSquared)
+          {
+            for (j = jmin; j <= jmax; j++)
+            {
+              jy = static_cast<DType>(j + center_y - sector_offset) /
+                       static_cast<DType>((width)) -
+                   0.5f;  //(j - center_y) *width_inv;
+              dy_sqr = jy - y;
+              dy_sqr *= dy_sqr;
+              if (dy_sqr < radiusSquared)
+              {
+                for (i = imin; i <= imax; i++)
+                {
+                  ix = static_cast<DType>(i + center_x - sector_offset) /
+                           static_cast<DType>((width)) -
+                       0.5f;  // (i - center_x) *width_inv;
+                  dx_sqr = ix - x;
+                  dx_sqr *= dx_sqr;
+                  if (dx_sqr < radiusSquared)
+                  {
+                    /* get kernel value */
+                    // separable Filters
+                    val = kernelTab[(int)round(dz_sqr * dist_multiplier)] *
+                          kernelTab[(int)round(dy_sqr * dist_multiplier)] *
+                          kernelTab[(int)round(dx_sqr * dist_multiplier)];
+                    ind = getIndex(i, j, k, sector_pad_width);
+
+                    /* multiply data by current kernel val */
+                    /* grid complex or scalar */
+                    sdata[sec][2 * ind] += val * data[2 * data_cnt];
+                    sdata[sec][2 * ind + 1] += val * data[2 * data_cnt + 1];
+                  } /* kernel bounds check x, spherical support */
+                }   /* x 	 */
+              }     /* kernel bounds check y, spherical support */
+            }       /* y */
+          }         /*kernel bounds check z */
+        }           /* z */
+      }             /*data points per sector*/
+
+    } /*sectors*/
+  }
+
+ private:
+  DType *data;
+  DType *crds;
+  DType *kernelTab;
+  int *sectors;
+  int *sector_centers;
+  DType **sdata;
+  int sector_dim;
+  int sector_pad_width;
+  int sector_offset;
+  int width;
+  DType kernel_radius;
+  DType radiusSquared;
+  DType dist_multiplier;
+};
+}
 
 void gpuNUFFT_cpu(DType *data, DType *crds, DType *gdata, DType *kernel,
                   int *sectors, int sector_count, int *sector_centers,
                   int sector_width, int kernel_width, int kernel_count,
                   int width)
 {
-  int imin, imax, jmin, jmax, kmin, kmax, i, j, k, ind;
-  DType x, y, z, ix, jy, kz;
-
-  /* kr */
-  DType dx_sqr, dy_sqr, dz_sqr, val;
-  int center_x, center_y, center_z, max_x, max_y, max_z;
+  int ind;
+  int center_x, center_y, center_z;
 
   DType kernel_radius = static_cast<DType>(kernel_width) / 2.0f;
   DType radius = kernel_radius / static_cast<DType>(width);
@@ -32,97 +168,10 @@ void gpuNUFFT_cpu(DType *data, DType *crds, DType *gdata, DType *kernel,
 
   assert(sectors != NULL);
 
-  for (int sec = 0; sec < sector_count; sec++)
-  {
-    sdata[sec] = (DType *)calloc(sector_dim * 2, sizeof(DType));  // 5*5*5 * 2
-    assert(sdata[sec] != NULL);
-
-    center_x = sector_centers[sec * 3];
-    center_y = sector_centers[sec * 3 + 1];
-    center_z = sector_centers[sec * 3 + 2];
-
-    if (DEBUG)
-      printf("handling center (%d,%d,%d) in sector %d\n", center_x, center_y,
-             center_z, sec);
-
-    for (int data_cnt = sectors[sec]; data_cnt < sectors[sec + 1]; data_cnt++)
-    {
-      if (DEBUG)
-        printf("handling %d data point = %f\n", data_cnt + 1,
-               data[2 * data_cnt]);
-
-      x = crds[3 * data_cnt];
-      y = crds[3 * data_cnt + 1];
-      z = crds[3 * data_cnt + 2];
-      if (DEBUG)
-        printf("data k-space coords (%f, %f, %f)\n", x, y, z);
-
-      max_x = sector_pad_width - 1;
-      max_y = sector_pad_width - 1;
-      max_z = sector_pad_width - 1;
-
-      /* set the boundaries of final dataset for gpuNUFFT this point */
-      ix = (x + 0.5f) * (width)-center_x + sector_offset;
-      set_minmax(&ix, &imin, &imax, max_x, kernel_radius);
-      if (DEBUG)
-        printf("ix=%f, imin = %d, imax = %d, max_x = %d\n", ix, imin, imax,
-               max_x);
-      jy = (y + 0.5f) * (width)-center_y + sector_offset;
-      set_minmax(&jy, &jmin, &jmax, max_y, kernel_radius);
-      kz = (z + 0.5f) * (width)-center_z + sector_offset;
-      set_minmax(&kz, &kmin, &kmax, max_z, kernel_radius);
-
-      if (DEBUG)
-        printf("sector grid position of data point: %f,%f,%f\n", ix, jy, kz);
-
-      /* grid this point onto the neighboring cartesian points */
-      for (k = kmin; k <= kmax; k++)
-      {
-        kz = static_cast<DType>((k + center_z - sector_offset)) /
-                 static_cast<DType>((width)) -
-             0.5f;  //(k - center_z) *width_inv;
-        dz_sqr = kz - z;
-        dz_sqr *= dz_sqr;
-        if (dz_sqr < radiusSquared)
-        {
-          for (j = jmin; j <= jmax; j++)
-          {
-            jy = static_cast<DType>(j + center_y - sector_offset) /
-                     static_cast<DType>((width)) -
-                 0.5f;  //(j - center_y) *width_inv;
-            dy_sqr = jy - y;
-            dy_sqr *= dy_sqr;
-            if (dy_sqr < radiusSquared)
-            {
-              for (i = imin; i <= imax; i++)
-              {
-                ix = static_cast<DType>(i + center_x - sector_offset) /
-                         static_cast<DType>((width)) -
-                     0.5f;  // (i - center_x) *width_inv;
-                dx_sqr = ix - x;
-                dx_sqr *= dx_sqr;
-                if (dx_sqr < radiusSquared)
-                {
-                  /* get kernel value */
-                  // separable Filters
-                  val = kernel[(int)round(dz_sqr * dist_multiplier)] *
-                        kernel[(int)round(dy_sqr * dist_multiplier)] *
-                        kernel[(int)round(dx_sqr * dist_multiplier)];
-                  ind = getIndex(i, j, k, sector_pad_width);
-
-                  /* multiply data by current kernel val */
-                  /* grid complex or scalar */
-                  sdata[sec][2 * ind] += val * data[2 * data_cnt];
-                  sdata[sec][2 * ind + 1] += val * data[2 * data_cnt + 1];
-                } /* kernel bounds check x, spherical support */
-              }   /* x 	 */
-            }     /* kernel bounds check y, spherical support */
-          }       /* y */
-        }         /*kernel bounds check z */
-      }           /* z */
-    }             /*data points per sector*/
-
-  } /*sectors*/
+  SectorGriddingTask task(data, crds, kernel, sectors, sector_centers, sdata,
+                          sector_dim, sector_pad_width, sector_offset, width,
+                          kernel_radius, radiusSquared, dist_multiplier);
+  gpuNUFFT::hostParallelFor(sector_count, task);
 
   for (int sec = 0; sec < sector_count; sec++)
   {
@@ -0,0 +1,317 @@
+#include "gpuNUFFT_kernels.hpp"
+#include "precomp_kernels.hpp"
+
+#include <stdexcept>
+#include <string>
+
+/**
+ * @file
+ * \brief Definitions of the CUDA runtime, CUFFT and gpu kernel entry points
+ * declared for the host-only build (GPUNUFFT_HOST_ONLY).
+ *
+ * No device exists, memory functions report cudaErrorNoDevice and every gpu
+ * kernel entry point throws. The factory only creates host operators in this
+ * build, thus none of them is reached by the host backend.
+ */
+
+static void throwNoDevice(const char *function)
+{
+  throw std::runtime_error(std::string(function) +
+                           " requires CUDA, gpuNUFFT was built host-only!");
+}
+
+cudaError_t cudaMalloc(void **devPtr, size_t size)
+{
+  *devPtr = NULL;
+  return cudaErrorNoDevice;
+}
+
+cudaError_t cudaFree(void *devPtr)
+{
+  return devPtr == NULL ? cudaSuccess : cudaErrorNoDevice;
+}
+
+cudaError_t cudaMemcpy(void *dst, const void *src, size_t count,
+                       cudaMemcpyKind kind)
+{
+  return cudaErrorNoDevice;
+}
+
+cudaError_t cudaMemset(void *devPtr, int value, size_t count)
+{
+  return cudaErrorNoDevice;
+}
+
+const char *cudaGetErrorString(cudaError_t error)
+{
+  return error == cudaSuccess ? "no error"
+                              : "no CUDA device in the host-only build";
+}
+
+cudaError_t cudaGetLastError()
+{
+  return cudaSuccess;
+}
+
+cudaError_t cudaThreadSynchronize()
+{
+  return cudaSuccess;
+}
+
+cudaError_t cudaDeviceSynchronize()
+{
+  return cudaSuccess;
+}
+
+cudaError_t cudaEventCreate(cudaEvent_t *event)
+{
+  *event = NULL;
+  return cudaErrorNoDevice;
+}
+
+cudaError_t cudaEventRecord(cudaEvent_t event, int stream)
+{
+  return cudaErrorNoDevice;
+}
+
+cudaError_t cudaEventSynchronize(cudaEvent_t event)
+{
+  return cudaErrorNoDevice;
+}
+
+cudaError_t cudaEventElapsedTime(float *ms, cudaEvent_t start, cudaEvent_t end)
+{
+  *ms = 0.0f;
+  return cudaErrorNoDevice;
+}
+
+cudaError_t cudaMemGetInfo(size_t *free, size_t *total)
+{
+  *free = 0;
+  *total = 0;
+  return cudaErrorNoDevice;
+}
+
+cudaError_t cudaGetDeviceProperties(cudaDeviceProp *prop, int device)
+{
+  prop->totalGlobalMem = 0;
+  return cudaErrorNoDevice;
+}
+
+cufftResult cufftPlan3d(cufftHandle *plan, int nx, int ny, int nz,
+                        cufftType_t type)
+{
+  *plan = 0;
+  return CUFFT_SETUP_FAILED;
+}
+
+cufftResult cufftDestroy(cufftHandle plan)
+{
+  return CUFFT_SUCCESS;
+}
+
+cufftResult cufftExecC2C(cufftHandle plan, cufftComplex *idata,
+                         cufftComplex *odata, int direction)
+{
+  return CUFFT_SETUP_FAILED;
+}
+
+cufftResult cufftExecZ2Z(cufftHandle plan, cufftDoubleComplex *idata,
+                         cufftDoubleComplex *odata, int direction)
+{
+  return CUFFT_SETUP_FAILED;
+}
+
+void initConstSymbol(const char *symbol, const void *src, IndType count)
+{
+  throwNoDevice("initConstSymbol");
+}
+
+void initTexture(const char *symbol, cudaArray **devicePtr,
+                 gpuNUFFT::Array<DType> hostTexture)
+{
+  throwNoDevice("initTexture");
+}
+
+void bindTo1DTexture(const char *symbol, void *devicePtr, IndType count)
+{
+  throwNoDevice("bindTo1DTexture");
+}
+
+void unbindTexture(const char *symbol)
+{
+}
+
+void freeTexture(const char *symbol, cudaArray *devicePtr)
+{
+}
+
+void performConvolution(DType2 *data_d, DType *crds_d, CufftType *gdata_d,
+                        DType *kernel_d, IndType *sectors_d,
+                        IndType *sector_centers_d,
+                        gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performConvolution");
+}
+
+void performConvolution(DType2 *data_d, DType *crds_d, CufftType *gdata_d,
+                        DType *kernel_d, IndType *sectors_d,
+                        IndType2 *sector_processing_order_d,
+                        IndType *sector_centers_d,
+                        gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performConvolution");
+}
+
+void performTextureConvolution(DType2 *data_d, DType *crds_d,
+                               CufftType *gdata_d, DType *kernel_d,
+                               IndType *sectors_d, IndType *sector_centers_d,
+                               gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performTextureConvolution");
+}
+
+void performTextureConvolution(DType2 *data_d, DType *crds_d,
+                               CufftType *gdata_d, DType *kernel_d,
+                               IndType *sectors_d,
+                               IndType2 *sector_processing_order_d,
+                               IndType *sector_centers_d,
+                               gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performTextureConvolution");
+}
+
+void performForwardConvolution(CufftType *data_d, DType *crds_d,
+                               CufftType *gdata_d, DType *kernel_d,
+                               IndType *sectors_d, IndType *sector_centers_d,
+                               gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performForwardConvolution");
+}
+
+void performForwardConvolution(CufftType *data_d, DType *crds_d,
+                               CufftType *gdata_d, DType *kernel_d,
+                               IndType *sectors_d,
+                               IndType2 *sector_processing_order_d,
+                               IndType *sector_centers_d,
+                               gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performForwardConvolution");
+}
+
+void performTextureForwardConvolution(CufftType *data_d, DType *crds_d,
+                                      CufftType *gdata_d, DType *kernel_d,
+                                      IndType *sectors_d,
+                                      IndType *sector_centers_d,
+                                      gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performTextureForwardConvolution");
+}
+
+void performTextureForwardConvolution(CufftType *data_d, DType *crds_d,
+                                      CufftType *gdata_d, DType *kernel_d,
+                                      IndType *sectors_d,
+                                      IndType2 *sector_processing_order_d,
+                                      IndType *sector_centers_d,
+                                      gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performTextureForwardConvolution");
+}
+
+void performFFTScaling(CufftType *data, int N, gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performFFTScaling");
+}
+
+void performDensityCompensation(DType2 *data, DType *density_comp,
+                                gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performDensityCompensation");
+}
+
+void performSensMul(CufftType *imdata_d, DType2 *sens_d,
+                    gpuNUFFT::GpuNUFFTInfo *gi_host, bool conjugate)
+{
+  throwNoDevice("performSensMul");
+}
+
+void performSensSum(CufftType *imdata_d, CufftType *imdata_sum_d,
+                    gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performSensSum");
+}
+
+void performFFTShift(CufftType *gdata_d, gpuNUFFT::FFTShiftDir shift_dir,
+                     gpuNUFFT::Dimensions gridDims,
+                     gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performFFTShift");
+}
+
+void performCrop(CufftType *gdata_d, CufftType *imdata_d,
+                 gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performCrop");
+}
+
+void performDeapodization(CufftType *imdata_d, gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performDeapodization");
+}
+
+void performDeapodization(CufftType *imdata_d, DType *deapo_d,
+                          gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performDeapodization");
+}
+
+void performForwardDeapodization(DType2 *imdata_d,
+                                 gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performForwardDeapodization");
+}
+
+void performForwardDeapodization(DType2 *imdata_d, DType *deapo_d,
+                                 gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performForwardDeapodization");
+}
+
+void performPadding(DType2 *imdata_d, CufftType *gdata_d,
+                    gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("performPadding");
+}
+
+void precomputeDeapodization(DType *deapo_d, gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  throwNoDevice("precomputeDeapodization");
+}
+
+void assignSectorsGPU(gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp,
+                      gpuNUFFT::Array<DType> &kSpaceTraj,
+                      IndType *assignedSectors)
+{
+  throwNoDevice("assignSectorsGPU");
+}
+
+void sortArrays(gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp,
+                std::vector<gpuNUFFT::IndPair> assignedSectorsAndIndicesSorted,
+                IndType *assignedSectors, IndType *dataIndices,
+                gpuNUFFT::Array<DType> &kSpaceTraj, DType *trajSorted,
+                DType *densCompData, DType *densData)
+{
+  throwNoDevice("sortArrays");
+}
+
+void selectOrderedGPU(DType2 *data_d, IndType *data_indices_d,
+                      DType2 *data_sorted_d, int N, int n_coils_cc)
+{
+  throwNoDevice("selectOrderedGPU");
+}
+
+void writeOrderedGPU(DType2 *data_sorted_d, IndType *data_indices_d,
+                     CufftType *data_d, int N, int n_coils_cc)
+{
+  throwNoDevice("writeOrderedGPU");
+}
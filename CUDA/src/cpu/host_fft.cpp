@@ -0,0 +1,513 @@
+#include "host_fft.hpp"
+#include "host_parallel.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/** \brief Largest prime radix handled by the generic butterfly. Lengths
+ * containing larger prime factors are computed with Bluestein's algorithm. */
+#define HOST_FFT_MAX_GENERIC_RADIX 61
+
+static inline CufftType cmul(const CufftType &a, const CufftType &b)
+{
+  CufftType r;
+  r.x = a.x * b.x - a.y * b.y;
+  r.y = a.x * b.y + a.y * b.x;
+  return r;
+}
+
+// multiply with b or its conjugate
+static inline CufftType cmul(const CufftType &a, const CufftType &b,
+                             bool conjugate)
+{
+  CufftType r;
+  if (conjugate)
+  {
+    r.x = a.x * b.x + a.y * b.y;
+    r.y = a.y * b.x - a.x * b.y;
+  }
+  else
+  {
+    r.x = a.x * b.x - a.y * b.y;
+    r.y = a.x * b.y + a.y * b.x;
+  }
+  return r;
+}
+
+static inline CufftType polar(double angle)
+{
+  CufftType r;
+  r.x = (DType)cos(angle);
+  r.y = (DType)sin(angle);
+  return r;
+}
+
+static IndType nextPowerOfTwo(IndType n)
+{
+  IndType p = 1;
+  while (p < n)
+    p <<= 1;
+  return p;
+}
+
+gpuNUFFT::HostFFTPlan1D::HostFFTPlan1D(IndType n)
+  : n(n), maxRadix(1), bluesteinPlan(NULL)
+{
+  // factorize: radix 4 first, then 2 and the remaining odd primes
+  IndType remaining = n;
+  IndType p = 4;
+  bool useBluestein = false;
+  while (remaining > 1)
+  {
+    while (remaining % p)
+    {
+      switch (p)
+      {
+      case 4:
+        p = 2;
+        break;
+      case 2:
+        p = 3;
+        break;
+      default:
+        p += 2;
+        break;
+      }
+      if (p * p > remaining)
+        p = remaining;
+    }
+    if (p > HOST_FFT_MAX_GENERIC_RADIX)
+    {
+      useBluestein = true;
+      break;
+    }
+    remaining /= p;
+    factors.push_back(p);
+    factors.push_back(remaining);
+    maxRadix = std::max(maxRadix, p);
+  }
+
+  if (!useBluestein)
+  {
+    twiddles.resize(n);
+    for (IndType k = 0; k < n; k++)
+      twiddles[k] = polar(-2.0 * M_PI * (double)k / (double)n);
+    return;
+  }
+
+  factors.clear();
+  maxRadix = 1;
+  IndType m = nextPowerOfTwo(2 * n - 1);
+  bluesteinPlan = new HostFFTPlan1D(m);
+
+  chirp.resize(n);
+  for (IndType k = 0; k < n; k++)
+  {
+    // k^2 mod 2n keeps the argument small for large k
+    unsigned long long k2 =
+        ((unsigned long long)k * (unsigned long long)k) %
+        (2ull * (unsigned long long)n);
+    chirp[k] = polar(-M_PI * (double)k2 / (double)n);
+  }
+
+  CufftType zero;
+  zero.x = (DType)0.0;
+  zero.y = (DType)0.0;
+  chirpFFTForward.assign(m, zero);
+  chirpFFTInverse.assign(m, zero);
+  for (IndType k = 0; k < n; k++)
+  {
+    CufftType w = chirp[k];
+    CufftType wConj = w;
+    wConj.y = -w.y;
+    chirpFFTForward[k] = wConj;
+    chirpFFTInverse[k] = w;
+    if (k > 0)
+    {
+      chirpFFTForward[m - k] = wConj;
+      chirpFFTInverse[m - k] = w;
+    }
+  }
+  std::vector<CufftType> tmp(bluesteinPlan->getScratchSize());
+  bluesteinPlan->execute(&chirpFFTForward[0], &tmp[0], HOST_FFT_FORWARD);
+  bluesteinPlan->execute(&chirpFFTInverse[0], &tmp[0], HOST_FFT_FORWARD);
+}
+
+gpuNUFFT::HostFFTPlan1D::~HostFFTPlan1D()
+{
+  delete bluesteinPlan;
+}
+
+IndType gpuNUFFT::HostFFTPlan1D::getScratchSize() const
+{
+  if (bluesteinPlan != NULL)
+    return bluesteinPlan->getLength() + bluesteinPlan->getScratchSize();
+  return n + maxRadix;
+}
+
+void gpuNUFFT::HostFFTPlan1D::execute(CufftType *line, CufftType *scratch,
+                                      HostFFTDirection dir) const
+{
+  if (n <= 1)
+    return;
+
+  bool inverse = (dir == HOST_FFT_INVERSE);
+  if (bluesteinPlan != NULL)
+  {
+    executeBluestein(line, scratch, inverse);
+    return;
+  }
+
+  // out of place into scratch, remaining scratch used by the butterflies
+  work(scratch, line, 1, &factors[0], scratch + n, inverse);
+  std::copy(scratch, scratch + n, line);
+}
+
+void gpuNUFFT::HostFFTPlan1D::work(CufftType *out, const CufftType *in,
+                                   IndType fstride, const IndType *factors,
+                                   CufftType *scratch, bool inverse) const
+{
+  IndType p = factors[0];
+  IndType m = factors[1];
+
+  if (m == 1)
+  {
+    for (IndType j = 0; j < p; j++)
+      out[j] = in[j * fstride];
+  }
+  else
+  {
+    // recursive decimation in time
+    for (IndType j = 0; j < p; j++)
+      work(out + j * m, in + j * fstride, fstride * p, factors + 2, scratch,
+           inverse);
+  }
+
+  switch (p)
+  {
+  case 2:
+    butterfly2(out, fstride, m, inverse);
+    break;
+  case 4:
+    butterfly4(out, fstride, m, inverse);
+    break;
+  default:
+    butterflyGeneric(out, fstride, m, p, scratch, inverse);
+    break;
+  }
+}
+
+void gpuNUFFT::HostFFTPlan1D::butterfly2(CufftType *out, IndType fstride,
+                                         IndType m, bool inverse) const
+{
+  for (IndType k = 0; k < m; k++)
+  {
+    CufftType t = cmul(out[k + m], twiddles[k * fstride], inverse);
+    out[k + m].x = out[k].x - t.x;
+    out[k + m].y = out[k].y - t.y;
+    out[k].x += t.x;
+    out[k].y += t.y;
+  }
+}
+
+void gpuNUFFT::HostFFTPlan1D::butterfly4(CufftType *out, IndType fstride,
+                                         IndType m, bool inverse) const
+{
+  for (IndType k = 0; k < m; k++)
+  {
+    CufftType s0 = cmul(out[k + m], twiddles[k * fstride], inverse);
+    CufftType s1 = cmul(out[k + 2 * m], twiddles[2 * k * fstride], inverse);
+    CufftType s2 = cmul(out[k + 3 * m], twiddles[3 * k * fstride], inverse);
+
+    CufftType s5, s3, s4;
+    s5.x = out[k].x - s1.x;
+    s5.y = out[k].y - s1.y;
+    out[k].x += s1.x;
+    out[k].y += s1.y;
+    s3.x = s0.x + s2.x;
+    s3.y = s0.y + s2.y;
+    s4.x = s0.x - s2.x;
+    s4.y = s0.y - s2.y;
+    out[k + 2 * m].x = out[k].x - s3.x;
+    out[k + 2 * m].y = out[k].y - s3.y;
+    out[k].x += s3.x;
+    out[k].y += s3.y;
+
+    if (inverse)
+    {
+      out[k + m].x = s5.x - s4.y;
+      out[k + m].y = s5.y + s4.x;
+      out[k + 3 * m].x = s5.x + s4.y;
+      out[k + 3 * m].y = s5.y - s4.x;
+    }
+    else
+    {
+      out[k + m].x = s5.x + s4.y;
+      out[k + m].y = s5.y - s4.x;
+      out[k + 3 * m].x = s5.x - s4.y;
+      out[k + 3 * m].y = s5.y + s4.x;
+    }
+  }
+}
+
+void gpuNUFFT::HostFFTPlan1D::butterflyGeneric(CufftType *out,
+                                               IndType fstride, IndType m,
+                                               IndType p, CufftType *scratch,
+                                               bool inverse) const
+{
+  for (IndType u = 0; u < m; u++)
+  {
+    for (IndType q1 = 0; q1 < p; q1++)
+      scratch[q1] = out[u + q1 * m];
+
+    for (IndType q1 = 0; q1 < p; q1++)
+    {
+      IndType k = u + q1 * m;
+      IndType twidx = 0;
+      CufftType sum = scratch[0];
+      for (IndType q = 1; q < p; q++)
+      {
+        twidx += fstride * k;
+        twidx %= n;
+        CufftType t = cmul(scratch[q], twiddles[twidx], inverse);
+        sum.x += t.x;
+        sum.y += t.y;
+      }
+      out[k] = sum;
+    }
+  }
+}
+
+void gpuNUFFT::HostFFTPlan1D::executeBluestein(CufftType *line,
+                                               CufftType *scratch,
+                                               bool inverse) const
+{
+  IndType m = bluesteinPlan->getLength();
+  CufftType *a = scratch;
+  CufftType *subScratch = scratch + m;
+
+  for (IndType k = 0; k < n; k++)
+    a[k] = cmul(line[k], chirp[k], inverse);
+  for (IndType k = n; k < m; k++)
+  {
+    a[k].x = (DType)0.0;
+    a[k].y = (DType)0.0;
+  }
+
+  bluesteinPlan->execute(a, subScratch, HOST_FFT_FORWARD);
+  const std::vector<CufftType> &b =
+      inverse ? chirpFFTInverse : chirpFFTForward;
+  for (IndType k = 0; k < m; k++)
+    a[k] = cmul(a[k], b[k]);
+  bluesteinPlan->execute(a, subScratch, HOST_FFT_INVERSE);
+
+  DType scale = (DType)1.0 / (DType)m;
+  for (IndType k = 0; k < n; k++)
+  {
+    line[k] = cmul(a[k], chirp[k], inverse);
+    line[k].x *= scale;
+    line[k].y *= scale;
+  }
+}
+
+gpuNUFFT::HostFFTPlan::HostFFTPlan(Dimensions gridDims)
+  : gridDims(gridDims), planX(NULL), planY(NULL), planZ(NULL), lineSize(0),
+    scratchSize(0)
+{
+  planX = new HostFFTPlan1D(DEFAULT_VALUE(gridDims.width));
+  planY = new HostFFTPlan1D(DEFAULT_VALUE(gridDims.height));
+  if (gridDims.depth > 0)
+    planZ = new HostFFTPlan1D(gridDims.depth);
+
+  scratchSize = std::max(planX->getScratchSize(), planY->getScratchSize());
+  lineSize = planY->getLength();
+  if (planZ != NULL)
+  {
+    scratchSize = std::max(scratchSize, planZ->getScratchSize());
+    lineSize = std::max(lineSize, planZ->getLength());
+  }
+  buffers.resize(lineSize + scratchSize);
+
+  regionOffset[0] = regionOffset[1] = regionOffset[2] = 0;
+  regionOutputOffset[0] = regionOutputOffset[1] = regionOutputOffset[2] = 0;
+  regionCount[0] = planX->getLength();
+  regionCount[1] = planY->getLength();
+  regionCount[2] = planZ != NULL ? planZ->getLength() : 1;
+}
+
+gpuNUFFT::HostFFTPlan::~HostFFTPlan()
+{
+  delete planX;
+  delete planY;
+  delete planZ;
+}
+
+void gpuNUFFT::HostFFTPlan::setPruningRegion(IndType3 offset,
+                                             Dimensions regionDims)
+{
+  setPruningRegion(offset, offset, regionDims);
+}
+
+void gpuNUFFT::HostFFTPlan::setPruningRegion(IndType3 inputOffset,
+                                             IndType3 outputOffset,
+                                             Dimensions regionDims)
+{
+  IndType n[3] = { planX->getLength(), planY->getLength(),
+                   planZ != NULL ? planZ->getLength() : 1 };
+  IndType in[3] = { inputOffset.x, inputOffset.y, inputOffset.z };
+  IndType out[3] = { outputOffset.x, outputOffset.y, outputOffset.z };
+  IndType c[3] = { regionDims.width, regionDims.height, regionDims.depth };
+  for (int a = 0; a < 3; a++)
+    if (c[a] > n[a])
+      throw std::invalid_argument("Pruning region exceeds the grid!");
+
+  for (int a = 0; a < 3; a++)
+  {
+    regionCount[a] = c[a] > 0 ? c[a] : n[a];
+    regionOffset[a] = regionCount[a] < n[a] ? in[a] % n[a] : 0;
+    regionOutputOffset[a] = regionCount[a] < n[a] ? out[a] % n[a] : 0;
+  }
+}
+
+namespace
+{
+// index range of one of the axes enumerating the lines
+struct HostFFTLineRange
+{
+  IndType n;
+  IndType offset;
+  IndType count;
+  IndType stride;
+};
+
+// transforms the lines [begin, end) of one axis, line i has the indices
+// i % first.count and i / first.count within the ranges of the other axes
+class HostFFTLineTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostFFTLineTask(CufftType *data, const gpuNUFFT::HostFFTPlan1D *plan,
+                  IndType stride, HostFFTLineRange first,
+                  HostFFTLineRange second, CufftType *buffers,
+                  IndType bufferSize, IndType lineSize,
+                  gpuNUFFT::HostFFTDirection dir)
+    : data(data), plan(plan), stride(stride), first(first), second(second),
+      buffers(buffers), bufferSize(bufferSize), lineSize(lineSize), dir(dir)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    CufftType *line = buffers + threadId * bufferSize;
+    CufftType *scratch = line + lineSize;
+    IndType n = plan->getLength();
+
+    for (IndType i = begin; i < end; i++)
+    {
+      IndType a = (first.offset + i % first.count) % first.n;
+      IndType b = (second.offset + i / first.count) % second.n;
+      CufftType *base = data + a * first.stride + b * second.stride;
+      if (stride == 1)
+      {
+        plan->execute(base, scratch, dir);
+        continue;
+      }
+      for (IndType k = 0; k < n; k++)
+        line[k] = base[k * stride];
+      plan->execute(line, scratch, dir);
+      for (IndType k = 0; k < n; k++)
+        base[k * stride] = line[k];
+    }
+  }
+
+ private:
+  CufftType *data;
+  const gpuNUFFT::HostFFTPlan1D *plan;
+  IndType stride;
+  HostFFTLineRange first;
+  HostFFTLineRange second;
+  CufftType *buffers;
+  IndType bufferSize;
+  IndType lineSize;
+  gpuNUFFT::HostFFTDirection dir;
+};
+}
+
+void gpuNUFFT::HostFFTPlan::executeAxis(CufftType *data, int axis,
+                                        bool pruneFirst, bool pruneSecond,
+                                        const IndType *offsets,
+                                        HostFFTDirection dir)
+{
+  const HostFFTPlan1D *plans[3] = { planX, planY, planZ };
+  IndType n[3] = { planX->getLength(), planY->getLength(),
+                   planZ != NULL ? planZ->getLength() : 1 };
+  IndType strides[3] = { 1, n[0], n[0] * n[1] };
+
+  // the remaining axes in memory order
+  int axes[2] = { axis == 0 ? 1 : 0, axis == 2 ? 1 : 2 };
+  bool prune[2] = { pruneFirst, pruneSecond };
+  HostFFTLineRange ranges[2];
+  for (int r = 0; r < 2; r++)
+  {
+    int a = axes[r];
+    ranges[r].n = n[a];
+    ranges[r].offset = prune[r] ? offsets[a] : 0;
+    ranges[r].count = prune[r] ? regionCount[a] : n[a];
+    ranges[r].stride = strides[a];
+  }
+
+  int n_threads = getHostThreadCount();
+  IndType bufferSize = lineSize + scratchSize;
+  if (buffers.size() < n_threads * bufferSize)
+    buffers.resize(n_threads * bufferSize);
+
+  HostFFTLineTask task(data, plans[axis], strides[axis], ranges[0],
+                       ranges[1], &buffers[0], bufferSize, lineSize, dir);
+  hostParallelFor(ranges[0].count * ranges[1].count, task, n_threads);
+}
+
+void gpuNUFFT::HostFFTPlan::execute(CufftType *data, HostFFTDirection dir)
+{
+  execute(data, dir, HOST_FFT_NO_PRUNING);
+}
+
+void gpuNUFFT::HostFFTPlan::execute(CufftType *data, HostFFTDirection dir,
+                                    HostFFTPruning pruning)
+{
+  bool has_y = planY->getLength() > 1;
+  bool has_z = planZ != NULL && planZ->getLength() > 1;
+
+  if (pruning == HOST_FFT_PRUNE_OUTPUT)
+  {
+    // z and y first, the x lines are only needed inside of the region
+    if (has_z)
+      executeAxis(data, 2, false, false, regionOutputOffset, dir);
+    if (has_y)
+      executeAxis(data, 1, false, true, regionOutputOffset, dir);
+    executeAxis(data, 0, true, true, regionOutputOffset, dir);
+    return;
+  }
+
+  // x lines outside of the region of y and z are zero, also the y lines
+  // outside of the z region
+  bool pruneInput = pruning == HOST_FFT_PRUNE_INPUT;
+  executeAxis(data, 0, pruneInput, pruneInput, regionOffset, dir);
+  if (has_y)
+    executeAxis(data, 1, false, pruneInput, regionOffset, dir);
+  if (has_z)
+    executeAxis(data, 2, false, false, regionOffset, dir);
+}
+
+void gpuNUFFT::HostFFTPlan::execute(CufftType *data, int n_grids,
+                                    HostFFTDirection dir,
+                                    HostFFTPruning pruning)
+{
+  IndType gridCount = planX->getLength() * planY->getLength() *
+                      (planZ != NULL ? planZ->getLength() : 1);
+  for (int g = 0; g < n_grids; g++)
+    execute(data + g * gridCount, dir, pruning);
+}
@@ -0,0 +1,1561 @@
+#include "host_gpuNUFFT_kernels.hpp"
+#include "host_parallel.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+// linear index of (x,y,z) in grid of dimensions dim
+static inline int hostXYZ2Lin(int x, int y, int z, IndType3 dim)
+{
+  return x + (int)dim.x * (y + (int)dim.y * z);
+}
+
+namespace
+{
+// kernel value at the table position pos (distance squared times
+// dist_multiplier), pos < last within the kernel radius
+struct NearestNeighborLookup
+{
+  DType operator()(const DType *kernel, int last, DType pos) const
+  {
+    return kernel[(int)round(pos)];
+  }
+};
+
+// linear interpolation between the neighboring entries, allows the compact
+// table of calculateKernelSizeLinInt
+struct LinearLookup
+{
+  DType operator()(const DType *kernel, int last, DType pos) const
+  {
+    int i = (int)pos;
+    if (i >= last)  // rounding at the kernel radius
+      return kernel[last];
+    DType w = pos - (DType)i;
+    return kernel[i] + w * (kernel[i + 1] - kernel[i]);
+  }
+};
+
+// kernel extent and lookup table of one dimension, the shared per-axis
+// table of gi_host if set unless sharedTable is false (derivative tables).
+// The slowest dimension is shifted by the first plane held by the grid.
+struct AxisKernel
+{
+  AxisKernel(const DType *kernel, gpuNUFFT::GpuNUFFTInfo *gi_host, int dim,
+             bool sharedTable = true)
+  {
+    IndType3 offset = gi_host->kernel_offset_axis;
+    IndType3 count = gi_host->kernel_count_axis;
+    DType3 radius = gi_host->kernel_radius_axis;
+    DType3 radiusSquared = gi_host->radiusSquared_axis;
+    DType3 multiplier = gi_host->dist_multiplier_axis;
+    IndType3 padMax = gi_host->sector_pad_max_axis;
+    IndType3 sectorOffset = gi_host->sector_offset_axis;
+    table = kernel + (dim == 0 ? offset.x : dim == 1 ? offset.y : offset.z);
+    if (sharedTable && gi_host->kernel_table_axis[dim] != NULL)
+      table = gi_host->kernel_table_axis[dim];
+    last = (int)(dim == 0 ? count.x : dim == 1 ? count.y : count.z) - 1;
+    this->radius = dim == 0 ? radius.x : dim == 1 ? radius.y : radius.z;
+    this->radiusSquared = dim == 0 ? radiusSquared.x
+                                   : dim == 1 ? radiusSquared.y
+                                              : radiusSquared.z;
+    dist_multiplier =
+        dim == 0 ? multiplier.x : dim == 1 ? multiplier.y : multiplier.z;
+    pad_max = (int)(dim == 0 ? padMax.x : dim == 1 ? padMax.y : padMax.z);
+    sector_offset = (int)(dim == 0 ? sectorOffset.x
+                                   : dim == 1 ? sectorOffset.y
+                                              : sectorOffset.z);
+    plane_offset = dim == (gi_host->is2Dprocessing ? 1 : 2)
+                       ? gi_host->grid_plane_offset
+                       : 0;
+  }
+
+  // index into the grid of padded sector position k, wrapped to the
+  // opposite side
+  int gridIndex(int k, int center, int gridDim) const
+  {
+    int ind = calculateOppositeIndex(k, center, gridDim, sector_offset) -
+              plane_offset;
+    return ind < 0 ? ind + gridDim : ind;
+  }
+
+  const DType *table;
+  int last;
+  DType radius;
+  DType radiusSquared;
+  DType dist_multiplier;
+  int pad_max;
+  int sector_offset;
+  int plane_offset;
+};
+
+// adjoint convolution of the sectors [firstSector, lastSector)
+template <typename Lookup>
+void hostConvolveSectors(DType2 *data, DType *crds, CufftType *gdata,
+                         DType *kernel, IndType *sectors,
+                         IndType *sector_centers,
+                         gpuNUFFT::GpuNUFFTInfo *gi_host, Lookup lookup,
+                         int firstSector, int lastSector)
+{
+  int imin, imax, jmin, jmax, kmin, kmax;
+  DType dx_sqr, dy_sqr, dz_sqr, val, ix, jy, kz;
+
+  int n_coils_cc = gi_host->n_coils_cc;
+  int dim_count = gi_host->is2Dprocessing ? 2 : 3;
+  AxisKernel kx(kernel, gi_host, 0);
+  AxisKernel ky(kernel, gi_host, 1);
+  AxisKernel kzk(kernel, gi_host, 2);
+
+  for (int sec = firstSector; sec < lastSector; sec++)
+  {
+    IndType3 center;
+    center.x = sector_centers[sec * dim_count];
+    center.y = sector_centers[sec * dim_count + 1];
+    center.z = gi_host->is2Dprocessing ? 0
+                                        : sector_centers[sec * dim_count + 2];
+
+    for (IndType data_cnt = sectors[sec]; data_cnt < sectors[sec + 1];
+         data_cnt++)
+    {
+      DType3 data_point;
+      data_point.x = crds[data_cnt];
+      data_point.y = crds[data_cnt + gi_host->data_count];
+      data_point.z = gi_host->is2Dprocessing
+                         ? (DType)0.0
+                         : crds[data_cnt + 2 * gi_host->data_count];
+
+      // set the boundaries of final dataset for gpuNUFFT this point
+      ix = mapKSpaceToGrid(data_point.x, gi_host->gridDims.x, center.x,
+                           kx.sector_offset);
+      set_minmax(&ix, &imin, &imax, kx.pad_max, kx.radius);
+      jy = mapKSpaceToGrid(data_point.y, gi_host->gridDims.y, center.y,
+                           ky.sector_offset);
+      set_minmax(&jy, &jmin, &jmax, ky.pad_max, ky.radius);
+      if (gi_host->is2Dprocessing)
+      {
+        kmin = kmax = 0;
+      }
+      else
+      {
+        kz = mapKSpaceToGrid(data_point.z, gi_host->gridDims.z, center.z,
+                             kzk.sector_offset);
+        set_minmax(&kz, &kmin, &kmax, kzk.pad_max, kzk.radius);
+      }
+
+      // grid this point onto the neighboring cartesian points
+      for (int k = kmin; k <= kmax; k++)
+      {
+        int z_ind = 0;
+        DType z_val = (DType)1.0;
+        if (!gi_host->is2Dprocessing)
+        {
+          kz = mapGridToKSpace(k, gi_host->gridDims.z, center.z,
+                               kzk.sector_offset);
+          dz_sqr = (kz - data_point.z) * gi_host->aniso_z_scale;
+          dz_sqr *= dz_sqr;
+          if (dz_sqr >= kzk.radiusSquared)
+            continue;
+          z_ind = kzk.gridIndex(k, center.z, gi_host->gridDims.z);
+          z_val = lookup(kzk.table, kzk.last, dz_sqr * kzk.dist_multiplier);
+        }
+        for (int j = jmin; j <= jmax; j++)
+        {
+          jy = mapGridToKSpace(j, gi_host->gridDims.y, center.y,
+                               ky.sector_offset);
+          dy_sqr = (jy - data_point.y) * gi_host->aniso_y_scale;
+          dy_sqr *= dy_sqr;
+          if (dy_sqr >= ky.radiusSquared)
+            continue;
+          int y_ind = ky.gridIndex(j, center.y, gi_host->gridDims.y);
+          DType yz_val =
+              z_val * lookup(ky.table, ky.last, dy_sqr * ky.dist_multiplier);
+          for (int i = imin; i <= imax; i++)
+          {
+            ix = mapGridToKSpace(i, gi_host->gridDims.x, center.x,
+                                 kx.sector_offset);
+            dx_sqr = (ix - data_point.x) * gi_host->aniso_x_scale;
+            dx_sqr *= dx_sqr;
+            if (dx_sqr >= kx.radiusSquared)
+              continue;
+
+            // separable kernel, grid positions outside of the grid are
+            // wrapped to the opposite side
+            val = yz_val *
+                  lookup(kx.table, kx.last, dx_sqr * kx.dist_multiplier);
+
+            int ind = hostXYZ2Lin(
+                kx.gridIndex(i, center.x, gi_host->gridDims.x),
+                y_ind, z_ind, gi_host->gridDims);
+
+            for (int c = 0; c < n_coils_cc; c++)
+            {
+              DType2 s_data = data[data_cnt + c * gi_host->data_count];
+              gdata[ind + c * gi_host->gridDims_count].x += val * s_data.x;
+              gdata[ind + c * gi_host->gridDims_count].y += val * s_data.y;
+            }
+          }  // x
+        }    // y
+      }      // z
+    }        // data points per sector
+  }          // sectors
+}
+
+// adjoint convolution of the sector planes firstPlane + n * stride for n in
+// [begin, end), the planes along the slowest dimension hold planeSectors
+// consecutive sectors each
+template <typename Lookup>
+class PlaneConvolutionTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  PlaneConvolutionTask(DType2 *data, DType *crds, CufftType *gdata,
+                       DType *kernel, IndType *sectors,
+                       IndType *sector_centers,
+                       gpuNUFFT::GpuNUFFTInfo *gi_host, Lookup lookup,
+                       int planeSectors, int firstPlane, int stride)
+    : data(data), crds(crds), gdata(gdata), kernelData(kernel),
+      sectors(sectors), sector_centers(sector_centers), gi_host(gi_host),
+      lookup(lookup), planeSectors(planeSectors), firstPlane(firstPlane),
+      stride(stride)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType n = begin; n < end; n++)
+    {
+      int plane = firstPlane + (int)n * stride;
+      hostConvolveSectors(data, crds, gdata, kernelData, sectors,
+                          sector_centers, gi_host, lookup, plane * planeSectors,
+                          (plane + 1) * planeSectors);
+    }
+  }
+
+ private:
+  DType2 *data;
+  DType *crds;
+  CufftType *gdata;
+  DType *kernelData;
+  IndType *sectors;
+  IndType *sector_centers;
+  gpuNUFFT::GpuNUFFTInfo *gi_host;
+  Lookup lookup;
+  int planeSectors;
+  int firstPlane;
+  int stride;
+};
+
+// adjoint convolution in phases of sector planes along the slowest dimension.
+// The padded sectors of plane q cover pad_max + 1 grid planes from
+// q * sector_width on (modulo the grid), thus planes colors apart never write
+// the same grid point and the planes of one color run in parallel. Planes
+// which would overlap across the wrap around are convolved last on the
+// calling thread. The summation order depends on the grid only, the result is
+// the same for any thread count.
+template <typename Lookup>
+void hostConvolution(DType2 *data, DType *crds, CufftType *gdata,
+                     DType *kernel, IndType *sectors, IndType *sector_centers,
+                     gpuNUFFT::GpuNUFFTInfo *gi_host, Lookup lookup)
+{
+  int width = gi_host->sector_width;
+  AxisKernel slow(kernel, gi_host, gi_host->is2Dprocessing ? 1 : 2);
+  int gridDim = (int)(gi_host->is2Dprocessing ? gi_host->gridDims.y
+                                              : gi_host->gridDims.z);
+  int planes = width > 0 ? (gridDim + width - 1) / width : 0;
+  int colors = (slow.pad_max + width) / std::max(width, 1);
+  int planeSectors =
+      width > 0 ? ((int)gi_host->gridDims.x + width - 1) / width : 0;
+  if (!gi_host->is2Dprocessing)
+    planeSectors *= ((int)gi_host->gridDims.y + width - 1) / width;
+
+  // colored planes [0, colored) of one color are at least pad_max + 1 grid
+  // planes apart in both directions. Sample subsets and shards may hold only
+  // part of the sectors and are convolved in sector order.
+  int colored = 0;
+  if (planes > 0 && gi_host->sector_count == planes * planeSectors &&
+      gridDim > slow.pad_max)
+  {
+    int reach = (gridDim - slow.pad_max - 1) / width + colors;
+    colored = std::min(planes, reach) / colors * colors;
+  }
+  int n_threads = gpuNUFFT::getHostThreadCount();
+
+  for (int color = 0; color < colors && colored > 0; color++)
+  {
+    // one range per plane, the sample counts of the planes differ widely
+    IndType count = (IndType)((colored - color + colors - 1) / colors);
+    PlaneConvolutionTask<Lookup> task(data, crds, gdata, kernel, sectors,
+                                      sector_centers, gi_host, lookup,
+                                      planeSectors, color, colors);
+    gpuNUFFT::hostParallelFor(count, task, n_threads > 1 ? (int)count : 1);
+  }
+  hostConvolveSectors(data, crds, gdata, kernel, sectors, sector_centers,
+                      gi_host, lookup, colored * planeSectors,
+                      gi_host->sector_count);
+}
+
+// grid tiles of the gather convolution along one dimension, tile t covers
+// [t * width, (t + 1) * width) of the grid
+struct GatherAxis
+{
+  GatherAxis(const AxisKernel &axisKernel, IndType gridDim, int width)
+    : axisKernel(axisKernel), gridDim(gridDim > 0 ? (int)gridDim : 1),
+      width(width), tileCount((this->gridDim + width - 1) / width)
+  {
+  }
+
+  // tiles reached by the padded sector of center, each once
+  void addTiles(IndType center, std::vector<int> &tiles) const
+  {
+    tiles.clear();
+    for (int i = 0; i <= axisKernel.pad_max; i++)
+    {
+      int tile = calculateOppositeIndex(i, (int)center, gridDim,
+                                        axisKernel.sector_offset) /
+                 width;
+      if (std::find(tiles.begin(), tiles.end(), tile) == tiles.end())
+        tiles.push_back(tile);
+    }
+  }
+
+  // ranges [lo[n], hi[n]] of the padded sector of center, in ascending
+  // order, which calculateOppositeIndex maps into tile
+  int getSpans(int tile, IndType center, int *lo, int *hi) const
+  {
+    int first = tile * width;
+    int last = std::min(first + width, gridDim) - 1;
+    int base = (int)center - axisKernel.sector_offset;
+    int count = 0;
+    for (int wrap = -1; wrap <= 1; wrap++)
+    {
+      lo[count] = std::max(first - base + wrap * gridDim, 0);
+      hi[count] = std::min(last - base + wrap * gridDim, axisKernel.pad_max);
+      if (lo[count] <= hi[count])
+        count++;
+    }
+    return count;
+  }
+
+  AxisKernel axisKernel;
+  int gridDim;
+  int width;
+  int tileCount;
+};
+
+// adjoint convolution of the tiles [begin, end), each tile gathers the
+// samples of the sectors reaching it, in sector and sample order, and is
+// written by one thread only
+template <typename Lookup>
+class GatherConvolutionTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  GatherConvolutionTask(DType2 *data, DType *crds, CufftType *gdata,
+                        IndType *sectors, IndType *sector_centers,
+                        gpuNUFFT::GpuNUFFTInfo *gi_host, const GatherAxis *axes,
+                        const IndType *tileOffsets,
+                        const IndType *tileSectors, IndType firstSector,
+                        IndType lastSector, Lookup lookup)
+    : data(data), crds(crds), gdata(gdata), sectors(sectors),
+      sector_centers(sector_centers), gi_host(gi_host), axes(axes),
+      tileOffsets(tileOffsets), tileSectors(tileSectors),
+      firstSector(firstSector), lastSector(lastSector), lookup(lookup)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    int imin, imax, jmin, jmax, kmin, kmax;
+    DType dx_sqr, dy_sqr, dz_sqr, val, ix, jy, kz;
+
+    int n_coils_cc = gi_host->n_coils_cc;
+    int dim_count = gi_host->is2Dprocessing ? 2 : 3;
+    const AxisKernel &kx = axes[0].axisKernel;
+    const AxisKernel &ky = axes[1].axisKernel;
+    const AxisKernel &kzk = axes[2].axisKernel;
+    // padded sector ranges reaching the tile per dimension
+    int count[3], lo[3][3], hi[3][3];
+
+    for (IndType tile = begin; tile < end; tile++)
+    {
+      int tiles[3] = { (int)tile % axes[0].tileCount,
+                       (int)tile / axes[0].tileCount % axes[1].tileCount,
+                       (int)tile / (axes[0].tileCount * axes[1].tileCount) };
+
+      for (IndType s = tileOffsets[tile]; s < tileOffsets[tile + 1]; s++)
+      {
+        IndType sec = tileSectors[s];
+        if (sec < firstSector || sec >= lastSector)
+          continue;
+        IndType3 center;
+        center.x = sector_centers[sec * dim_count];
+        center.y = sector_centers[sec * dim_count + 1];
+        center.z = gi_host->is2Dprocessing
+                       ? 0
+                       : sector_centers[sec * dim_count + 2];
+        count[0] = axes[0].getSpans(tiles[0], center.x, lo[0], hi[0]);
+        count[1] = axes[1].getSpans(tiles[1], center.y, lo[1], hi[1]);
+        count[2] = 1;
+        lo[2][0] = hi[2][0] = 0;
+        if (!gi_host->is2Dprocessing)
+          count[2] = axes[2].getSpans(tiles[2], center.z, lo[2], hi[2]);
+
+        for (IndType data_cnt = sectors[sec]; data_cnt < sectors[sec + 1];
+             data_cnt++)
+        {
+          DType3 data_point;
+          data_point.x = crds[data_cnt];
+          data_point.y = crds[data_cnt + gi_host->data_count];
+          data_point.z = gi_host->is2Dprocessing
+                             ? (DType)0.0
+                             : crds[data_cnt + 2 * gi_host->data_count];
+
+          // same footprint and kernel values as hostConvolution, restricted
+          // to the tile, samples missing the tile are skipped early
+          ix = mapKSpaceToGrid(data_point.x, gi_host->gridDims.x, center.x,
+                               kx.sector_offset);
+          set_minmax(&ix, &imin, &imax, kx.pad_max, kx.radius);
+          if (!overlaps(imin, imax, count[0], lo[0], hi[0]))
+            continue;
+          jy = mapKSpaceToGrid(data_point.y, gi_host->gridDims.y, center.y,
+                               ky.sector_offset);
+          set_minmax(&jy, &jmin, &jmax, ky.pad_max, ky.radius);
+          if (!overlaps(jmin, jmax, count[1], lo[1], hi[1]))
+            continue;
+          if (gi_host->is2Dprocessing)
+          {
+            kmin = kmax = 0;
+          }
+          else
+          {
+            kz = mapKSpaceToGrid(data_point.z, gi_host->gridDims.z, center.z,
+                                 kzk.sector_offset);
+            set_minmax(&kz, &kmin, &kmax, kzk.pad_max, kzk.radius);
+            if (!overlaps(kmin, kmax, count[2], lo[2], hi[2]))
+              continue;
+          }
+
+          for (int zs = 0; zs < count[2]; zs++)
+            for (int k = std::max(kmin, lo[2][zs]);
+                 k <= std::min(kmax, hi[2][zs]); k++)
+            {
+              int z_ind = 0;
+              DType z_val = (DType)1.0;
+              if (!gi_host->is2Dprocessing)
+              {
+                kz = mapGridToKSpace(k, gi_host->gridDims.z, center.z,
+                                     kzk.sector_offset);
+                dz_sqr = (kz - data_point.z) * gi_host->aniso_z_scale;
+                dz_sqr *= dz_sqr;
+                if (dz_sqr >= kzk.radiusSquared)
+                  continue;
+                z_ind = kzk.gridIndex(k, center.z, gi_host->gridDims.z);
+                z_val =
+                    lookup(kzk.table, kzk.last, dz_sqr * kzk.dist_multiplier);
+              }
+              for (int ys = 0; ys < count[1]; ys++)
+                for (int j = std::max(jmin, lo[1][ys]);
+                     j <= std::min(jmax, hi[1][ys]); j++)
+                {
+                  jy = mapGridToKSpace(j, gi_host->gridDims.y, center.y,
+                                       ky.sector_offset);
+                  dy_sqr = (jy - data_point.y) * gi_host->aniso_y_scale;
+                  dy_sqr *= dy_sqr;
+                  if (dy_sqr >= ky.radiusSquared)
+                    continue;
+                  int y_ind = ky.gridIndex(j, center.y, gi_host->gridDims.y);
+                  DType yz_val = z_val * lookup(ky.table, ky.last,
+                                                dy_sqr * ky.dist_multiplier);
+                  for (int xs = 0; xs < count[0]; xs++)
+                    for (int i = std::max(imin, lo[0][xs]);
+                         i <= std::min(imax, hi[0][xs]); i++)
+                    {
+                      ix = mapGridToKSpace(i, gi_host->gridDims.x, center.x,
+                                           kx.sector_offset);
+                      dx_sqr = (ix - data_point.x) * gi_host->aniso_x_scale;
+                      dx_sqr *= dx_sqr;
+                      if (dx_sqr >= kx.radiusSquared)
+                        continue;
+
+                      val = yz_val * lookup(kx.table, kx.last,
+                                            dx_sqr * kx.dist_multiplier);
+
+                      int ind = hostXYZ2Lin(
+                          kx.gridIndex(i, center.x, gi_host->gridDims.x),
+                          y_ind, z_ind, gi_host->gridDims);
+
+                      for (int c = 0; c < n_coils_cc; c++)
+                      {
+                        DType2 s_data =
+                            data[data_cnt + c * gi_host->data_count];
+                        CufftType &g = gdata[ind + c * gi_host->gridDims_count];
+                        g.x += val * s_data.x;
+                        g.y += val * s_data.y;
+                      }
+                    }  // x
+                }      // y
+            }          // z
+        }              // data points per sector
+      }                // sectors reaching the tile
+    }                  // tiles
+  }
+
+ private:
+  static bool overlaps(int min, int max, int count, const int *lo,
+                       const int *hi)
+  {
+    for (int n = 0; n < count; n++)
+      if (min <= hi[n] && lo[n] <= max)
+        return true;
+    return false;
+  }
+
+ private:
+  DType2 *data;
+  DType *crds;
+  CufftType *gdata;
+  IndType *sectors;
+  IndType *sector_centers;
+  gpuNUFFT::GpuNUFFTInfo *gi_host;
+  const GatherAxis *axes;
+  const IndType *tileOffsets;
+  const IndType *tileSectors;
+  IndType firstSector;
+  IndType lastSector;
+  Lookup lookup;
+};
+
+// tiles of sector width per dimension, z of 2-d grids is one tile
+void initGatherAxes(DType *kernel, gpuNUFFT::GpuNUFFTInfo *gi_host,
+                    std::vector<GatherAxis> &axes)
+{
+  int width = gi_host->sector_width;
+  axes.push_back(
+      GatherAxis(AxisKernel(kernel, gi_host, 0), gi_host->gridDims.x, width));
+  axes.push_back(
+      GatherAxis(AxisKernel(kernel, gi_host, 1), gi_host->gridDims.y, width));
+  axes.push_back(GatherAxis(AxisKernel(kernel, gi_host, 2),
+                            gi_host->is2Dprocessing ? 1 : gi_host->gridDims.z,
+                            gi_host->is2Dprocessing ? 1 : width));
+}
+
+template <typename Lookup>
+void hostGatherConvolution(DType2 *data, DType *crds, CufftType *gdata,
+                           DType *kernel, IndType *sectors,
+                           IndType *sector_centers,
+                           gpuNUFFT::GpuNUFFTInfo *gi_host,
+                           const std::vector<IndType> &tileOffsets,
+                           const std::vector<IndType> &tileSectors,
+                           IndType firstSector, IndType lastSector,
+                           Lookup lookup)
+{
+  std::vector<GatherAxis> axes;
+  initGatherAxes(kernel, gi_host, axes);
+  GatherConvolutionTask<Lookup> task(data, crds, gdata, sectors,
+                                     sector_centers, gi_host, &axes[0],
+                                     &tileOffsets[0],
+                                     tileSectors.empty() ? NULL
+                                                         : &tileSectors[0],
+                                     firstSector, lastSector, lookup);
+  gpuNUFFT::hostParallelFor(tileOffsets.size() - 2, task);
+}
+
+// sector holding the sample at sorted position data_cnt, the first sector
+// if data_cnt precedes all sectors
+int findSector(const IndType *sectors, int sector_count, IndType data_cnt)
+{
+  int sec = (int)(std::upper_bound(sectors, sectors + sector_count + 1,
+                                   data_cnt) -
+                  sectors) -
+            1;
+  return std::max(sec, 0);
+}
+
+// forward convolution of the samples [begin, end) in sorted order, each
+// sample is written by its own call only
+template <typename Lookup>
+void hostForwardConvolution(CufftType *data, DType *crds, CufftType *gdata,
+                            DType *kernel, IndType *sectors,
+                            IndType *sector_centers,
+                            gpuNUFFT::GpuNUFFTInfo *gi_host, Lookup lookup,
+                            IndType begin, IndType end)
+{
+  int imin, imax, jmin, jmax, kmin, kmax;
+  DType dx_sqr, dy_sqr, dz_sqr, val, ix, jy, kz;
+
+  int n_coils_cc = gi_host->n_coils_cc;
+  int dim_count = gi_host->is2Dprocessing ? 2 : 3;
+  AxisKernel kx(kernel, gi_host, 0);
+  AxisKernel ky(kernel, gi_host, 1);
+  AxisKernel kzk(kernel, gi_host, 2);
+
+  for (int sec = findSector(sectors, gi_host->sector_count, begin);
+       sec < gi_host->sector_count && sectors[sec] < end; sec++)
+  {
+    IndType3 center;
+    center.x = sector_centers[sec * dim_count];
+    center.y = sector_centers[sec * dim_count + 1];
+    center.z = gi_host->is2Dprocessing ? 0
+                                        : sector_centers[sec * dim_count + 2];
+
+    for (IndType data_cnt = std::max(sectors[sec], begin);
+         data_cnt < std::min(sectors[sec + 1], end); data_cnt++)
+    {
+      DType3 data_point;
+      data_point.x = crds[data_cnt];
+      data_point.y = crds[data_cnt + gi_host->data_count];
+      data_point.z = gi_host->is2Dprocessing
+                         ? (DType)0.0
+                         : crds[data_cnt + 2 * gi_host->data_count];
+
+      for (int c = 0; c < n_coils_cc; c++)
+      {
+        data[data_cnt + c * gi_host->data_count].x = (DType)0.0;
+        data[data_cnt + c * gi_host->data_count].y = (DType)0.0;
+      }
+
+      // set the boundaries of final dataset for gpuNUFFT this point
+      ix = mapKSpaceToGrid(data_point.x, gi_host->gridDims.x, center.x,
+                           kx.sector_offset);
+      set_minmax(&ix, &imin, &imax, kx.pad_max, kx.radius);
+      jy = mapKSpaceToGrid(data_point.y, gi_host->gridDims.y, center.y,
+                           ky.sector_offset);
+      set_minmax(&jy, &jmin, &jmax, ky.pad_max, ky.radius);
+      if (gi_host->is2Dprocessing)
+      {
+        kmin = kmax = 0;
+      }
+      else
+      {
+        kz = mapKSpaceToGrid(data_point.z, gi_host->gridDims.z, center.z,
+                             kzk.sector_offset);
+        set_minmax(&kz, &kmin, &kmax, kzk.pad_max, kzk.radius);
+      }
+
+      // convolve neighboring cartesian points to this data point
+      for (int k = kmin; k <= kmax; k++)
+      {
+        int z_ind = 0;
+        DType z_val = (DType)1.0;
+        if (!gi_host->is2Dprocessing)
+        {
+          kz = mapGridToKSpace(k, gi_host->gridDims.z, center.z,
+                               kzk.sector_offset);
+          dz_sqr = (kz - data_point.z) * gi_host->aniso_z_scale;
+          dz_sqr *= dz_sqr;
+          if (dz_sqr >= kzk.radiusSquared)
+            continue;
+          z_ind = kzk.gridIndex(k, center.z, gi_host->gridDims.z);
+          z_val = lookup(kzk.table, kzk.last, dz_sqr * kzk.dist_multiplier);
+        }
+        for (int j = jmin; j <= jmax; j++)
+        {
+          jy = mapGridToKSpace(j, gi_host->gridDims.y, center.y,
+                               ky.sector_offset);
+          dy_sqr = (jy - data_point.y) * gi_host->aniso_y_scale;
+          dy_sqr *= dy_sqr;
+          if (dy_sqr >= ky.radiusSquared)
+            continue;
+          int y_ind = ky.gridIndex(j, center.y, gi_host->gridDims.y);
+          DType yz_val =
+              z_val * lookup(ky.table, ky.last, dy_sqr * ky.dist_multiplier);
+          for (int i = imin; i <= imax; i++)
+          {
+            ix = mapGridToKSpace(i, gi_host->gridDims.x, center.x,
+                                 kx.sector_offset);
+            dx_sqr = (ix - data_point.x) * gi_host->aniso_x_scale;
+            dx_sqr *= dx_sqr;
+            if (dx_sqr >= kx.radiusSquared)
+              continue;
+
+            val = yz_val *
+                  lookup(kx.table, kx.last, dx_sqr * kx.dist_multiplier);
+
+            int ind = hostXYZ2Lin(
+                kx.gridIndex(i, center.x, gi_host->gridDims.x),
+                y_ind, z_ind, gi_host->gridDims);
+
+            for (int c = 0; c < n_coils_cc; c++)
+            {
+              CufftType g = gdata[ind + c * gi_host->gridDims_count];
+              data[data_cnt + c * gi_host->data_count].x += g.x * val;
+              data[data_cnt + c * gi_host->data_count].y += g.y * val;
+            }
+          }  // x
+        }    // y
+      }      // z
+    }        // data points per sector
+  }          // sectors
+}
+
+// forward convolution of hostForwardConvolution which in addition computes
+// the derivatives of the samples with respect to their coordinates from the
+// derivative tables in the same pass. The weight of a grid point is
+// T(u_x) T(u_y) T(u_z) with the table position u = (a (g - k))^2 m, thus
+// dT(u)/dk = -2 a^2 m (g - k) T'(u).
+template <typename Lookup>
+void hostForwardConvolutionGradient(CufftType *data, CufftType *gradient,
+                                    DType *crds, CufftType *gdata,
+                                    DType *kernel, DType *kernelDerivative,
+                                    IndType *sectors, IndType *sector_centers,
+                                    gpuNUFFT::GpuNUFFTInfo *gi_host,
+                                    Lookup lookup, IndType begin, IndType end)
+{
+  int imin, imax, jmin, jmax, kmin, kmax;
+  DType ix, jy, kz;
+
+  int n_coils_cc = gi_host->n_coils_cc;
+  int dim_count = gi_host->is2Dprocessing ? 2 : 3;
+  int axis_stride = n_coils_cc * gi_host->data_count;
+  AxisKernel kx(kernel, gi_host, 0);
+  AxisKernel ky(kernel, gi_host, 1);
+  AxisKernel kzk(kernel, gi_host, 2);
+  AxisKernel dkx(kernelDerivative, gi_host, 0, false);
+  AxisKernel dky(kernelDerivative, gi_host, 1, false);
+  AxisKernel dkz(kernelDerivative, gi_host, 2, false);
+  DType gx = (DType)-2.0 * gi_host->aniso_x_scale * gi_host->aniso_x_scale *
+             kx.dist_multiplier;
+  DType gy = (DType)-2.0 * gi_host->aniso_y_scale * gi_host->aniso_y_scale *
+             ky.dist_multiplier;
+  DType gz = (DType)-2.0 * gi_host->aniso_z_scale * gi_host->aniso_z_scale *
+             kzk.dist_multiplier;
+
+  for (int sec = findSector(sectors, gi_host->sector_count, begin);
+       sec < gi_host->sector_count && sectors[sec] < end; sec++)
+  {
+    IndType3 center;
+    center.x = sector_centers[sec * dim_count];
+    center.y = sector_centers[sec * dim_count + 1];
+    center.z = gi_host->is2Dprocessing ? 0
+                                        : sector_centers[sec * dim_count + 2];
+
+    for (IndType data_cnt = std::max(sectors[sec], begin);
+         data_cnt < std::min(sectors[sec + 1], end); data_cnt++)
+    {
+      DType3 data_point;
+      data_point.x = crds[data_cnt];
+      data_point.y = crds[data_cnt + gi_host->data_count];
+      data_point.z = gi_host->is2Dprocessing
+                         ? (DType)0.0
+                         : crds[data_cnt + 2 * gi_host->data_count];
+
+      for (int c = 0; c < n_coils_cc; c++)
+      {
+        int t = data_cnt + c * gi_host->data_count;
+        data[t].x = data[t].y = (DType)0.0;
+        for (int d = 0; d < dim_count; d++)
+          gradient[t + d * axis_stride].x = gradient[t + d * axis_stride].y =
+              (DType)0.0;
+      }
+
+      ix = mapKSpaceToGrid(data_point.x, gi_host->gridDims.x, center.x,
+                           kx.sector_offset);
+      set_minmax(&ix, &imin, &imax, kx.pad_max, kx.radius);
+      jy = mapKSpaceToGrid(data_point.y, gi_host->gridDims.y, center.y,
+                           ky.sector_offset);
+      set_minmax(&jy, &jmin, &jmax, ky.pad_max, ky.radius);
+      if (gi_host->is2Dprocessing)
+      {
+        kmin = kmax = 0;
+      }
+      else
+      {
+        kz = mapKSpaceToGrid(data_point.z, gi_host->gridDims.z, center.z,
+                             kzk.sector_offset);
+        set_minmax(&kz, &kmin, &kmax, kzk.pad_max, kzk.radius);
+      }
+
+      for (int k = kmin; k <= kmax; k++)
+      {
+        int z_ind = 0;
+        DType z_val = (DType)1.0, z_der = (DType)0.0;
+        if (!gi_host->is2Dprocessing)
+        {
+          kz = mapGridToKSpace(k, gi_host->gridDims.z, center.z,
+                               kzk.sector_offset);
+          DType dz = kz - data_point.z;
+          DType dz_sqr = dz * gi_host->aniso_z_scale;
+          dz_sqr *= dz_sqr;
+          if (dz_sqr >= kzk.radiusSquared)
+            continue;
+          z_ind = kzk.gridIndex(k, center.z, gi_host->gridDims.z);
+          DType pos = dz_sqr * kzk.dist_multiplier;
+          z_val = lookup(kzk.table, kzk.last, pos);
+          z_der = gz * dz * lookup(dkz.table, dkz.last, pos);
+        }
+        for (int j = jmin; j <= jmax; j++)
+        {
+          jy = mapGridToKSpace(j, gi_host->gridDims.y, center.y,
+                               ky.sector_offset);
+          DType dy = jy - data_point.y;
+          DType dy_sqr = dy * gi_host->aniso_y_scale;
+          dy_sqr *= dy_sqr;
+          if (dy_sqr >= ky.radiusSquared)
+            continue;
+          int y_ind = ky.gridIndex(j, center.y, gi_host->gridDims.y);
+          DType pos = dy_sqr * ky.dist_multiplier;
+          DType y_val = lookup(ky.table, ky.last, pos);
+          DType y_der = gy * dy * lookup(dky.table, dky.last, pos);
+          for (int i = imin; i <= imax; i++)
+          {
+            ix = mapGridToKSpace(i, gi_host->gridDims.x, center.x,
+                                 kx.sector_offset);
+            DType dx = ix - data_point.x;
+            DType dx_sqr = dx * gi_host->aniso_x_scale;
+            dx_sqr *= dx_sqr;
+            if (dx_sqr >= kx.radiusSquared)
+              continue;
+
+            DType x_pos = dx_sqr * kx.dist_multiplier;
+            DType x_val = lookup(kx.table, kx.last, x_pos);
+            DType x_der = gx * dx * lookup(dkx.table, dkx.last, x_pos);
+            DType val = x_val * y_val * z_val;
+            DType w[3] = { x_der * y_val * z_val, x_val * y_der * z_val,
+                           x_val * y_val * z_der };
+
+            int ind = hostXYZ2Lin(
+                kx.gridIndex(i, center.x, gi_host->gridDims.x),
+                y_ind, z_ind, gi_host->gridDims);
+
+            // one read of the grid value serves the sample and all
+            // derivatives
+            for (int c = 0; c < n_coils_cc; c++)
+            {
+              CufftType g = gdata[ind + c * gi_host->gridDims_count];
+              int t = data_cnt + c * gi_host->data_count;
+              data[t].x += g.x * val;
+              data[t].y += g.y * val;
+              for (int d = 0; d < dim_count; d++)
+              {
+                gradient[t + d * axis_stride].x += g.x * w[d];
+                gradient[t + d * axis_stride].y += g.y * w[d];
+              }
+            }
+          }  // x
+        }    // y
+      }      // z
+    }        // data points per sector
+  }          // sectors
+}
+
+// forward convolution, with the derivatives if gradient is set, split into
+// ranges of sorted samples which balance the work of the threads
+template <typename Lookup>
+class ForwardConvolutionTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  ForwardConvolutionTask(CufftType *data, CufftType *gradient, DType *crds,
+                         CufftType *gdata, DType *kernel,
+                         DType *kernelDerivative, IndType *sectors,
+                         IndType *sector_centers,
+                         gpuNUFFT::GpuNUFFTInfo *gi_host, Lookup lookup)
+    : data(data), gradient(gradient), crds(crds), gdata(gdata),
+      kernelData(kernel), kernelDerivative(kernelDerivative),
+      sectors(sectors),
+      sector_centers(sector_centers), gi_host(gi_host), lookup(lookup)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    if (gradient == NULL)
+      hostForwardConvolution(data, crds, gdata, kernelData, sectors,
+                             sector_centers, gi_host, lookup, begin, end);
+    else
+      hostForwardConvolutionGradient(data, gradient, crds, gdata, kernelData,
+                                     kernelDerivative, sectors,
+                                     sector_centers, gi_host, lookup, begin,
+                                     end);
+  }
+
+ private:
+  CufftType *data;
+  CufftType *gradient;
+  DType *crds;
+  CufftType *gdata;
+  DType *kernelData;
+  DType *kernelDerivative;
+  IndType *sectors;
+  IndType *sector_centers;
+  gpuNUFFT::GpuNUFFTInfo *gi_host;
+  Lookup lookup;
+};
+
+template <typename Lookup>
+void hostParallelForwardConvolution(CufftType *data, CufftType *gradient,
+                                    DType *crds, CufftType *gdata,
+                                    DType *kernel, DType *kernelDerivative,
+                                    IndType *sectors, IndType *sector_centers,
+                                    gpuNUFFT::GpuNUFFTInfo *gi_host,
+                                    Lookup lookup)
+{
+  ForwardConvolutionTask<Lookup> task(data, gradient, crds, gdata, kernel,
+                                      kernelDerivative, sectors,
+                                      sector_centers, gi_host, lookup);
+  gpuNUFFT::hostParallelFor(
+      gi_host->sector_count > 0 ? sectors[gi_host->sector_count] : 0, task);
+}
+}
+
+void performHostConvolution(DType2 *data, DType *crds, CufftType *gdata,
+                            DType *kernel, IndType *sectors,
+                            IndType *sector_centers,
+                            gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  if (gi_host->interpolationType == gpuNUFFT::TEXTURE_LOOKUP)
+    hostConvolution(data, crds, gdata, kernel, sectors, sector_centers,
+                    gi_host, LinearLookup());
+  else
+    hostConvolution(data, crds, gdata, kernel, sectors, sector_centers,
+                    gi_host, NearestNeighborLookup());
+}
+
+void buildHostGatherTiles(DType *kernel, IndType *sectors,
+                          IndType *sector_centers,
+                          gpuNUFFT::GpuNUFFTInfo *gi_host,
+                          std::vector<IndType> &tileOffsets,
+                          std::vector<IndType> &tileSectors)
+{
+  int dim_count = gi_host->is2Dprocessing ? 2 : 3;
+  std::vector<GatherAxis> axes;
+  initGatherAxes(kernel, gi_host, axes);
+  IndType tileCount =
+      (IndType)axes[0].tileCount * axes[1].tileCount * axes[2].tileCount;
+
+  // counted in the first and filled in the second pass, the last entry of
+  // tileOffsets is not used
+  tileOffsets.assign(tileCount + 2, 0);
+  std::vector<int> tiles[3];
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (int sec = 0; sec < gi_host->sector_count; sec++)
+    {
+      if (sectors[sec] == sectors[sec + 1])
+        continue;
+      for (int d = 0; d < 3; d++)
+        if (d < dim_count)
+          axes[d].addTiles(sector_centers[sec * dim_count + d], tiles[d]);
+        else
+          tiles[d].assign(1, 0);
+
+      for (unsigned z = 0; z < tiles[2].size(); z++)
+        for (unsigned y = 0; y < tiles[1].size(); y++)
+          for (unsigned x = 0; x < tiles[0].size(); x++)
+          {
+            IndType tile =
+                tiles[0][x] + axes[0].tileCount *
+                                  (tiles[1][y] + axes[1].tileCount *
+                                                     (IndType)tiles[2][z]);
+            if (pass == 0)
+              tileOffsets[tile + 2]++;
+            else
+              tileSectors[tileOffsets[tile + 1]++] = sec;
+          }
+    }
+    if (pass == 0)
+    {
+      for (IndType t = 2; t < tileOffsets.size(); t++)
+        tileOffsets[t] += tileOffsets[t - 1];
+      tileSectors.resize(tileOffsets.back());
+    }
+  }
+}
+
+void performHostGatherConvolution(DType2 *data, DType *crds, CufftType *gdata,
+                                  DType *kernel, IndType *sectors,
+                                  IndType *sector_centers,
+                                  gpuNUFFT::GpuNUFFTInfo *gi_host,
+                                  const std::vector<IndType> &tileOffsets,
+                                  const std::vector<IndType> &tileSectors,
+                                  IndType firstSector, IndType lastSector)
+{
+  if (gi_host->interpolationType == gpuNUFFT::TEXTURE_LOOKUP)
+    hostGatherConvolution(data, crds, gdata, kernel, sectors, sector_centers,
+                          gi_host, tileOffsets, tileSectors, firstSector,
+                          lastSector, LinearLookup());
+  else
+    hostGatherConvolution(data, crds, gdata, kernel, sectors, sector_centers,
+                          gi_host, tileOffsets, tileSectors, firstSector,
+                          lastSector, NearestNeighborLookup());
+}
+
+void performHostForwardConvolution(CufftType *data, DType *crds,
+                                   CufftType *gdata, DType *kernel,
+                                   IndType *sectors, IndType *sector_centers,
+                                   gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  if (gi_host->interpolationType == gpuNUFFT::TEXTURE_LOOKUP)
+    hostParallelForwardConvolution(data, NULL, crds, gdata, kernel, NULL,
+                                   sectors, sector_centers, gi_host,
+                                   LinearLookup());
+  else
+    hostParallelForwardConvolution(data, NULL, crds, gdata, kernel, NULL,
+                                   sectors, sector_centers, gi_host,
+                                   NearestNeighborLookup());
+}
+
+void performHostForwardConvolutionGradient(
+    CufftType *data, CufftType *gradient, DType *crds, CufftType *gdata,
+    DType *kernel, DType *kernelDerivative, IndType *sectors,
+    IndType *sector_centers, gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  if (gi_host->interpolationType == gpuNUFFT::TEXTURE_LOOKUP)
+    hostParallelForwardConvolution(data, gradient, crds, gdata, kernel,
+                                   kernelDerivative, sectors, sector_centers,
+                                   gi_host, LinearLookup());
+  else
+    hostParallelForwardConvolution(data, gradient, crds, gdata, kernel,
+                                   kernelDerivative, sectors, sector_centers,
+                                   gi_host, NearestNeighborLookup());
+}
+
+void performHostFFTShift(CufftType *gdata, gpuNUFFT::FFTShiftDir shift_dir,
+                         gpuNUFFT::Dimensions gridDims,
+                         gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  IndType3 offset;
+  if (shift_dir == gpuNUFFT::FORWARD)
+  {
+    offset.x = (int)ceil((DType)(gridDims.width / (DType)2.0));
+    offset.y = (int)ceil((DType)(gridDims.height / (DType)2.0));
+    offset.z = (int)ceil((DType)(gridDims.depth / (DType)2.0));
+  }
+  else
+  {
+    offset.x = (int)floor((DType)(gridDims.width / (DType)2.0));
+    offset.y = (int)floor((DType)(gridDims.height / (DType)2.0));
+    offset.z = (int)floor((DType)(gridDims.depth / (DType)2.0));
+  }
+
+  IndType w = gridDims.width;
+  IndType h = gridDims.height;
+  IndType d = DEFAULT_VALUE(gridDims.depth);
+
+  // out[x] = in[(x + offset) % dim] is a rotation along each axis
+  for (int c = 0; c < gi_host->n_coils_cc; c++)
+  {
+    CufftType *grid = gdata + c * w * h * d;
+    if (offset.x > 0)
+      for (IndType r = 0; r < h * d; r++)
+        std::rotate(grid + r * w, grid + r * w + offset.x, grid + (r + 1) * w);
+    if (offset.y > 0)
+      for (IndType z = 0; z < d; z++)
+        std::rotate(grid + z * w * h, grid + z * w * h + offset.y * w,
+                    grid + (z + 1) * w * h);
+    if (offset.z > 0)
+      std::rotate(grid, grid + offset.z * w * h, grid + d * w * h);
+  }
+}
+
+// offset of the image inside the oversampled grid
+static IndType3 computeImageOffset(gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  IndType3 ind_off;
+  ind_off.x = (IndType)(gi_host->imgDims.x * ((DType)gi_host->osr - 1.0f) /
+                        (DType)2);
+  ind_off.y = (IndType)(gi_host->imgDims.y * ((DType)gi_host->osr - 1.0f) /
+                        (DType)2);
+  ind_off.z = (IndType)(gi_host->imgDims.z * ((DType)gi_host->osr - 1.0f) /
+                        (DType)2);
+  return ind_off;
+}
+
+IndType3 computeHostShiftedImageOffset(gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  // grid index i holds the unshifted index (i + floor(n/2)) % n
+  IndType3 ind_off = computeImageOffset(gi_host);
+  IndType3 offset;
+  offset.x = (ind_off.x + gi_host->gridDims.x - gi_host->gridDims.x / 2) %
+             gi_host->gridDims.x;
+  offset.y = (ind_off.y + gi_host->gridDims.y - gi_host->gridDims.y / 2) %
+             gi_host->gridDims.y;
+  offset.z = gi_host->is2Dprocessing
+                 ? 0
+                 : (ind_off.z + gi_host->gridDims.z - gi_host->gridDims.z / 2) %
+                       gi_host->gridDims.z;
+  return offset;
+}
+
+IndType3 computeHostAdjointImageOffset(gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  // the inverse FFT shift after the FFT moves grid index i to
+  // (i + n - floor(n/2)) % n, where the crop reads the image region
+  IndType3 ind_off = computeImageOffset(gi_host);
+  IndType3 offset;
+  offset.x = (ind_off.x + gi_host->gridDims.x / 2) % gi_host->gridDims.x;
+  offset.y = (ind_off.y + gi_host->gridDims.y / 2) % gi_host->gridDims.y;
+  offset.z = gi_host->is2Dprocessing
+                 ? 0
+                 : (ind_off.z + gi_host->gridDims.z / 2) % gi_host->gridDims.z;
+  return offset;
+}
+
+namespace
+{
+// copies the image rows [begin, end) of all coils from (crop) or to
+// (padding) the oversampled grid, row r is the image row y = r % height of
+// slice z = r / height
+class CopyRowsTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  CopyRowsTask(CufftType *gdata, CufftType *imdata,
+               gpuNUFFT::GpuNUFFTInfo *gi_host, bool crop)
+    : gdata(gdata), imdata(imdata), gi_host(gi_host),
+      ind_off(computeImageOffset(gi_host)), crop(crop)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    int N = gi_host->im_width_dim;
+    IndType width = gi_host->imgDims.x;
+    for (IndType r = begin; r < end; r++)
+    {
+      IndType y = r % gi_host->imgDims.y;
+      IndType z = r / gi_host->imgDims.y;
+      int grid_ind = hostXYZ2Lin(ind_off.x, ind_off.y + y, ind_off.z + z,
+                                 gi_host->gridDims);
+      int t = (int)(r * width);
+      for (int c = 0; c < gi_host->n_coils_cc; c++)
+      {
+        CufftType *grid = gdata + grid_ind + c * gi_host->gridDims_count;
+        if (crop)
+          std::copy(grid, grid + width, imdata + t + c * N);
+        else
+          std::copy(imdata + t + c * N, imdata + t + c * N + width, grid);
+      }
+    }
+  }
+
+ private:
+  CufftType *gdata;
+  CufftType *imdata;
+  gpuNUFFT::GpuNUFFTInfo *gi_host;
+  IndType3 ind_off;
+  bool crop;
+};
+}
+
+void performHostCrop(CufftType *gdata, CufftType *imdata,
+                     gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  CopyRowsTask task(gdata, imdata, gi_host, true);
+  gpuNUFFT::hostParallelFor(
+      DEFAULT_VALUE(gi_host->imgDims.z) * gi_host->imgDims.y, task);
+}
+
+void performHostPadding(DType2 *imdata, CufftType *gdata,
+                        gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  CopyRowsTask task(gdata, imdata, gi_host, false);
+  gpuNUFFT::hostParallelFor(
+      DEFAULT_VALUE(gi_host->imgDims.z) * gi_host->imgDims.y, task);
+}
+
+bool isHostFusedImagePassSupported(gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  return gi_host->gridDims.x % 2 == 0 && gi_host->gridDims.y % 2 == 0 &&
+         (gi_host->is2Dprocessing || gi_host->gridDims.z % 2 == 0);
+}
+
+// grid position and checkerboard sign of the image indices of one dimension
+// for the fused passes, see performHostFusedCrop
+static void computeFusedAxis(IndType imgWidth, IndType gridWidth,
+                             IndType offset, std::vector<int> &index,
+                             std::vector<DType> &sign)
+{
+  index.resize(imgWidth);
+  sign.resize(imgWidth);
+  for (IndType i = 0; i < imgWidth; i++)
+  {
+    IndType k = offset + i + gridWidth / 2;
+    index[i] = (int)(k % gridWidth);
+    sign[i] = (k % 2) ? (DType)-1.0 : (DType)1.0;
+  }
+}
+
+// grid positions and signs of the region indices of one dimension, shifted
+// grids hold the region in place, see computeFusedAxis otherwise
+static void computeRegionAxis(IndType count, IndType gridWidth, IndType offset,
+                              bool shifted, std::vector<int> &index,
+                              std::vector<DType> &sign)
+{
+  if (!shifted)
+  {
+    computeFusedAxis(count, gridWidth, offset, index, sign);
+    return;
+  }
+  index.resize(count);
+  sign.assign(count, (DType)1.0);
+  for (IndType i = 0; i < count; i++)
+    index[i] = (int)(offset + i);
+}
+
+namespace
+{
+// region crop of the box rows [begin, end) of all coils, row r is the box row
+// y = r % roiDims.height of slice z = r / roiDims.height. The coils are
+// summed per pixel in coil order.
+class RegionCropTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  RegionCropTask(CufftType *gdata, CufftType *roidata, DType *deapo,
+                 DType2 *sens, CufftType *roidata_sum, IndType3 roiOffset,
+                 gpuNUFFT::Dimensions roiDims, bool shifted,
+                 gpuNUFFT::GpuNUFFTInfo *gi_host)
+    : gdata(gdata), roidata(roidata), deapo(deapo), sens(sens),
+      roidata_sum(roidata_sum), roiOffset(roiOffset), roiDims(roiDims),
+      gi_host(gi_host)
+  {
+    IndType3 ind_off = computeImageOffset(gi_host);
+    computeRegionAxis(roiDims.width, gi_host->gridDims.x,
+                      ind_off.x + roiOffset.x, shifted, ix, sx);
+    computeRegionAxis(roiDims.height, gi_host->gridDims.y,
+                      ind_off.y + roiOffset.y, shifted, iy, sy);
+    if (gi_host->is2Dprocessing)
+    {
+      iz.assign(1, 0);
+      sz.assign(1, (DType)1.0);
+    }
+    else
+      computeRegionAxis(roiDims.depth, gi_host->gridDims.z,
+                        ind_off.z + roiOffset.z, shifted, iz, sz);
+  }
+
+  IndType getRowCount() const
+  {
+    return (IndType)iz.size() * roiDims.height;
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    int N = gi_host->im_width_dim;
+    int roi_count = (int)(roiDims.width * getRowCount());
+    DType scaling_factor =
+        (DType)1.0 / (DType)sqrt((DType)gi_host->im_width_dim);
+
+    for (IndType row = begin; row < end; row++)
+    {
+      IndType y = row % roiDims.height;
+      IndType z = row / roiDims.height;
+      int grid_ind = hostXYZ2Lin(0, iy[y], iz[z], gi_host->gridDims);
+      // image index of the first element of the box row
+      int first = hostXYZ2Lin(roiOffset.x, roiOffset.y + y, roiOffset.z + z,
+                              gi_host->imgDims);
+      DType rowFactor = scaling_factor * sy[y] * sz[z];
+      for (IndType x = 0; x < roiDims.width; x++)
+      {
+        int t = first + (int)x;
+        int r = (int)(row * roiDims.width + x);
+        DType f = rowFactor * sx[x];
+        if (deapo != NULL)
+          f *= deapo[t];
+        for (int c = 0; c < gi_host->n_coils_cc; c++)
+        {
+          CufftType v = gdata[grid_ind + ix[x] + c * gi_host->gridDims_count];
+          v.x *= f;
+          v.y *= f;
+          if (sens == NULL)
+          {
+            roidata[r + c * roi_count] = v;
+            continue;
+          }
+          DType2 s = sens[t + c * N];
+          roidata_sum[r].x += v.x * s.x + v.y * s.y;
+          roidata_sum[r].y += v.y * s.x - v.x * s.y;
+        }
+      }
+    }
+  }
+
+ private:
+  CufftType *gdata;
+  CufftType *roidata;
+  DType *deapo;
+  DType2 *sens;
+  CufftType *roidata_sum;
+  IndType3 roiOffset;
+  gpuNUFFT::Dimensions roiDims;
+  gpuNUFFT::GpuNUFFTInfo *gi_host;
+  std::vector<int> ix, iy, iz;
+  std::vector<DType> sx, sy, sz;
+};
+}
+
+void performHostFusedCrop(CufftType *gdata, CufftType *imdata, DType *deapo,
+                          DType2 *sens, CufftType *imdata_sum,
+                          gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  // the whole image is the region at offset 0
+  IndType3 roiOffset;
+  roiOffset.x = roiOffset.y = roiOffset.z = 0;
+  gpuNUFFT::Dimensions roiDims(gi_host->imgDims.x, gi_host->imgDims.y,
+                               gi_host->imgDims.z);
+  performHostRegionCrop(gdata, imdata, deapo, sens, imdata_sum, roiOffset,
+                        roiDims, false, gi_host);
+}
+
+void performHostRegionCrop(CufftType *gdata, CufftType *roidata, DType *deapo,
+                           DType2 *sens, CufftType *roidata_sum,
+                           IndType3 roiOffset, gpuNUFFT::Dimensions roiDims,
+                           bool shifted, gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  RegionCropTask task(gdata, roidata, deapo, sens, roidata_sum, roiOffset,
+                      roiDims, shifted, gi_host);
+  gpuNUFFT::hostParallelFor(task.getRowCount(), task);
+}
+
+namespace
+{
+enum ElementPass
+{
+  FFT_SCALING,
+  DEAPODIZATION,
+  SENS_MUL,
+  SENS_CONJUGATE_MUL,
+  SENS_SUM,
+  DENSITY_COMPENSATION
+};
+
+// element wise pass over the elements [begin, end) of all coils, coil c of
+// element t is data[t + c * N]
+class ElementPassTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  ElementPassTask(ElementPass pass, DType2 *data, int N, int n_coils,
+                  const DType *factors, const DType2 *sens,
+                  CufftType *data_sum)
+    : pass(pass), data(data), N(N), n_coils(n_coils), factors(factors),
+      sens(sens), data_sum(data_sum)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (int t = (int)begin; t < (int)end; t++)
+    {
+      DType f = (DType)1.0;
+      if (pass == FFT_SCALING)
+        f = factors[0];
+      else if (pass == DEAPODIZATION)
+        f = factors[t];
+      else if (pass == DENSITY_COMPENSATION)
+        f = sqrt(factors[t]);
+
+      for (int c = 0; c < n_coils; c++)
+      {
+        DType2 &v = data[t + c * N];
+        if (pass == SENS_SUM)
+        {
+          data_sum[t].x += v.x;
+          data_sum[t].y += v.y;
+        }
+        else if (pass == SENS_MUL || pass == SENS_CONJUGATE_MUL)
+        {
+          DType2 data_p = v;
+          DType2 s = sens[t + c * N];
+          if (pass == SENS_CONJUGATE_MUL)
+          {
+            v.x = data_p.x * s.x + data_p.y * s.y;  // Re
+            v.y = data_p.y * s.x - data_p.x * s.y;  // Im
+          }
+          else
+          {
+            v.x = data_p.x * s.x - data_p.y * s.y;  // Re
+            v.y = data_p.x * s.y + data_p.y * s.x;  // Im
+          }
+        }
+        else
+        {
+          v.x *= f;
+          v.y *= f;
+        }
+      }
+    }
+  }
+
+ private:
+  ElementPass pass;
+  DType2 *data;
+  int N;
+  int n_coils;
+  const DType *factors;
+  const DType2 *sens;
+  CufftType *data_sum;
+};
+}
+
+void performHostFFTScaling(CufftType *data, int N,
+                           gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  DType scaling_factor =
+      (DType)1.0 / (DType)sqrt((DType)gi_host->im_width_dim);
+  ElementPassTask task(FFT_SCALING, data, N, gi_host->n_coils_cc,
+                       &scaling_factor, NULL, NULL);
+  gpuNUFFT::hostParallelFor(N, task);
+}
+
+void performHostDeapodization(CufftType *imdata, DType *deapo,
+                              gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  int N = gi_host->im_width_dim;
+  ElementPassTask task(DEAPODIZATION, imdata, N, gi_host->n_coils_cc, deapo,
+                       NULL, NULL);
+  gpuNUFFT::hostParallelFor(N, task);
+}
+
+void performHostSensMul(CufftType *imdata, DType2 *sens,
+                        gpuNUFFT::GpuNUFFTInfo *gi_host, bool conjugate)
+{
+  int N = gi_host->im_width_dim;
+  ElementPassTask task(conjugate ? SENS_CONJUGATE_MUL : SENS_MUL, imdata, N,
+                       gi_host->n_coils_cc, NULL, sens, NULL);
+  gpuNUFFT::hostParallelFor(N, task);
+}
+
+void performHostSensSum(CufftType *imdata, CufftType *imdata_sum,
+                        gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  int N = gi_host->im_width_dim;
+  ElementPassTask task(SENS_SUM, imdata, N, gi_host->n_coils_cc, NULL, NULL,
+                       imdata_sum);
+  gpuNUFFT::hostParallelFor(N, task);
+}
+
+void performHostDensityCompensation(DType2 *data, DType *density_comp,
+                                    gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  int N = gi_host->data_count;
+  ElementPassTask task(DENSITY_COMPENSATION, data, N, gi_host->n_coils_cc,
+                       density_comp, NULL, NULL);
+  gpuNUFFT::hostParallelFor(N, task);
+}
+
+namespace
+{
+// fused padding of the image rows [begin, end) of all coils, see
+// RegionCropTask for the row order
+class FusedPaddingTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  FusedPaddingTask(DType2 *imdata, CufftType *gdata, DType *deapo,
+                   DType2 *sens, gpuNUFFT::GpuNUFFTInfo *gi_host)
+    : imdata(imdata), gdata(gdata), deapo(deapo), sens(sens), gi_host(gi_host)
+  {
+    IndType3 ind_off = computeImageOffset(gi_host);
+    computeFusedAxis(gi_host->imgDims.x, gi_host->gridDims.x, ind_off.x, ix,
+                     sx);
+    computeFusedAxis(gi_host->imgDims.y, gi_host->gridDims.y, ind_off.y, iy,
+                     sy);
+    if (gi_host->is2Dprocessing)
+    {
+      iz.assign(1, 0);
+      sz.assign(1, (DType)1.0);
+    }
+    else
+      computeFusedAxis(gi_host->imgDims.z, gi_host->gridDims.z, ind_off.z, iz,
+                       sz);
+  }
+
+  IndType getRowCount() const
+  {
+    return (IndType)iz.size() * gi_host->imgDims.y;
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    int N = gi_host->im_width_dim;
+    for (IndType row = begin; row < end; row++)
+    {
+      IndType y = row % gi_host->imgDims.y;
+      IndType z = row / gi_host->imgDims.y;
+      int grid_ind = hostXYZ2Lin(0, iy[y], iz[z], gi_host->gridDims);
+      DType rowFactor = sy[y] * sz[z];
+      for (IndType x = 0; x < gi_host->imgDims.x; x++)
+      {
+        int t = (int)(row * gi_host->imgDims.x + x);
+        DType f = rowFactor * sx[x] * deapo[t];
+        for (int c = 0; c < gi_host->n_coils_cc; c++)
+        {
+          // the image is repeated for each coil in case of sensitivity data
+          DType2 v = sens != NULL ? imdata[t] : imdata[t + c * N];
+          if (sens != NULL)
+          {
+            DType2 s = sens[t + c * N];
+            DType2 p;
+            p.x = v.x * s.x - v.y * s.y;
+            p.y = v.x * s.y + v.y * s.x;
+            v = p;
+          }
+          CufftType &g = gdata[grid_ind + ix[x] + c * gi_host->gridDims_count];
+          g.x = v.x * f;
+          g.y = v.y * f;
+        }
+      }
+    }
+  }
+
+ private:
+  DType2 *imdata;
+  CufftType *gdata;
+  DType *deapo;
+  DType2 *sens;
+  gpuNUFFT::GpuNUFFTInfo *gi_host;
+  std::vector<int> ix, iy, iz;
+  std::vector<DType> sx, sy, sz;
+};
+}
+
+void performHostFusedPadding(DType2 *imdata, CufftType *gdata, DType *deapo,
+                             DType2 *sens, gpuNUFFT::GpuNUFFTInfo *gi_host)
+{
+  FusedPaddingTask task(imdata, gdata, deapo, sens, gi_host);
+  gpuNUFFT::hostParallelFor(task.getRowCount(), task);
+}
+
+namespace
+{
+// copies the samples [begin, end) of all coils from (select) or to (write)
+// their position in the data order
+class OrderedCopyTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  OrderedCopyTask(DType2 *data, IndType *data_indices, DType2 *data_sorted,
+                  int N, int n_coils_cc, bool select)
+    : data(data), data_indices(data_indices), data_sorted(data_sorted), N(N),
+      n_coils_cc(n_coils_cc), select(select)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (int c = 0; c < n_coils_cc; c++)
+      for (IndType t = begin; t < end; t++)
+        if (select)
+          data_sorted[t + c * N] = data[data_indices[t] + c * N];
+        else
+          data[data_indices[t] + c * N] = data_sorted[t + c * N];
+  }
+
+ private:
+  DType2 *data;
+  IndType *data_indices;
+  DType2 *data_sorted;
+  int N;
+  int n_coils_cc;
+  bool select;
+};
+}
+
+void selectOrderedHost(DType2 *data, IndType *data_indices,
+                       DType2 *data_sorted, int N, int n_coils_cc)
+{
+  OrderedCopyTask task(data, data_indices, data_sorted, N, n_coils_cc, true);
+  gpuNUFFT::hostParallelFor(N, task);
+}
+
+void writeOrderedHost(DType2 *data_sorted, IndType *data_indices,
+                      CufftType *data, int N, int n_coils_cc)
+{
+  OrderedCopyTask task(data_sorted, data_indices, data, N, n_coils_cc, false);
+  gpuNUFFT::hostParallelFor(N, task);
+}
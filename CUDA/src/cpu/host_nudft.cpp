@@ -0,0 +1,284 @@
+#include "host_nudft.hpp"
+#include "host_parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+const double NUDFT_PI = 3.14159265358979323846;
+
+// samples sharing one set of twiddle tables
+const IndType NUDFT_BLOCK = 16;
+
+// table entries after which the twiddle recurrence is re-seeded exactly,
+// bounds the accumulated rounding error of the recurrence
+const IndType NUDFT_RESEED = 64;
+
+struct NUDFTGeometry
+{
+  NUDFTGeometry(const gpuNUFFT::Dimensions &imgDims)
+    : nx(imgDims.width), ny(DEFAULT_VALUE(imgDims.height)),
+      nz(DEFAULT_VALUE(imgDims.depth)), imgCount(nx * ny * nz),
+      is3D(imgDims.depth > 0), scale(1.0 / std::sqrt((double)imgCount))
+  {
+  }
+
+  IndType nx, ny, nz;
+  IndType imgCount;
+  bool is3D;
+  double scale;
+};
+
+// re[i * stride] + i im[i * stride] = exp(sign 2 pi i k (i - floor(n/2)))
+void fillTwiddles(double k, double sign, IndType n, double *re, double *im,
+                  IndType stride)
+{
+  double phase = sign * 2.0 * NUDFT_PI * k;
+  double stepRe = std::cos(phase);
+  double stepIm = std::sin(phase);
+  double offset = (double)(n / 2);
+  double r = 0.0, s = 0.0;
+  for (IndType i = 0; i < n; i++)
+  {
+    if (i % NUDFT_RESEED == 0)
+    {
+      double p = phase * ((double)i - offset);
+      r = std::cos(p);
+      s = std::sin(p);
+    }
+    else
+    {
+      double rNext = r * stepRe - s * stepIm;
+      s = r * stepIm + s * stepRe;
+      r = rNext;
+    }
+    re[i * stride] = r;
+    im[i * stride] = s;
+  }
+}
+
+// tables of the y and z axis for samples [j0, j0 + bCount), one row per sample
+void fillOuterTwiddles(const DType *crds, IndType dataCount, IndType j0,
+                       IndType bCount, double sign, const NUDFTGeometry &geo,
+                       double *tyRe, double *tyIm, double *tzRe, double *tzIm)
+{
+  for (IndType b = 0; b < bCount; b++)
+  {
+    IndType j = j0 + b;
+    fillTwiddles(crds[j + dataCount], sign, geo.ny, tyRe + b * geo.ny,
+                 tyIm + b * geo.ny, 1);
+    if (geo.is3D)
+      fillTwiddles(crds[j + 2 * dataCount], sign, geo.nz, tzRe + b * geo.nz,
+                   tzIm + b * geo.nz, 1);
+    else
+    {
+      tzRe[b] = 1.0;
+      tzIm[b] = 0.0;
+    }
+  }
+}
+
+// Each thread owns a range of image rows (y,z) of all coils and accumulates
+// all samples into them, no synchronization required.
+class HostNUDFTAdjTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostNUDFTAdjTask(const DType2 *data, const DType *crds, IndType dataCount,
+                   IndType n_coils, const NUDFTGeometry &geo,
+                   CufftType *imgData)
+    : data(data), crds(crds), dataCount(dataCount), n_coils(n_coils),
+      geo(geo), imgData(imgData)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    IndType nx = geo.nx;
+    IndType rowCount = end - begin;
+    std::vector<double> acc(2 * rowCount * nx * n_coils, 0.0);
+    std::vector<double> tables(
+        2 * NUDFT_BLOCK * (nx + geo.ny + geo.nz), 0.0);
+    double *txRe = &tables[0];
+    double *txIm = txRe + NUDFT_BLOCK * nx;
+    double *tyRe = txIm + NUDFT_BLOCK * nx;
+    double *tyIm = tyRe + NUDFT_BLOCK * geo.ny;
+    double *tzRe = tyIm + NUDFT_BLOCK * geo.ny;
+    double *tzIm = tzRe + NUDFT_BLOCK * geo.nz;
+
+    for (IndType j0 = 0; j0 < dataCount; j0 += NUDFT_BLOCK)
+    {
+      IndType bCount = std::min(NUDFT_BLOCK, dataCount - j0);
+      for (IndType b = 0; b < bCount; b++)
+        fillTwiddles(crds[j0 + b], 1.0, nx, txRe + b * nx, txIm + b * nx, 1);
+      fillOuterTwiddles(crds, dataCount, j0, bCount, 1.0, geo, tyRe, tyIm,
+                        tzRe, tzIm);
+
+      for (IndType row = begin; row < end; row++)
+      {
+        IndType iy = row % geo.ny;
+        IndType iz = row / geo.ny;
+        for (IndType b = 0; b < bCount; b++)
+        {
+          double yr = tyRe[b * geo.ny + iy], yi = tyIm[b * geo.ny + iy];
+          double zr = tzRe[b * geo.nz + iz], zi = tzIm[b * geo.nz + iz];
+          double wr = yr * zr - yi * zi;
+          double wi = yr * zi + yi * zr;
+          const double *xr = txRe + b * nx;
+          const double *xi = txIm + b * nx;
+          for (IndType c = 0; c < n_coils; c++)
+          {
+            DType2 d = data[j0 + b + c * dataCount];
+            double cr = d.x * wr - d.y * wi;
+            double ci = d.x * wi + d.y * wr;
+            double *aRe = &acc[2 * ((c * rowCount + row - begin) * nx)];
+            double *aIm = aRe + nx;
+            for (IndType ix = 0; ix < nx; ix++)
+            {
+              aRe[ix] += cr * xr[ix] - ci * xi[ix];
+              aIm[ix] += cr * xi[ix] + ci * xr[ix];
+            }
+          }
+        }
+      }
+    }
+
+    for (IndType c = 0; c < n_coils; c++)
+      for (IndType row = begin; row < end; row++)
+      {
+        const double *aRe = &acc[2 * ((c * rowCount + row - begin) * nx)];
+        const double *aIm = aRe + nx;
+        CufftType *out = imgData + c * geo.imgCount + row * nx;
+        for (IndType ix = 0; ix < nx; ix++)
+        {
+          out[ix].x = (DType)(aRe[ix] * geo.scale);
+          out[ix].y = (DType)(aIm[ix] * geo.scale);
+        }
+      }
+  }
+
+ private:
+  const DType2 *data;
+  const DType *crds;
+  IndType dataCount;
+  IndType n_coils;
+  const NUDFTGeometry &geo;
+  CufftType *imgData;
+};
+
+// Each thread owns a range of sample blocks. The x tables are stored
+// interleaved by sample, so that every image value is applied to all samples
+// of the block by one contiguous loop.
+class HostNUDFTForwardTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostNUDFTForwardTask(const DType2 *imgData, const DType *crds,
+                       IndType dataCount, IndType n_coils,
+                       const NUDFTGeometry &geo, CufftType *data)
+    : imgData(imgData), crds(crds), dataCount(dataCount), n_coils(n_coils),
+      geo(geo), data(data)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    const IndType B = NUDFT_BLOCK;
+    IndType nx = geo.nx;
+    std::vector<double> tables(2 * B * (nx + geo.ny + geo.nz) + 4 * B, 0.0);
+    double *txRe = &tables[0];
+    double *txIm = txRe + B * nx;
+    double *tyRe = txIm + B * nx;
+    double *tyIm = tyRe + B * geo.ny;
+    double *tzRe = tyIm + B * geo.ny;
+    double *tzIm = tzRe + B * geo.nz;
+    double *rowRe = tzIm + B * geo.nz;
+    double *rowIm = rowRe + B;
+    double *totRe = rowIm + B;
+    double *totIm = totRe + B;
+
+    for (IndType block = begin; block < end; block++)
+    {
+      IndType j0 = block * B;
+      IndType bCount = std::min(B, dataCount - j0);
+      for (IndType b = 0; b < B; b++)
+      {
+        if (b < bCount)
+          fillTwiddles(crds[j0 + b], -1.0, nx, txRe + b, txIm + b, B);
+        else
+          for (IndType ix = 0; ix < nx; ix++)
+            txRe[ix * B + b] = txIm[ix * B + b] = 0.0;
+      }
+      fillOuterTwiddles(crds, dataCount, j0, bCount, -1.0, geo, tyRe, tyIm,
+                        tzRe, tzIm);
+
+      for (IndType c = 0; c < n_coils; c++)
+      {
+        const DType2 *img = imgData + c * geo.imgCount;
+        std::fill(totRe, totRe + 2 * B, 0.0);
+        for (IndType iz = 0; iz < geo.nz; iz++)
+          for (IndType iy = 0; iy < geo.ny; iy++)
+          {
+            const DType2 *line = img + (iz * geo.ny + iy) * nx;
+            std::fill(rowRe, rowRe + 2 * B, 0.0);
+            for (IndType ix = 0; ix < nx; ix++)
+            {
+              double vr = line[ix].x;
+              double vi = line[ix].y;
+              const double *xr = txRe + ix * B;
+              const double *xi = txIm + ix * B;
+              for (IndType b = 0; b < B; b++)
+              {
+                rowRe[b] += vr * xr[b] - vi * xi[b];
+                rowIm[b] += vr * xi[b] + vi * xr[b];
+              }
+            }
+            for (IndType b = 0; b < bCount; b++)
+            {
+              double yr = tyRe[b * geo.ny + iy], yi = tyIm[b * geo.ny + iy];
+              double zr = tzRe[b * geo.nz + iz], zi = tzIm[b * geo.nz + iz];
+              double wr = yr * zr - yi * zi;
+              double wi = yr * zi + yi * zr;
+              totRe[b] += rowRe[b] * wr - rowIm[b] * wi;
+              totIm[b] += rowRe[b] * wi + rowIm[b] * wr;
+            }
+          }
+        for (IndType b = 0; b < bCount; b++)
+        {
+          data[j0 + b + c * dataCount].x = (DType)(totRe[b] * geo.scale);
+          data[j0 + b + c * dataCount].y = (DType)(totIm[b] * geo.scale);
+        }
+      }
+    }
+  }
+
+ private:
+  const DType2 *imgData;
+  const DType *crds;
+  IndType dataCount;
+  IndType n_coils;
+  const NUDFTGeometry &geo;
+  CufftType *data;
+};
+}
+
+void gpuNUFFT::performHostNUDFTAdj(const DType2 *data, const DType *crds,
+                                   IndType dataCount, IndType n_coils,
+                                   const Dimensions &imgDims,
+                                   CufftType *imgData)
+{
+  NUDFTGeometry geo(imgDims);
+  HostNUDFTAdjTask task(data, crds, dataCount, n_coils, geo, imgData);
+  hostParallelFor(geo.ny * geo.nz, task);
+}
+
+void gpuNUFFT::performHostNUDFTForward(const DType2 *imgData,
+                                       const DType *crds, IndType dataCount,
+                                       IndType n_coils,
+                                       const Dimensions &imgDims,
+                                       CufftType *data)
+{
+  NUDFTGeometry geo(imgDims);
+  HostNUDFTForwardTask task(imgData, crds, dataCount, n_coils, geo, data);
+  hostParallelFor((dataCount + NUDFT_BLOCK - 1) / NUDFT_BLOCK, task);
+}
@@ -0,0 +1,457 @@
+#include "host_parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static std::atomic<int> hostThreadCount(0);
+
+static std::atomic<gpuNUFFT::HostExecutor *> hostExecutor(NULL);
+
+// set while the current thread executes a range of hostParallelFor
+static thread_local bool insideHostParallelFor = false;
+
+// set in forked processes, which run without workers
+static bool hostSerialProcess = false;
+
+namespace
+{
+// ranges of one execute call
+struct PoolCall
+{
+  PoolCall(gpuNUFFT::HostParallelTask &task, IndType count, int n_ranges)
+    : task(task), count(count), n_ranges(n_ranges), remaining(n_ranges),
+      errors(n_ranges)
+  {
+  }
+
+  gpuNUFFT::HostParallelTask &task;
+  IndType count;
+  int n_ranges;
+  // guarded by lock, the last finished range notifies done
+  int remaining;
+  std::vector<std::exception_ptr> errors;
+  std::mutex lock;
+  std::condition_variable done;
+};
+
+struct PoolJob
+{
+  PoolCall *call;
+  int range;
+};
+
+struct PoolWorker
+{
+  std::mutex lock;
+  std::deque<PoolJob> jobs;
+  std::thread thread;
+  int node;
+};
+
+#ifdef __linux__
+// CPUs of the list format of sysfs, e.g. "0-3,8-11"
+std::vector<int> parseCpuList(const char *list)
+{
+  std::vector<int> cpus;
+  const char *p = list;
+  while (*p != '\0' && *p != '\n')
+  {
+    int first, last, read = 0;
+    if (sscanf(p, "%d-%d%n", &first, &last, &read) == 2 && read > 0)
+      ;
+    else if (sscanf(p, "%d%n", &first, &read) == 1 && read > 0)
+      last = first;
+    else
+      break;
+    for (int cpu = first; cpu <= last; cpu++)
+      cpus.push_back(cpu);
+    p += read;
+    if (*p == ',')
+      p++;
+  }
+  return cpus;
+}
+#endif
+
+// CPUs per NUMA node restricted to the affinity of the process, nodes without
+// usable CPU are dropped
+std::vector<std::vector<int> > readNodeCpus()
+{
+  std::vector<std::vector<int> > nodes;
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    return nodes;
+
+  DIR *dir = opendir("/sys/devices/system/node");
+  if (dir == NULL)
+    return nodes;
+  std::vector<int> nodeIds;
+  for (struct dirent *entry = readdir(dir); entry != NULL;
+       entry = readdir(dir))
+  {
+    int node;
+    if (sscanf(entry->d_name, "node%d", &node) == 1)
+      nodeIds.push_back(node);
+  }
+  closedir(dir);
+  std::sort(nodeIds.begin(), nodeIds.end());
+
+  for (size_t n = 0; n < nodeIds.size(); n++)
+  {
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+             nodeIds[n]);
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+      continue;
+    char list[4096];
+    if (fgets(list, sizeof(list), file) != NULL)
+    {
+      std::vector<int> cpus = parseCpuList(list);
+      std::vector<int> usable;
+      for (size_t c = 0; c < cpus.size(); c++)
+        if (cpus[c] < CPU_SETSIZE && CPU_ISSET(cpus[c], &allowed))
+          usable.push_back(cpus[c]);
+      if (!usable.empty())
+        nodes.push_back(usable);
+    }
+    fclose(file);
+  }
+#endif
+  return nodes;
+}
+}
+
+struct gpuNUFFT::HostThreadPoolState
+{
+  HostThreadPoolState() : workerCount(0), queued(0), stopping(false), next(0)
+  {
+  }
+
+  PoolWorker *workers[HOST_THREAD_POOL_MAX_WORKERS];
+  // published after the worker is completely initialized
+  std::atomic<int> workerCount;
+
+  // serializes reserveWorkers
+  std::mutex growLock;
+
+  // sleeping workers wait for queued ranges
+  std::mutex lock;
+  std::condition_variable wake;
+  std::atomic<int> queued;
+  bool stopping;
+
+  // first queue of the next call
+  std::atomic<unsigned> next;
+
+  std::vector<std::vector<int> > nodeCpus;
+};
+
+namespace
+{
+// execute one range and count it down, the last range wakes the caller
+void runJob(PoolJob job)
+{
+  PoolCall *call = job.call;
+  gpuNUFFT::HostExecutor::runRange(call->task, call->count, call->n_ranges,
+                                   job.range, call->errors[job.range]);
+  // the caller returns as soon as remaining drops to zero, thus the call must
+  // not be accessed after the lock is released
+  std::lock_guard<std::mutex> guard(call->lock);
+  if (--call->remaining == 0)
+    call->done.notify_all();
+}
+
+// own queue from the back, otherwise steal from the front of the other
+// queues, those of the same node first. self is -1 for a calling thread.
+bool takeJob(gpuNUFFT::HostThreadPoolState *state, int self, int node,
+             PoolJob &job)
+{
+  int n_workers = state->workerCount.load(std::memory_order_acquire);
+  if (self >= 0)
+  {
+    PoolWorker *worker = state->workers[self];
+    std::lock_guard<std::mutex> guard(worker->lock);
+    if (!worker->jobs.empty())
+    {
+      job = worker->jobs.back();
+      worker->jobs.pop_back();
+      state->queued--;
+      return true;
+    }
+  }
+  int start = self + 1;
+  for (int pass = 0; pass < 2; pass++)
+    for (int i = 0; i < n_workers; i++)
+    {
+      int victim = (start + i) % n_workers;
+      PoolWorker *worker = state->workers[victim];
+      if (victim == self || (pass == 0) != (worker->node == node))
+        continue;
+      std::lock_guard<std::mutex> guard(worker->lock);
+      if (!worker->jobs.empty())
+      {
+        job = worker->jobs.front();
+        worker->jobs.pop_front();
+        state->queued--;
+        return true;
+      }
+    }
+  return false;
+}
+
+void pinCurrentThread(const std::vector<int> &cpus)
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (size_t c = 0; c < cpus.size(); c++)
+    CPU_SET(cpus[c], &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+void workerLoop(gpuNUFFT::HostThreadPoolState *state, int self, bool pin)
+{
+  int node = state->workers[self]->node;
+  if (pin && !state->nodeCpus.empty())
+    pinCurrentThread(state->nodeCpus[node]);
+
+  for (;;)
+  {
+    PoolJob job;
+    if (takeJob(state, self, node, job))
+    {
+      runJob(job);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(state->lock);
+    while (!state->stopping && state->queued <= 0)
+      state->wake.wait(lock);
+    if (state->stopping && state->queued <= 0)
+      return;
+  }
+}
+}
+
+void gpuNUFFT::HostExecutor::getRange(IndType count, int n_ranges, int r,
+                                      IndType &begin, IndType &end)
+{
+  IndType chunk = count / n_ranges;
+  IndType remainder = count % n_ranges;
+  begin = r * chunk + std::min((IndType)r, remainder);
+  end = begin + chunk + ((IndType)r < remainder ? 1 : 0);
+}
+
+void gpuNUFFT::HostExecutor::runRange(HostParallelTask &task, IndType count,
+                                      int n_ranges, int r,
+                                      std::exception_ptr &error)
+{
+  IndType begin, end;
+  getRange(count, n_ranges, r, begin, end);
+  bool nested = insideHostParallelFor;
+  insideHostParallelFor = true;
+  try
+  {
+    task.run(begin, end, r);
+  }
+  catch (...)
+  {
+    error = std::current_exception();
+  }
+  insideHostParallelFor = nested;
+}
+
+gpuNUFFT::HostThreadPool::HostThreadPool(int workerCount, bool pinWorkers)
+  : state(new HostThreadPoolState()), pinWorkers(pinWorkers)
+{
+  state->nodeCpus = readNodeCpus();
+  reserveWorkers(workerCount);
+}
+
+gpuNUFFT::HostThreadPool::~HostThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> guard(state->lock);
+    state->stopping = true;
+  }
+  state->wake.notify_all();
+  // workers still stealing access the queues of the others until they exit
+  int n_workers = state->workerCount;
+  for (int w = 0; w < n_workers; w++)
+    state->workers[w]->thread.join();
+  for (int w = 0; w < n_workers; w++)
+    delete state->workers[w];
+  delete state;
+}
+
+void gpuNUFFT::HostThreadPool::reserveWorkers(int workerCount)
+{
+  std::lock_guard<std::mutex> guard(state->growLock);
+  workerCount = std::min(workerCount, HOST_THREAD_POOL_MAX_WORKERS);
+  int nodeCount = getNodeCount();
+  for (int w = state->workerCount; w < workerCount; w++)
+  {
+    PoolWorker *worker = new PoolWorker();
+    worker->node = w % nodeCount;
+    state->workers[w] = worker;
+    worker->thread = std::thread(workerLoop, state, w, pinWorkers);
+    state->workerCount.store(w + 1, std::memory_order_release);
+  }
+}
+
+int gpuNUFFT::HostThreadPool::getWorkerCount()
+{
+  return state->workerCount;
+}
+
+int gpuNUFFT::HostThreadPool::getNodeCount()
+{
+  return std::max((int)state->nodeCpus.size(), 1);
+}
+
+int gpuNUFFT::HostThreadPool::getWorkerNode(int worker)
+{
+  if (worker < 0 || worker >= getWorkerCount())
+    return -1;
+  return state->workers[worker]->node;
+}
+
+void gpuNUFFT::HostThreadPool::execute(IndType count, HostParallelTask &task,
+                                       int n_ranges)
+{
+  PoolCall call(task, count, n_ranges);
+  int n_workers = state->workerCount.load(std::memory_order_acquire);
+
+  // ranges 1..n_ranges-1 round robin over the queues, consecutive calls start
+  // at different queues
+  if (n_workers > 0)
+  {
+    unsigned first = state->next.fetch_add(1);
+    for (int r = 1; r < n_ranges; r++)
+    {
+      PoolWorker *worker = state->workers[(first + r - 1) % n_workers];
+      PoolJob job = { &call, r };
+      std::lock_guard<std::mutex> guard(worker->lock);
+      worker->jobs.push_back(job);
+    }
+    {
+      std::lock_guard<std::mutex> guard(state->lock);
+      state->queued += n_ranges - 1;
+    }
+    state->wake.notify_all();
+  }
+
+  PoolJob own = { &call, 0 };
+  runJob(own);
+  if (n_workers == 0)
+    for (int r = 1; r < n_ranges; r++)
+    {
+      PoolJob job = { &call, r };
+      runJob(job);
+    }
+
+  // help with queued ranges until the own ranges are done
+  for (;;)
+  {
+    {
+      std::lock_guard<std::mutex> guard(call.lock);
+      if (call.remaining == 0)
+        break;
+    }
+    PoolJob job;
+    if (!takeJob(state, -1, 0, job))
+      break;
+    runJob(job);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(call.lock);
+    while (call.remaining > 0)
+      call.done.wait(lock);
+  }
+
+  for (int r = 0; r < n_ranges; r++)
+    if (call.errors[r])
+      std::rethrow_exception(call.errors[r]);
+}
+
+static gpuNUFFT::HostThreadPool &getDefaultHostThreadPool()
+{
+  static gpuNUFFT::HostThreadPool pool(gpuNUFFT::getHostThreadCount() - 1);
+  return pool;
+}
+
+void gpuNUFFT::setHostThreadCount(int n_threads)
+{
+  hostThreadCount = std::max(n_threads, 0);
+  getDefaultHostThreadPool().reserveWorkers(getHostThreadCount() - 1);
+}
+
+int gpuNUFFT::getHostThreadCount()
+{
+  int n_threads = hostThreadCount;
+  if (n_threads > 0)
+    return n_threads;
+  n_threads = (int)std::thread::hardware_concurrency();
+  return n_threads > 0 ? n_threads : 1;
+}
+
+void gpuNUFFT::setHostSerialProcess()
+{
+  hostSerialProcess = true;
+}
+
+bool gpuNUFFT::isInsideHostParallelFor()
+{
+  return insideHostParallelFor;
+}
+
+void gpuNUFFT::setHostExecutor(HostExecutor *executor)
+{
+  hostExecutor = executor;
+}
+
+gpuNUFFT::HostExecutor &gpuNUFFT::getHostExecutor()
+{
+  HostExecutor *executor = hostExecutor;
+  if (executor != NULL)
+    return *executor;
+  return getDefaultHostThreadPool();
+}
+
+void gpuNUFFT::hostParallelFor(IndType count, HostParallelTask &task,
+                               int n_threads)
+{
+  if (count == 0)
+    return;
+
+  // loops nested into a parallel range run on the calling thread
+  n_threads = (int)std::min((IndType)std::max(n_threads, 1), count);
+  if (n_threads == 1 || insideHostParallelFor || hostSerialProcess)
+  {
+    task.run(0, count, 0);
+    return;
+  }
+
+  getHostExecutor().execute(count, task, n_threads);
+}
+
+void gpuNUFFT::hostParallelFor(IndType count, HostParallelTask &task)
+{
+  hostParallelFor(count, task, getHostThreadCount());
+}
@@ -0,0 +1,191 @@
+#include "host_process_shards.hpp"
+#include "host_parallel.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+gpuNUFFT::HostSharedMemory::~HostSharedMemory()
+{
+#ifdef __unix__
+  if (data != NULL)
+    munmap(data, size);
+#else
+  free(data);
+#endif
+}
+
+void *gpuNUFFT::HostSharedMemory::reserve(size_t bytes)
+{
+  if (bytes <= size)
+    return data;
+
+#ifdef __unix__
+  // unique name of the object, only needed until it is unlinked
+  static unsigned counter = 0;
+  char name[64];
+  snprintf(name, sizeof(name), "/gpuNUFFT_%ld_%u", (long)getpid(),
+           __sync_fetch_and_add(&counter, 1));
+
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0)
+    throw std::runtime_error("Creation of shared memory failed!");
+  shm_unlink(name);
+  void *mapped = MAP_FAILED;
+  if (ftruncate(fd, (off_t)bytes) == 0)
+    mapped =
+        mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)0);
+  close(fd);
+  if (mapped == MAP_FAILED)
+    throw std::runtime_error("Mapping of shared memory failed!");
+
+  if (data != NULL)
+    munmap(data, size);
+  data = mapped;
+#else
+  // without processes the slabs are plain memory of the calling process
+  void *allocated = malloc(bytes);
+  if (allocated == NULL)
+    throw std::runtime_error("Allocation of shard memory failed!");
+  free(data);
+  data = allocated;
+#endif
+  size = bytes;
+  return data;
+}
+
+namespace
+{
+// adds the slab of a child to the slab of its parent
+class AddSlabTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  AddSlabTask(CufftType *slab, const CufftType *childSlab)
+    : slab(slab), childSlab(childSlab)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType i = begin; i < end; i++)
+    {
+      slab[i].x += childSlab[i].x;
+      slab[i].y += childSlab[i].y;
+    }
+  }
+
+ private:
+  CufftType *slab;
+  const CufftType *childSlab;
+};
+
+// process of the upper half of the shards, -1 if none is started. Other
+// threads running loops of the executor may hold locks, e.g. of the
+// allocator, which would never be released in the child, thus shards
+// started from within a loop are gridded in process.
+long forkShardProcess()
+{
+#ifdef __unix__
+  if (gpuNUFFT::isInsideHostParallelFor())
+    return -1;
+  fflush(NULL);
+  return (long)fork();
+#else
+  return -1;
+#endif
+}
+
+// true if the process exited successfully
+bool waitShardProcess(long pid)
+{
+#ifdef __unix__
+  int status = 0;
+  while (waitpid((pid_t)pid, &status, 0) < 0)
+    if (errno != EINTR)
+      return false;
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#else
+  return false;
+#endif
+}
+
+// grids shards [first, last) into slab, slabs holds the slabs of the shards
+// 1..n_shards-1
+void gridShardRange(gpuNUFFT::HostShardTask &task, int first, int last,
+                    CufftType *slab, CufftType *slabs, IndType slabCount)
+{
+  if (last - first == 1)
+  {
+    memset(slab, 0, slabCount * sizeof(CufftType));
+    task.grid(first, slab);
+    return;
+  }
+
+  int mid = first + (last - first + 1) / 2;
+  CufftType *childSlab = slabs + (IndType)(mid - 1) * slabCount;
+  long pid = forkShardProcess();
+  if (pid == 0)
+  {
+#ifdef __unix__
+    // the workers of the thread pool are not forked, the pool and its
+    // locks must not be touched
+    gpuNUFFT::setHostSerialProcess();
+    int status = 0;
+    try
+    {
+      gridShardRange(task, mid, last, childSlab, slabs, slabCount);
+    }
+    catch (...)
+    {
+      status = 1;
+    }
+    _exit(status);
+#endif
+  }
+
+  std::exception_ptr error;
+  try
+  {
+    if (pid < 0)
+      gridShardRange(task, mid, last, childSlab, slabs, slabCount);
+    gridShardRange(task, first, mid, slab, slabs, slabCount);
+  }
+  catch (...)
+  {
+    error = std::current_exception();
+  }
+  // the child has to be reaped in any case
+  if (pid > 0 && !waitShardProcess(pid) && !error)
+    error = std::make_exception_ptr(
+        std::runtime_error("Gridding process of a shard failed!"));
+  if (error)
+    std::rethrow_exception(error);
+
+  AddSlabTask add(slab, childSlab);
+  gpuNUFFT::hostParallelFor(slabCount, add);
+}
+}
+
+void gpuNUFFT::hostShardedGridding(int n_shards, HostShardTask &task,
+                                   CufftType *grid, IndType slabCount,
+                                   HostSharedMemory &memory)
+{
+  if (n_shards < 1 || n_shards > HOST_SHARD_MAX_PROCESSES)
+    throw std::invalid_argument("Invalid amount of shard processes!");
+
+  CufftType *slabs = NULL;
+  if (n_shards > 1)
+    slabs = (CufftType *)memory.reserve((size_t)(n_shards - 1) * slabCount *
+                                        sizeof(CufftType));
+  gridShardRange(task, 0, n_shards, grid, slabs, slabCount);
+}
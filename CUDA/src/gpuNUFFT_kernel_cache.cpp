@@ -0,0 +1,162 @@
+#include "gpuNUFFT_kernel_cache.hpp"
+#include "gpuNUFFT_utils.hpp"
+
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace
+{
+struct TableKey
+{
+  gpuNUFFT::KernelType kernelType;
+  IndType kernelWidth;
+  DType osf;
+  IndType size;
+  int dimensionCount;
+
+  bool operator<(const TableKey &other) const
+  {
+    if (kernelType != other.kernelType)
+      return kernelType < other.kernelType;
+    if (kernelWidth != other.kernelWidth)
+      return kernelWidth < other.kernelWidth;
+    if (osf != other.osf)
+      return osf < other.osf;
+    if (size != other.size)
+      return size < other.size;
+    return dimensionCount < other.dimensionCount;
+  }
+};
+
+struct TableEntry
+{
+  DType *data;
+  unsigned long long bytes;
+  unsigned long long references;
+};
+
+struct TableCache
+{
+  std::mutex lock;
+  std::map<TableKey, TableEntry> tables;
+  gpuNUFFT::KernelLookupTableCacheStats stats;
+};
+
+// constructed on first use, never destroyed, so that operators released
+// during static destruction still find the cache
+TableCache &cache()
+{
+  static TableCache *instance = new TableCache();
+  return *instance;
+}
+
+DType *computeTable(const TableKey &key, unsigned long long count)
+{
+  DType *data = (DType *)calloc(count, sizeof(DType));
+  if (data == NULL)
+    throw std::runtime_error("Allocation of kernel lookup table failed!");
+
+  switch (key.dimensionCount)
+  {
+  case 2:
+    load2DKernel(data, (long)key.size, (int)key.kernelWidth, key.osf,
+                 key.kernelType);
+    break;
+  case 3:
+    load3DKernel(data, (long)key.size, (int)key.kernelWidth, key.osf,
+                 key.kernelType);
+    break;
+  default:
+    load1DKernel(data, (long)key.size, (int)key.kernelWidth, key.osf,
+                 key.kernelType);
+  }
+  return data;
+}
+}
+
+const DType *gpuNUFFT::KernelLookupTableCache::acquire(IndType kernelWidth,
+                                                       DType osf, IndType size,
+                                                       int dimensionCount,
+                                                       KernelType kernelType)
+{
+  if (size < 2)
+    throw std::invalid_argument(
+        "Kernel lookup table requires at least 2 entries!");
+  if (dimensionCount < 1 || dimensionCount > 3)
+    throw std::invalid_argument(
+        "Kernel lookup table dimension count has to be 1, 2 or 3!");
+
+  TableKey key = { kernelType, kernelWidth, osf, size, dimensionCount };
+  unsigned long long count = size;
+  for (int d = 1; d < dimensionCount; d++)
+    count *= size;
+  unsigned long long bytes = count * sizeof(DType);
+
+  TableCache &c = cache();
+  std::lock_guard<std::mutex> guard(c.lock);
+  std::map<TableKey, TableEntry>::iterator it = c.tables.find(key);
+  if (it != c.tables.end())
+  {
+    it->second.references++;
+    c.stats.hits++;
+    c.stats.savedBytes += bytes;
+    return it->second.data;
+  }
+
+  // computed while holding the lock, concurrent requests of the same key
+  // wait for the table instead of computing it twice
+  TableEntry entry = { computeTable(key, count), bytes, 1 };
+  c.tables[key] = entry;
+  c.stats.misses++;
+  c.stats.tables++;
+  c.stats.bytes += bytes;
+  return entry.data;
+}
+
+void gpuNUFFT::KernelLookupTableCache::release(const DType *table)
+{
+  if (table == NULL)
+    return;
+
+  TableCache &c = cache();
+  std::lock_guard<std::mutex> guard(c.lock);
+  for (std::map<TableKey, TableEntry>::iterator it = c.tables.begin();
+       it != c.tables.end(); ++it)
+  {
+    if (it->second.data == table)
+    {
+      if (it->second.references > 0)
+        it->second.references--;
+      return;
+    }
+  }
+}
+
+void gpuNUFFT::KernelLookupTableCache::releaseUnused()
+{
+  TableCache &c = cache();
+  std::lock_guard<std::mutex> guard(c.lock);
+  std::map<TableKey, TableEntry>::iterator it = c.tables.begin();
+  while (it != c.tables.end())
+  {
+    if (it->second.references == 0)
+    {
+      free(it->second.data);
+      c.stats.tables--;
+      c.stats.bytes -= it->second.bytes;
+      c.tables.erase(it++);
+    }
+    else
+      ++it;
+  }
+}
+
+gpuNUFFT::KernelLookupTableCacheStats
+gpuNUFFT::KernelLookupTableCache::getStats()
+{
+  TableCache &c = cache();
+  std::lock_guard<std::mutex> guard(c.lock);
+  return c.stats;
+}
@@ -0,0 +1,223 @@
+#include "gpuNUFFT_mapped_input.hpp"
+
+#include <stdexcept>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define DEFAULT_CHUNK_SIZE (1 << 20)
+
+gpuNUFFT::MappedFile::MappedFile(const std::string &fileName)
+  : data(NULL), size(0)
+{
+#ifdef _WIN32
+  throw std::runtime_error("Memory mapped input is not supported on Windows!");
+#else
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Could not open file " + fileName);
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    throw std::runtime_error("Could not stat file " + fileName);
+  }
+  size = (size_t)st.st_size;
+
+  if (size > 0)
+  {
+    void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+      close(fd);
+      throw std::runtime_error("Could not map file " + fileName);
+    }
+    data = (char *)mapped;
+  }
+  // the mapping stays valid after closing the descriptor
+  close(fd);
+#endif
+}
+
+gpuNUFFT::MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+  if (data != NULL)
+    munmap(data, size);
+#endif
+}
+
+#ifndef _WIN32
+// align range to page boundaries, madvise expects page aligned addresses
+static void pageAlign(size_t size, size_t &offset, size_t &length)
+{
+  if (offset >= size)
+  {
+    length = 0;
+    return;
+  }
+  if (offset + length > size)
+    length = size - offset;
+  size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+  size_t start = offset - (offset % pageSize);
+  length += offset - start;
+  offset = start;
+}
+#endif
+
+void gpuNUFFT::MappedFile::prefetch(size_t offset, size_t length) const
+{
+#ifndef _WIN32
+  if (data == NULL)
+    return;
+  pageAlign(size, offset, length);
+  if (length > 0)
+    madvise(data + offset, length, MADV_WILLNEED);
+#endif
+}
+
+void gpuNUFFT::MappedFile::release(size_t offset, size_t length) const
+{
+#ifndef _WIN32
+  if (data == NULL)
+    return;
+  if (offset >= size)
+    return;
+  if (offset + length > size)
+    length = size - offset;
+  // release only whole pages inside the range, the partial pages at both
+  // ends may hold data of neighboring ranges
+  size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+  size_t start = (offset + pageSize - 1) / pageSize * pageSize;
+  size_t end = (offset + length) / pageSize * pageSize;
+  if (end > start)
+    madvise(data + start, end - start, MADV_DONTNEED);
+#endif
+}
+
+gpuNUFFT::MappedInputSource::MappedInputSource(const std::string &trajFile,
+                                               const std::string &kspaceFile,
+                                               int dimCount,
+                                               const std::string &densFile)
+  : traj(NULL), kspace(NULL), dens(NULL), dimCount(dimCount), sampleCount(0),
+    coilCount(0), chunkSize(DEFAULT_CHUNK_SIZE)
+{
+  if (dimCount != 2 && dimCount != 3)
+    throw std::invalid_argument("Trajectory dimension count must be 2 or 3!");
+
+  traj = new MappedFile(trajFile);
+  try
+  {
+    kspace = new MappedFile(kspaceFile);
+    if (!densFile.empty())
+      dens = new MappedFile(densFile);
+
+    size_t trajSampleSize = dimCount * sizeof(DType);
+    if (traj->getSize() == 0 || traj->getSize() % trajSampleSize != 0)
+      throw std::invalid_argument(
+          "Trajectory file size does not match dimension count!");
+    sampleCount = (IndType)(traj->getSize() / trajSampleSize);
+
+    size_t coilSize = sampleCount * sizeof(DType2);
+    if (kspace->getSize() == 0 || kspace->getSize() % coilSize != 0)
+    {
+      std::stringstream ss;
+      ss << "k-space file size does not match sample count " << sampleCount
+         << "!";
+      throw std::invalid_argument(ss.str());
+    }
+    coilCount = (IndType)(kspace->getSize() / coilSize);
+
+    if (dens != NULL && dens->getSize() != sampleCount * sizeof(DType))
+      throw std::invalid_argument(
+          "Density compensation file size does not match sample count!");
+  }
+  catch (...)
+  {
+    delete traj;
+    delete kspace;
+    delete dens;
+    throw;
+  }
+}
+
+gpuNUFFT::MappedInputSource::~MappedInputSource()
+{
+  delete traj;
+  delete kspace;
+  delete dens;
+}
+
+gpuNUFFT::Array<DType> gpuNUFFT::MappedInputSource::getKSpaceTraj()
+{
+  Array<DType> kSpaceTraj;
+  kSpaceTraj.data = (DType *)traj->getData();
+  kSpaceTraj.dim.length = sampleCount;
+  return kSpaceTraj;
+}
+
+gpuNUFFT::Array<DType> gpuNUFFT::MappedInputSource::getDens()
+{
+  Array<DType> densData;
+  if (dens != NULL)
+  {
+    densData.data = (DType *)dens->getData();
+    densData.dim.length = sampleCount;
+  }
+  return densData;
+}
+
+gpuNUFFT::Array<DType2>
+gpuNUFFT::MappedInputSource::getCoilData(IndType coil, IndType count)
+{
+  if (coil + count > coilCount)
+    throw std::invalid_argument("Coil range exceeds coil count!");
+
+  Array<DType2> coilData;
+  coilData.data = (DType2 *)kspace->getData() + (size_t)coil * sampleCount;
+  coilData.dim.length = sampleCount;
+  coilData.dim.channels = count;
+  return coilData;
+}
+
+void gpuNUFFT::MappedInputSource::prefetchTraj(IndType offset, IndType count)
+{
+  for (int d = 0; d < dimCount; d++)
+    traj->prefetch(((size_t)d * sampleCount + offset) * sizeof(DType),
+                   (size_t)count * sizeof(DType));
+  if (dens != NULL)
+    dens->prefetch((size_t)offset * sizeof(DType),
+                   (size_t)count * sizeof(DType));
+}
+
+void gpuNUFFT::MappedInputSource::releaseTraj(IndType offset, IndType count)
+{
+  for (int d = 0; d < dimCount; d++)
+    traj->release(((size_t)d * sampleCount + offset) * sizeof(DType),
+                  (size_t)count * sizeof(DType));
+  if (dens != NULL)
+    dens->release((size_t)offset * sizeof(DType),
+                  (size_t)count * sizeof(DType));
+}
+
+void gpuNUFFT::MappedInputSource::prefetchCoils(IndType coil, IndType count)
+{
+  if (coil >= coilCount)
+    return;
+  kspace->prefetch((size_t)coil * sampleCount * sizeof(DType2),
+                   (size_t)count * sampleCount * sizeof(DType2));
+}
+
+void gpuNUFFT::MappedInputSource::releaseCoils(IndType coil, IndType count)
+{
+  if (coil >= coilCount)
+    return;
+  kspace->release((size_t)coil * sampleCount * sizeof(DType2),
+                  (size_t)count * sampleCount * sizeof(DType2));
+}
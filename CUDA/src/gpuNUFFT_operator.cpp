@@ -7,6 +7,19 @@
 
 #include <iostream>
 #include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+// kernels are launched asynchronously, wait for them before a profiled stage
+// is recorded
+void stopSynchronized(gpuNUFFT::ProfileScope &scope)
+{
+  if (scope.isActive())
+    cudaThreadSynchronize();
+  scope.stop();
+}
+}
 
 template <typename T>
 T *gpuNUFFT::GpuNUFFTOperator::selectOrdered(gpuNUFFT::Array<T> &dataArray,
@@ -39,14 +52,59 @@ void gpuNUFFT::GpuNUFFTOperator::writeOrdered(gpuNUFFT::Array<T> &destArray,
   }
 }
 
+void gpuNUFFT::GpuNUFFTOperator::setKernelLookupTableSize(
+    IndType lookupTableSize)
+{
+  // size of the KERNEL constant memory array, see cuda_utils.cuh
+  if (lookupTableSize > 10000 &&
+      (getType() == DEFAULT || getType() == BALANCED))
+    throw std::invalid_argument(
+        "Kernel lookup table exceeds constant memory size!");
+  if (lookupTableSize == 1)
+    throw std::invalid_argument(
+        "Kernel lookup table requires at least 2 entries!");
+
+  this->lookupTableSize = lookupTableSize;
+  if (this->kernel.data != NULL)
+    initKernel();
+}
+
+void gpuNUFFT::GpuNUFFTOperator::setKernelType(KernelType kernelType)
+{
+  this->kernelType = kernelType;
+  if (this->kernel.data != NULL)
+    initKernel();
+}
+
+gpuNUFFT::Dimensions gpuNUFFT::GpuNUFFTOperator::getKernelWidths()
+{
+  // unset (0) entries use the kernel width of the operator
+  Dimensions kernelWidths;
+  kernelWidths.width =
+      this->kernelWidths.width > 0 ? this->kernelWidths.width : kernelWidth;
+  kernelWidths.height =
+      this->kernelWidths.height > 0 ? this->kernelWidths.height : kernelWidth;
+  if (imgDims.depth > 0)
+    kernelWidths.depth =
+        this->kernelWidths.depth > 0 ? this->kernelWidths.depth : kernelWidth;
+  return kernelWidths;
+}
+
+IndType gpuNUFFT::GpuNUFFTOperator::getDefaultKernelLookupTableSize()
+{
+  return (IndType)calculateGrid3KernelSize(osf, kernelWidth);
+}
+
 void gpuNUFFT::GpuNUFFTOperator::initKernel()
 {
-  IndType kernelSize = calculateGrid3KernelSize(osf, kernelWidth);
+  IndType kernelSize =
+      lookupTableSize > 0 ? lookupTableSize : getDefaultKernelLookupTableSize();
   this->kernel.dim.length = kernelSize;
-  if (this->kernel.data != NULL)
-    free(this->kernel.data);
-  this->kernel.data = (DType *)calloc(this->kernel.count(), sizeof(DType));
-  load1DKernel(this->kernel.data, (int)kernelSize, (int)kernelWidth, osf);
+  const DType *table =
+      KernelLookupTableCache::acquire(kernelWidth, osf, kernelSize, 1,
+                                      kernelType);
+  KernelLookupTableCache::release(this->kernel.data);
+  this->kernel.data = const_cast<DType *>(table);
 }
 
 gpuNUFFT::GpuNUFFTInfo *
@@ -62,6 +120,7 @@ gpuNUFFT::GpuNUFFTOperator::initGpuNUFFTInfo(int n_coils_cc)
   gi_host->kernel_width = (int)this->kernelWidth;
   gi_host->kernel_widthSquared = (int)(this->kernelWidth * this->kernelWidth);
   gi_host->kernel_count = (int)this->kernel.count();
+  gi_host->interpolationType = CONST_LOOKUP;
 
   gi_host->grid_width_dim = (int)this->getGridDims().count();
   gi_host->grid_width_offset =
@@ -85,6 +144,7 @@ gpuNUFFT::GpuNUFFTOperator::initGpuNUFFTInfo(int n_coils_cc)
   gi_host->gridDims_count = this->getGridDims().width *
                             this->getGridDims().height *
                             DEFAULT_VALUE(this->getGridDims().depth);  // s.a.
+  gi_host->grid_plane_offset = 0;
 
   // The largest value of the grid dimensions determines the kernel radius
   // (resolution) in k-space units
@@ -141,6 +201,53 @@ gpuNUFFT::GpuNUFFTOperator::initGpuNUFFTInfo(int n_coils_cc)
   gi_host->is2Dprocessing = this->is2DProcessing();
 
   gi_host->n_coils_cc = n_coils_cc;
+
+  // per-axis kernel extent and sector padding, identical to the scalar
+  // values above unless per-axis kernel widths are set
+  Dimensions kernelWidths = this->getKernelWidths();
+  IndType widths[3] = { kernelWidths.width, kernelWidths.height,
+                        DEFAULT_VALUE(kernelWidths.depth) };
+  IndType sectorWidths[3] = { sectorDims.width, sectorDims.height,
+                              DEFAULT_VALUE(sectorDims.depth) };
+  DType radii[3], radiiSquared[3], multipliers[3];
+  IndType padMax[3], padOffset[3];
+  for (int d = 0; d < 3; d++)
+  {
+    double axisRadius = (widths[d] / 2.0) / static_cast<double>(max_grid_dim);
+    radii[d] = (DType)(widths[d] / 2.0);
+    radiiSquared[d] = (DType)(axisRadius * axisRadius);
+    multipliers[d] =
+        (DType)((this->kernel.count() - 1) / (axisRadius * axisRadius));
+    IndType padWidth = sectorWidths[d] + 2 * (widths[d] / 2);
+    padMax[d] = padWidth - 1;
+    padOffset[d] = padWidth / 2;
+  }
+  gi_host->kernel_width_axis.x = widths[0];
+  gi_host->kernel_width_axis.y = widths[1];
+  gi_host->kernel_width_axis.z = widths[2];
+  gi_host->kernel_radius_axis.x = radii[0];
+  gi_host->kernel_radius_axis.y = radii[1];
+  gi_host->kernel_radius_axis.z = radii[2];
+  gi_host->radiusSquared_axis.x = radiiSquared[0];
+  gi_host->radiusSquared_axis.y = radiiSquared[1];
+  gi_host->radiusSquared_axis.z = radiiSquared[2];
+  gi_host->dist_multiplier_axis.x = multipliers[0];
+  gi_host->dist_multiplier_axis.y = multipliers[1];
+  gi_host->dist_multiplier_axis.z = multipliers[2];
+  gi_host->kernel_offset_axis.x = 0;
+  gi_host->kernel_offset_axis.y = 0;
+  gi_host->kernel_offset_axis.z = 0;
+  gi_host->kernel_count_axis.x = this->kernel.count();
+  gi_host->kernel_count_axis.y = this->kernel.count();
+  gi_host->kernel_count_axis.z = this->kernel.count();
+  for (int d = 0; d < 3; d++)
+    gi_host->kernel_table_axis[d] = NULL;
+  gi_host->sector_pad_max_axis.x = padMax[0];
+  gi_host->sector_pad_max_axis.y = padMax[1];
+  gi_host->sector_pad_max_axis.z = padMax[2];
+  gi_host->sector_offset_axis.x = padOffset[0];
+  gi_host->sector_offset_axis.y = padOffset[1];
+  gi_host->sector_offset_axis.z = padOffset[2];
   return gi_host;
 }
 
@@ -686,13 +793,24 @@ void gpuNUFFT::GpuNUFFTOperator::performGpuNUFFTAdj(
     cudaMemset(gdata_d, 0,
                sizeof(CufftType) * gi_host->grid_width_dim * n_coils_cc);
     // copy coil data to device and select ordered
+    IndType coilSamples = (IndType)data_count * n_coils_cc;
+    IndType coilGridCount = gi_host->grid_width_dim * n_coils_cc;
+    ProfileScope sortScope(profiler, PROFILE_SORT, coilSamples,
+                           coilSamples * (2 * sizeof(DType2) + sizeof(IndType)));
     copyToDevice(kspaceData.data + data_coil_offset, data_d,
                  data_count * n_coils_cc);
     selectOrderedGPU(data_d, data_indices_d, data_sorted_d, data_count,
                      n_coils_cc);
+    stopSynchronized(sortScope);
 
     if (this->applyDensComp())
+    {
+      ProfileScope densScope(profiler, PROFILE_DENSITY_COMPENSATION,
+                             coilSamples,
+                             coilSamples * (2 * sizeof(DType2) + sizeof(DType)));
       performDensityCompensation(data_sorted_d, density_comp_d, gi_host);
+      stopSynchronized(densScope);
+    }
 
     if (DEBUG && (cudaThreadSynchronize() != cudaSuccess))
       printf("error at adj thread synchronization 1: %s\n",
@@ -701,8 +819,14 @@ void gpuNUFFT::GpuNUFFTOperator::performGpuNUFFTAdj(
     if (debugTiming)
       startTiming();
 
+    ProfileScope convScope(
+        profiler, PROFILE_CONVOLUTION, coilSamples,
+        coilSamples * (sizeof(DType2) +
+                       getImageDimensionCount() * sizeof(DType)) +
+            coilGridCount * 2 * sizeof(CufftType));
     adjConvolution(data_sorted_d, crds_d, gdata_d, NULL, sectors_d,
                    sector_centers_d, gi_host);
+    stopSynchronized(convScope);
 
     if (debugTiming)
       printf("Adjoint convolution: %.2f ms\n", stopTiming());
@@ -734,6 +858,8 @@ void gpuNUFFT::GpuNUFFTOperator::performGpuNUFFTAdj(
     if (debugTiming)
       startTiming();
 
+    ProfileScope fftScope(profiler, PROFILE_FFT, coilSamples,
+                          coilGridCount * 6 * sizeof(CufftType));
     performFFTShift(gdata_d, INVERSE, getGridDims(), gi_host);
 
     // Inverse FFT
@@ -754,6 +880,7 @@ void gpuNUFFT::GpuNUFFTOperator::performGpuNUFFTAdj(
               cudaGetErrorString(cudaGetLastError()));
 
     performFFTShift(gdata_d, INVERSE, getGridDims(), gi_host);
+    stopSynchronized(fftScope);
 
     if (debugTiming)
       printf("iFFT (incl. shift) : %.2f ms\n", stopTiming());
@@ -761,6 +888,8 @@ void gpuNUFFT::GpuNUFFTOperator::performGpuNUFFTAdj(
     if (DEBUG && (cudaThreadSynchronize() != cudaSuccess))
       printf("error at adj thread synchronization 5: %s\n",
              cudaGetErrorString(cudaGetLastError()));
+    ProfileScope cropScope(profiler, PROFILE_CROP, coilSamples,
+                           imdata_count * n_coils_cc * 3 * sizeof(CufftType));
     performCrop(gdata_d, imdata_d, gi_host);
 
     if (DEBUG && (cudaThreadSynchronize() != cudaSuccess))
@@ -768,6 +897,7 @@ void gpuNUFFT::GpuNUFFTOperator::performGpuNUFFTAdj(
              cudaGetErrorString(cudaGetLastError()));
 
     performFFTScaling(imdata_d, gi_host->im_width_dim, gi_host);
+    stopSynchronized(cropScope);
     if (DEBUG && (cudaThreadSynchronize() != cudaSuccess))
       printf("error: at adj  thread synchronization 7: %s\n",
       cudaGetErrorString(cudaGetLastError()));
@@ -788,7 +918,11 @@ void gpuNUFFT::GpuNUFFTOperator::performGpuNUFFTAdj(
       printf("error at adj thread synchronization 8: %s\n",
       cudaGetErrorString(cudaGetLastError()));
 
+    ProfileScope deapoScope(
+        profiler, PROFILE_DEAPODIZATION, coilSamples,
+        imdata_count * n_coils_cc * (2 * sizeof(CufftType) + sizeof(DType)));
     performDeapodization(imdata_d, deapo_d, gi_host);
+    stopSynchronized(deapoScope);
 	  
     if (DEBUG && (cudaThreadSynchronize() != cudaSuccess))
       printf("error at adj thread synchronization 9: %s\n",
@@ -796,10 +930,13 @@ void gpuNUFFT::GpuNUFFTOperator::performGpuNUFFTAdj(
 
     if (this->applySensData())
     {
+      ProfileScope sensScope(profiler, PROFILE_SENSITIVITY, coilSamples,
+                             imdata_count * n_coils_cc * 4 * sizeof(CufftType));
       copyToDevice(this->sens.data + im_coil_offset, sens_d,
                    imdata_count * n_coils_cc);
       performSensMul(imdata_d, sens_d, gi_host, true);
       performSensSum(imdata_d, imdata_sum_d, gi_host);
+      stopSynchronized(sensScope);
     }
     else
     {
@@ -1118,6 +1255,9 @@ void gpuNUFFT::GpuNUFFTOperator::performForwardGpuNUFFT(
 
     this->updateConcurrentCoilCount(coil_it, n_coils, n_coils_cc);
 
+    IndType coilSamples = (IndType)data_count * n_coils_cc;
+    IndType coilGridCount = gi_host->grid_width_dim * n_coils_cc;
+
     if (this->applySensData())
       // perform automatically "repeating" of input image in case
       // of existing sensitivity data
@@ -1139,19 +1279,30 @@ void gpuNUFFT::GpuNUFFTOperator::performForwardGpuNUFFT(
 
     if (this->applySensData())
     {
+      ProfileScope sensScope(profiler, PROFILE_SENSITIVITY, coilSamples,
+                             imdata_count * n_coils_cc * 3 * sizeof(CufftType));
       copyToDevice(this->sens.data + im_coil_offset, sens_d,
                    imdata_count * n_coils_cc);
       performSensMul(imdata_d, sens_d, gi_host, false);
+      stopSynchronized(sensScope);
     }
 
     // apodization Correction
+    ProfileScope deapoScope(
+        profiler, PROFILE_DEAPODIZATION, coilSamples,
+        imdata_count * n_coils_cc * (2 * sizeof(CufftType) + sizeof(DType)));
     performForwardDeapodization(imdata_d, deapo_d, gi_host);
+    stopSynchronized(deapoScope);
 	  
     if (DEBUG && (cudaThreadSynchronize() != cudaSuccess))
       printf("error at thread synchronization 2: %s\n",
              cudaGetErrorString(cudaGetLastError()));
     // resize by oversampling factor and zero pad
+    ProfileScope cropScope(
+        profiler, PROFILE_CROP, coilSamples,
+        (imdata_count * n_coils_cc + coilGridCount) * sizeof(CufftType));
     performPadding(imdata_d, gdata_d, gi_host);
+    stopSynchronized(cropScope);
 
     if (debugTiming)
       startTiming();
@@ -1160,6 +1311,8 @@ void gpuNUFFT::GpuNUFFTOperator::performForwardGpuNUFFT(
       printf("error at thread synchronization 3: %s\n",
              cudaGetErrorString(cudaGetLastError()));
     // shift image to get correct zero frequency position
+    ProfileScope fftScope(profiler, PROFILE_FFT, coilSamples,
+                          coilGridCount * 6 * sizeof(CufftType));
     performFFTShift(gdata_d, INVERSE, getGridDims(), gi_host);
 
     if (DEBUG && (cudaThreadSynchronize() != cudaSuccess))
@@ -1184,6 +1337,7 @@ void gpuNUFFT::GpuNUFFTOperator::performForwardGpuNUFFT(
       printf("error at thread synchronization 5: %s\n",
              cudaGetErrorString(cudaGetLastError()));
     performFFTShift(gdata_d, FORWARD, getGridDims(), gi_host);
+    stopSynchronized(fftScope);
 
     if (DEBUG && (cudaThreadSynchronize() != cudaSuccess))
       printf("error at thread synchronization 6: %s\n",
@@ -1196,6 +1350,11 @@ void gpuNUFFT::GpuNUFFTOperator::performForwardGpuNUFFT(
       startTiming();
 
     // convolution and resampling to non-standard trajectory
+    ProfileScope convScope(
+        profiler, PROFILE_CONVOLUTION, coilSamples,
+        coilSamples * (sizeof(CufftType) +
+                       getImageDimensionCount() * sizeof(DType)) +
+            coilGridCount * sizeof(CufftType));
     forwardConvolution(data_d, crds_d, gdata_d, NULL, sectors_d,
                        sector_centers_d, gi_host);
     if (DEBUG && (cudaThreadSynchronize() != cudaSuccess))
@@ -1206,20 +1365,30 @@ void gpuNUFFT::GpuNUFFTOperator::performForwardGpuNUFFT(
       printf("Forward Convolution: %.2f ms\n", stopTiming());
 
     performFFTScaling(data_d, gi_host->data_count, gi_host);
+    stopSynchronized(convScope);
     if (DEBUG && (cudaThreadSynchronize() != cudaSuccess))
       printf("error: at thread synchronization 8: %s\n",
              cudaGetErrorString(cudaGetLastError()));
 
     // Also apply density compensation here
     if (this->applyDensComp())
+    {
+      ProfileScope densScope(profiler, PROFILE_DENSITY_COMPENSATION,
+                             coilSamples,
+                             coilSamples * (2 * sizeof(CufftType) + sizeof(DType)));
       performDensityCompensation(data_d, density_comp_d, gi_host);
+      stopSynchronized(densScope);
+    }
 
     // write result in correct order back into output array
+    ProfileScope sortScope(profiler, PROFILE_SORT, coilSamples,
+                           coilSamples * (2 * sizeof(CufftType) + sizeof(IndType)));
     writeOrderedGPU(data_sorted_d, data_indices_d, data_d,
                     (int)this->kSpaceTraj.count(), n_coils_cc);
     
     copyFromDevice(data_sorted_d, kspaceData.data + data_coil_offset,
                    data_count * n_coils_cc);
+    sortScope.stop();
   }  // iterate over coils
 
   freeTotalDeviceMemory(data_d, imdata_d, NULL);
@@ -9,6 +9,325 @@
 #include "precomp_kernels.hpp"
 #include <limits>
 
+#include "host_parallel.hpp"
+
+namespace
+{
+// sector index of the trajectory samples [offset + begin, offset + end)
+class AssignSectorsTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  AssignSectorsTask(gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp,
+                    gpuNUFFT::Array<DType> &kSpaceTraj,
+                    IndType *assignedSectors, IndType offset)
+    : coords(kSpaceTraj.data), coordCnt(kSpaceTraj.count()),
+      assignedSectors(assignedSectors), offset(offset),
+      gridDims(gpuNUFFTOp->getGridDims()),
+      gridSectorDims(gpuNUFFTOp->getGridSectorDims()),
+      sectorWidth((DType)gpuNUFFTOp->getSectorWidth()),
+      is2D(gpuNUFFTOp->is2DProcessing())
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType cCnt = offset + begin; cCnt < offset + end; cCnt++)
+    {
+      if (is2D)
+      {
+        DType2 coord;
+        coord.x = coords[cCnt];
+        coord.y = coords[cCnt + coordCnt];
+        IndType2 mappedSector =
+            computeSectorMapping(coord, gridDims, sectorWidth);
+        // linearize mapped sector
+        assignedSectors[cCnt] = computeInd22Lin(mappedSector, gridSectorDims);
+      }
+      else
+      {
+        DType3 coord;
+        coord.x = coords[cCnt];
+        coord.y = coords[cCnt + coordCnt];
+        coord.z = coords[cCnt + 2 * coordCnt];
+        IndType3 mappedSector =
+            computeSectorMapping(coord, gridDims, sectorWidth);
+        // linearize mapped sector
+        assignedSectors[cCnt] = computeInd32Lin(mappedSector, gridSectorDims);
+      }
+    }
+  }
+
+ private:
+  const DType *coords;
+  IndType coordCnt;
+  IndType *assignedSectors;
+  IndType offset;
+  gpuNUFFT::Dimensions gridDims;
+  gpuNUFFT::Dimensions gridSectorDims;
+  DType sectorWidth;
+  bool is2D;
+};
+
+// index-value pairs of the array to be sorted
+template <typename T>
+class InitPairsTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  InitPairsTask(const T *values, std::vector<gpuNUFFT::IndPair> &pairs)
+    : values(values), pairs(pairs)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType i = begin; i < end; i++)
+      pairs[i] = gpuNUFFT::IndPair(i, (IndType)values[i]);
+  }
+
+ private:
+  const T *values;
+  std::vector<gpuNUFFT::IndPair> &pairs;
+};
+
+// stable sort of the chunks [begin, end) of pairs
+template <typename Compare>
+class SortChunksTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  SortChunksTask(std::vector<gpuNUFFT::IndPair> &pairs, int chunkCount)
+    : pairs(pairs), chunkCount(chunkCount)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType c = begin; c < end; c++)
+    {
+      IndType first, last;
+      gpuNUFFT::HostExecutor::getRange(pairs.size(), chunkCount, (int)c,
+                                       first, last);
+      std::stable_sort(pairs.begin() + first, pairs.begin() + last,
+                       Compare());
+    }
+  }
+
+ private:
+  std::vector<gpuNUFFT::IndPair> &pairs;
+  int chunkCount;
+};
+
+// stable merge of the sorted runs of width chunks from src to dst, one pair of
+// runs per index
+template <typename Compare>
+class MergeChunksTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  MergeChunksTask(const std::vector<gpuNUFFT::IndPair> &src,
+                  std::vector<gpuNUFFT::IndPair> &dst, int chunkCount,
+                  int width)
+    : src(src), dst(dst), chunkCount(chunkCount), width(width)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType p = begin; p < end; p++)
+    {
+      int firstChunk = (int)p * 2 * width;
+      int midChunk = std::min(firstChunk + width, chunkCount);
+      int endChunk = std::min(firstChunk + 2 * width, chunkCount);
+      IndType first = chunkBegin(firstChunk);
+      IndType mid = chunkBegin(midChunk);
+      IndType last = chunkBegin(endChunk);
+      std::merge(src.begin() + first, src.begin() + mid, src.begin() + mid,
+                 src.begin() + last, dst.begin() + first, Compare());
+    }
+  }
+
+ private:
+  IndType chunkBegin(int c)
+  {
+    if (c == chunkCount)
+      return src.size();
+    IndType first, last;
+    gpuNUFFT::HostExecutor::getRange(src.size(), chunkCount, c, first, last);
+    return first;
+  }
+
+  const std::vector<gpuNUFFT::IndPair> &src;
+  std::vector<gpuNUFFT::IndPair> &dst;
+  int chunkCount;
+  int width;
+};
+
+// stable parallel merge sort, chunks sorted concurrently, then merged pairwise
+template <typename Compare>
+void parallelStableSort(std::vector<gpuNUFFT::IndPair> &pairs)
+{
+  // chunks of at least 4096 pairs, smaller arrays are sorted at once
+  int chunkCount = (int)std::max(
+      std::min((IndType)gpuNUFFT::getHostThreadCount(),
+               (IndType)pairs.size() / 4096),
+      (IndType)1);
+  SortChunksTask<Compare> sortTask(pairs, chunkCount);
+  gpuNUFFT::hostParallelFor(chunkCount, sortTask);
+  if (chunkCount == 1)
+    return;
+
+  std::vector<gpuNUFFT::IndPair> buffer(pairs.size(), gpuNUFFT::IndPair(0, 0));
+  std::vector<gpuNUFFT::IndPair> *src = &pairs, *dst = &buffer;
+  for (int width = 1; width < chunkCount; width *= 2)
+  {
+    MergeChunksTask<Compare> mergeTask(*src, *dst, chunkCount, width);
+    gpuNUFFT::hostParallelFor((chunkCount + 2 * width - 1) / (2 * width),
+                              mergeTask);
+    std::swap(src, dst);
+  }
+  if (src != &pairs)
+    pairs.swap(buffer);
+}
+
+// sorted coordinates, density and indices of the sorted index-sector pairs
+class GatherSortedTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  GatherSortedTask(const std::vector<gpuNUFFT::IndPair> &sorted,
+                   gpuNUFFT::Array<DType> &kSpaceTraj, int dimCount,
+                   const DType *dens, DType *trajSorted, DType *densSorted,
+                   IndType *dataIndices, IndType *assignedSectors)
+    : sorted(sorted), coords(kSpaceTraj.data), coordCnt(kSpaceTraj.count()),
+      dimCount(dimCount), dens(dens), trajSorted(trajSorted),
+      densSorted(densSorted), dataIndices(dataIndices),
+      assignedSectors(assignedSectors)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType i = begin; i < end; i++)
+    {
+      IndType index = sorted[i].first;
+      for (int d = 0; d < dimCount; d++)
+        trajSorted[i + d * coordCnt] = coords[index + d * coordCnt];
+      if (dens != NULL)
+        densSorted[i] = dens[index];
+      dataIndices[i] = index;
+      assignedSectors[i] = sorted[i].second;
+    }
+  }
+
+ private:
+  const std::vector<gpuNUFFT::IndPair> &sorted;
+  const DType *coords;
+  IndType coordCnt;
+  int dimCount;
+  const DType *dens;
+  DType *trajSorted;
+  DType *densSorted;
+  IndType *dataIndices;
+  IndType *assignedSectors;
+};
+
+// indices and sorted position of the sorted index-sector pairs
+class SortedIndicesTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  SortedIndicesTask(const std::vector<gpuNUFFT::IndPair> &sorted,
+                    IndType *dataIndices, IndType *assignedSectors,
+                    std::vector<IndType> &sortedPosition)
+    : sorted(sorted), dataIndices(dataIndices),
+      assignedSectors(assignedSectors), sortedPosition(sortedPosition)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType i = begin; i < end; i++)
+    {
+      dataIndices[i] = sorted[i].first;
+      assignedSectors[i] = sorted[i].second;
+      sortedPosition[sorted[i].first] = i;
+    }
+  }
+
+ private:
+  const std::vector<gpuNUFFT::IndPair> &sorted;
+  IndType *dataIndices;
+  IndType *assignedSectors;
+  std::vector<IndType> &sortedPosition;
+};
+
+// coordinates and density of the input samples [offset + begin,
+// offset + end) to their sorted position
+class ScatterSortedTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  ScatterSortedTask(const std::vector<IndType> &sortedPosition,
+                    gpuNUFFT::Array<DType> &kSpaceTraj, int dimCount,
+                    const DType *dens, DType *trajSorted, DType *densSorted,
+                    IndType offset)
+    : sortedPosition(sortedPosition), coords(kSpaceTraj.data),
+      coordCnt(kSpaceTraj.count()), dimCount(dimCount), dens(dens),
+      trajSorted(trajSorted), densSorted(densSorted), offset(offset)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType i = offset + begin; i < offset + end; i++)
+    {
+      for (int d = 0; d < dimCount; d++)
+        trajSorted[sortedPosition[i] + d * coordCnt] =
+            coords[i + d * coordCnt];
+      if (dens != NULL)
+        densSorted[sortedPosition[i]] = dens[i];
+    }
+  }
+
+ private:
+  const std::vector<IndType> &sortedPosition;
+  const DType *coords;
+  IndType coordCnt;
+  int dimCount;
+  const DType *dens;
+  DType *trajSorted;
+  DType *densSorted;
+  IndType offset;
+};
+
+// centers of the sectors [begin, end) in linear sector order from the centers
+// per sector index of each dimension
+class SectorCentersTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  SectorCentersTask(const std::vector<IndType> &centers,
+                    gpuNUFFT::Dimensions sectorDims, int dimCount,
+                    IndType *sectorCenters)
+    : centers(centers), sectorDims(sectorDims), dimCount(dimCount),
+      sectorCenters(sectorCenters)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType index = begin; index < end; index++)
+    {
+      IndType pos[3] = { index % sectorDims.width,
+                         index / sectorDims.width % sectorDims.height,
+                         index / (sectorDims.width * sectorDims.height) };
+      for (int d = 0; d < dimCount; d++)
+        sectorCenters[dimCount * index + d] = centers[pos[d]];
+    }
+  }
+
+ private:
+  const std::vector<IndType> &centers;
+  gpuNUFFT::Dimensions sectorDims;
+  int dimCount;
+  IndType *sectorCenters;
+};
+}
+
 void gpuNUFFT::GpuNUFFTOperatorFactory::setUseTextures(bool useTextures)
 {
   this->useTextures = useTextures;
@@ -19,6 +338,55 @@ void gpuNUFFT::GpuNUFFTOperatorFactory::setBalanceWorkload(bool balanceWorkload)
   this->balanceWorkload = balanceWorkload;
 }
 
+void gpuNUFFT::GpuNUFFTOperatorFactory::setUseHostBackend(bool useHostBackend)
+{
+#ifdef GPUNUFFT_HOST_ONLY
+  if (!useHostBackend)
+    throw std::invalid_argument(
+        "gpuNUFFT was built host-only, the host backend cannot be disabled!");
+#endif
+  this->useHostBackend = useHostBackend;
+}
+
+void gpuNUFFT::GpuNUFFTOperatorFactory::setUseHostNUDFT(bool useHostNUDFT)
+{
+  this->useHostNUDFT = useHostNUDFT;
+}
+
+void gpuNUFFT::GpuNUFFTOperatorFactory::setHostNUDFTSampleLimit(
+    IndType sampleLimit)
+{
+  this->hostNUDFTSampleLimit = sampleLimit;
+}
+
+void gpuNUFFT::GpuNUFFTOperatorFactory::setUseLinearKernelInterpolation(
+    bool useLinearKernelInterpolation)
+{
+  this->useLinearKernelInterpolation = useLinearKernelInterpolation;
+}
+
+void gpuNUFFT::GpuNUFFTOperatorFactory::setKernelWidths(
+    Dimensions kernelWidths)
+{
+  this->kernelWidths = kernelWidths;
+}
+
+void gpuNUFFT::GpuNUFFTOperatorFactory::setKernelLookupTableSize(
+    IndType lookupTableSize)
+{
+  this->lookupTableSize = lookupTableSize;
+}
+
+void gpuNUFFT::GpuNUFFTOperatorFactory::setKernelType(KernelType kernelType)
+{
+  this->kernelType = kernelType;
+}
+
+void gpuNUFFT::GpuNUFFTOperatorFactory::setProfiler(Profiler *profiler)
+{
+  this->profiler = profiler;
+}
+
 IndType gpuNUFFT::GpuNUFFTOperatorFactory::computeSectorCountPerDimension(
     IndType dim, IndType sectorWidth)
 {
@@ -32,6 +400,7 @@ gpuNUFFT::GpuNUFFTOperatorFactory::initLinArray(IndType arrCount)
   gpuNUFFT::Array<T> new_array;
   new_array.data = (T *)malloc(arrCount * sizeof(T));
   new_array.dim.length = arrCount;
+  profileAllocation(profiler, arrCount * sizeof(T));
   return new_array;
 }
 
@@ -56,20 +425,27 @@ template <typename T>
 std::vector<gpuNUFFT::IndPair> gpuNUFFT::GpuNUFFTOperatorFactory::sortVector(
     gpuNUFFT::Array<T> assignedSectors, bool descending)
 {
-  std::vector<IndPair> secVector;
+  std::vector<IndPair> secVector(assignedSectors.count(), IndPair(0, 0));
 
-  for (IndType i = 0; i < assignedSectors.count(); i++)
-    secVector.push_back(IndPair(i, assignedSectors.data[i]));
+  InitPairsTask<T> initTask(assignedSectors.data, secVector);
+  hostParallelFor(assignedSectors.count(), initTask);
 
-  // using function as comp
+  // stable, thus the order of the samples within a sector does not depend on
+  // the thread count
   if (descending)
-    std::sort(secVector.begin(), secVector.end(), std::greater<IndPair>());
+    parallelStableSort<std::greater<IndPair> >(secVector);
   else
-    std::sort(secVector.begin(), secVector.end());
+    parallelStableSort<std::less<IndPair> >(secVector);
 
   return secVector;
 }
 
+// the sector sort is used outside of the factory as well, e.g. by the
+// benchmarks
+template std::vector<gpuNUFFT::IndPair>
+gpuNUFFT::GpuNUFFTOperatorFactory::sortVector<IndType>(
+    gpuNUFFT::Array<IndType> assignedSectors, bool descending);
+
 void gpuNUFFT::GpuNUFFTOperatorFactory::computeProcessingOrder(
     gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp)
 {
@@ -135,42 +511,54 @@ gpuNUFFT::Array<IndType> gpuNUFFT::GpuNUFFTOperatorFactory::assignSectors(
   assignedSectors.data = (IndType *)malloc(coordCnt * sizeof(IndType));
   assignedSectors.dim.length = coordCnt;
 
-  if (useGpu)
+  if (useGpu && !useHostBackend)
   {
     assignSectorsGPU(gpuNUFFTOp, kSpaceTraj, assignedSectors.data);
   }
   else
   {
-    IndType sector;
-    for (IndType cCnt = 0; cCnt < coordCnt; cCnt++)
-    {
-      if (gpuNUFFTOp->is2DProcessing())
-      {
-        DType2 coord;
-        coord.x = kSpaceTraj.data[cCnt];
-        coord.y = kSpaceTraj.data[cCnt + coordCnt];
-        IndType2 mappedSector =
-            computeSectorMapping(coord, gpuNUFFTOp->getGridDims(),
-                                 (DType)gpuNUFFTOp->getSectorWidth());
-        // linearize mapped sector
-        sector = computeInd22Lin(mappedSector, gpuNUFFTOp->getGridSectorDims());
-      }
-      else
-      {
-        DType3 coord;
-        coord.x = kSpaceTraj.data[cCnt];
-        coord.y = kSpaceTraj.data[cCnt + coordCnt];
-        coord.z = kSpaceTraj.data[cCnt + 2 * coordCnt];
-        IndType3 mappedSector =
-            computeSectorMapping(coord, gpuNUFFTOp->getGridDims(),
-                                 (DType)gpuNUFFTOp->getSectorWidth());
-        // linearize mapped sector
-        sector = computeInd32Lin(mappedSector, gpuNUFFTOp->getGridSectorDims());
-      }
+    assignSectorsCPU(gpuNUFFTOp, kSpaceTraj, assignedSectors.data, 0,
+                     coordCnt);
+  }
+  debug("finished assign sectors\n");
+  return assignedSectors;
+}
 
-      assignedSectors.data[cCnt] = sector;
-    }
+void gpuNUFFT::GpuNUFFTOperatorFactory::assignSectorsCPU(
+    gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp, gpuNUFFT::Array<DType> &kSpaceTraj,
+    IndType *assignedSectors, IndType offset, IndType count)
+{
+  AssignSectorsTask task(gpuNUFFTOp, kSpaceTraj, assignedSectors, offset);
+  hostParallelFor(count, task);
+}
+
+gpuNUFFT::Array<IndType> gpuNUFFT::GpuNUFFTOperatorFactory::assignSectors(
+    gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp, gpuNUFFT::MappedInputSource &input)
+{
+  debug("in assign sectors (mapped input)\n");
+
+  gpuNUFFTOp->setGridSectorDims(computeSectorCountPerDimension(
+      gpuNUFFTOp->getGridDims(), gpuNUFFTOp->getSectorWidth()));
+
+  gpuNUFFT::Array<DType> kSpaceTraj = input.getKSpaceTraj();
+  IndType coordCnt = kSpaceTraj.count();
+  IndType chunkSize = input.getChunkSize();
+
+  gpuNUFFT::Array<IndType> assignedSectors;
+  assignedSectors.data = (IndType *)malloc(coordCnt * sizeof(IndType));
+  assignedSectors.dim.length = coordCnt;
+
+  input.prefetchTraj(0, chunkSize);
+  for (IndType offset = 0; offset < coordCnt; offset += chunkSize)
+  {
+    IndType count = std::min(chunkSize, coordCnt - offset);
+    // read ahead next block
+    input.prefetchTraj(offset + count, chunkSize);
+    assignSectorsCPU(gpuNUFFTOp, kSpaceTraj, assignedSectors.data, offset,
+                     count);
+    input.releaseTraj(offset, count);
   }
+
   debug("finished assign sectors\n");
   return assignedSectors;
 }
@@ -225,16 +613,13 @@ gpuNUFFT::GpuNUFFTOperatorFactory::computeSectorCenters2D(
   gpuNUFFT::Array<IndType> sectorCenters =
     useLocalMemory ? GpuNUFFTOperatorFactory::initSectorCenters(gpuNUFFTOp, sectorDims.count()) : initSectorCenters(gpuNUFFTOp, sectorDims.count());
 
-  for (IndType y = 0; y < sectorDims.height; y++)
-    for (IndType x = 0; x < sectorDims.width; x++)
-    {
-      IndType2 center;
-      center.x = computeSectorCenter(x, sectorWidth);
-      center.y = computeSectorCenter(y, sectorWidth);
-      int index = computeXY2Lin((int)x, (int)y, sectorDims);
-      sectorCenters.data[2 * index] = center.x;
-      sectorCenters.data[2 * index + 1] = center.y;
-    }
+  std::vector<IndType> centers(
+      std::max(sectorDims.width, sectorDims.height));
+  for (IndType i = 0; i < centers.size(); i++)
+    centers[i] = computeSectorCenter(i, sectorWidth);
+
+  SectorCentersTask task(centers, sectorDims, 2, sectorCenters.data);
+  hostParallelFor(sectorDims.count(), task);
   return sectorCenters;
 }
 
@@ -248,20 +633,14 @@ gpuNUFFT::GpuNUFFTOperatorFactory::computeSectorCenters(
   gpuNUFFT::Array<IndType> sectorCenters =
     useLocalMemory ? GpuNUFFTOperatorFactory::initSectorCenters(gpuNUFFTOp, sectorDims.count()) : initSectorCenters(gpuNUFFTOp, sectorDims.count());
 
-  for (IndType z = 0; z < sectorDims.depth; z++)
-    for (IndType y = 0; y < sectorDims.height; y++)
-      for (IndType x = 0; x < sectorDims.width; x++)
-      {
-        IndType3 center;
-        center.x = computeSectorCenter(x, sectorWidth);
-        center.y = computeSectorCenter(y, sectorWidth);
-        center.z = computeSectorCenter(z, sectorWidth);
-        int index = computeXYZ2Lin((int)x, (int)y, (int)z, sectorDims);
-        // necessary in order to avoid 2d or 3d typed array
-        sectorCenters.data[3 * index] = center.x;
-        sectorCenters.data[3 * index + 1] = center.y;
-        sectorCenters.data[3 * index + 2] = center.z;
-      }
+  std::vector<IndType> centers(std::max(
+      std::max(sectorDims.width, sectorDims.height), sectorDims.depth));
+  for (IndType i = 0; i < centers.size(); i++)
+    centers[i] = computeSectorCenter(i, sectorWidth);
+
+  // necessary in order to avoid 2d or 3d typed array
+  SectorCentersTask task(centers, sectorDims, 3, sectorCenters.data);
+  hostParallelFor(sectorDims.count(), task);
   return sectorCenters;
 }
 
@@ -319,53 +698,99 @@ gpuNUFFT::Array<DType> gpuNUFFT::GpuNUFFTOperatorFactory::initDeapoData(
 
 gpuNUFFT::GpuNUFFTOperator *
 gpuNUFFT::GpuNUFFTOperatorFactory::createNewGpuNUFFTOperator(
-    IndType kernelWidth, IndType sectorWidth, DType osf, Dimensions imgDims)
+    IndType kernelWidth, IndType sectorWidth, DType osf, Dimensions imgDims,
+    IndType sampleCount)
 {
-  if (balanceWorkload)
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp;
+  bool hostNUDFT = useHostNUDFT || (sampleCount > 0 &&
+                                    sampleCount <= hostNUDFTSampleLimit);
+  if (useHostBackend && hostNUDFT)
+  {
+    debug("creating Host NUDFT Operator!\n");
+    gpuNUFFTOp = new gpuNUFFT::HostNUDFTOperator(kernelWidth, sectorWidth, osf,
+                                                 imgDims, this->matlabSharedMem);
+  }
+  else if (useHostBackend)
+  {
+    debug("creating Host GpuNUFFT Operator!\n");
+    gpuNUFFT::HostGpuNUFFTOperator *hostOp = new gpuNUFFT::HostGpuNUFFTOperator(
+        kernelWidth, sectorWidth, osf, imgDims, this->matlabSharedMem);
+    if (useLinearKernelInterpolation)
+      hostOp->setLinearKernelInterpolation(true);
+    if (hasKernelWidths())
+      hostOp->setKernelWidths(kernelWidths);
+    gpuNUFFTOp = hostOp;
+  }
+  else if (hasKernelWidths())
+  {
+    throw std::invalid_argument(
+        "Kernel widths per dimension require the host backend!");
+  }
+  else if (balanceWorkload)
   {
     if (useTextures)
     {
       debug("creating Balanced 2D TextureLookup Operator!\n");
-      return new gpuNUFFT::BalancedTextureGpuNUFFTOperator(
+      gpuNUFFTOp = new gpuNUFFT::BalancedTextureGpuNUFFTOperator(
           kernelWidth, sectorWidth, osf, imgDims, TEXTURE2D_LOOKUP,
           this->matlabSharedMem);
     }
     else
     {
       debug("creating Balanced GpuNUFFT Operator!\n");
-      return new gpuNUFFT::BalancedGpuNUFFTOperator(kernelWidth, sectorWidth,
+      gpuNUFFTOp = new gpuNUFFT::BalancedGpuNUFFTOperator(kernelWidth, sectorWidth,
         osf, imgDims, this->matlabSharedMem);
     }
   }
-
-  if (useTextures)
+  else if (useTextures)
   {
     debug("creating 2D TextureLookup Operator!\n");
-    return new gpuNUFFT::TextureGpuNUFFTOperator(kernelWidth, sectorWidth, osf,
-      imgDims, TEXTURE2D_LOOKUP, this->matlabSharedMem);
+    gpuNUFFTOp = new gpuNUFFT::TextureGpuNUFFTOperator(kernelWidth, sectorWidth,
+      osf, imgDims, TEXTURE2D_LOOKUP, this->matlabSharedMem);
   }
   else
   {
     debug("creating DEFAULT GpuNUFFT Operator!\n");
-    return new gpuNUFFT::GpuNUFFTOperator(kernelWidth, sectorWidth, osf,
-                                          imgDims, true, DEFAULT, true);
+    gpuNUFFTOp = new gpuNUFFT::GpuNUFFTOperator(kernelWidth, sectorWidth, osf,
+                                                imgDims, true, DEFAULT, true);
   }
+
+  gpuNUFFTOp->setProfiler(profiler);
+  if (kernelType != KAISER_BESSEL)
+    gpuNUFFTOp->setKernelType(kernelType);
+  if (lookupTableSize > 0)
+    gpuNUFFTOp->setKernelLookupTableSize(lookupTableSize);
+  return gpuNUFFTOp;
 }
 
 gpuNUFFT::Array<DType> gpuNUFFT::GpuNUFFTOperatorFactory::computeDeapodizationFunction(
   const IndType &kernelWidth, const DType &osf, gpuNUFFT::Dimensions &imgDims)
 {
   debug("compute deapodization function\n");
+  if (kernelType != KAISER_BESSEL)
+    return computeNumericalDeapodizationFunction(kernelWidth, osf, imgDims);
   
   // Create simple gpuNUFFT Operator
   IndType sectorWidth = 8;
   gpuNUFFT::GpuNUFFTOperator *deapoGpuNUFFTOp;
   
-  if (useTextures)
+  if (useHostBackend)
+  {
+    gpuNUFFT::HostGpuNUFFTOperator *hostOp =
+      new gpuNUFFT::HostGpuNUFFTOperator(kernelWidth, sectorWidth, osf, imgDims);
+    if (useLinearKernelInterpolation)
+      hostOp->setLinearKernelInterpolation(true);
+    if (hasKernelWidths())
+      hostOp->setKernelWidths(kernelWidths);
+    deapoGpuNUFFTOp = hostOp;
+  }
+  else if (useTextures)
     deapoGpuNUFFTOp = new gpuNUFFT::TextureGpuNUFFTOperator(kernelWidth, sectorWidth, osf,
     imgDims, TEXTURE2D_LOOKUP);
   else
     deapoGpuNUFFTOp = new gpuNUFFT::GpuNUFFTOperator(kernelWidth, sectorWidth, osf, imgDims);
+  if (lookupTableSize > 0)
+    deapoGpuNUFFTOp->setKernelLookupTableSize(lookupTableSize);
   
   // Data
   gpuNUFFT::Array<DType2> dataArray;
@@ -436,6 +861,46 @@ gpuNUFFT::Array<DType> gpuNUFFT::GpuNUFFTOperatorFactory::computeDeapodizationFu
   return deapoAbs;
 }
 
+gpuNUFFT::Array<DType>
+gpuNUFFT::GpuNUFFTOperatorFactory::computeNumericalDeapodizationFunction(
+    const IndType &kernelWidth, const DType &osf, gpuNUFFT::Dimensions &imgDims)
+{
+  debug("compute numerical deapodization function\n");
+
+  // Fourier transform of the kernel per dimension, evaluated at the
+  // image positions relative to the image center in cycles per grid unit
+  IndType dims[3] = { imgDims.width, DEFAULT_VALUE(imgDims.height),
+                      DEFAULT_VALUE(imgDims.depth) };
+  std::vector<double> transform[3];
+  for (int d = 0; d < 3; d++)
+  {
+    transform[d].resize(dims[d], 1.0);
+    if (d > 0 && (d == 1 ? imgDims.height : imgDims.depth) == 0)
+      continue;
+    IndType gridWidth = (IndType)(dims[d] * osf);
+    IndType axisWidth = d == 0 ? kernelWidths.width
+                               : d == 1 ? kernelWidths.height
+                                        : kernelWidths.depth;
+    int width = (int)(axisWidth > 0 ? axisWidth : kernelWidth);
+    for (IndType i = 0; i < dims[d]; i++)
+    {
+      double frequency =
+          ((double)i - (double)(dims[d] / 2)) / (double)gridWidth;
+      transform[d][i] =
+          kernelFourierTransform(frequency, width, osf, kernelType);
+    }
+  }
+
+  Array<DType> deapoAbs = initDeapoData(imgDims.count());
+  for (IndType z = 0; z < dims[2]; z++)
+    for (IndType y = 0; y < dims[1]; y++)
+      for (IndType x = 0; x < dims[0]; x++)
+        deapoAbs.data[x + dims[0] * (y + dims[1] * z)] = (DType)(
+            1.0 / std::fabs(transform[0][x] * transform[1][y] *
+                            transform[2][z]));
+  return deapoAbs;
+}
+
 gpuNUFFT::GpuNUFFTOperator *
 gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
     gpuNUFFT::Array<DType> &kSpaceTraj, gpuNUFFT::Array<DType> &densCompData,
@@ -443,8 +908,9 @@ gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
     const IndType &sectorWidth, const DType &osf, gpuNUFFT::Dimensions &imgDims)
 {
   // validate arguments
-  checkMemoryConsumption(kSpaceTraj.dim, sectorWidth, osf, imgDims,
-                         densCompData.dim, sensData.dim);
+  if (!useHostBackend)
+    checkMemoryConsumption(kSpaceTraj.dim, sectorWidth, osf, imgDims,
+                           densCompData.dim, sensData.dim);
 
   if (kSpaceTraj.dim.channels > 1)
     throw std::invalid_argument(
@@ -456,19 +922,23 @@ gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
 
   debug("create gpuNUFFT operator...");
 
-  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp =
-      createNewGpuNUFFTOperator(kernelWidth, sectorWidth, osf, imgDims);
+  IndType coordCnt = kSpaceTraj.dim.count();
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp = createNewGpuNUFFTOperator(
+      kernelWidth, sectorWidth, osf, imgDims, coordCnt);
 
   // assign according sector to k-Space position
+  ProfileScope assignScope(profiler, PROFILE_FACTORY_ASSIGN, coordCnt,
+                           coordCnt * (gpuNUFFTOp->getImageDimensionCount() *
+                                           sizeof(DType) + sizeof(IndType)));
   gpuNUFFT::Array<IndType> assignedSectors =
       assignSectors(gpuNUFFTOp, kSpaceTraj);
+  assignScope.stop();
 
   // order the assigned sectors and memorize index
+  ProfileScope sortScope(profiler, PROFILE_FACTORY_SORT, coordCnt);
   std::vector<IndPair> assignedSectorsAndIndicesSorted =
       sortVector<IndType>(assignedSectors);
 
-  IndType coordCnt = kSpaceTraj.dim.count();
-
   Array<DType> trajSorted = initCoordsData(gpuNUFFTOp, coordCnt);
   Array<IndType> dataIndices = initDataIndices(gpuNUFFTOp, coordCnt);
 
@@ -479,7 +949,7 @@ gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
   if (sensData.data != NULL)
     gpuNUFFTOp->setSens(sensData);
 
-  if (useGpu)
+  if (useGpu && !useHostBackend)
   {
     sortArrays(gpuNUFFTOp, assignedSectorsAndIndicesSorted,
                assignedSectors.data, dataIndices.data, kSpaceTraj,
@@ -487,29 +957,33 @@ gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
   }
   else
   {
-    // sort kspace data coords
-    for (unsigned i = 0; i < coordCnt; i++)
-    {
-      trajSorted.data[i] =
-          kSpaceTraj.data[assignedSectorsAndIndicesSorted[i].first];
-      trajSorted.data[i + 1 * coordCnt] =
-          kSpaceTraj
-              .data[assignedSectorsAndIndicesSorted[i].first + 1 * coordCnt];
-      if (gpuNUFFTOp->is3DProcessing())
-        trajSorted.data[i + 2 * coordCnt] =
-            kSpaceTraj
-                .data[assignedSectorsAndIndicesSorted[i].first + 2 * coordCnt];
-
-      // sort density compensation
-      if (densCompData.data != NULL)
-        densData.data[i] =
-            densCompData.data[assignedSectorsAndIndicesSorted[i].first];
-
-      dataIndices.data[i] = assignedSectorsAndIndicesSorted[i].first;
-      assignedSectors.data[i] = assignedSectorsAndIndicesSorted[i].second;
-    }
+    // sort kspace data coords and density compensation
+    GatherSortedTask task(assignedSectorsAndIndicesSorted, kSpaceTraj,
+                          gpuNUFFTOp->is3DProcessing() ? 3 : 2,
+                          densCompData.data, trajSorted.data, densData.data,
+                          dataIndices.data, assignedSectors.data);
+    hostParallelFor(coordCnt, task);
   }
+  sortScope.stop();
+
+  finalizeGpuNUFFTOperator(gpuNUFFTOp, assignedSectors, dataIndices,
+                           trajSorted, densData, kernelWidth, osf, imgDims);
+
+  debug("finished creation of gpuNUFFT operator\n");
+  
+  return gpuNUFFTOp;
+}
 
+void gpuNUFFT::GpuNUFFTOperatorFactory::finalizeGpuNUFFTOperator(
+    gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp,
+    gpuNUFFT::Array<IndType> &assignedSectors,
+    gpuNUFFT::Array<IndType> &dataIndices, gpuNUFFT::Array<DType> &trajSorted,
+    gpuNUFFT::Array<DType> &densData, const IndType &kernelWidth,
+    const DType &osf, gpuNUFFT::Dimensions &imgDims)
+{
+  ProfileScope countScope(profiler, PROFILE_FACTORY_COUNT,
+                          assignedSectors.count(),
+                          assignedSectors.count() * sizeof(IndType));
   gpuNUFFTOp->setSectorDataCount(
       computeSectorDataCount(gpuNUFFTOp, assignedSectors));
 
@@ -517,6 +991,7 @@ gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
     gpuNUFFTOp->getType() == gpuNUFFT::BALANCED_TEXTURE) {
     computeProcessingOrder(gpuNUFFTOp);
   }
+  countScope.stop();
 
   gpuNUFFTOp->setDataIndices(dataIndices);
 
@@ -524,22 +999,119 @@ gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
 
   gpuNUFFTOp->setDens(densData);
 
+  ProfileScope centersScope(profiler, PROFILE_FACTORY_CENTERS);
   if (gpuNUFFTOp->is3DProcessing())
     gpuNUFFTOp->setSectorCenters(computeSectorCenters(gpuNUFFTOp));
   else
     gpuNUFFTOp->setSectorCenters(computeSectorCenters2D(gpuNUFFTOp));
+  centersScope.stop();
 
   // free temporary array
   free(assignedSectors.data);
 
+  // the exact NUDFT needs no deapodization, which costs one gridding
+  // operation of the full grid, neither do convolution only operators
+  if (gpuNUFFTOp->getType() == gpuNUFFT::HOST_NUDFT || !useDeapodization)
+    return;
+
+  ProfileScope deapoScope(profiler, PROFILE_FACTORY_DEAPO, 0,
+                          imgDims.count() * sizeof(DType));
   gpuNUFFTOp->setDeapodizationFunction(
     this->computeDeapodizationFunction(kernelWidth, osf, imgDims));
-    
+}
+
+gpuNUFFT::GpuNUFFTOperator *
+gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
+    gpuNUFFT::MappedInputSource &input, gpuNUFFT::Array<DType2> &sensData,
+    const IndType &kernelWidth, const IndType &sectorWidth, const DType &osf,
+    gpuNUFFT::Dimensions &imgDims)
+{
+  gpuNUFFT::Array<DType> kSpaceTraj = input.getKSpaceTraj();
+  gpuNUFFT::Array<DType> densCompData = input.getDens();
+
+  // validate arguments
+  if (input.getDimensionCount() != (imgDims.depth > 0 ? 3 : 2))
+    throw std::invalid_argument(
+        "Trajectory dimension count does not match image dimensions!");
+
+  if (imgDims.channels > 1)
+    throw std::invalid_argument(
+        "Image dimensions must not contain a channel size greater than 1!");
+
+  if (!useHostBackend)
+    checkMemoryConsumption(kSpaceTraj.dim, sectorWidth, osf, imgDims,
+                           densCompData.dim, sensData.dim);
+
+  debug("create gpuNUFFT operator from mapped input...");
+
+  IndType coordCnt = kSpaceTraj.dim.count();
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp = createNewGpuNUFFTOperator(
+      kernelWidth, sectorWidth, osf, imgDims, coordCnt);
+
+  // assign according sector to k-Space position
+  ProfileScope assignScope(profiler, PROFILE_FACTORY_ASSIGN, coordCnt,
+                           coordCnt * (gpuNUFFTOp->getImageDimensionCount() *
+                                           sizeof(DType) + sizeof(IndType)));
+  gpuNUFFT::Array<IndType> assignedSectors = assignSectors(gpuNUFFTOp, input);
+  assignScope.stop();
+
+  // order the assigned sectors and memorize index
+  ProfileScope sortScope(profiler, PROFILE_FACTORY_SORT, coordCnt);
+  std::vector<IndPair> assignedSectorsAndIndicesSorted =
+      sortVector<IndType>(assignedSectors);
+
+  Array<DType> trajSorted = initCoordsData(gpuNUFFTOp, coordCnt);
+  Array<IndType> dataIndices = initDataIndices(gpuNUFFTOp, coordCnt);
+
+  Array<DType> densData;
+  if (densCompData.data != NULL)
+    densData = initDensData(gpuNUFFTOp, coordCnt);
+
+  if (sensData.data != NULL)
+    gpuNUFFTOp->setSens(sensData);
+
+  // sorted position of each input sample, allows to read the input
+  // sequentially block by block
+  std::vector<IndType> sortedPosition(coordCnt);
+  SortedIndicesTask indicesTask(assignedSectorsAndIndicesSorted,
+                                dataIndices.data, assignedSectors.data,
+                                sortedPosition);
+  hostParallelFor(coordCnt, indicesTask);
+  std::vector<IndPair>().swap(assignedSectorsAndIndicesSorted);
+
+  int dimCount = gpuNUFFTOp->getImageDimensionCount();
+  IndType chunkSize = input.getChunkSize();
+  input.prefetchTraj(0, chunkSize);
+  for (IndType offset = 0; offset < coordCnt; offset += chunkSize)
+  {
+    IndType count = std::min(chunkSize, coordCnt - offset);
+    input.prefetchTraj(offset + count, chunkSize);
+    ScatterSortedTask scatterTask(sortedPosition, kSpaceTraj, dimCount,
+                                  densCompData.data, trajSorted.data,
+                                  densData.data, offset);
+    hostParallelFor(count, scatterTask);
+    input.releaseTraj(offset, count);
+  }
+  sortScope.stop();
+
+  finalizeGpuNUFFTOperator(gpuNUFFTOp, assignedSectors, dataIndices,
+                           trajSorted, densData, kernelWidth, osf, imgDims);
+
   debug("finished creation of gpuNUFFT operator\n");
-  
+
   return gpuNUFFTOp;
 }
 
+gpuNUFFT::GpuNUFFTOperator *
+gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
+    gpuNUFFT::MappedInputSource &input, const IndType &kernelWidth,
+    const IndType &sectorWidth, const DType &osf, gpuNUFFT::Dimensions &imgDims)
+{
+  gpuNUFFT::Array<DType2> sensData;
+  return createGpuNUFFTOperator(input, sensData, kernelWidth, sectorWidth, osf,
+                                imgDims);
+}
+
 gpuNUFFT::GpuNUFFTOperator *
 gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
     gpuNUFFT::Array<DType> &kSpaceTraj, gpuNUFFT::Array<DType> &densCompData,
@@ -561,6 +1133,202 @@ gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
                                 sectorWidth, osf, imgDims);
 }
 
+gpuNUFFT::HostStackOfStarsOperator *
+gpuNUFFT::GpuNUFFTOperatorFactory::createStackOfStarsOperator(
+    gpuNUFFT::Array<DType> &kSpaceTraj, gpuNUFFT::Array<DType> &densCompData,
+    gpuNUFFT::Array<DType2> &sensData, const IndType &kernelWidth,
+    const IndType &sectorWidth, const DType &osf, gpuNUFFT::Dimensions &imgDims)
+{
+  if (imgDims.depth == 0)
+    throw std::invalid_argument(
+        "Stack-of-stars image dimensions require at least one partition!");
+
+  debug("create stack-of-stars operator...");
+
+  // the partitions share one 2-d host operator
+  gpuNUFFT::Dimensions sliceDims(imgDims.width, imgDims.height);
+  gpuNUFFT::HostGpuNUFFTOperator *sliceOp = createHostGpuNUFFTOperator(
+      kSpaceTraj, densCompData, kernelWidth, sectorWidth, osf, sliceDims);
+
+  return new gpuNUFFT::HostStackOfStarsOperator(sliceOp, imgDims.depth,
+                                                sensData);
+}
+
+gpuNUFFT::HostTimeSegmentedOperator *
+gpuNUFFT::GpuNUFFTOperatorFactory::createTimeSegmentedOperator(
+    gpuNUFFT::Array<DType> &kSpaceTraj, gpuNUFFT::Array<DType> &densCompData,
+    gpuNUFFT::Array<DType2> &sensData, gpuNUFFT::Array<DType> &fieldMap,
+    gpuNUFFT::Array<DType> &readoutTimes, IndType segments,
+    const IndType &kernelWidth, const IndType &sectorWidth, const DType &osf,
+    gpuNUFFT::Dimensions &imgDims)
+{
+  debug("create time-segmented operator...");
+
+  // all segments share one host operator without sensitivities
+  gpuNUFFT::HostGpuNUFFTOperator *gpuNUFFTOp = createHostGpuNUFFTOperator(
+      kSpaceTraj, densCompData, kernelWidth, sectorWidth, osf, imgDims);
+
+  return new gpuNUFFT::HostTimeSegmentedOperator(gpuNUFFTOp, sensData,
+                                                 fieldMap, readoutTimes,
+                                                 segments);
+}
+
+gpuNUFFT::HostPartitionedOperator *
+gpuNUFFT::GpuNUFFTOperatorFactory::createPartitionedOperator(
+    gpuNUFFT::Array<DType> &kSpaceTraj, gpuNUFFT::Array<DType> &densCompData,
+    gpuNUFFT::Array<DType2> &sensData, IndType partitions,
+    const IndType &kernelWidth, const IndType &sectorWidth, const DType &osf,
+    gpuNUFFT::Dimensions &imgDims)
+{
+  debug("create partitioned operator...");
+
+  gpuNUFFT::HostGpuNUFFTOperator *gpuNUFFTOp = createHostGpuNUFFTOperator(
+      kSpaceTraj, densCompData, kernelWidth, sectorWidth, osf, imgDims);
+
+  // each backend is created from the sorted samples of its slab
+  std::vector<IndType> slabSectors, slabSamples;
+  std::vector<gpuNUFFT::HostGpuNUFFTOperator *> backends;
+  try
+  {
+    gpuNUFFT::HostPartitionedOperator::computeSlabs(gpuNUFFTOp, partitions,
+                                                    slabSectors, slabSamples);
+    gpuNUFFT::Array<DType> trajSorted = gpuNUFFTOp->getKSpaceTraj();
+    gpuNUFFT::Array<DType> densSorted = gpuNUFFTOp->getDens();
+    bool dens = gpuNUFFTOp->applyDensComp();
+    IndType dimCount = gpuNUFFTOp->getImageDimensionCount();
+    IndType coordCnt = trajSorted.count();
+    for (IndType p = 0; p < partitions; p++)
+    {
+      IndType first = slabSamples[p];
+      IndType count = slabSamples[p + 1] - first;
+      if (count == 0)
+      {
+        backends.push_back(NULL);
+        continue;
+      }
+      std::vector<DType> traj(count * dimCount), densSlab(dens ? count : 0);
+      for (IndType d = 0; d < dimCount; d++)
+        std::copy(trajSorted.data + d * coordCnt + first,
+                  trajSorted.data + d * coordCnt + first + count,
+                  traj.begin() + d * count);
+      if (dens)
+        std::copy(densSorted.data + first, densSorted.data + first + count,
+                  densSlab.begin());
+      gpuNUFFT::Array<DType> trajSlab;
+      trajSlab.data = &traj[0];
+      trajSlab.dim.length = count;
+      gpuNUFFT::Array<DType> densArray;
+      densArray.data = dens ? &densSlab[0] : NULL;
+      densArray.dim.length = dens ? count : 0;
+      // the main operator performs the deapodization for all backends
+      backends.push_back(createHostGpuNUFFTOperator(trajSlab, densArray,
+                                                    kernelWidth, sectorWidth,
+                                                    osf, imgDims, false));
+    }
+  }
+  catch (...)
+  {
+    for (IndType p = 0; p < backends.size(); p++)
+      delete backends[p];
+    delete gpuNUFFTOp;
+    throw;
+  }
+
+  gpuNUFFTOp->setSens(sensData);
+  return new gpuNUFFT::HostPartitionedOperator(gpuNUFFTOp, backends,
+                                               slabSectors);
+}
+
+gpuNUFFT::HostGpuNUFFTOperator *
+gpuNUFFT::GpuNUFFTOperatorFactory::createHostGpuNUFFTOperator(
+    gpuNUFFT::Array<DType> &kSpaceTraj, gpuNUFFT::Array<DType> &densCompData,
+    const IndType &kernelWidth, const IndType &sectorWidth, const DType &osf,
+    gpuNUFFT::Dimensions &imgDims, bool deapodization)
+{
+  bool hostBackend = useHostBackend;
+  bool hostNUDFT = useHostNUDFT;
+  IndType nudftSampleLimit = hostNUDFTSampleLimit;
+  useHostBackend = true;
+  useHostNUDFT = false;
+  hostNUDFTSampleLimit = 0;
+  useDeapodization = deapodization;
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp;
+  try
+  {
+    gpuNUFFTOp = createGpuNUFFTOperator(kSpaceTraj, densCompData, kernelWidth,
+                                        sectorWidth, osf, imgDims);
+  }
+  catch (...)
+  {
+    useHostBackend = hostBackend;
+    useHostNUDFT = hostNUDFT;
+    hostNUDFTSampleLimit = nudftSampleLimit;
+    useDeapodization = true;
+    throw;
+  }
+  useHostBackend = hostBackend;
+  useHostNUDFT = hostNUDFT;
+  hostNUDFTSampleLimit = nudftSampleLimit;
+  useDeapodization = true;
+  return static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(gpuNUFFTOp);
+}
+
+gpuNUFFT::GpuNUFFTPlan gpuNUFFT::GpuNUFFTOperatorFactory::planGpuNUFFTOperator(
+    double tolerance, IndType sampleCount, gpuNUFFT::Dimensions &imgDims)
+{
+  bool linearInterpolation = useHostBackend
+                                 ? (useLinearKernelInterpolation && !useHostNUDFT)
+                                 : useTextures;
+  // texture operators hold 2-d or 3-d tables of size^d entries
+  IndType maxLookupTableSize = (useTextures && !useHostBackend) ? 256 : 10000;
+  return planGpuNUFFT(tolerance, imgDims, sampleCount, kernelType,
+                      linearInterpolation, 8.0, maxLookupTableSize);
+}
+
+gpuNUFFT::GpuNUFFTOperator *
+gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
+    gpuNUFFT::Array<DType> &kSpaceTraj, gpuNUFFT::Array<DType> &densCompData,
+    gpuNUFFT::Array<DType2> &sensData, double tolerance,
+    const IndType &sectorWidth, gpuNUFFT::Dimensions &imgDims)
+{
+  GpuNUFFTPlan plan =
+      planGpuNUFFTOperator(tolerance, kSpaceTraj.count(), imgDims);
+  std::stringstream ss;
+  ss << "planned kernel width " << plan.kernelWidth << ", osf " << plan.osf
+     << ", lookup table size " << plan.lookupTableSize << std::endl;
+  debug(ss.str());
+
+  // the planned table size applies to the gridding and the deapodization
+  // operator, the configured size is restored afterwards
+  IndType configuredLookupTableSize = lookupTableSize;
+  lookupTableSize = plan.lookupTableSize;
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp = NULL;
+  try
+  {
+    gpuNUFFTOp =
+        createGpuNUFFTOperator(kSpaceTraj, densCompData, sensData,
+                               plan.kernelWidth, sectorWidth, plan.osf, imgDims);
+  }
+  catch (...)
+  {
+    lookupTableSize = configuredLookupTableSize;
+    throw;
+  }
+  lookupTableSize = configuredLookupTableSize;
+  return gpuNUFFTOp;
+}
+
+gpuNUFFT::GpuNUFFTOperator *
+gpuNUFFT::GpuNUFFTOperatorFactory::createGpuNUFFTOperator(
+    gpuNUFFT::Array<DType> &kSpaceTraj, double tolerance,
+    const IndType &sectorWidth, gpuNUFFT::Dimensions &imgDims)
+{
+  gpuNUFFT::Array<DType> densCompData;
+  gpuNUFFT::Array<DType2> sensData;
+  return createGpuNUFFTOperator(kSpaceTraj, densCompData, sensData, tolerance,
+                                sectorWidth, imgDims);
+}
+
 gpuNUFFT::GpuNUFFTOperator *
 gpuNUFFT::GpuNUFFTOperatorFactory::loadPrecomputedGpuNUFFTOperator(
     gpuNUFFT::Array<DType> &kSpaceTraj, gpuNUFFT::Array<IndType> &dataIndices,
@@ -0,0 +1,162 @@
+#include "gpuNUFFT_planner.hpp"
+#include "gpuNUFFT_utils.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+// sum of the prime factors of n, i.e. the butterfly passes of a mixed radix
+// FFT of length n
+double primeFactorSum(IndType n)
+{
+  double sum = 0.0;
+  for (IndType p = 2; p * p <= n; p++)
+    while (n % p == 0)
+    {
+      sum += p;
+      n /= p;
+    }
+  if (n > 1)
+    sum += n;
+  return sum;
+}
+
+double estimateCost(gpuNUFFT::Dimensions &gridDims, IndType sampleCount,
+                    int kernelWidth, int dimensionCount,
+                    double convolutionWeight)
+{
+  double gridCount = (double)gridDims.count();
+  double passes = primeFactorSum(gridDims.width) +
+                  primeFactorSum(gridDims.height) +
+                  primeFactorSum(gridDims.depth);
+  double fftCost = 0.5 * gridCount * passes;
+  double convolutionCost = convolutionWeight * sampleCount *
+                           pow((double)kernelWidth, dimensionCount);
+  return fftCost + convolutionCost;
+}
+
+// measured table errors of the gridding implementation relative to the
+// bounds of Beatty et al., the tables are indexed by the squared radius
+const double NEAREST_NEIGHBOR_TABLE_FACTOR = 2.0;
+const double LINEAR_TABLE_FACTOR = 8.0;
+
+// smallest table keeping the table error of one dimension below tolerance
+double requiredLookupTableSize(double tolerance, int kernelWidth, DType osf,
+                               bool linearInterpolation)
+{
+  double kernelOsf =
+      linearInterpolation
+          ? sqrt(LINEAR_TABLE_FACTOR * 0.37 / (sqr((double)osf) * tolerance))
+          : NEAREST_NEIGHBOR_TABLE_FACTOR * 0.91 / (osf * tolerance);
+  return ceil(kernelOsf * kernelWidth * 0.5);
+}
+}
+
+double gpuNUFFT::estimateAliasingError(int kernelWidth, DType osf,
+                                       KernelType kernelType)
+{
+  // the Kaiser-Bessel deapodization is obtained by gridding a single sample,
+  // i.e. it is the transform of the kernel sampled at the grid points instead
+  // of the continuous transform, which adds the difference of both
+  bool sampledDeapodization = kernelType == KAISER_BESSEL;
+  const int frequencies = 5;
+  const int aliases = 2;
+  double sum = 0.0;
+  for (int i = 0; i < frequencies; i++)
+  {
+    double f = 0.5 / osf * i / (frequencies - 1);
+    double transform = kernelFourierTransform(f, kernelWidth, osf, kernelType);
+    double aliasedPower = 0.0;
+    for (int p = 1; p <= aliases; p++)
+      aliasedPower +=
+          sqr(kernelFourierTransform(f - p, kernelWidth, osf, kernelType)) +
+          sqr(kernelFourierTransform(f + p, kernelWidth, osf, kernelType));
+
+    double deapodization = transform;
+    if (sampledDeapodization)
+    {
+      deapodization = 0.0;
+      for (int x = -kernelWidth / 2; x <= kernelWidth / 2; x++)
+        deapodization += evaluateKernel(fabs(x) / (0.5 * kernelWidth),
+                                        kernelWidth, osf, kernelType) *
+                         cos(2.0 * M_PI * f * x);
+      aliasedPower += sqr(transform - deapodization);
+    }
+    sum += aliasedPower / sqr(deapodization);
+  }
+  return sqrt(sum / frequencies);
+}
+
+double gpuNUFFT::estimateLookupTableError(IndType tableSize, int kernelWidth,
+                                          DType osf, bool linearInterpolation)
+{
+  double kernelOsf = tableSize / (kernelWidth * 0.5);
+  if (linearInterpolation)
+    return LINEAR_TABLE_FACTOR * 0.37 / sqr(osf * kernelOsf);
+  return NEAREST_NEIGHBOR_TABLE_FACTOR * 0.91 / (osf * kernelOsf);
+}
+
+gpuNUFFT::GpuNUFFTPlan gpuNUFFT::planGpuNUFFT(
+    double tolerance, Dimensions &imgDims, IndType sampleCount,
+    KernelType kernelType, bool linearInterpolation, double convolutionWeight,
+    IndType maxLookupTableSize)
+{
+  if (!(tolerance > 0.0 && tolerance < 1.0))
+    throw std::invalid_argument("Tolerance has to be in (0,1)!");
+  // single precision rounding limits the reachable error
+  if (sizeof(DType) == sizeof(float) && tolerance < 2e-5)
+    throw std::invalid_argument(
+        "Tolerance below single precision accuracy (2e-5)!");
+
+  int dimensionCount = imgDims.depth > 1 ? 3 : (imgDims.height > 1 ? 2 : 1);
+  // the per dimension errors add up in quadrature
+  double dimensionTolerance = tolerance / sqrt((double)dimensionCount);
+
+  // odd Kaiser-Bessel widths and oversampling ratios below 1.5 exceed the
+  // modelled error by a factor of up to 3.5 in the gridding implementation
+  bool kaiserBessel = kernelType == KAISER_BESSEL;
+  int widthIncrement = kaiserBessel ? 2 : 1;
+
+  GpuNUFFTPlan best;
+  for (int o = kaiserBessel ? 2 : 0; o <= 6; o++)
+  {
+    DType osf = (DType)(1.25 + 0.125 * o);
+    Dimensions gridDims = imgDims * osf;
+    for (int kernelWidth = 2; kernelWidth <= 16;
+         kernelWidth += widthIncrement)
+    {
+      double aliasingError = estimateAliasingError(kernelWidth, osf, kernelType);
+      if (aliasingError >= dimensionTolerance)
+        continue;
+      double tableSize =
+          requiredLookupTableSize(dimensionTolerance - aliasingError,
+                                  kernelWidth, osf, linearInterpolation);
+      if (tableSize > maxLookupTableSize)
+        continue;
+
+      // wider kernels of this oversampling ratio only cost more
+      double cost = estimateCost(gridDims, sampleCount, kernelWidth,
+                                 dimensionCount, convolutionWeight);
+      if (best.kernelWidth == 0 || cost < best.estimatedCost)
+      {
+        best.kernelWidth = kernelWidth;
+        best.osf = osf;
+        best.lookupTableSize = tableSize < 2 ? 2 : (IndType)tableSize;
+        best.aliasingError = aliasingError;
+        best.lookupTableError = estimateLookupTableError(
+            best.lookupTableSize, kernelWidth, osf, linearInterpolation);
+        best.estimatedError = sqrt((double)dimensionCount) *
+                              (best.aliasingError + best.lookupTableError);
+        best.estimatedCost = cost;
+      }
+      break;
+    }
+  }
+
+  if (best.kernelWidth == 0)
+    throw std::invalid_argument(
+        "Tolerance cannot be reached by any kernel width and oversampling "
+        "ratio!");
+  return best;
+}
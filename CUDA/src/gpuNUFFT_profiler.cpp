@@ -0,0 +1,143 @@
+#include "gpuNUFFT_profiler.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <mutex>
+
+namespace
+{
+std::mutex &lockOf(void *lock)
+{
+  return *static_cast<std::mutex *>(lock);
+}
+}
+
+gpuNUFFT::Profiler::Profiler()
+  : enabled(false), sink(NULL), allocationCount(0), allocatedBytes(0),
+    lock(new std::mutex())
+{
+}
+
+gpuNUFFT::Profiler::~Profiler()
+{
+  delete static_cast<std::mutex *>(lock);
+}
+
+void gpuNUFFT::Profiler::setSink(ProfileSink *sink)
+{
+  std::lock_guard<std::mutex> guard(lockOf(lock));
+  this->sink = sink;
+}
+
+void gpuNUFFT::Profiler::reset()
+{
+  std::lock_guard<std::mutex> guard(lockOf(lock));
+  for (int s = 0; s < PROFILE_STAGE_COUNT; s++)
+    counters[s] = ProfileCounters();
+  allocationCount = 0;
+  allocatedBytes = 0;
+}
+
+gpuNUFFT::ProfileCounters
+gpuNUFFT::Profiler::getCounters(ProfileStage stage)
+{
+  std::lock_guard<std::mutex> guard(lockOf(lock));
+  return counters[stage];
+}
+
+unsigned long long gpuNUFFT::Profiler::getAllocationCount()
+{
+  std::lock_guard<std::mutex> guard(lockOf(lock));
+  return allocationCount;
+}
+
+unsigned long long gpuNUFFT::Profiler::getAllocatedBytes()
+{
+  std::lock_guard<std::mutex> guard(lockOf(lock));
+  return allocatedBytes;
+}
+
+const char *gpuNUFFT::Profiler::getStageName(ProfileStage stage)
+{
+  switch (stage)
+  {
+  case PROFILE_SORT:
+    return "sort";
+  case PROFILE_DENSITY_COMPENSATION:
+    return "density_compensation";
+  case PROFILE_CONVOLUTION:
+    return "convolution";
+  case PROFILE_FFT:
+    return "fft";
+  case PROFILE_CROP:
+    return "crop";
+  case PROFILE_DEAPODIZATION:
+    return "deapodization";
+  case PROFILE_SENSITIVITY:
+    return "sensitivity";
+  case PROFILE_FUSED_IMAGE:
+    return "fused_image";
+  case PROFILE_FACTORY_ASSIGN:
+    return "factory_assign";
+  case PROFILE_FACTORY_SORT:
+    return "factory_sort";
+  case PROFILE_FACTORY_COUNT:
+    return "factory_count";
+  case PROFILE_FACTORY_CENTERS:
+    return "factory_centers";
+  case PROFILE_FACTORY_DEAPO:
+    return "factory_deapo";
+  default:
+    return "unknown";
+  }
+}
+
+void gpuNUFFT::Profiler::addStage(ProfileStage stage, double wallTime,
+                                  double cpuTime, unsigned long long samples,
+                                  unsigned long long bytes)
+{
+  ProfileCounters record;
+  record.wallTime = wallTime;
+  record.cpuTime = cpuTime;
+  record.calls = 1;
+  record.samples = samples;
+  record.bytes = bytes;
+
+  ProfileSink *currentSink;
+  {
+    std::lock_guard<std::mutex> guard(lockOf(lock));
+    ProfileCounters &c = counters[stage];
+    c.wallTime += wallTime;
+    c.cpuTime += cpuTime;
+    c.calls++;
+    c.samples += samples;
+    c.bytes += bytes;
+    currentSink = sink;
+  }
+  if (currentSink != NULL)
+    currentSink->stageFinished(stage, record);
+}
+
+void gpuNUFFT::Profiler::addAllocation(size_t bytes)
+{
+  ProfileSink *currentSink;
+  {
+    std::lock_guard<std::mutex> guard(lockOf(lock));
+    allocationCount++;
+    allocatedBytes += bytes;
+    currentSink = sink;
+  }
+  if (currentSink != NULL)
+    currentSink->allocationPerformed(bytes);
+}
+
+double gpuNUFFT::Profiler::wallClock()
+{
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double gpuNUFFT::Profiler::cpuClock()
+{
+  return (double)std::clock() / CLOCKS_PER_SEC;
+}
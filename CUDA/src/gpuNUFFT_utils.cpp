@@ -1,4 +1,95 @@
 #include "gpuNUFFT_utils.hpp"
+#include "host_parallel.hpp"
+
+namespace
+{
+// kernel table entries [first + begin, first + end) of radius squared, or
+// their derivative
+class KernelTableTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  KernelTableTask(DType *kernTab, long first, long kernel_entries,
+                  int kernel_width, DType osr,
+                  gpuNUFFT::KernelType kernelType, bool derivative)
+    : kernTab(kernTab), first(first), kernel_entries(kernel_entries),
+      kernel_width(kernel_width), osr(osr), kernelType(kernelType),
+      derivative(derivative)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (long i = first + (long)begin; i < first + (long)end; i++)
+      kernTab[i] = derivative ? evaluateDerivative(i) : evaluate(i);
+  }
+
+ private:
+  DType evaluate(long i)
+  {
+    // dirty fix for kw 1 -> something
+    // like nearest neighbor
+    if (kernel_width == 1)
+      return 1.0f;
+    double rsqr = (double)sqrt(
+        i / (double)(kernel_entries - 1));  //*(i/(float)(size-1));
+    return static_cast<DType>(evaluateKernel(
+        rsqr, kernel_width, osr,
+        kernelType)); /* kernel table for radius squared */
+  }
+
+  DType evaluateDerivative(long i)
+  {
+    if (kernel_width == 1 || i == kernel_entries - 1)
+      return (DType)0.0;
+    // step of the central differences in table entries, large enough for the
+    // single precision evaluation of the Kaiser-Bessel function. The kernel
+    // is evaluated up to just below the radius where it may not be
+    // differentiable.
+    const double h = 0.5;
+    double last = (double)(kernel_entries - 1);
+    double lo = fmax((double)i - h, 0.0);
+    double hi = fmin((double)i + h, last * (1.0 - 1e-9));
+    double klo = evaluateKernel(sqrt(lo / last), kernel_width, osr, kernelType);
+    double khi = evaluateKernel(sqrt(hi / last), kernel_width, osr, kernelType);
+    return static_cast<DType>((khi - klo) / (hi - lo));
+  }
+
+  DType *kernTab;
+  long first;
+  long kernel_entries;
+  int kernel_width;
+  DType osr;
+  gpuNUFFT::KernelType kernelType;
+  bool derivative;
+};
+
+// rows [begin, end) of the separable 2-d or 3-d kernel table, the row index is
+// j + k * kernel_entries. Row 0 is the 1-d table itself since its first entry
+// is 1.
+class SeparableKernelTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  SeparableKernelTask(DType *kernTab, long kernel_entries)
+    : kernTab(kernTab), kernel_entries(kernel_entries)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (long row = (long)begin + 1; row < (long)end + 1; row++)
+    {
+      DType factor =
+          kernTab[row % kernel_entries] * kernTab[row / kernel_entries];
+      for (long i = 0; i < kernel_entries; i++)
+        kernTab[i + row * kernel_entries] = factor * kernTab[i];
+    }
+  }
+
+ private:
+  DType *kernTab;
+  long kernel_entries;
+};
+}
 
 DType i0(DType x)
 {
@@ -33,6 +124,55 @@ DType i0(DType x)
   return (ans);
 }
 
+DType esKernelBeta(int kernel_width, DType osr)
+{
+  return (DType)(0.97 * M_PI * kernel_width * (1.0 - 0.5 / osr));
+}
+
+int esKernelWidth(DType tolerance, DType osr)
+{
+  if (tolerance <= 0 || osr <= 1)
+    return 16;
+  int width = (int)ceil(-log((double)tolerance) /
+                        (M_PI * sqrt(1.0 - 1.0 / (double)osr))) +
+              1;
+  if (width < 2)
+    width = 2;
+  if (width > 16)
+    width = 16;
+  return width;
+}
+
+double evaluateKernel(double radius, int kernel_width, DType osr,
+                      gpuNUFFT::KernelType kernelType)
+{
+  if (radius >= 1.0)
+    return 0.0;
+  if (kernelType == gpuNUFFT::EXPONENTIAL_OF_SEMICIRCLE)
+    return exp(esKernelBeta(kernel_width, osr) *
+               (sqrt(1.0 - radius * radius) - 1.0));
+  return kernel((DType)radius, kernel_width, osr);
+}
+
+double kernelFourierTransform(double frequency, int kernel_width, DType osr,
+                              gpuNUFFT::KernelType kernelType)
+{
+  // the kernel is even, integrate over [0, kernel_width/2] and double
+  const int intervals = 128 * kernel_width;
+  double halfWidth = 0.5 * kernel_width;
+  double h = halfWidth / intervals;
+  double sum = 0.0;
+  for (int i = 0; i <= intervals; i++)
+  {
+    double x = i * h;
+    double weight = (i == 0 || i == intervals) ? 1.0 : (i % 2 ? 4.0 : 2.0);
+    sum += weight * evaluateKernel(x / halfWidth, kernel_width, osr,
+                                   kernelType) *
+           cos(2.0 * M_PI * frequency * x);
+  }
+  return 2.0 * sum * h / 3.0;
+}
+
 long calculateGrid3KernelSize()
 {
   return calculateGrid3KernelSize(DEFAULT_OVERSAMPLING_RATIO,
@@ -72,31 +212,17 @@ void loadGrid3Kernel(DType *kernTab, long kernel_entries)
 }
 
 void load1DKernel(DType *kernTab, long kernel_entries, int kernel_width,
-                  DType osr)
+                  DType osr, gpuNUFFT::KernelType kernelType)
 {
   /* check input data */
   assert(kernTab != NULL);
-  long i;
 
-  double rsqr = 0.0;
   /* load table */
-  for (i = 1; i < kernel_entries - 1; i++)
+  if (kernel_entries > 2)
   {
-    // dirty fix for kw 1 -> something
-    // like nearest neighbor
-    if (kernel_width == 1)
-    {
-      kernTab[i] = 1.0f;
-    }
-    else
-    {
-      rsqr = (double)sqrt(
-          i / (double)(kernel_entries - 1));  //*(i/(float)(size-1));
-      kernTab[i] = static_cast<DType>(
-          (DType)kernel((DType)rsqr, kernel_width,
-                        osr)); /* kernel table for radius squared */
-    }
-    //    assert(!isnan(kernTab[i])); //check is NaN
+    KernelTableTask task(kernTab, 1, kernel_entries, kernel_width, osr,
+                         kernelType, false);
+    gpuNUFFT::hostParallelFor(kernel_entries - 2, task);
   }
 
   /* ensure center point is 1 */
@@ -106,39 +232,37 @@ void load1DKernel(DType *kernTab, long kernel_entries, int kernel_width,
   kernTab[kernel_entries - 1] = (DType)0.0f;
 } /* end loadGrid3Kernel() */
 
+void load1DKernelDerivative(DType *derivTab, long kernel_entries,
+                            int kernel_width, DType osr,
+                            gpuNUFFT::KernelType kernelType)
+{
+  assert(derivTab != NULL);
+  KernelTableTask task(derivTab, 0, kernel_entries, kernel_width, osr,
+                       kernelType, true);
+  gpuNUFFT::hostParallelFor(kernel_entries, task);
+}
+
 void load2DKernel(DType *kernTab, long kernel_entries, int kernel_width,
-                  DType osr)
+                  DType osr, gpuNUFFT::KernelType kernelType)
 {
   /* check input data */
   assert(kernTab != NULL);
-  load1DKernel(kernTab, kernel_entries, kernel_width, osr);
+  load1DKernel(kernTab, kernel_entries, kernel_width, osr, kernelType);
 
   /* load table */
-  for (long j = 0; j < kernel_entries; j++)
-  {
-    for (long i = 0; i < kernel_entries; i++)
-    {
-      kernTab[i + j * kernel_entries] = kernTab[j] * kernTab[i];
-    }
-  }
+  SeparableKernelTask task(kernTab, kernel_entries);
+  gpuNUFFT::hostParallelFor(kernel_entries - 1, task);
 }  // end load2DKernel()
 
 void load3DKernel(DType *kernTab, long kernel_entries, int kernel_width,
-                  DType osr)
+                  DType osr, gpuNUFFT::KernelType kernelType)
 {
   /* check input data */
   assert(kernTab != NULL);
-  load1DKernel(kernTab, kernel_entries, kernel_width, osr);
+  load1DKernel(kernTab, kernel_entries, kernel_width, osr, kernelType);
 
   /* load table */
-  for (long k = 0; k < kernel_entries; k++)
-    for (long j = 0; j < kernel_entries; j++)
-    {
-      for (long i = 0; i < kernel_entries; i++)
-      {
-        kernTab[i + kernel_entries * (j + k * kernel_entries)] =
-            kernTab[j] * kernTab[i] * kernTab[k];
-      }
-    }
+  SeparableKernelTask task(kernTab, kernel_entries);
+  gpuNUFFT::hostParallelFor(kernel_entries * kernel_entries - 1, task);
 }  // end load3DKernel()
 
@@ -0,0 +1,274 @@
+#include "host_cg_sense_solver.hpp"
+#include "host_parallel.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace
+{
+// r = y, p = y, x = 0, returns |r|^2
+class HostCGInitTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostCGInitTask(const CufftType *y, CufftType *x, CufftType *r, CufftType *p,
+                 double *partialSums)
+    : y(y), x(x), r(r), p(p), partialSums(partialSums)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    double sum = 0.0;
+    for (IndType i = begin; i < end; i++)
+    {
+      r[i] = y[i];
+      p[i] = y[i];
+      x[i].x = (DType)0.0;
+      x[i].y = (DType)0.0;
+      sum += (double)y[i].x * y[i].x + (double)y[i].y * y[i].y;
+    }
+    partialSums[threadId] = sum;
+  }
+
+ private:
+  const CufftType *y;
+  CufftType *x, *r, *p;
+  double *partialSums;
+};
+
+// Ap += alpha p, returns Re(p^H Ap)
+class HostCGRegularizeTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostCGRegularizeTask(const CufftType *p, CufftType *Ap, DType alpha,
+                       double *partialSums)
+    : p(p), Ap(Ap), alpha(alpha), partialSums(partialSums)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    double sum = 0.0;
+    for (IndType i = begin; i < end; i++)
+    {
+      Ap[i].x += alpha * p[i].x;
+      Ap[i].y += alpha * p[i].y;
+      sum += (double)p[i].x * Ap[i].x + (double)p[i].y * Ap[i].y;
+    }
+    partialSums[threadId] = sum;
+  }
+
+ private:
+  const CufftType *p;
+  CufftType *Ap;
+  DType alpha;
+  double *partialSums;
+};
+
+// x += a p, r -= a Ap, returns |r|^2
+class HostCGStepTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostCGStepTask(CufftType *x, CufftType *r, const CufftType *p,
+                 const CufftType *Ap, DType a, double *partialSums)
+    : x(x), r(r), p(p), Ap(Ap), a(a), partialSums(partialSums)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    double sum = 0.0;
+    for (IndType i = begin; i < end; i++)
+    {
+      x[i].x += a * p[i].x;
+      x[i].y += a * p[i].y;
+      r[i].x -= a * Ap[i].x;
+      r[i].y -= a * Ap[i].y;
+      sum += (double)r[i].x * r[i].x + (double)r[i].y * r[i].y;
+    }
+    partialSums[threadId] = sum;
+  }
+
+ private:
+  CufftType *x, *r;
+  const CufftType *p, *Ap;
+  DType a;
+  double *partialSums;
+};
+
+// p = r + b p
+class HostCGDirectionTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostCGDirectionTask(const CufftType *r, CufftType *p, DType b)
+    : r(r), p(p), b(b)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType i = begin; i < end; i++)
+    {
+      p[i].x = r[i].x + b * p[i].x;
+      p[i].y = r[i].y + b * p[i].y;
+    }
+  }
+
+ private:
+  const CufftType *r;
+  CufftType *p;
+  DType b;
+};
+
+double sumPartials(const std::vector<double> &partialSums, int n_threads)
+{
+  double sum = 0.0;
+  for (int t = 0; t < n_threads; t++)
+    sum += partialSums[t];
+  return sum;
+}
+}
+
+gpuNUFFT::HostCGSenseSolver::HostCGSenseSolver(GpuNUFFTOperator *gpuNUFFTOp,
+                                               DType alpha, DType tolerance,
+                                               int maxIterations)
+  : gpuNUFFTOp(gpuNUFFTOp), alpha(alpha), tolerance(tolerance),
+    maxIterations(maxIterations), useToeplitz(false), toeplitzOp(NULL),
+    imgDims(gpuNUFFTOp->getImageDims()),
+    dataCount(gpuNUFFTOp->getDataIndices().count()), n_coils(1),
+    iterationCount(0), residualNorm(0.0), iterationsPerSecond(0.0)
+{
+  IndType imgCount = imgDims.count();
+  if (gpuNUFFTOp->applySensData())
+    n_coils = gpuNUFFTOp->getSens().count() / imgCount;
+
+  r.resize(imgCount);
+  p.resize(imgCount);
+  Ap.resize(imgCount);
+  kspace.resize(dataCount * n_coils);
+}
+
+gpuNUFFT::HostCGSenseSolver::~HostCGSenseSolver()
+{
+  delete toeplitzOp;
+}
+
+void gpuNUFFT::HostCGSenseSolver::setUseToeplitz(bool useToeplitz)
+{
+  this->useToeplitz = useToeplitz;
+  if (useToeplitz && toeplitzOp == NULL)
+    toeplitzOp = new HostToeplitzNormalOperator(gpuNUFFTOp);
+}
+
+void gpuNUFFT::HostCGSenseSolver::applyNormal(CufftType *pData,
+                                              CufftType *ApData)
+{
+  Array<DType2> pArray;
+  pArray.data = pData;
+  pArray.dim = imgDims;
+
+  Array<CufftType> ApArray;
+  ApArray.data = ApData;
+  ApArray.dim = imgDims;
+
+  if (useToeplitz)
+  {
+    toeplitzOp->apply(pArray, ApArray);
+    return;
+  }
+
+  Array<CufftType> kspaceArray;
+  kspaceArray.data = &kspace[0];
+  kspaceArray.dim.length = dataCount;
+  kspaceArray.dim.channels = n_coils;
+
+  gpuNUFFTOp->performForwardGpuNUFFT(pArray, kspaceArray);
+  gpuNUFFTOp->performGpuNUFFTAdj(kspaceArray, ApArray);
+}
+
+int gpuNUFFT::HostCGSenseSolver::solve(Array<DType2> kspaceData,
+                                       Array<CufftType> &imgData)
+{
+  IndType imgCount = imgDims.count();
+  if (kspaceData.data == NULL || imgData.data == NULL)
+    throw std::invalid_argument("CG SENSE: missing k-space or image data!");
+  if (kspaceData.count() != dataCount * n_coils)
+    throw std::invalid_argument(
+        "CG SENSE: k-space data does not match operator!");
+
+  int n_threads = getHostThreadCount();
+  if ((int)partialSums.size() < n_threads)
+    partialSums.resize(n_threads);
+
+  // right hand side A^H y, stored in Ap
+  Array<CufftType> rhsArray;
+  rhsArray.data = &Ap[0];
+  rhsArray.dim = imgDims;
+  gpuNUFFTOp->performGpuNUFFTAdj(kspaceData, rhsArray);
+
+  CufftType *x = imgData.data;
+  HostCGInitTask initTask(&Ap[0], x, &r[0], &p[0], &partialSums[0]);
+  hostParallelFor(imgCount, initTask, n_threads);
+  double rr = sumPartials(partialSums, n_threads);
+  double rr0 = rr;
+
+  iterationCount = 0;
+  residualNorm = rr0 > 0.0 ? 1.0 : 0.0;
+  iterationsPerSecond = 0.0;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  while (iterationCount < maxIterations && residualNorm > tolerance)
+  {
+    applyNormal(&p[0], &Ap[0]);
+
+    HostCGRegularizeTask regularizeTask(&p[0], &Ap[0], alpha,
+                                        &partialSums[0]);
+    hostParallelFor(imgCount, regularizeTask, n_threads);
+    double pAp = sumPartials(partialSums, n_threads);
+    if (pAp <= 0.0)
+      break;
+
+    HostCGStepTask stepTask(x, &r[0], &p[0], &Ap[0], (DType)(rr / pAp),
+                            &partialSums[0]);
+    hostParallelFor(imgCount, stepTask, n_threads);
+    double rrNew = sumPartials(partialSums, n_threads);
+
+    HostCGDirectionTask directionTask(&r[0], &p[0], (DType)(rrNew / rr));
+    hostParallelFor(imgCount, directionTask, n_threads);
+
+    rr = rrNew;
+    residualNorm = std::sqrt(rr / rr0);
+    iterationCount++;
+  }
+
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start).count();
+  if (iterationCount > 0 && elapsed > 0.0)
+    iterationsPerSecond = iterationCount / elapsed;
+
+  return iterationCount;
+}
+
+gpuNUFFT::Array<CufftType>
+gpuNUFFT::HostCGSenseSolver::solve(Array<DType2> kspaceData)
+{
+  Array<CufftType> imgData;
+  imgData.dim = imgDims;
+  imgData.data = (CufftType *)calloc(imgDims.count(), sizeof(CufftType));
+  if (imgData.data == NULL)
+    throw std::runtime_error("Allocation of CG SENSE output failed!");
+  try
+  {
+    solve(kspaceData, imgData);
+  }
+  catch (...)
+  {
+    free(imgData.data);
+    throw;
+  }
+  return imgData;
+}
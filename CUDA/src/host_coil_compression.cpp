@@ -0,0 +1,322 @@
+#include "host_coil_compression.hpp"
+#include "host_parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+/** \brief Amount of samples compressed at once by one thread */
+#define HOST_COIL_COMPRESSION_BLOCK 256
+
+namespace
+{
+// partial covariance sum_n conj(x_i(n)) x_j(n), upper triangle, per thread
+class HostCoilCovarianceTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostCoilCovarianceTask(const DType2 *data, IndType sampleCount,
+                         IndType n_coils, std::vector<double> &partialCov)
+    : data(data), sampleCount(sampleCount), n_coils(n_coils),
+      partialCov(partialCov)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    double *cov = &partialCov[(size_t)threadId * 2 * n_coils * n_coils];
+    for (IndType blockBegin = begin; blockBegin < end;
+         blockBegin += HOST_COIL_COMPRESSION_BLOCK)
+    {
+      IndType blockEnd =
+          std::min(blockBegin + HOST_COIL_COMPRESSION_BLOCK, end);
+      for (IndType i = 0; i < n_coils; i++)
+      {
+        const DType2 *xi = data + (size_t)i * sampleCount;
+        for (IndType j = i; j < n_coils; j++)
+        {
+          const DType2 *xj = data + (size_t)j * sampleCount;
+          double re = 0.0, im = 0.0;
+          for (IndType n = blockBegin; n < blockEnd; n++)
+          {
+            re += (double)xi[n].x * xj[n].x + (double)xi[n].y * xj[n].y;
+            im += (double)xi[n].x * xj[n].y - (double)xi[n].y * xj[n].x;
+          }
+          cov[2 * (i * n_coils + j)] += re;
+          cov[2 * (i * n_coils + j) + 1] += im;
+        }
+      }
+    }
+  }
+
+ private:
+  const DType2 *data;
+  IndType sampleCount;
+  IndType n_coils;
+  std::vector<double> &partialCov;
+};
+
+// y'_k = sum_c A_kc y_c in blocks of HOST_COIL_COMPRESSION_BLOCK samples, the
+// inner loop streams one channel of a block
+class HostCoilCompressTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostCoilCompressTask(const DType2 *data, DType2 *compressed,
+                       IndType sampleCount, IndType physicalCoils,
+                       IndType virtualCoils, const DType2 *matrix)
+    : data(data), compressed(compressed), sampleCount(sampleCount),
+      physicalCoils(physicalCoils), virtualCoils(virtualCoils), matrix(matrix)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    std::vector<DType2> acc(virtualCoils * HOST_COIL_COMPRESSION_BLOCK);
+    for (IndType blockBegin = begin; blockBegin < end;
+         blockBegin += HOST_COIL_COMPRESSION_BLOCK)
+    {
+      IndType blockCount =
+          std::min((IndType)HOST_COIL_COMPRESSION_BLOCK, end - blockBegin);
+      for (IndType i = 0; i < virtualCoils * HOST_COIL_COMPRESSION_BLOCK; i++)
+      {
+        acc[i].x = (DType)0.0;
+        acc[i].y = (DType)0.0;
+      }
+      for (IndType c = 0; c < physicalCoils; c++)
+      {
+        const DType2 *x = data + (size_t)c * sampleCount + blockBegin;
+        for (IndType k = 0; k < virtualCoils; k++)
+        {
+          DType2 a = matrix[k * physicalCoils + c];
+          DType2 *y = &acc[k * HOST_COIL_COMPRESSION_BLOCK];
+          for (IndType n = 0; n < blockCount; n++)
+          {
+            y[n].x += a.x * x[n].x - a.y * x[n].y;
+            y[n].y += a.x * x[n].y + a.y * x[n].x;
+          }
+        }
+      }
+      for (IndType k = 0; k < virtualCoils; k++)
+        std::copy(&acc[k * HOST_COIL_COMPRESSION_BLOCK],
+                  &acc[k * HOST_COIL_COMPRESSION_BLOCK] + blockCount,
+                  compressed + (size_t)k * sampleCount + blockBegin);
+    }
+  }
+
+ private:
+  const DType2 *data;
+  DType2 *compressed;
+  IndType sampleCount;
+  IndType physicalCoils;
+  IndType virtualCoils;
+  const DType2 *matrix;
+};
+
+// orders eigenvalue indices by descending eigenvalue
+struct DescendingEigenvalue
+{
+  DescendingEigenvalue(const std::vector<double> &ev) : ev(ev)
+  {
+  }
+
+  bool operator()(int a, int b) const
+  {
+    return ev[a] > ev[b];
+  }
+
+  const std::vector<double> &ev;
+};
+
+// Cyclic Jacobi eigenvalue algorithm for the symmetric n x n matrix m (row
+// major), which is overwritten. Eigenvalues are returned in ev, the
+// eigenvectors in the columns of v.
+void jacobiEigen(std::vector<double> &m, int n, std::vector<double> &ev,
+                 std::vector<double> &v)
+{
+  v.assign((size_t)n * n, 0.0);
+  for (int i = 0; i < n; i++)
+    v[i * n + i] = 1.0;
+
+  for (int sweep = 0; sweep < 100; sweep++)
+  {
+    double offDiagonal = 0.0, diagonal = 0.0;
+    for (int p = 0; p < n; p++)
+    {
+      diagonal += m[p * n + p] * m[p * n + p];
+      for (int q = p + 1; q < n; q++)
+        offDiagonal += m[p * n + q] * m[p * n + q];
+    }
+    if (offDiagonal <= 1e-24 * diagonal || offDiagonal == 0.0)
+      break;
+
+    for (int p = 0; p < n; p++)
+      for (int q = p + 1; q < n; q++)
+      {
+        double mpq = m[p * n + q];
+        if (mpq == 0.0)
+          continue;
+        double theta = (m[q * n + q] - m[p * n + p]) / (2.0 * mpq);
+        double t = (theta >= 0.0 ? 1.0 : -1.0) /
+                   (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+        double c = 1.0 / std::sqrt(t * t + 1.0);
+        double s = t * c;
+        for (int k = 0; k < n; k++)
+        {
+          double mkp = m[k * n + p], mkq = m[k * n + q];
+          m[k * n + p] = c * mkp - s * mkq;
+          m[k * n + q] = s * mkp + c * mkq;
+        }
+        for (int k = 0; k < n; k++)
+        {
+          double mpk = m[p * n + k], mqk = m[q * n + k];
+          m[p * n + k] = c * mpk - s * mqk;
+          m[q * n + k] = s * mpk + c * mqk;
+        }
+        for (int k = 0; k < n; k++)
+        {
+          double vkp = v[k * n + p], vkq = v[k * n + q];
+          v[k * n + p] = c * vkp - s * vkq;
+          v[k * n + q] = s * vkp + c * vkq;
+        }
+      }
+  }
+
+  ev.resize(n);
+  for (int i = 0; i < n; i++)
+    ev[i] = m[i * n + i];
+}
+}
+
+gpuNUFFT::HostCoilCompression::HostCoilCompression(Array<DType2> calibData,
+                                                   IndType virtualCoils)
+  : physicalCoils(calibData.dim.channels), virtualCoils(virtualCoils)
+{
+  if (virtualCoils < 1 || virtualCoils > physicalCoils)
+    throw std::invalid_argument(
+        "Virtual coil count has to be in [1, physical coil count]!");
+  IndType sampleCount = calibData.count() / physicalCoils;
+  if (calibData.data == NULL || sampleCount == 0)
+    throw std::invalid_argument("Coil compression requires calibration data!");
+
+  int C = (int)physicalCoils;
+  int n_threads = getHostThreadCount();
+  std::vector<double> partialCov((size_t)n_threads * 2 * C * C, 0.0);
+  HostCoilCovarianceTask covTask(calibData.data, sampleCount, physicalCoils,
+                                 partialCov);
+  hostParallelFor(sampleCount, covTask, n_threads);
+
+  // Hermitian covariance H = Re + i Im embedded as the real symmetric matrix
+  // [Re -Im; Im Re], each eigenvalue of H appears twice
+  int n = 2 * C;
+  std::vector<double> m((size_t)n * n, 0.0);
+  for (int i = 0; i < C; i++)
+    for (int j = i; j < C; j++)
+    {
+      double re = 0.0, im = 0.0;
+      for (int t = 0; t < n_threads; t++)
+      {
+        re += partialCov[(size_t)t * 2 * C * C + 2 * (i * C + j)];
+        im += partialCov[(size_t)t * 2 * C * C + 2 * (i * C + j) + 1];
+      }
+      m[i * n + j] = m[(i + C) * n + (j + C)] = re;
+      m[j * n + i] = m[(j + C) * n + (i + C)] = re;
+      m[(i + C) * n + j] = im;
+      m[(j + C) * n + i] = -im;
+      m[i * n + (j + C)] = -im;
+      m[j * n + (i + C)] = im;
+    }
+
+  std::vector<double> ev, v;
+  jacobiEigen(m, n, ev, v);
+
+  std::vector<int> order(n);
+  for (int i = 0; i < n; i++)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), DescendingEigenvalue(ev));
+
+  // Select C complex eigenvectors a + ib from the real eigenvectors [a; b],
+  // the second vector of each pair is i times the first and removed by the
+  // orthogonalization against the already selected ones.
+  std::vector<std::vector<double> > basis;
+  for (int e = 0; e < n && (int)basis.size() < C; e++)
+  {
+    std::vector<double> w(n);
+    for (int i = 0; i < n; i++)
+      w[i] = v[i * n + order[e]];
+    for (size_t b = 0; b < basis.size(); b++)
+    {
+      // w -= <u, w> u for the complex vectors u = basis[b] and w
+      double re = 0.0, im = 0.0;
+      for (int i = 0; i < C; i++)
+      {
+        re += basis[b][i] * w[i] + basis[b][i + C] * w[i + C];
+        im += basis[b][i] * w[i + C] - basis[b][i + C] * w[i];
+      }
+      for (int i = 0; i < C; i++)
+      {
+        double ur = basis[b][i], ui = basis[b][i + C];
+        w[i] -= re * ur - im * ui;
+        w[i + C] -= re * ui + im * ur;
+      }
+    }
+    double norm = 0.0;
+    for (int i = 0; i < n; i++)
+      norm += w[i] * w[i];
+    if (norm < 0.25)
+      continue;
+    norm = std::sqrt(norm);
+    for (int i = 0; i < n; i++)
+      w[i] /= norm;
+    basis.push_back(w);
+    singularValues.push_back(std::sqrt(std::max(ev[order[e]], 0.0)));
+  }
+
+  matrix.resize(virtualCoils * physicalCoils);
+  for (IndType k = 0; k < virtualCoils; k++)
+    for (int c = 0; c < C; c++)
+    {
+      matrix[k * physicalCoils + c].x = (DType)basis[k][c];
+      matrix[k * physicalCoils + c].y = (DType)basis[k][c + C];
+    }
+}
+
+double gpuNUFFT::HostCoilCompression::getRetainedEnergy()
+{
+  double kept = 0.0, total = 0.0;
+  for (size_t i = 0; i < singularValues.size(); i++)
+  {
+    double energy = singularValues[i] * singularValues[i];
+    total += energy;
+    if (i < virtualCoils)
+      kept += energy;
+  }
+  return total > 0.0 ? kept / total : 1.0;
+}
+
+void gpuNUFFT::HostCoilCompression::compress(Array<DType2> data,
+                                             Array<DType2> &compressed)
+{
+  if (data.dim.channels != physicalCoils ||
+      compressed.dim.channels != virtualCoils ||
+      data.count() / physicalCoils != compressed.count() / virtualCoils)
+    throw std::invalid_argument(
+        "Channel counts do not match the coil compression!");
+
+  IndType sampleCount = data.count() / physicalCoils;
+  HostCoilCompressTask task(data.data, compressed.data, sampleCount,
+                            physicalCoils, virtualCoils, &matrix[0]);
+  hostParallelFor(sampleCount, task);
+}
+
+gpuNUFFT::Array<DType2>
+gpuNUFFT::HostCoilCompression::compress(Array<DType2> data)
+{
+  Array<DType2> compressed;
+  compressed.dim = data.dim;
+  compressed.dim.channels = virtualCoils;
+  compressed.data = (DType2 *)malloc(compressed.count() * sizeof(DType2));
+  if (compressed.data == NULL)
+    throw std::runtime_error("Allocation of compressed coil data failed!");
+  compress(data, compressed);
+  return compressed;
+}
@@ -0,0 +1,1338 @@
+#include "host_gpuNUFFT_operator.hpp"
+#include "host_gpuNUFFT_kernels.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+gpuNUFFT::HostGpuNUFFTWorkspace *
+gpuNUFFT::HostGpuNUFFTOperator::createWorkspace(int coilBatchSize)
+{
+  if (coilBatchSize < 1)
+    throw std::invalid_argument("Coil batch size must be at least 1!");
+
+  GpuNUFFTInfo *gi_host = initGpuNUFFTInfo(coilBatchSize);
+  gi_host->sectorsToProcess = gi_host->sector_count;
+  gi_host->interpolationType =
+      linearInterpolation ? TEXTURE_LOOKUP : CONST_LOOKUP;
+  if (axisKernels[0] != NULL)
+  {
+    // the offsets describe the layout of the derivative tables
+    for (int d = 0; d < 3; d++)
+      gi_host->kernel_table_axis[d] = axisKernels[d];
+    gi_host->kernel_offset_axis.x = 0;
+    gi_host->kernel_offset_axis.y = axisKernelCounts[0];
+    gi_host->kernel_offset_axis.z = axisKernelCounts[0] + axisKernelCounts[1];
+    gi_host->kernel_count_axis.x = axisKernelCounts[0];
+    gi_host->kernel_count_axis.y = axisKernelCounts[1];
+    gi_host->kernel_count_axis.z = axisKernelCounts[2];
+    gi_host->dist_multiplier_axis.x =
+        (DType)(axisKernelCounts[0] - 1) / gi_host->radiusSquared_axis.x;
+    gi_host->dist_multiplier_axis.y =
+        (DType)(axisKernelCounts[1] - 1) / gi_host->radiusSquared_axis.y;
+    gi_host->dist_multiplier_axis.z =
+        (DType)(axisKernelCounts[2] - 1) / gi_host->radiusSquared_axis.z;
+  }
+  // the grids hold the planes of setGridPlanes only
+  gi_host->grid_plane_offset = (int)gridPlaneOffset;
+  gi_host->gridDims_count = getConvolutionGridDims().count();
+  gi_host->grid_width_dim = (int)gi_host->gridDims_count;
+
+  HostGpuNUFFTWorkspace *ws =
+      new HostGpuNUFFTWorkspace(gi_host, getGridDims(), coilBatchSize);
+  // the FFTs skip the lines outside of the image region
+  ws->fftPlan.setPruningRegion(computeHostShiftedImageOffset(gi_host),
+                               computeHostAdjointImageOffset(gi_host),
+                               this->imgDims);
+  profileAllocation(profiler, ws->getAllocatedBytes());
+  return ws;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::setLinearKernelInterpolation(
+    bool linearInterpolation)
+{
+  this->linearInterpolation = linearInterpolation;
+  if (this->kernel.data != NULL)
+    initKernel();
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::setGridPlanes(IndType offset,
+                                                   IndType count)
+{
+  Dimensions gridDims = getGridDims();
+  IndType planes = is3DProcessing() ? gridDims.depth : gridDims.height;
+  if (count == 0 || count > planes || offset >= planes)
+    throw std::invalid_argument("Grid planes exceed the grid!");
+  gridPlaneOffset = offset;
+  gridPlaneCount = count;
+  delete workspace;
+  workspace = NULL;
+}
+
+gpuNUFFT::Dimensions gpuNUFFT::HostGpuNUFFTOperator::getConvolutionGridDims()
+{
+  Dimensions gridDims = getGridDims();
+  if (gridPlaneCount == 0)
+    return gridDims;
+  if (is3DProcessing())
+    gridDims.depth = gridPlaneCount;
+  else
+    gridDims.height = gridPlaneCount;
+  return gridDims;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::setShardProcessCount(int shardProcesses)
+{
+  if (shardProcesses < 1 || shardProcesses > HOST_SHARD_MAX_PROCESSES)
+    throw std::invalid_argument("Invalid amount of shard processes!");
+  this->shardProcesses = shardProcesses;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::setKernelWidths(Dimensions kernelWidths)
+{
+  Dimensions widths = getKernelWidths();
+  if (kernelWidths.width > 0)
+    widths.width = kernelWidths.width;
+  if (kernelWidths.height > 0)
+    widths.height = kernelWidths.height;
+  if (kernelWidths.depth > 0 && imgDims.depth > 0)
+    widths.depth = kernelWidths.depth;
+
+  // the sector padding of each dimension covers one kernel radius
+  IndType maxWidth = std::max(std::max(widths.width, widths.height),
+                              widths.depth);
+  if (maxWidth > 2 * sectorWidth)
+    throw std::invalid_argument(
+        "Kernel width must not exceed twice the sector width!");
+
+  this->kernelWidths = widths;
+  this->kernelWidth = maxWidth;
+  if (this->kernel.data != NULL)
+    initKernel();
+}
+
+IndType gpuNUFFT::HostGpuNUFFTOperator::getKernelLookupTableSize(
+    IndType kernelWidth)
+{
+  if (lookupTableSize > 0)
+    return lookupTableSize;
+  if (linearInterpolation)
+    return (IndType)calculateKernelSizeLinInt(osf, kernelWidth);
+  return (IndType)calculateGrid3KernelSize(osf, kernelWidth);
+}
+
+IndType gpuNUFFT::HostGpuNUFFTOperator::getDefaultKernelLookupTableSize()
+{
+  if (linearInterpolation)
+    return (IndType)calculateKernelSizeLinInt(osf, kernelWidth);
+  return GpuNUFFTOperator::getDefaultKernelLookupTableSize();
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::initKernel()
+{
+  GpuNUFFTOperator::initKernel();
+
+  releaseAxisKernels();
+  free(kernelDerivative);
+  kernelDerivative = NULL;
+  Dimensions widths = getKernelWidths();
+  IndType axisWidths[3] = { widths.width, widths.height,
+                            widths.depth > 0 ? widths.depth : kernelWidth };
+  if (axisWidths[0] != kernelWidth || axisWidths[1] != kernelWidth ||
+      axisWidths[2] != kernelWidth)
+  {
+    for (int d = 0; d < 3; d++)
+    {
+      axisKernelCounts[d] = getKernelLookupTableSize(axisWidths[d]);
+      axisKernels[d] = KernelLookupTableCache::acquire(
+          axisWidths[d], osf, axisKernelCounts[d], 1, kernelType);
+    }
+  }
+
+  delete workspace;
+  workspace = NULL;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::releaseAxisKernels()
+{
+  for (int d = 0; d < 3; d++)
+  {
+    KernelLookupTableCache::release(axisKernels[d]);
+    axisKernels[d] = NULL;
+  }
+}
+
+DType *gpuNUFFT::HostGpuNUFFTOperator::getConvolutionKernelDerivative()
+{
+  if (kernelDerivative != NULL)
+    return kernelDerivative;
+
+  Dimensions widths = getKernelWidths();
+  IndType axisWidths[3] = { widths.width, widths.height,
+                            widths.depth > 0 ? widths.depth : kernelWidth };
+  IndType counts[3] = { this->kernel.count(), 0, 0 };
+  int tables = 1;
+  if (axisKernels[0] != NULL)
+  {
+    tables = 3;
+    for (int d = 0; d < 3; d++)
+      counts[d] = axisKernelCounts[d];
+  }
+  else
+  {
+    axisWidths[0] = kernelWidth;
+  }
+
+  kernelDerivative =
+      (DType *)malloc((counts[0] + counts[1] + counts[2]) * sizeof(DType));
+  if (kernelDerivative == NULL)
+    throw std::runtime_error("Allocation of kernel derivative tables failed!");
+  DType *table = kernelDerivative;
+  for (int d = 0; d < tables; d++)
+  {
+    load1DKernelDerivative(table, counts[d], (int)axisWidths[d], osf,
+                           kernelType);
+    table += counts[d];
+  }
+  return kernelDerivative;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::setCoilBatchSize(int coilBatchSize)
+{
+  if (coilBatchSize < 1)
+    throw std::invalid_argument("Coil batch size must be at least 1!");
+  this->coilBatchSize = coilBatchSize;
+}
+
+gpuNUFFT::HostGpuNUFFTWorkspace &
+gpuNUFFT::HostGpuNUFFTOperator::getWorkspace()
+{
+  if (workspace != NULL &&
+      (workspace->getCoilBatchSize() != coilBatchSize ||
+       workspace->gi_host->data_count != (int)this->kSpaceTraj.count()))
+  {
+    delete workspace;
+    workspace = NULL;
+  }
+  if (workspace == NULL)
+    workspace = createWorkspace(coilBatchSize);
+  return *workspace;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::validateWorkspace(
+    HostGpuNUFFTWorkspace &ws)
+{
+  if (ws.gi_host->data_count != (int)this->kSpaceTraj.count() ||
+      ws.gi_host->gridDims_count != getConvolutionGridDims().count() ||
+      ws.gi_host->grid_plane_offset != (int)gridPlaneOffset ||
+      ws.gi_host->imgDims_count != this->imgDims.count() ||
+      ws.gi_host->kernel_count != (int)this->kernel.count() ||
+      ws.gi_host->kernel_width_axis.x != getKernelWidths().width ||
+      ws.gi_host->kernel_width_axis.y != getKernelWidths().height ||
+      ws.gi_host->kernel_width_axis.z !=
+          DEFAULT_VALUE(getKernelWidths().depth) ||
+      ws.gi_host->interpolationType !=
+          (linearInterpolation ? TEXTURE_LOOKUP : CONST_LOOKUP))
+    throw std::invalid_argument(
+        "Workspace does not match gridding problem of operator!");
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::validateFullGrid()
+{
+  if (gridPlaneCount > 0)
+    throw std::invalid_argument(
+        "Operator grids hold part of the grid planes only!");
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::validateAdjointOutput(
+    IndType n_coils, GpuNUFFTOutput gpuNUFFTOut, Array<CufftType> &imgData)
+{
+  // same layout as initAdjointOutput
+  IndType count = gpuNUFFTOut == CONVOLUTION
+                      ? getConvolutionGridDims().count() * n_coils
+                      : this->imgDims.count() *
+                            (this->applySensData() ? 1 : n_coils);
+  if (imgData.data == NULL || imgData.count() != count)
+    throw std::invalid_argument(
+        "Output array does not match the adjoint operation!");
+}
+
+gpuNUFFT::Array<CufftType> gpuNUFFT::HostGpuNUFFTOperator::initAdjointOutput(
+    IndType n_coils, GpuNUFFTOutput gpuNUFFTOut)
+{
+  gpuNUFFT::Array<CufftType> imgData;
+
+  if (gpuNUFFTOut == gpuNUFFT::CONVOLUTION)
+  {
+    imgData.dim = getConvolutionGridDims();
+    imgData.dim.channels = n_coils;
+  }
+  else
+  {
+    imgData.dim = this->getImageDims();
+    // if sens data is present a summation over all coils is performed
+    // automatically
+    imgData.dim.channels = this->applySensData() ? 1 : n_coils;
+  }
+  imgData.data = (CufftType *)calloc(imgData.count(), sizeof(CufftType));
+  profileAllocation(profiler, imgData.count() * sizeof(CufftType));
+  return imgData;
+}
+
+gpuNUFFT::HostGpuNUFFTOperator::SampleSelection
+gpuNUFFT::HostGpuNUFFTOperator::selectAllSamples()
+{
+  SampleSelection samples;
+  samples.crds = this->kSpaceTraj.data;
+  samples.dens = this->dens.data;
+  samples.sectors = this->sectorDataCount.data;
+  samples.sectorCenters = this->sectorCenters.data;
+  samples.indices = this->dataIndices.data;
+  samples.data_count = (int)this->kSpaceTraj.count();
+  samples.sector_count = (int)this->gridSectorDims.count();
+  return samples;
+}
+
+namespace
+{
+// orders subset entries by the sorted position of their sample
+struct SortedPositionLess
+{
+  SortedPositionLess(const IndType *sampleIndices,
+                     const std::vector<IndType> &sortedPositions)
+    : sampleIndices(sampleIndices), sortedPositions(sortedPositions)
+  {
+  }
+
+  bool operator()(IndType a, IndType b) const
+  {
+    return sortedPositions[sampleIndices[a]] <
+           sortedPositions[sampleIndices[b]];
+  }
+
+  const IndType *sampleIndices;
+  const std::vector<IndType> &sortedPositions;
+};
+}
+
+gpuNUFFT::HostGpuNUFFTOperator::SampleSelection
+gpuNUFFT::HostGpuNUFFTOperator::selectSamples(Array<IndType> sampleIndices,
+                                              HostGpuNUFFTWorkspace &ws)
+{
+  IndType data_count = this->kSpaceTraj.count();
+  IndType subset_count = sampleIndices.count();
+  if (sampleIndices.data == NULL || subset_count == 0)
+    throw std::invalid_argument("Sample subset is empty!");
+  for (IndType j = 0; j < subset_count; j++)
+    if (sampleIndices.data[j] >= data_count ||
+        (j > 0 && sampleIndices.data[j] <= sampleIndices.data[j - 1]))
+      throw std::invalid_argument(
+          "Sample indices have to be strictly ascending trajectory indices!");
+
+  if (ws.sortedPositions.size() != data_count)
+  {
+    ws.sortedPositions.resize(data_count);
+    for (IndType t = 0; t < data_count; t++)
+      ws.sortedPositions[this->dataIndices.data[t]] = t;
+  }
+
+  // subset entries in sorted, i.e. sector, order
+  ws.subsetIndices.resize(subset_count);
+  for (IndType j = 0; j < subset_count; j++)
+    ws.subsetIndices[j] = j;
+  std::sort(ws.subsetIndices.begin(), ws.subsetIndices.end(),
+            SortedPositionLess(sampleIndices.data, ws.sortedPositions));
+
+  int dim_count = (int)getImageDimensionCount();
+  bool dens = this->applyDensComp();
+  ws.subsetCrds.resize(subset_count * dim_count);
+  ws.subsetDens.resize(dens ? subset_count : 0);
+  ws.subsetSectors.assign(1, 0);
+  ws.subsetSectorCenters.clear();
+
+  // sector ranges of the sectors holding subset samples, the sorted positions
+  // are ascending, thus the sector search continues at the current sector
+  IndType *sectors = this->sectorDataCount.data;
+  IndType *sectorsEnd = sectors + ws.gi_host->sector_count + 1;
+  IndType *sector = sectors;
+  for (IndType s = 0; s < subset_count; s++)
+  {
+    IndType t = ws.sortedPositions[sampleIndices.data[ws.subsetIndices[s]]];
+    if (s == 0 || t >= *(sector + 1))
+    {
+      sector = std::upper_bound(sector, sectorsEnd, t) - 1;
+      if (s > 0)
+        ws.subsetSectors.push_back(s);
+      IndType sec = (IndType)(sector - sectors);
+      for (int d = 0; d < dim_count; d++)
+        ws.subsetSectorCenters.push_back(
+            this->sectorCenters.data[sec * dim_count + d]);
+    }
+    for (int d = 0; d < dim_count; d++)
+      ws.subsetCrds[s + d * subset_count] =
+          this->kSpaceTraj.data[t + d * data_count];
+    if (dens)
+      ws.subsetDens[s] = this->dens.data[t];
+  }
+  ws.subsetSectors.push_back(subset_count);
+
+  SampleSelection samples;
+  samples.crds = &ws.subsetCrds[0];
+  samples.dens = dens ? &ws.subsetDens[0] : NULL;
+  samples.sectors = &ws.subsetSectors[0];
+  samples.sectorCenters = &ws.subsetSectorCenters[0];
+  samples.indices = &ws.subsetIndices[0];
+  samples.data_count = (int)subset_count;
+  samples.sector_count = (int)ws.subsetSectors.size() - 1;
+  return samples;
+}
+
+gpuNUFFT::GpuNUFFTInfo
+gpuNUFFT::HostGpuNUFFTOperator::getSelectionInfo(const SampleSelection &samples,
+                                                 HostGpuNUFFTWorkspace &ws)
+{
+  GpuNUFFTInfo gi_host = *ws.gi_host;
+  gi_host.data_count = samples.data_count;
+  gi_host.sector_count = samples.sector_count;
+  gi_host.sectorsToProcess = samples.sector_count;
+  return gi_host;
+}
+
+namespace
+{
+// convolution of the sector range of one shard
+class ShardConvolutionTask : public gpuNUFFT::HostShardTask
+{
+ public:
+  ShardConvolutionTask(DType2 *data, DType *crds, DType *kernelData,
+                       IndType *sectors, IndType *sectorCenters,
+                       gpuNUFFT::GpuNUFFTInfo *gi_host, bool gather,
+                       const std::vector<IndType> &shardSectors,
+                       const std::vector<IndType> &tileOffsets,
+                       const std::vector<IndType> &tileSectors)
+    : data(data), crds(crds), kernelData(kernelData), sectors(sectors),
+      sectorCenters(sectorCenters), gi_host(gi_host), gather(gather),
+      shardSectors(shardSectors),
+      tileOffsets(tileOffsets), tileSectors(tileSectors)
+  {
+  }
+
+  void grid(int shard, CufftType *slab)
+  {
+    IndType first = shardSectors[shard];
+    IndType last = shardSectors[shard + 1];
+    if (first == last)
+      return;
+
+    // the tiles of all sectors are restricted to the shard
+    if (gather)
+    {
+      performHostGatherConvolution(data, crds, slab, kernelData, sectors,
+                                   sectorCenters, gi_host, tileOffsets,
+                                   tileSectors, first, last);
+      return;
+    }
+
+    // the sample arrays keep their strides, only the sectors are restricted
+    int dim_count = gi_host->is2Dprocessing ? 2 : 3;
+    gpuNUFFT::GpuNUFFTInfo gi_shard = *gi_host;
+    gi_shard.sector_count = (int)(last - first);
+    gi_shard.sectorsToProcess = gi_shard.sector_count;
+    performHostConvolution(data, crds, slab, kernelData, sectors + first,
+                           sectorCenters + first * dim_count, &gi_shard);
+  }
+
+ private:
+  DType2 *data;
+  DType *crds;
+  DType *kernelData;
+  IndType *sectors;
+  IndType *sectorCenters;
+  gpuNUFFT::GpuNUFFTInfo *gi_host;
+  bool gather;
+  const std::vector<IndType> &shardSectors;
+  const std::vector<IndType> &tileOffsets;
+  const std::vector<IndType> &tileSectors;
+};
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::updateGatherTiles(
+    const SampleSelection &samples, GpuNUFFTInfo *gi_host,
+    HostGpuNUFFTWorkspace &ws)
+{
+  // the tiles of all samples depend on the trajectory only, those of a
+  // subset are built per operation
+  const IndType *key = samples.sectors == this->sectorDataCount.data
+                           ? this->sectorDataCount.data
+                           : NULL;
+  if (key != NULL && key == ws.gatherTileKey)
+    return;
+  buildHostGatherTiles(getConvolutionKernel(), samples.sectors,
+                       samples.sectorCenters, gi_host, ws.gatherTileOffsets,
+                       ws.gatherTileSectors);
+  ws.gatherTileKey = key;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::shardConvolution(
+    DType2 *data_sorted, const SampleSelection &samples, GpuNUFFTInfo *gi_host,
+    HostGpuNUFFTWorkspace &ws)
+{
+  // contiguous sector ranges of about data_count / shardProcesses samples
+  IndType *sectors = samples.sectors;
+  IndType *sectorsEnd = sectors + samples.sector_count + 1;
+  ws.shardSectors.resize(shardProcesses + 1);
+  ws.shardSectors[0] = 0;
+  for (int p = 1; p < shardProcesses; p++)
+  {
+    IndType target =
+        (IndType)((unsigned long long)samples.data_count * p / shardProcesses);
+    ws.shardSectors[p] =
+        (IndType)(std::lower_bound(sectors, sectorsEnd, target) - sectors);
+    ws.shardSectors[p] =
+        std::min(ws.shardSectors[p], (IndType)samples.sector_count);
+  }
+  ws.shardSectors[shardProcesses] = samples.sector_count;
+  if (gatherConvolution)
+    updateGatherTiles(samples, gi_host, ws);
+
+  ShardConvolutionTask task(data_sorted, samples.crds, getConvolutionKernel(),
+                            samples.sectors, samples.sectorCenters, gi_host,
+                            gatherConvolution, ws.shardSectors,
+                            ws.gatherTileOffsets, ws.gatherTileSectors);
+  hostShardedGridding(shardProcesses, task, ws.gdata,
+                      (IndType)gi_host->grid_width_dim * gi_host->n_coils_cc,
+                      ws.shardSlabs);
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::gridCoils(DType2 *kspaceCoils,
+                                               const SampleSelection &samples,
+                                               HostGpuNUFFTWorkspace &ws)
+{
+  GpuNUFFTInfo gi_host = getSelectionInfo(samples, ws);
+  int n_coils_cc = gi_host.n_coils_cc;
+
+  // profiling counters of this coil batch
+  unsigned long long sampleCount =
+      (unsigned long long)samples.data_count * n_coils_cc;
+  unsigned long long sampleBytes = sampleCount * sizeof(DType2);
+  unsigned long long gridBytes = (unsigned long long)gi_host.grid_width_dim *
+                                 n_coils_cc * sizeof(CufftType);
+
+  {
+    ProfileScope scope(profiler, PROFILE_SORT, sampleCount,
+                       2 * sampleBytes + samples.data_count * sizeof(IndType));
+    selectOrderedHost(kspaceCoils, samples.indices, ws.data_sorted,
+                      samples.data_count, n_coils_cc);
+  }
+
+  if (this->applyDensComp())
+  {
+    ProfileScope scope(profiler, PROFILE_DENSITY_COMPENSATION, sampleCount,
+                       2 * sampleBytes + samples.data_count * sizeof(DType));
+    performHostDensityCompensation(ws.data_sorted, samples.dens, &gi_host);
+  }
+
+  {
+    ProfileScope scope(profiler, PROFILE_CONVOLUTION, sampleCount,
+                       sampleBytes + 3 * gridBytes +
+                           samples.data_count * getImageDimensionCount() *
+                               sizeof(DType));
+    memset(ws.gdata, 0,
+           sizeof(CufftType) * gi_host.grid_width_dim * n_coils_cc);
+    if (shardProcesses > 1)
+      shardConvolution(ws.data_sorted, samples, &gi_host, ws);
+    else if (gatherConvolution)
+    {
+      updateGatherTiles(samples, &gi_host, ws);
+      performHostGatherConvolution(ws.data_sorted, samples.crds, ws.gdata,
+                                   getConvolutionKernel(), samples.sectors,
+                                   samples.sectorCenters, &gi_host,
+                                   ws.gatherTileOffsets, ws.gatherTileSectors,
+                                   0, samples.sector_count);
+    }
+    else
+      performHostConvolution(ws.data_sorted, samples.crds, ws.gdata,
+                             getConvolutionKernel(), samples.sectors,
+                             samples.sectorCenters, &gi_host);
+  }
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::adjointCoils(
+    DType2 *kspaceCoils, int coil_it, Array<CufftType> &imgData,
+    GpuNUFFTOutput gpuNUFFTOut, const SampleSelection &samples,
+    HostGpuNUFFTWorkspace &ws)
+{
+  GpuNUFFTInfo *gi_host = ws.gi_host;
+  int n_coils_cc = gi_host->n_coils_cc;
+
+  gridCoils(kspaceCoils, samples, ws);
+
+  if (gpuNUFFTOut == CONVOLUTION)
+  {
+    memcpy(imgData.data + (size_t)coil_it * gi_host->grid_width_dim, ws.gdata,
+           sizeof(CufftType) * gi_host->grid_width_dim * n_coils_cc);
+    return;
+  }
+
+  gridToImage(coil_it, imgData, gpuNUFFTOut,
+              (unsigned long long)samples.data_count * n_coils_cc, ws);
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::gridToImage(
+    int coil_it, Array<CufftType> &imgData, GpuNUFFTOutput gpuNUFFTOut,
+    unsigned long long sampleCount, HostGpuNUFFTWorkspace &ws)
+{
+  validateFullGrid();
+  GpuNUFFTInfo *gi_host = ws.gi_host;
+  int n_coils_cc = gi_host->n_coils_cc;
+  IndType imdata_count = this->imgDims.count();
+
+  // profiling counters of this coil batch
+  unsigned long long gridBytes = (unsigned long long)gi_host->grid_width_dim *
+                                 n_coils_cc * sizeof(CufftType);
+  unsigned long long imgBytes =
+      (unsigned long long)imdata_count * n_coils_cc * sizeof(CufftType);
+
+  // even grids fold the FFT shifts into the single pass of
+  // performHostFusedCrop
+  bool fused = isHostFusedImagePassSupported(gi_host);
+  {
+    ProfileScope scope(profiler, PROFILE_FFT, sampleCount,
+                       (fused ? 2 : 6) * gridBytes);
+    if (!fused)
+      performHostFFTShift(ws.gdata, INVERSE, getGridDims(), gi_host);
+    ws.fftPlan.execute(ws.gdata, n_coils_cc, HOST_FFT_INVERSE,
+                       HOST_FFT_PRUNE_OUTPUT);
+    if (!fused)
+      performHostFFTShift(ws.gdata, INVERSE, getGridDims(), gi_host);
+  }
+
+  if (fused)
+  {
+    bool deapodize = gpuNUFFTOut != FFT;
+    bool combine = deapodize && this->applySensData();
+    ProfileScope scope(profiler, PROFILE_FUSED_IMAGE, sampleCount,
+                       (combine ? 5 : 2) * imgBytes +
+                           (deapodize ? imdata_count * sizeof(DType) : 0));
+    performHostFusedCrop(
+        ws.gdata, imgData.data + coil_it * imdata_count,
+        deapodize ? this->deapo.data : NULL,
+        combine ? this->sens.data + coil_it * imdata_count : NULL,
+        ws.imdata_sum, gi_host);
+    return;
+  }
+
+  {
+    ProfileScope scope(profiler, PROFILE_CROP, sampleCount, 4 * imgBytes);
+    performHostCrop(ws.gdata, ws.imdata, gi_host);
+    performHostFFTScaling(ws.imdata, gi_host->im_width_dim, gi_host);
+  }
+
+  if (gpuNUFFTOut == FFT)
+  {
+    memcpy(imgData.data + coil_it * imdata_count, ws.imdata,
+           sizeof(CufftType) * imdata_count * n_coils_cc);
+    return;
+  }
+
+  {
+    ProfileScope scope(profiler, PROFILE_DEAPODIZATION, sampleCount,
+                       2 * imgBytes + imdata_count * sizeof(DType));
+    performHostDeapodization(ws.imdata, this->deapo.data, gi_host);
+  }
+
+  if (this->applySensData())
+  {
+    ProfileScope scope(profiler, PROFILE_SENSITIVITY, sampleCount,
+                       5 * imgBytes);
+    performHostSensMul(ws.imdata, this->sens.data + coil_it * imdata_count,
+                       gi_host, true);
+    performHostSensSum(ws.imdata, ws.imdata_sum, gi_host);
+  }
+  else
+  {
+    // no summation is performed in absence of sensitity data
+    memcpy(imgData.data + coil_it * imdata_count, ws.imdata,
+           sizeof(CufftType) * imdata_count * n_coils_cc);
+  }
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::setCoilCompression(
+    HostCoilCompression *compression)
+{
+  // sensitivities set before a previous compression
+  Array<DType2> sensData = virtualSens.data != NULL ? physicalSens : this->sens;
+  bool hasSens = sensData.data != NULL && sensData.count() > 1;
+  if (compression != NULL && hasSens &&
+      sensData.dim.channels != compression->getPhysicalCoils())
+    throw std::invalid_argument(
+        "Sensitivity channels do not match the coil compression!");
+
+  this->sens = sensData;
+  free(virtualSens.data);
+  virtualSens.data = NULL;
+
+  coilCompression = compression;
+  if (compression == NULL || !hasSens)
+    return;
+
+  physicalSens = sensData;
+  virtualSens = compression->compress(physicalSens);
+  this->sens = virtualSens;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::validateCoilCount(IndType n_coils)
+{
+  if (coilCompression != NULL && n_coils != coilCompression->getVirtualCoils())
+    throw std::invalid_argument(
+        "Data has to be compressed to the virtual coils of the coil "
+        "compression!");
+}
+
+gpuNUFFT::Array<DType2>
+gpuNUFFT::HostGpuNUFFTOperator::compressCoils(Array<DType2> kspaceData)
+{
+  if (coilCompression == NULL ||
+      kspaceData.dim.channels != coilCompression->getPhysicalCoils())
+    return kspaceData;
+
+  Array<DType2> compressed;
+  compressed.dim = kspaceData.dim;
+  compressed.dim.channels = coilCompression->getVirtualCoils();
+  if (compressedDataCount != compressed.count())
+  {
+    free(compressedData);
+    compressedData = (DType2 *)malloc(compressed.count() * sizeof(DType2));
+    compressedDataCount = compressedData != NULL ? compressed.count() : 0;
+    if (compressedData == NULL)
+      throw std::runtime_error("Allocation of compressed k-space data failed!");
+  }
+  compressed.data = compressedData;
+  coilCompression->compress(kspaceData, compressed);
+  return compressed;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdj(
+    gpuNUFFT::Array<DType2> kspaceData, gpuNUFFT::Array<CufftType> &imgData,
+    GpuNUFFTOutput gpuNUFFTOut)
+{
+  performGpuNUFFTAdj(compressCoils(kspaceData), imgData, getWorkspace(),
+                     gpuNUFFTOut);
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdj(
+    gpuNUFFT::Array<DType2> kspaceData, gpuNUFFT::Array<CufftType> &imgData,
+    HostGpuNUFFTWorkspace &ws, GpuNUFFTOutput gpuNUFFTOut)
+{
+  if (DEBUG)
+  {
+    std::cout << "performing host gpuNUFFT adjoint!!!" << std::endl;
+    std::cout << "dataCount: " << kSpaceTraj.count()
+              << " chnCount: " << kspaceData.dim.channels << std::endl;
+  }
+  validateWorkspace(ws);
+  validateCoilCount(kspaceData.dim.channels);
+  validateAdjointOutput(kspaceData.dim.channels, gpuNUFFTOut, imgData);
+
+  int data_count = (int)this->kSpaceTraj.count();
+  int n_coils = (int)kspaceData.dim.channels;
+  IndType imdata_count = this->imgDims.count();
+
+  if (this->applySensData())
+    memset(ws.imdata_sum, 0, imdata_count * sizeof(CufftType));
+
+  // iterate over coil batches and compute result
+  SampleSelection samples = selectAllSamples();
+  for (int coil_it = 0; coil_it < n_coils; coil_it += ws.getCoilBatchSize())
+  {
+    ws.setConcurrentCoilCount(
+        std::min(ws.getCoilBatchSize(), n_coils - coil_it));
+    adjointCoils(kspaceData.data + (size_t)coil_it * data_count, coil_it,
+                 imgData, gpuNUFFTOut, samples, ws);
+  }
+
+  if (this->applySensData() && gpuNUFFTOut == DEAPODIZATION)
+    memcpy(imgData.data, ws.imdata_sum, imdata_count * sizeof(CufftType));
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdj(
+    gpuNUFFT::MappedInputSource &input, gpuNUFFT::Array<CufftType> &imgData,
+    GpuNUFFTOutput gpuNUFFTOut)
+{
+  if (input.getSampleCount() != this->kSpaceTraj.count())
+    throw std::invalid_argument(
+        "Sample count of mapped input does not match operator!");
+  validateCoilCount(input.getCoilCount());
+  validateAdjointOutput(input.getCoilCount(), gpuNUFFTOut, imgData);
+
+  HostGpuNUFFTWorkspace &ws = getWorkspace();
+  int n_coils = (int)input.getCoilCount();
+  int batch = ws.getCoilBatchSize();
+  IndType imdata_count = this->imgDims.count();
+
+  if (this->applySensData())
+    memset(ws.imdata_sum, 0, imdata_count * sizeof(CufftType));
+
+  SampleSelection samples = selectAllSamples();
+  input.prefetchCoils(0, batch);
+  for (int coil_it = 0; coil_it < n_coils; coil_it += batch)
+  {
+    int n_coils_cc = std::min(batch, n_coils - coil_it);
+    // read ahead next coil batch while the current one is gridded
+    input.prefetchCoils(coil_it + n_coils_cc, batch);
+    ws.setConcurrentCoilCount(n_coils_cc);
+    adjointCoils(input.getCoilData(coil_it, n_coils_cc).data, coil_it,
+                 imgData, gpuNUFFTOut, samples, ws);
+    input.releaseCoils(coil_it, n_coils_cc);
+  }
+
+  if (this->applySensData() && gpuNUFFTOut == DEAPODIZATION)
+    memcpy(imgData.data, ws.imdata_sum, imdata_count * sizeof(CufftType));
+}
+
+gpuNUFFT::Array<CufftType> gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdj(
+    gpuNUFFT::MappedInputSource &input, GpuNUFFTOutput gpuNUFFTOut)
+{
+  gpuNUFFT::Array<CufftType> imgData =
+      initAdjointOutput(input.getCoilCount(), gpuNUFFTOut);
+  performGpuNUFFTAdj(input, imgData, gpuNUFFTOut);
+  return imgData;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdj(
+    gpuNUFFT::Array<DType2> kspaceData, gpuNUFFT::Array<CufftType> &roiData,
+    IndType3 roiOffset, Dimensions roiDims, HostGpuNUFFTWorkspace &ws)
+{
+  validateWorkspace(ws);
+  validateFullGrid();
+  validateCoilCount(kspaceData.dim.channels);
+
+  bool is2D = this->is2DProcessing();
+  roiDims.channels = 1;
+  roiDims.frames = 1;
+  if (is2D)
+    roiDims.depth = 0;
+  if (roiDims.width == 0 || roiDims.height == 0 ||
+      (!is2D && roiDims.depth == 0) ||
+      roiOffset.x + roiDims.width > this->imgDims.width ||
+      roiOffset.y + roiDims.height > this->imgDims.height ||
+      (is2D ? roiOffset.z > 0
+            : roiOffset.z + roiDims.depth > this->imgDims.depth))
+    throw std::invalid_argument("Region of interest exceeds the image!");
+
+  int data_count = (int)this->kSpaceTraj.count();
+  int n_coils = (int)kspaceData.dim.channels;
+  IndType roi_count = roiDims.count();
+  if (roiData.data == NULL ||
+      roiData.count() != roi_count * (this->applySensData() ? 1 : n_coils))
+    throw std::invalid_argument(
+        "Output array does not match the region of interest!");
+
+  if (this->applySensData())
+    memset(ws.imdata_sum, 0, roi_count * sizeof(CufftType));
+
+  // the FFTs skip the lines outside of the box instead of the image region,
+  // only the output side is pruned by the adjoint
+  GpuNUFFTInfo *gi_host = ws.gi_host;
+  IndType3 imageOffset = computeHostShiftedImageOffset(gi_host);
+  IndType3 adjointOffset = computeHostAdjointImageOffset(gi_host);
+  IndType3 regionOffset;
+  regionOffset.x = adjointOffset.x + roiOffset.x;
+  regionOffset.y = adjointOffset.y + roiOffset.y;
+  regionOffset.z = adjointOffset.z + roiOffset.z;
+  ws.fftPlan.setPruningRegion(regionOffset, roiDims);
+
+  // even grids fold the FFT shifts into performHostRegionCrop
+  bool fused = isHostFusedImagePassSupported(gi_host);
+  SampleSelection samples = selectAllSamples();
+  for (int coil_it = 0; coil_it < n_coils; coil_it += ws.getCoilBatchSize())
+  {
+    int n_coils_cc = std::min(ws.getCoilBatchSize(), n_coils - coil_it);
+    ws.setConcurrentCoilCount(n_coils_cc);
+    gridCoils(kspaceData.data + (size_t)coil_it * data_count, samples, ws);
+
+    unsigned long long sampleCount =
+        (unsigned long long)samples.data_count * n_coils_cc;
+    unsigned long long gridBytes =
+        (unsigned long long)gi_host->grid_width_dim * n_coils_cc *
+        sizeof(CufftType);
+    unsigned long long roiBytes =
+        (unsigned long long)roi_count * n_coils_cc * sizeof(CufftType);
+    {
+      ProfileScope scope(profiler, PROFILE_FFT, sampleCount,
+                         (fused ? 2 : 6) * gridBytes);
+      if (!fused)
+        performHostFFTShift(ws.gdata, INVERSE, getGridDims(), gi_host);
+      ws.fftPlan.execute(ws.gdata, n_coils_cc, HOST_FFT_INVERSE,
+                         HOST_FFT_PRUNE_OUTPUT);
+      if (!fused)
+        performHostFFTShift(ws.gdata, INVERSE, getGridDims(), gi_host);
+    }
+
+    {
+      ProfileScope scope(profiler, PROFILE_FUSED_IMAGE, sampleCount,
+                         (this->applySensData() ? 5 : 2) * roiBytes +
+                             roi_count * sizeof(DType));
+      performHostRegionCrop(
+          ws.gdata, roiData.data + coil_it * roi_count, this->deapo.data,
+          this->applySensData()
+              ? this->sens.data + coil_it * this->imgDims.count()
+              : NULL,
+          ws.imdata_sum, roiOffset, roiDims, !fused, gi_host);
+    }
+  }
+
+  ws.fftPlan.setPruningRegion(imageOffset, adjointOffset, this->imgDims);
+
+  if (this->applySensData())
+    memcpy(roiData.data, ws.imdata_sum, roi_count * sizeof(CufftType));
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdj(
+    gpuNUFFT::Array<DType2> kspaceData, gpuNUFFT::Array<CufftType> &roiData,
+    IndType3 roiOffset, Dimensions roiDims)
+{
+  performGpuNUFFTAdj(compressCoils(kspaceData), roiData, roiOffset, roiDims,
+                     getWorkspace());
+}
+
+gpuNUFFT::Array<CufftType> gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdj(
+    gpuNUFFT::Array<DType2> kspaceData, IndType3 roiOffset, Dimensions roiDims)
+{
+  gpuNUFFT::Array<CufftType> roiData;
+  roiData.dim = roiDims;
+  if (this->is2DProcessing())
+    roiData.dim.depth = 0;
+  IndType n_coils = coilCompression != NULL
+                        ? coilCompression->getVirtualCoils()
+                        : kspaceData.dim.channels;
+  roiData.dim.channels = this->applySensData() ? 1 : n_coils;
+  roiData.data = (CufftType *)calloc(roiData.count(), sizeof(CufftType));
+  profileAllocation(profiler, roiData.count() * sizeof(CufftType));
+  performGpuNUFFTAdj(kspaceData, roiData, roiOffset, roiDims);
+  return roiData;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdj(
+    gpuNUFFT::Array<DType2> kspaceData, gpuNUFFT::Array<CufftType> &imgData,
+    Array<IndType> sampleIndices, HostGpuNUFFTWorkspace &ws)
+{
+  validateWorkspace(ws);
+  validateCoilCount(kspaceData.dim.channels);
+  SampleSelection samples = selectSamples(sampleIndices, ws);
+
+  int data_count = samples.data_count;
+  int n_coils = (int)kspaceData.dim.channels;
+  if (kspaceData.count() != (IndType)data_count * n_coils)
+    throw std::invalid_argument(
+        "k-space data does not match the sample subset!");
+  validateAdjointOutput(n_coils, DEAPODIZATION, imgData);
+  IndType imdata_count = this->imgDims.count();
+
+  if (this->applySensData())
+    memset(ws.imdata_sum, 0, imdata_count * sizeof(CufftType));
+
+  for (int coil_it = 0; coil_it < n_coils; coil_it += ws.getCoilBatchSize())
+  {
+    ws.setConcurrentCoilCount(
+        std::min(ws.getCoilBatchSize(), n_coils - coil_it));
+    adjointCoils(kspaceData.data + (size_t)coil_it * data_count, coil_it,
+                 imgData, DEAPODIZATION, samples, ws);
+  }
+
+  if (this->applySensData())
+    memcpy(imgData.data, ws.imdata_sum, imdata_count * sizeof(CufftType));
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdj(
+    gpuNUFFT::Array<DType2> kspaceData, gpuNUFFT::Array<CufftType> &imgData,
+    Array<IndType> sampleIndices)
+{
+  performGpuNUFFTAdj(compressCoils(kspaceData), imgData, sampleIndices,
+                     getWorkspace());
+}
+
+gpuNUFFT::Array<CufftType> gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdj(
+    gpuNUFFT::Array<DType2> kspaceData, Array<IndType> sampleIndices)
+{
+  IndType n_coils = coilCompression != NULL
+                        ? coilCompression->getVirtualCoils()
+                        : kspaceData.dim.channels;
+  gpuNUFFT::Array<CufftType> imgData =
+      initAdjointOutput(n_coils, DEAPODIZATION);
+  performGpuNUFFTAdj(kspaceData, imgData, sampleIndices);
+  return imgData;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdj(
+    GpuArray<DType2> kspaceData_gpu, GpuArray<CufftType> &imgData_gpu,
+    GpuNUFFTOutput gpuNUFFTOut)
+{
+  throw std::runtime_error(
+      "Host gpuNUFFT operator does not support GPU arrays!");
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performForwardGpuNUFFT(
+    gpuNUFFT::Array<DType2> imgData, gpuNUFFT::Array<CufftType> &kspaceData,
+    GpuNUFFTOutput gpuNUFFTOut)
+{
+  performForwardGpuNUFFT(imgData, kspaceData, getWorkspace(), gpuNUFFTOut);
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performForwardGpuNUFFT(
+    gpuNUFFT::Array<DType2> imgData, gpuNUFFT::Array<CufftType> &kspaceData,
+    HostGpuNUFFTWorkspace &ws, GpuNUFFTOutput gpuNUFFTOut)
+{
+  if (DEBUG)
+  {
+    std::cout << "performing host forward gpuNUFFT!!!" << std::endl;
+    std::cout << "dataCount: " << kspaceData.count()
+              << " chnCount: " << kspaceData.dim.channels << std::endl;
+  }
+  validateWorkspace(ws);
+  validateCoilCount(kspaceData.dim.channels);
+  forwardCoils(imgData, kspaceData, NULL, selectAllSamples(), ws);
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::imageToGrid(Array<DType2> imgData,
+                                                 int coil_it,
+                                                 unsigned long long sampleCount,
+                                                 HostGpuNUFFTWorkspace &ws)
+{
+  validateFullGrid();
+  GpuNUFFTInfo *gi_host = ws.gi_host;
+  int n_coils_cc = gi_host->n_coils_cc;
+  IndType imdata_count = this->imgDims.count();
+  size_t im_coil_offset = (size_t)coil_it * imdata_count;
+
+  memset(ws.gdata, 0,
+         sizeof(CufftType) * gi_host->grid_width_dim * n_coils_cc);
+
+  // profiling counters of this coil batch
+  unsigned long long gridBytes =
+      (unsigned long long)gi_host->grid_width_dim * n_coils_cc *
+      sizeof(CufftType);
+  unsigned long long imgBytes =
+      (unsigned long long)imdata_count * n_coils_cc * sizeof(CufftType);
+
+  // even grids fold the FFT shifts into the single pass of
+  // performHostFusedPadding
+  bool fused = isHostFusedImagePassSupported(gi_host);
+  if (fused)
+  {
+    ProfileScope scope(profiler, PROFILE_FUSED_IMAGE, sampleCount,
+                       (this->applySensData() ? 3 : 2) * imgBytes +
+                           imdata_count * sizeof(DType));
+    if (this->applySensData())
+      performHostFusedPadding(imgData.data, ws.gdata, this->deapo.data,
+                              this->sens.data + im_coil_offset, gi_host);
+    else
+      performHostFusedPadding(imgData.data + im_coil_offset, ws.gdata,
+                              this->deapo.data, NULL, gi_host);
+  }
+  else
+  {
+    if (this->applySensData())
+      // perform automatically "repeating" of input image in case
+      // of existing sensitivity data
+      for (int cnt = 0; cnt < n_coils_cc; cnt++)
+        memcpy(ws.imdata + cnt * imdata_count, imgData.data,
+               imdata_count * sizeof(DType2));
+    else
+      memcpy(ws.imdata, imgData.data + im_coil_offset,
+             (size_t)imdata_count * n_coils_cc * sizeof(DType2));
+
+    if (this->applySensData())
+    {
+      ProfileScope scope(profiler, PROFILE_SENSITIVITY, sampleCount,
+                         3 * imgBytes);
+      performHostSensMul(ws.imdata, this->sens.data + im_coil_offset,
+                         gi_host, false);
+    }
+
+    // apodization Correction
+    {
+      ProfileScope scope(profiler, PROFILE_DEAPODIZATION, sampleCount,
+                         2 * imgBytes + imdata_count * sizeof(DType));
+      performHostDeapodization(ws.imdata, this->deapo.data, gi_host);
+    }
+
+    // resize by oversampling factor and zero pad
+    {
+      ProfileScope scope(profiler, PROFILE_CROP, sampleCount,
+                         imgBytes + gridBytes);
+      performHostPadding(ws.imdata, ws.gdata, gi_host);
+    }
+  }
+
+  // shift image to get correct zero frequency position
+  {
+    ProfileScope scope(profiler, PROFILE_FFT, sampleCount,
+                       (fused ? 2 : 6) * gridBytes);
+    if (!fused)
+      performHostFFTShift(ws.gdata, INVERSE, getGridDims(), gi_host);
+    ws.fftPlan.execute(ws.gdata, n_coils_cc, HOST_FFT_FORWARD,
+                       HOST_FFT_PRUNE_INPUT);
+    if (!fused)
+      performHostFFTShift(ws.gdata, FORWARD, getGridDims(), gi_host);
+  }
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::forwardCoils(
+    Array<DType2> imgData, Array<CufftType> &kspaceData,
+    Array<CufftType> *kspaceGradient, const SampleSelection &samples,
+    HostGpuNUFFTWorkspace &ws, CufftType *gridData)
+{
+
+  GpuNUFFTInfo *gi_host = ws.gi_host;
+  int data_count = samples.data_count;
+  int n_coils = (int)kspaceData.dim.channels;
+
+  // forward results are computed in sorted order into the sample buffer
+  CufftType *data = (CufftType *)ws.data_sorted;
+
+  // derivatives in sorted order, dimension major
+  int dim_count = (int)getImageDimensionCount();
+  CufftType *gradient = NULL;
+  DType *kernelDeriv = NULL;
+  if (kspaceGradient != NULL)
+  {
+    size_t gradientCount =
+        (size_t)dim_count * data_count * ws.getCoilBatchSize();
+    if (ws.gradientSorted.size() < gradientCount)
+      ws.gradientSorted.resize(gradientCount);
+    gradient = &ws.gradientSorted[0];
+    kernelDeriv = getConvolutionKernelDerivative();
+  }
+
+  // iterate over coil batches and compute result
+  for (int coil_it = 0; coil_it < n_coils; coil_it += ws.getCoilBatchSize())
+  {
+    int n_coils_cc = std::min(ws.getCoilBatchSize(), n_coils - coil_it);
+    ws.setConcurrentCoilCount(n_coils_cc);
+    GpuNUFFTInfo selectionInfo = getSelectionInfo(samples, ws);
+
+    size_t data_coil_offset = (size_t)coil_it * data_count;
+
+    // profiling counters of this coil batch
+    unsigned long long sampleCount =
+        (unsigned long long)data_count * n_coils_cc;
+    unsigned long long sampleBytes = sampleCount * sizeof(CufftType);
+    unsigned long long gridBytes =
+        (unsigned long long)gi_host->grid_width_dim * n_coils_cc *
+        sizeof(CufftType);
+
+    // grids of the coil batch, either passed in or computed from the image
+    CufftType *gdata = ws.gdata;
+    if (gridData != NULL)
+      gdata = gridData + (size_t)coil_it * gi_host->grid_width_dim;
+    else
+      imageToGrid(imgData, coil_it, sampleCount, ws);
+
+    // convolution and resampling to non-standard trajectory
+    {
+      ProfileScope scope(profiler, PROFILE_CONVOLUTION, sampleCount,
+                         3 * sampleBytes + gridBytes +
+                             data_count * getImageDimensionCount() *
+                                 sizeof(DType));
+      if (gradient != NULL)
+        performHostForwardConvolutionGradient(
+            data, gradient, samples.crds, gdata, getConvolutionKernel(),
+            kernelDeriv, samples.sectors, samples.sectorCenters,
+            &selectionInfo);
+      else
+        performHostForwardConvolution(data, samples.crds, gdata,
+                                      getConvolutionKernel(), samples.sectors,
+                                      samples.sectorCenters, &selectionInfo);
+
+      performHostFFTScaling(data, data_count, &selectionInfo);
+      if (gradient != NULL)
+        performHostFFTScaling(gradient, dim_count * data_count,
+                              &selectionInfo);
+    }
+
+    if (this->applyDensComp())
+    {
+      ProfileScope scope(profiler, PROFILE_DENSITY_COMPENSATION, sampleCount,
+                         2 * sampleBytes +
+                             data_count * sizeof(DType));
+      performHostDensityCompensation(data, samples.dens, &selectionInfo);
+      for (int d = 0; gradient != NULL && d < dim_count; d++)
+        performHostDensityCompensation(
+            gradient + (size_t)d * data_count * n_coils_cc, samples.dens,
+            &selectionInfo);
+    }
+
+    // write result in correct order back into output array
+    {
+      ProfileScope scope(profiler, PROFILE_SORT, sampleCount,
+                         2 * sampleBytes +
+                             data_count * sizeof(IndType));
+      writeOrderedHost(kspaceData.data + data_coil_offset, samples.indices,
+                       data, data_count, n_coils_cc);
+      for (int d = 0; gradient != NULL && d < dim_count; d++)
+        writeOrderedHost(
+            kspaceGradient->data + d * kspaceData.count() + data_coil_offset,
+            samples.indices, gradient + (size_t)d * data_count * n_coils_cc,
+            data_count, n_coils_cc);
+    }
+  }  // iterate over coils
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performForwardGpuNUFFT(
+    gpuNUFFT::Array<DType2> imgData, gpuNUFFT::Array<CufftType> &kspaceData,
+    Array<IndType> sampleIndices, HostGpuNUFFTWorkspace &ws)
+{
+  validateWorkspace(ws);
+  validateCoilCount(kspaceData.dim.channels);
+  SampleSelection samples = selectSamples(sampleIndices, ws);
+  if (kspaceData.count() !=
+      (IndType)samples.data_count * kspaceData.dim.channels)
+    throw std::invalid_argument(
+        "k-space data does not match the sample subset!");
+  forwardCoils(imgData, kspaceData, NULL, samples, ws);
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performForwardGpuNUFFT(
+    gpuNUFFT::Array<DType2> imgData, gpuNUFFT::Array<CufftType> &kspaceData,
+    Array<IndType> sampleIndices)
+{
+  performForwardGpuNUFFT(imgData, kspaceData, sampleIndices, getWorkspace());
+}
+
+gpuNUFFT::Array<CufftType>
+gpuNUFFT::HostGpuNUFFTOperator::performForwardGpuNUFFT(
+    gpuNUFFT::Array<DType2> imgData, Array<IndType> sampleIndices)
+{
+  gpuNUFFT::Array<CufftType> kspaceData;
+  kspaceData.dim.length = sampleIndices.count();
+  kspaceData.dim.channels =
+      this->applySensData() ? this->sens.dim.channels : imgData.dim.channels;
+  kspaceData.data =
+      (CufftType *)calloc(kspaceData.count(), sizeof(CufftType));
+  profileAllocation(profiler, kspaceData.count() * sizeof(CufftType));
+  performForwardGpuNUFFT(imgData, kspaceData, sampleIndices);
+  return kspaceData;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performForwardGpuNUFFTGradient(
+    gpuNUFFT::Array<DType2> imgData, gpuNUFFT::Array<CufftType> &kspaceData,
+    gpuNUFFT::Array<CufftType> &kspaceGradient, HostGpuNUFFTWorkspace &ws)
+{
+  validateWorkspace(ws);
+  validateCoilCount(kspaceData.dim.channels);
+  if (kspaceGradient.count() !=
+      getImageDimensionCount() * kspaceData.count())
+    throw std::invalid_argument(
+        "Gradient data does not match the k-space data!");
+  forwardCoils(imgData, kspaceData, &kspaceGradient, selectAllSamples(), ws);
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performForwardGpuNUFFTGradient(
+    gpuNUFFT::Array<DType2> imgData, gpuNUFFT::Array<CufftType> &kspaceData,
+    gpuNUFFT::Array<CufftType> &kspaceGradient)
+{
+  performForwardGpuNUFFTGradient(imgData, kspaceData, kspaceGradient,
+                                 getWorkspace());
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performGpuNUFFTAdjFromGrid(
+    gpuNUFFT::Array<CufftType> gridData, gpuNUFFT::Array<CufftType> &imgData,
+    GpuNUFFTOutput gpuNUFFTOut)
+{
+  IndType n_coils = gridData.dim.channels;
+  IndType grid_count = this->getGridDims().count();
+  if (gridData.data == NULL || gridData.count() != grid_count * n_coils)
+    throw std::invalid_argument("Grids do not match the operator!");
+
+  HostGpuNUFFTWorkspace &ws = getWorkspace();
+  IndType imdata_count = this->imgDims.count();
+  if (this->applySensData())
+    memset(ws.imdata_sum, 0, imdata_count * sizeof(CufftType));
+
+  for (int coil_it = 0; coil_it < (int)n_coils;
+       coil_it += ws.getCoilBatchSize())
+  {
+    int n_coils_cc = std::min(ws.getCoilBatchSize(), (int)n_coils - coil_it);
+    ws.setConcurrentCoilCount(n_coils_cc);
+    CufftType *grid = gridData.data + coil_it * grid_count;
+    if (gpuNUFFTOut == CONVOLUTION)
+    {
+      memcpy(imgData.data + coil_it * grid_count, grid,
+             (size_t)grid_count * n_coils_cc * sizeof(CufftType));
+      continue;
+    }
+    memcpy(ws.gdata, grid, (size_t)grid_count * n_coils_cc * sizeof(CufftType));
+    gridToImage(coil_it, imgData, gpuNUFFTOut,
+                (unsigned long long)this->kSpaceTraj.count() * n_coils_cc, ws);
+  }
+
+  if (this->applySensData() && gpuNUFFTOut == DEAPODIZATION)
+    memcpy(imgData.data, ws.imdata_sum, imdata_count * sizeof(CufftType));
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performForwardGpuNUFFTToGrid(
+    gpuNUFFT::Array<DType2> imgData, gpuNUFFT::Array<CufftType> &gridData)
+{
+  IndType n_coils = gridData.dim.channels;
+  IndType grid_count = this->getGridDims().count();
+  if (gridData.data == NULL || gridData.count() != grid_count * n_coils)
+    throw std::invalid_argument("Grids do not match the operator!");
+
+  HostGpuNUFFTWorkspace &ws = getWorkspace();
+  for (int coil_it = 0; coil_it < (int)n_coils;
+       coil_it += ws.getCoilBatchSize())
+  {
+    int n_coils_cc = std::min(ws.getCoilBatchSize(), (int)n_coils - coil_it);
+    ws.setConcurrentCoilCount(n_coils_cc);
+    imageToGrid(imgData, coil_it,
+                (unsigned long long)this->kSpaceTraj.count() * n_coils_cc, ws);
+    memcpy(gridData.data + coil_it * grid_count, ws.gdata,
+           (size_t)grid_count * n_coils_cc * sizeof(CufftType));
+  }
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performForwardGpuNUFFTFromGrid(
+    gpuNUFFT::Array<CufftType> gridData, gpuNUFFT::Array<CufftType> &kspaceData)
+{
+  if (gridData.data == NULL || kspaceData.data == NULL ||
+      gridData.dim.channels != kspaceData.dim.channels ||
+      gridData.count() !=
+          getConvolutionGridDims().count() * gridData.dim.channels ||
+      kspaceData.count() != this->kSpaceTraj.count() * kspaceData.dim.channels)
+    throw std::invalid_argument(
+        "Grids or k-space data do not match the operator!");
+
+  HostGpuNUFFTWorkspace &ws = getWorkspace();
+  Array<DType2> imgData;
+  forwardCoils(imgData, kspaceData, NULL, selectAllSamples(), ws,
+               gridData.data);
+}
+
+gpuNUFFT::Array<IndType>
+gpuNUFFT::HostGpuNUFFTOperator::createSampleIndices(Array<unsigned char> mask)
+{
+  IndType count = 0;
+  for (IndType i = 0; i < mask.count(); i++)
+    count += mask.data[i] != 0;
+
+  Array<IndType> sampleIndices;
+  sampleIndices.dim.length = count;
+  sampleIndices.data =
+      (IndType *)malloc(DEFAULT_VALUE(count) * sizeof(IndType));
+  if (sampleIndices.data == NULL)
+    throw std::runtime_error("Allocation of sample indices failed!");
+  for (IndType i = 0, j = 0; i < mask.count(); i++)
+    if (mask.data[i] != 0)
+      sampleIndices.data[j++] = i;
+  return sampleIndices;
+}
+
+void gpuNUFFT::HostGpuNUFFTOperator::performForwardGpuNUFFT(
+    GpuArray<DType2> imgData_gpu, GpuArray<CufftType> &kspaceData_gpu,
+    GpuNUFFTOutput gpuNUFFTOut)
+{
+  throw std::runtime_error(
+      "Host gpuNUFFT operator does not support GPU arrays!");
+}
@@ -0,0 +1,62 @@
+#include "host_gpuNUFFT_workspace.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+
+gpuNUFFT::HostGpuNUFFTWorkspace::HostGpuNUFFTWorkspace(
+    GpuNUFFTInfo *gi_host, Dimensions gridDims, int coilBatchSize)
+  : coilBatchSize(coilBatchSize), gi_host(gi_host), fftPlan(gridDims),
+    data_sorted(NULL), gdata(NULL), imdata(NULL), imdata_sum(NULL),
+    gatherTileKey(NULL)
+{
+  // sizes in size_t, samples times coils exceed the range of int
+  data_sorted = (DType2 *)malloc((size_t)gi_host->data_count * coilBatchSize *
+                                 sizeof(DType2));
+  gdata = (CufftType *)malloc((size_t)gi_host->gridDims_count *
+                              coilBatchSize * sizeof(CufftType));
+  imdata = (CufftType *)malloc((size_t)gi_host->imgDims_count *
+                               coilBatchSize * sizeof(CufftType));
+  imdata_sum = (CufftType *)malloc((size_t)gi_host->imgDims_count *
+                                   sizeof(CufftType));
+
+  if (data_sorted == NULL || gdata == NULL || imdata == NULL ||
+      imdata_sum == NULL)
+  {
+    free(data_sorted);
+    free(gdata);
+    free(imdata);
+    free(imdata_sum);
+    free(gi_host);
+    throw std::runtime_error("Allocation of host workspace failed!");
+  }
+}
+
+gpuNUFFT::HostGpuNUFFTWorkspace::~HostGpuNUFFTWorkspace()
+{
+  free(data_sorted);
+  free(gdata);
+  free(imdata);
+  free(imdata_sum);
+  free(gi_host);
+}
+
+size_t gpuNUFFT::HostGpuNUFFTWorkspace::getAllocatedBytes()
+{
+  return (size_t)gi_host->data_count * coilBatchSize * sizeof(DType2) +
+         (size_t)gi_host->gridDims_count * coilBatchSize * sizeof(CufftType) +
+         (size_t)gi_host->imgDims_count * (coilBatchSize + 1) *
+             sizeof(CufftType) +
+         (sortedPositions.capacity() + subsetIndices.capacity() +
+          subsetSectors.capacity() + subsetSectorCenters.capacity() +
+          gatherTileOffsets.capacity() + gatherTileSectors.capacity() +
+          shardSectors.capacity()) *
+             sizeof(IndType) +
+         (subsetCrds.capacity() + subsetDens.capacity()) * sizeof(DType) +
+         gradientSorted.capacity() * sizeof(CufftType) +
+         shardSlabs.getSize();
+}
+
+void gpuNUFFT::HostGpuNUFFTWorkspace::setConcurrentCoilCount(int n_coils_cc)
+{
+  gi_host->n_coils_cc = n_coils_cc;
+}
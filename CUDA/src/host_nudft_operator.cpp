@@ -0,0 +1,163 @@
+#include "host_nudft_operator.hpp"
+#include "host_nudft.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+void gpuNUFFT::HostNUDFTOperator::validateOutput(GpuNUFFTOutput gpuNUFFTOut)
+{
+  if (gpuNUFFTOut != DEAPODIZATION)
+    throw std::invalid_argument(
+        "NUDFT operator does not provide intermediate gridding results!");
+}
+
+void gpuNUFFT::HostNUDFTOperator::performGpuNUFFTAdj(
+    gpuNUFFT::Array<DType2> kspaceData, gpuNUFFT::Array<CufftType> &imgData,
+    GpuNUFFTOutput gpuNUFFTOut)
+{
+  if (DEBUG)
+    std::cout << "performing host adjoint NUDFT!!!" << std::endl;
+  validateOutput(gpuNUFFTOut);
+
+  IndType data_count = this->kSpaceTraj.count();
+  IndType n_coils = kspaceData.dim.channels;
+  IndType imdata_count = this->imgDims.count();
+  unsigned long long samples = (unsigned long long)data_count * n_coils;
+
+  // select data ordered and apply density compensation
+  std::vector<DType2> data_sorted(data_count * n_coils);
+  {
+    ProfileScope scope(profiler, PROFILE_SORT, samples,
+                       samples * 2 * sizeof(DType2) +
+                           data_count * (sizeof(IndType) + sizeof(DType)));
+    for (IndType c = 0; c < n_coils; c++)
+      for (IndType i = 0; i < data_count; i++)
+      {
+        DType2 val = kspaceData.data[this->dataIndices.data[i] + c * data_count];
+        if (this->applyDensComp())
+        {
+          DType dens_sqrt = std::sqrt(this->dens.data[i]);
+          val.x *= dens_sqrt;
+          val.y *= dens_sqrt;
+        }
+        data_sorted[i + c * data_count] = val;
+      }
+  }
+
+  std::vector<CufftType> coilImages;
+  CufftType *nudftOut = imgData.data;
+  if (this->applySensData())
+  {
+    coilImages.resize(imdata_count * n_coils);
+    nudftOut = &coilImages[0];
+  }
+
+  {
+    ProfileScope scope(profiler, PROFILE_CONVOLUTION, samples,
+                       samples * sizeof(DType2) +
+                           data_count * getImageDimensionCount() *
+                               sizeof(DType) +
+                           imdata_count * n_coils * sizeof(CufftType));
+    performHostNUDFTAdj(&data_sorted[0], this->kSpaceTraj.data, data_count,
+                        n_coils, this->imgDims, nudftOut);
+  }
+
+  if (this->applySensData())
+  {
+    ProfileScope scope(profiler, PROFILE_SENSITIVITY, samples,
+                       imdata_count * (2 * n_coils + 1) * sizeof(CufftType));
+    for (IndType i = 0; i < imdata_count; i++)
+    {
+      CufftType sum = { 0.0f, 0.0f };
+      for (IndType c = 0; c < n_coils; c++)
+      {
+        CufftType val = coilImages[i + c * imdata_count];
+        DType2 s = this->sens.data[i + c * imdata_count];
+        sum.x += val.x * s.x + val.y * s.y;
+        sum.y += val.y * s.x - val.x * s.y;
+      }
+      imgData.data[i] = sum;
+    }
+  }
+}
+
+void gpuNUFFT::HostNUDFTOperator::performGpuNUFFTAdj(
+    GpuArray<DType2> kspaceData_gpu, GpuArray<CufftType> &imgData_gpu,
+    GpuNUFFTOutput gpuNUFFTOut)
+{
+  throw std::runtime_error(
+      "Host NUDFT operator does not support GPU arrays!");
+}
+
+void gpuNUFFT::HostNUDFTOperator::performForwardGpuNUFFT(
+    gpuNUFFT::Array<DType2> imgData, gpuNUFFT::Array<CufftType> &kspaceData,
+    GpuNUFFTOutput gpuNUFFTOut)
+{
+  if (DEBUG)
+    std::cout << "performing host forward NUDFT!!!" << std::endl;
+
+  IndType data_count = this->kSpaceTraj.count();
+  IndType n_coils = kspaceData.dim.channels;
+  IndType imdata_count = this->imgDims.count();
+  unsigned long long samples = (unsigned long long)data_count * n_coils;
+
+  // perform automatically "repeating" of input image in case
+  // of existing sensitivity data
+  std::vector<DType2> coilImages;
+  const DType2 *nudftIn = imgData.data;
+  if (this->applySensData())
+  {
+    ProfileScope scope(profiler, PROFILE_SENSITIVITY, samples,
+                       imdata_count * (2 * n_coils + 1) * sizeof(CufftType));
+    coilImages.resize(imdata_count * n_coils);
+    for (IndType c = 0; c < n_coils; c++)
+      for (IndType i = 0; i < imdata_count; i++)
+      {
+        DType2 val = imgData.data[i];
+        DType2 s = this->sens.data[i + c * imdata_count];
+        coilImages[i + c * imdata_count].x = val.x * s.x - val.y * s.y;
+        coilImages[i + c * imdata_count].y = val.x * s.y + val.y * s.x;
+      }
+    nudftIn = &coilImages[0];
+  }
+
+  std::vector<CufftType> data_sorted(data_count * n_coils);
+  {
+    ProfileScope scope(profiler, PROFILE_CONVOLUTION, samples,
+                       samples * sizeof(CufftType) +
+                           data_count * getImageDimensionCount() *
+                               sizeof(DType) +
+                           imdata_count * n_coils * sizeof(DType2));
+    performHostNUDFTForward(nudftIn, this->kSpaceTraj.data, data_count,
+                            n_coils, this->imgDims, &data_sorted[0]);
+  }
+
+  // apply density compensation and write result in original order
+  {
+    ProfileScope scope(profiler, PROFILE_SORT, samples,
+                       samples * 2 * sizeof(CufftType) +
+                           data_count * (sizeof(IndType) + sizeof(DType)));
+    for (IndType c = 0; c < n_coils; c++)
+      for (IndType i = 0; i < data_count; i++)
+      {
+        CufftType val = data_sorted[i + c * data_count];
+        if (this->applyDensComp())
+        {
+          DType dens_sqrt = std::sqrt(this->dens.data[i]);
+          val.x *= dens_sqrt;
+          val.y *= dens_sqrt;
+        }
+        kspaceData.data[this->dataIndices.data[i] + c * data_count] = val;
+      }
+  }
+}
+
+void gpuNUFFT::HostNUDFTOperator::performForwardGpuNUFFT(
+    GpuArray<DType2> imgData_gpu, GpuArray<CufftType> &kspaceData_gpu,
+    GpuNUFFTOutput gpuNUFFTOut)
+{
+  throw std::runtime_error(
+      "Host NUDFT operator does not support GPU arrays!");
+}
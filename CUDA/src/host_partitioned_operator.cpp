@@ -0,0 +1,454 @@
+#include "host_partitioned_operator.hpp"
+#include "host_parallel.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+// sector planes along the slowest dimension and sectors per plane
+void getSectorPlanes(gpuNUFFT::HostGpuNUFFTOperator *op, IndType &planes,
+                     IndType &planeSectors)
+{
+  gpuNUFFT::Dimensions sectorDims = op->getGridSectorDims();
+  planes = op->is3DProcessing() ? sectorDims.depth : sectorDims.height;
+  planeSectors = sectorDims.count() / planes;
+}
+
+// plane of grid plane z in the grids of a backend holding planes from
+// offset on (modulo planeCount)
+IndType getBackendPlane(IndType z, IndType offset, IndType planeCount)
+{
+  return (z + planeCount - offset) % planeCount;
+}
+
+// convolution of the samples of each backend into its grids
+class BackendAdjointTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  BackendAdjointTask(
+      const std::vector<gpuNUFFT::HostGpuNUFFTOperator *> &backends,
+      const std::vector<IndType> &slabSamples, const IndType *dataIndices,
+      gpuNUFFT::Array<DType2> kspaceData,
+      std::vector<std::vector<DType2> > &backendData,
+      std::vector<std::vector<CufftType> > &backendGrids)
+    : backends(backends), slabSamples(slabSamples), dataIndices(dataIndices),
+      kspaceData(kspaceData), backendData(backendData),
+      backendGrids(backendGrids)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    IndType data_count = kspaceData.dim.length;
+    IndType n_coils = kspaceData.dim.channels;
+    for (IndType p = begin; p < end; p++)
+    {
+      if (backends[p] == NULL)
+        continue;
+      IndType first = slabSamples[p];
+      IndType count = slabSamples[p + 1] - first;
+      DType2 *data = &backendData[p][0];
+      for (IndType c = 0; c < n_coils; c++)
+        for (IndType j = 0; j < count; j++)
+          data[j + c * count] =
+              kspaceData.data[dataIndices[first + j] + c * data_count];
+
+      gpuNUFFT::Array<DType2> dataArray;
+      dataArray.data = data;
+      dataArray.dim.length = count;
+      dataArray.dim.channels = n_coils;
+      gpuNUFFT::Array<CufftType> gridArray;
+      gridArray.data = &backendGrids[p][0];
+      gridArray.dim = backends[p]->getConvolutionGridDims();
+      gridArray.dim.channels = n_coils;
+      backends[p]->performGpuNUFFTAdj(dataArray, gridArray,
+                                      gpuNUFFT::CONVOLUTION);
+    }
+  }
+
+ private:
+  const std::vector<gpuNUFFT::HostGpuNUFFTOperator *> &backends;
+  const std::vector<IndType> &slabSamples;
+  const IndType *dataIndices;
+  gpuNUFFT::Array<DType2> kspaceData;
+  std::vector<std::vector<DType2> > &backendData;
+  std::vector<std::vector<CufftType> > &backendGrids;
+};
+
+// interpolation of the samples of each backend from its grids
+class BackendForwardTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  BackendForwardTask(
+      const std::vector<gpuNUFFT::HostGpuNUFFTOperator *> &backends,
+      const std::vector<IndType> &slabSamples, const IndType *dataIndices,
+      gpuNUFFT::Array<CufftType> kspaceData,
+      std::vector<std::vector<DType2> > &backendData,
+      std::vector<std::vector<CufftType> > &backendGrids)
+    : backends(backends), slabSamples(slabSamples), dataIndices(dataIndices),
+      kspaceData(kspaceData), backendData(backendData),
+      backendGrids(backendGrids)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    IndType data_count = kspaceData.dim.length;
+    IndType n_coils = kspaceData.dim.channels;
+    for (IndType p = begin; p < end; p++)
+    {
+      if (backends[p] == NULL)
+        continue;
+      IndType first = slabSamples[p];
+      IndType count = slabSamples[p + 1] - first;
+
+      gpuNUFFT::Array<CufftType> gridArray;
+      gridArray.data = &backendGrids[p][0];
+      gridArray.dim = backends[p]->getConvolutionGridDims();
+      gridArray.dim.channels = n_coils;
+      // the sample buffer holds the forward results of the backend
+      gpuNUFFT::Array<CufftType> dataArray;
+      dataArray.data = (CufftType *)&backendData[p][0];
+      dataArray.dim.length = count;
+      dataArray.dim.channels = n_coils;
+      backends[p]->performForwardGpuNUFFTFromGrid(gridArray, dataArray);
+
+      for (IndType c = 0; c < n_coils; c++)
+        for (IndType j = 0; j < count; j++)
+          kspaceData.data[dataIndices[first + j] + c * data_count] =
+              dataArray.data[j + c * count];
+    }
+  }
+
+ private:
+  const std::vector<gpuNUFFT::HostGpuNUFFTOperator *> &backends;
+  const std::vector<IndType> &slabSamples;
+  const IndType *dataIndices;
+  gpuNUFFT::Array<CufftType> kspaceData;
+  std::vector<std::vector<DType2> > &backendData;
+  std::vector<std::vector<CufftType> > &backendGrids;
+};
+
+// sum of the slab and halo planes of the backend grids, per coil and plane
+// in backend order
+class MergeHaloTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  MergeHaloTask(const std::vector<IndType> &gridOffsets,
+                const std::vector<IndType> &gridPlanes, IndType planeCount,
+                IndType planeSize,
+                std::vector<std::vector<CufftType> > &backendGrids,
+                CufftType *grid)
+    : gridOffsets(gridOffsets), gridPlanes(gridPlanes),
+      planeCount(planeCount), planeSize(planeSize),
+      backendGrids(backendGrids), grid(grid)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType plane = begin; plane < end; plane++)
+    {
+      IndType c = plane / planeCount;
+      CufftType *dst = grid + plane * planeSize;
+      memset(dst, 0, planeSize * sizeof(CufftType));
+      for (IndType p = 0; p < gridPlanes.size(); p++)
+      {
+        IndType local =
+            getBackendPlane(plane % planeCount, gridOffsets[p], planeCount);
+        if (local >= gridPlanes[p])
+          continue;
+        const CufftType *src =
+            &backendGrids[p][0] + (c * gridPlanes[p] + local) * planeSize;
+        for (IndType i = 0; i < planeSize; i++)
+        {
+          dst[i].x += src[i].x;
+          dst[i].y += src[i].y;
+        }
+      }
+    }
+  }
+
+ private:
+  const std::vector<IndType> &gridOffsets;
+  const std::vector<IndType> &gridPlanes;
+  IndType planeCount;
+  IndType planeSize;
+  std::vector<std::vector<CufftType> > &backendGrids;
+  CufftType *grid;
+};
+
+// copy of the slab and halo planes of the grid to each backend, per backend,
+// coil and plane of the grid
+class DistributeHaloTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  DistributeHaloTask(const std::vector<IndType> &gridOffsets,
+                     const std::vector<IndType> &gridPlanes,
+                     IndType planeCount, IndType planeSize, IndType n_coils,
+                     std::vector<std::vector<CufftType> > &backendGrids,
+                     const CufftType *grid)
+    : gridOffsets(gridOffsets), gridPlanes(gridPlanes),
+      planeCount(planeCount), planeSize(planeSize), n_coils(n_coils),
+      backendGrids(backendGrids), grid(grid)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    IndType coilPlanes = planeCount * n_coils;
+    for (IndType index = begin; index < end; index++)
+    {
+      IndType p = index / coilPlanes;
+      IndType plane = index % coilPlanes;
+      IndType c = plane / planeCount;
+      IndType local =
+          getBackendPlane(plane % planeCount, gridOffsets[p], planeCount);
+      if (local >= gridPlanes[p])
+        continue;
+      memcpy(&backendGrids[p][0] + (c * gridPlanes[p] + local) * planeSize,
+             grid + plane * planeSize, planeSize * sizeof(CufftType));
+    }
+  }
+
+ private:
+  const std::vector<IndType> &gridOffsets;
+  const std::vector<IndType> &gridPlanes;
+  IndType planeCount;
+  IndType planeSize;
+  IndType n_coils;
+  std::vector<std::vector<CufftType> > &backendGrids;
+  const CufftType *grid;
+};
+}
+
+void gpuNUFFT::HostPartitionedOperator::computeSlabs(
+    HostGpuNUFFTOperator *op, IndType partitions,
+    std::vector<IndType> &slabSectors, std::vector<IndType> &slabSamples)
+{
+  IndType planes, planeSectors;
+  getSectorPlanes(op, planes, planeSectors);
+  if (partitions == 0 || partitions > planes)
+    throw std::invalid_argument(
+        "Partition count has to be in [1, amount of sector planes]!");
+
+  // at least one sector plane per slab, the boundaries follow the sample
+  // counts of the planes
+  const IndType *sectors = op->getSectorDataCount().data;
+  IndType data_count = op->getKSpaceTraj().count();
+  slabSectors.assign(partitions + 1, 0);
+  for (IndType p = 1; p < partitions; p++)
+  {
+    IndType target =
+        (IndType)((unsigned long long)data_count * p / partitions);
+    IndType plane = slabSectors[p - 1] + 1;
+    while (plane < planes - (partitions - p) &&
+           sectors[plane * planeSectors] < target)
+      plane++;
+    slabSectors[p] = plane;
+  }
+  slabSectors[partitions] = planes;
+
+  slabSamples.resize(partitions + 1);
+  for (IndType p = 0; p <= partitions; p++)
+    slabSamples[p] = sectors[slabSectors[p] * planeSectors];
+}
+
+gpuNUFFT::HostPartitionedOperator::HostPartitionedOperator(
+    HostGpuNUFFTOperator *gpuNUFFTOp,
+    const std::vector<HostGpuNUFFTOperator *> &backends,
+    const std::vector<IndType> &slabSectors)
+  : gpuNUFFTOp(gpuNUFFTOp), backends(backends), slabSectors(slabSectors),
+    coilCount(0)
+{
+  IndType planes, planeSectors;
+  getSectorPlanes(gpuNUFFTOp, planes, planeSectors);
+  const IndType *sectors = gpuNUFFTOp->getSectorDataCount().data;
+
+  bool valid = !backends.empty() && slabSectors.size() == backends.size() + 1 &&
+               slabSectors[0] == 0 && slabSectors.back() == planes;
+  slabSamples.resize(slabSectors.size());
+  for (IndType p = 0; valid && p < slabSectors.size(); p++)
+  {
+    valid = p == 0 || slabSectors[p] > slabSectors[p - 1];
+    slabSamples[p] = sectors[slabSectors[p] * planeSectors];
+  }
+  for (IndType p = 0; valid && p < backends.size(); p++)
+  {
+    IndType count = slabSamples[p + 1] - slabSamples[p];
+    valid = count == 0
+                ? backends[p] == NULL
+                : backends[p] != NULL &&
+                      backends[p]->getKSpaceTraj().count() == count &&
+                      !backends[p]->applySensData() &&
+                      backends[p]->getGridDims().count() ==
+                          gpuNUFFTOp->getGridDims().count();
+  }
+  if (!valid)
+  {
+    for (IndType p = 0; p < backends.size(); p++)
+      delete backends[p];
+    delete gpuNUFFTOp;
+    throw std::invalid_argument(
+        "Backends do not match the slabs of the partitioned operator!");
+  }
+
+  Dimensions gridDims = gpuNUFFTOp->getGridDims();
+  Dimensions kernelWidths = gpuNUFFTOp->getKernelWidths();
+  bool is3D = gpuNUFFTOp->is3DProcessing();
+  planeCount = is3D ? gridDims.depth : gridDims.height;
+  planeSize = gridDims.width * (is3D ? gridDims.height : 1);
+  sectorWidth = gpuNUFFTOp->getSectorWidth();
+  halo = (is3D ? kernelWidths.depth : kernelWidths.height) / 2;
+
+  // the grids of each backend hold its slab and halo planes only
+  gridOffsets.assign(backends.size(), 0);
+  gridPlanes.assign(backends.size(), 0);
+  for (IndType p = 0; p < backends.size(); p++)
+  {
+    if (backends[p] == NULL)
+      continue;
+    IndType first, last;
+    getSlabPlanes(p, first, last);
+    gridOffsets[p] = (first + planeCount - halo % planeCount) % planeCount;
+    gridPlanes[p] = std::min(last - first + 2 * halo, planeCount);
+    backends[p]->setGridPlanes(gridOffsets[p], gridPlanes[p]);
+  }
+}
+
+gpuNUFFT::HostPartitionedOperator::~HostPartitionedOperator()
+{
+  for (IndType p = 0; p < backends.size(); p++)
+    delete backends[p];
+  delete gpuNUFFTOp;
+}
+
+void gpuNUFFT::HostPartitionedOperator::getSlabPlanes(IndType p,
+                                                      IndType &first,
+                                                      IndType &last)
+{
+  first = std::min(slabSectors[p] * sectorWidth, planeCount);
+  last = std::min(slabSectors[p + 1] * sectorWidth, planeCount);
+}
+
+void gpuNUFFT::HostPartitionedOperator::setCoilBatchSize(int coilBatchSize)
+{
+  gpuNUFFTOp->setCoilBatchSize(coilBatchSize);
+  for (IndType p = 0; p < backends.size(); p++)
+    if (backends[p] != NULL)
+      backends[p]->setCoilBatchSize(coilBatchSize);
+}
+
+int gpuNUFFT::HostPartitionedOperator::getBackendThreadCount()
+{
+  // fewer backends than threads leave the parallelization to the gridding
+  // steps of each backend
+  int n_threads = getHostThreadCount();
+  return backends.size() >= (IndType)n_threads ? n_threads : 1;
+}
+
+void gpuNUFFT::HostPartitionedOperator::prepare(IndType n_coils,
+                                                IndType kspaceCount)
+{
+  if (n_coils == 0 ||
+      kspaceCount != n_coils * gpuNUFFTOp->getKSpaceTraj().count())
+    throw std::invalid_argument(
+        "K-space data does not match the partitioned operator!");
+  if (n_coils == coilCount)
+    return;
+
+  grid.assign(planeCount * planeSize * n_coils, CufftType());
+  backendGrids.resize(backends.size());
+  backendData.resize(backends.size());
+  for (IndType p = 0; p < backends.size(); p++)
+  {
+    IndType count = slabSamples[p + 1] - slabSamples[p];
+    backendGrids[p].assign(gridPlanes[p] * planeSize * n_coils, CufftType());
+    backendData[p].resize(count * n_coils);
+  }
+  coilCount = n_coils;
+}
+
+void gpuNUFFT::HostPartitionedOperator::performGpuNUFFTAdj(
+    Array<DType2> kspaceData, Array<CufftType> &imgData,
+    GpuNUFFTOutput gpuNUFFTOut)
+{
+  IndType n_coils = kspaceData.dim.channels;
+  prepare(n_coils, kspaceData.count());
+
+  BackendAdjointTask convolution(backends, slabSamples,
+                                 gpuNUFFTOp->getDataIndices().data,
+                                 kspaceData, backendData, backendGrids);
+  hostParallelFor(backends.size(), convolution, getBackendThreadCount());
+
+  MergeHaloTask merge(gridOffsets, gridPlanes, planeCount, planeSize,
+                      backendGrids, &grid[0]);
+  hostParallelFor(planeCount * n_coils, merge);
+
+  Array<CufftType> gridArray;
+  gridArray.data = &grid[0];
+  gridArray.dim = gpuNUFFTOp->getGridDims();
+  gridArray.dim.channels = n_coils;
+  gpuNUFFTOp->performGpuNUFFTAdjFromGrid(gridArray, imgData, gpuNUFFTOut);
+}
+
+gpuNUFFT::Array<CufftType>
+gpuNUFFT::HostPartitionedOperator::performGpuNUFFTAdj(
+    Array<DType2> kspaceData, GpuNUFFTOutput gpuNUFFTOut)
+{
+  Array<CufftType> imgData;
+  if (gpuNUFFTOut == CONVOLUTION)
+  {
+    imgData.dim = gpuNUFFTOp->getGridDims();
+    imgData.dim.channels = kspaceData.dim.channels;
+  }
+  else
+  {
+    imgData.dim = gpuNUFFTOp->getImageDims();
+    imgData.dim.channels =
+        gpuNUFFTOp->applySensData() ? 1 : kspaceData.dim.channels;
+  }
+  imgData.data = (CufftType *)calloc(imgData.count(), sizeof(CufftType));
+  performGpuNUFFTAdj(kspaceData, imgData, gpuNUFFTOut);
+  return imgData;
+}
+
+void gpuNUFFT::HostPartitionedOperator::performForwardGpuNUFFT(
+    Array<DType2> imgData, Array<CufftType> &kspaceData)
+{
+  IndType n_coils = kspaceData.dim.channels;
+  prepare(n_coils, kspaceData.count());
+
+  Array<CufftType> gridArray;
+  gridArray.data = &grid[0];
+  gridArray.dim = gpuNUFFTOp->getGridDims();
+  gridArray.dim.channels = n_coils;
+  gpuNUFFTOp->performForwardGpuNUFFTToGrid(imgData, gridArray);
+
+  DistributeHaloTask distribute(gridOffsets, gridPlanes, planeCount,
+                                planeSize, n_coils, backendGrids, &grid[0]);
+  hostParallelFor(backends.size() * planeCount * n_coils, distribute);
+
+  BackendForwardTask convolution(backends, slabSamples,
+                                 gpuNUFFTOp->getDataIndices().data,
+                                 kspaceData, backendData, backendGrids);
+  hostParallelFor(backends.size(), convolution, getBackendThreadCount());
+}
+
+gpuNUFFT::Array<CufftType>
+gpuNUFFT::HostPartitionedOperator::performForwardGpuNUFFT(
+    Array<DType2> imgData)
+{
+  Array<CufftType> kspaceData;
+  kspaceData.dim.length = gpuNUFFTOp->getKSpaceTraj().count();
+  kspaceData.dim.channels = gpuNUFFTOp->applySensData()
+                                ? gpuNUFFTOp->getSens().dim.channels
+                                : imgData.dim.channels;
+  kspaceData.data =
+      (CufftType *)calloc(kspaceData.count(), sizeof(CufftType));
+  performForwardGpuNUFFT(imgData, kspaceData);
+  return kspaceData;
+}
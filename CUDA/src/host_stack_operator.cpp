@@ -0,0 +1,356 @@
+#include "host_stack_operator.hpp"
+#include "host_parallel.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+// 1-d transform of the kz lines, one line per coil and sample. The line is
+// stored shifted by P/2 such that the unshifted FFT evaluates the centered
+// sum exp(+-2 pi i (p - P/2)(z - P/2) / P).
+class HostPartitionFFTTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostPartitionFFTTask(const DType2 *src, DType2 *dst, IndType n_coils,
+                       IndType partitions, IndType sampleCount, bool toHybrid,
+                       gpuNUFFT::HostFFTDirection dir,
+                       const gpuNUFFT::HostFFTPlan1D &plan,
+                       CufftType *buffers, IndType bufferSize)
+    : src(src), dst(dst), n_coils(n_coils), partitions(partitions),
+      sampleCount(sampleCount), toHybrid(toHybrid), dir(dir), plan(plan),
+      buffers(buffers), bufferSize(bufferSize)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    CufftType *line = buffers + threadId * bufferSize;
+    CufftType *scratch = line + partitions;
+    IndType center = partitions / 2;
+    DType scale = (DType)(1.0 / std::sqrt((double)partitions));
+
+    for (IndType l = begin; l < end; l++)
+    {
+      IndType coil = l / sampleCount;
+      IndType sample = l % sampleCount;
+      // stride between partitions and offset of the line in both layouts
+      IndType coilStride = partitions * sampleCount;
+      IndType hybridStride = n_coils * sampleCount;
+      IndType coilOffset = coil * coilStride + sample;
+      IndType hybridOffset = coil * sampleCount + sample;
+
+      const DType2 *in = src + (toHybrid ? coilOffset : hybridOffset);
+      IndType inStride = toHybrid ? sampleCount : hybridStride;
+      for (IndType p = 0; p < partitions; p++)
+        line[(p + partitions - center) % partitions] = in[p * inStride];
+
+      plan.execute(line, scratch, dir);
+
+      DType2 *out = dst + (toHybrid ? hybridOffset : coilOffset);
+      IndType outStride = toHybrid ? hybridStride : sampleCount;
+      for (IndType p = 0; p < partitions; p++)
+      {
+        CufftType v = line[(p + partitions - center) % partitions];
+        out[p * outStride].x = v.x * scale;
+        out[p * outStride].y = v.y * scale;
+      }
+    }
+  }
+
+ private:
+  const DType2 *src;
+  DType2 *dst;
+  IndType n_coils;
+  IndType partitions;
+  IndType sampleCount;
+  bool toHybrid;
+  gpuNUFFT::HostFFTDirection dir;
+  const gpuNUFFT::HostFFTPlan1D &plan;
+  CufftType *buffers;
+  IndType bufferSize;
+};
+
+// 2-d gridding of the partitions [begin, end) with the workspace of the
+// thread, coil combination resp. sensitivity expansion per partition
+class HostPartitionGriddingTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostPartitionGriddingTask(
+      gpuNUFFT::HostGpuNUFFTOperator *sliceOp,
+      std::vector<gpuNUFFT::HostGpuNUFFTWorkspace *> &workspaces,
+      DType2 *hybridData, DType2 *coilImages, DType2 *imgData,
+      gpuNUFFT::Array<DType2> sens, IndType n_coils, IndType partitions,
+      bool adjoint)
+    : sliceOp(sliceOp), workspaces(workspaces), hybridData(hybridData),
+      coilImages(coilImages), imgData(imgData), sens(sens), n_coils(n_coils),
+      partitions(partitions), adjoint(adjoint)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    gpuNUFFT::Dimensions sliceDims = sliceOp->getImageDims();
+    IndType sliceCount = sliceDims.count();
+    IndType sampleCount = sliceOp->getKSpaceTraj().count();
+    DType2 *coilImg = coilImages + threadId * n_coils * sliceCount;
+
+    gpuNUFFT::Array<DType2> sliceImg;
+    sliceImg.data = coilImg;
+    sliceImg.dim = sliceDims;
+    sliceImg.dim.channels = n_coils;
+
+    for (IndType z = begin; z < end; z++)
+    {
+      gpuNUFFT::Array<DType2> sliceData;
+      sliceData.data = hybridData + z * n_coils * sampleCount;
+      sliceData.dim.length = sampleCount;
+      sliceData.dim.channels = n_coils;
+
+      if (adjoint)
+      {
+        gpuNUFFT::Array<CufftType> sliceOut;
+        sliceOut.data = (CufftType *)coilImg;
+        sliceOut.dim = sliceImg.dim;
+        sliceOp->performGpuNUFFTAdj(sliceData, sliceOut, *workspaces[threadId]);
+        combine(z, coilImg, sliceCount);
+      }
+      else
+      {
+        expand(z, coilImg, sliceCount);
+        gpuNUFFT::Array<CufftType> sliceOut;
+        sliceOut.data = (CufftType *)sliceData.data;
+        sliceOut.dim = sliceData.dim;
+        sliceOp->performForwardGpuNUFFT(sliceImg, sliceOut,
+                                        *workspaces[threadId]);
+      }
+    }
+  }
+
+ private:
+  // sum_c conj(S_c) I_c into partition z of the image or copy per coil
+  void combine(IndType z, const DType2 *coilImg, IndType sliceCount)
+  {
+    if (sens.data == NULL)
+    {
+      for (IndType c = 0; c < n_coils; c++)
+        memcpy(imgData + (c * partitions + z) * sliceCount,
+               coilImg + c * sliceCount, sliceCount * sizeof(DType2));
+      return;
+    }
+    DType2 *out = imgData + z * sliceCount;
+    memset(out, 0, sliceCount * sizeof(DType2));
+    for (IndType c = 0; c < n_coils; c++)
+    {
+      const DType2 *s = sens.data + (c * partitions + z) * sliceCount;
+      const DType2 *img = coilImg + c * sliceCount;
+      for (IndType i = 0; i < sliceCount; i++)
+      {
+        out[i].x += s[i].x * img[i].x + s[i].y * img[i].y;
+        out[i].y += s[i].x * img[i].y - s[i].y * img[i].x;
+      }
+    }
+  }
+
+  // S_c I resp. the coil images of partition z
+  void expand(IndType z, DType2 *coilImg, IndType sliceCount)
+  {
+    if (sens.data == NULL)
+    {
+      for (IndType c = 0; c < n_coils; c++)
+        memcpy(coilImg + c * sliceCount,
+               imgData + (c * partitions + z) * sliceCount,
+               sliceCount * sizeof(DType2));
+      return;
+    }
+    const DType2 *in = imgData + z * sliceCount;
+    for (IndType c = 0; c < n_coils; c++)
+    {
+      const DType2 *s = sens.data + (c * partitions + z) * sliceCount;
+      DType2 *img = coilImg + c * sliceCount;
+      for (IndType i = 0; i < sliceCount; i++)
+      {
+        img[i].x = s[i].x * in[i].x - s[i].y * in[i].y;
+        img[i].y = s[i].x * in[i].y + s[i].y * in[i].x;
+      }
+    }
+  }
+
+  gpuNUFFT::HostGpuNUFFTOperator *sliceOp;
+  std::vector<gpuNUFFT::HostGpuNUFFTWorkspace *> &workspaces;
+  DType2 *hybridData;
+  DType2 *coilImages;
+  DType2 *imgData;
+  gpuNUFFT::Array<DType2> sens;
+  IndType n_coils;
+  IndType partitions;
+  bool adjoint;
+};
+}
+
+gpuNUFFT::HostStackOfStarsOperator::HostStackOfStarsOperator(
+    HostGpuNUFFTOperator *sliceOp, IndType partitions, Array<DType2> sensData)
+  : sliceOp(sliceOp), partitions(partitions), sens(sensData),
+    coilBatchSize(1), zPlan(DEFAULT_VALUE(partitions))
+{
+  if (sliceOp->is3DProcessing() || sliceOp->applySensData() ||
+      partitions == 0)
+  {
+    delete sliceOp;
+    throw std::invalid_argument(
+        "Stack-of-stars operator requires a 2-d slice operator without "
+        "sensitivities and at least one partition!");
+  }
+
+  sampleCount = sliceOp->getKSpaceTraj().count();
+  imgDims = sliceOp->getImageDims();
+  imgDims.depth = partitions;
+  if (!applySensData())
+    sens.data = NULL;
+}
+
+gpuNUFFT::HostStackOfStarsOperator::~HostStackOfStarsOperator()
+{
+  for (size_t t = 0; t < workspaces.size(); t++)
+    delete workspaces[t];
+  delete sliceOp;
+}
+
+void gpuNUFFT::HostStackOfStarsOperator::setCoilBatchSize(int coilBatchSize)
+{
+  if (coilBatchSize < 1)
+    throw std::invalid_argument("Coil batch size must be at least 1!");
+  this->coilBatchSize = coilBatchSize;
+  for (size_t t = 0; t < workspaces.size(); t++)
+    delete workspaces[t];
+  workspaces.clear();
+}
+
+int gpuNUFFT::HostStackOfStarsOperator::getPartitionThreadCount()
+{
+  // fewer partitions than threads leave the parallelization to the gridding
+  // steps of the slice operator
+  int n_threads = getHostThreadCount();
+  return partitions >= (IndType)n_threads ? n_threads : 1;
+}
+
+void gpuNUFFT::HostStackOfStarsOperator::prepare(IndType n_coils,
+                                                 IndType kspaceCount,
+                                                 IndType imgCount,
+                                                 int n_threads)
+{
+  IndType sliceCount = sliceOp->getImageDims().count();
+  if (n_coils == 0 || kspaceCount != n_coils * partitions * sampleCount)
+    throw std::invalid_argument(
+        "K-space data does not match the stack-of-stars operator!");
+  if (sens.data != NULL && sens.dim.channels != n_coils)
+    throw std::invalid_argument(
+        "Sensitivity channels do not match the k-space data!");
+  if (imgCount !=
+      (sens.data != NULL ? 1 : n_coils) * partitions * sliceCount)
+    throw std::invalid_argument(
+        "Image data does not match the stack-of-stars operator!");
+
+  hybridData.resize((size_t)n_coils * partitions * sampleCount);
+  if (coilImages.size() < (size_t)n_threads * n_coils * sliceCount)
+    coilImages.resize((size_t)n_threads * n_coils * sliceCount);
+  while (workspaces.size() < (size_t)n_threads)
+    workspaces.push_back(sliceOp->createWorkspace(coilBatchSize));
+
+  IndType bufferSize = partitions + zPlan.getScratchSize();
+  size_t lineThreads = (size_t)getHostThreadCount();
+  if (lineBuffers.size() < lineThreads * bufferSize)
+    lineBuffers.resize(lineThreads * bufferSize);
+}
+
+void gpuNUFFT::HostStackOfStarsOperator::transformPartitions(
+    const DType2 *src, DType2 *dst, IndType n_coils, bool toHybrid,
+    HostFFTDirection dir)
+{
+  int n_threads = getHostThreadCount();
+  IndType bufferSize = partitions + zPlan.getScratchSize();
+  HostPartitionFFTTask task(src, dst, n_coils, partitions, sampleCount,
+                            toHybrid, dir, zPlan, &lineBuffers[0],
+                            bufferSize);
+  hostParallelFor(n_coils * sampleCount, task, n_threads);
+}
+
+void gpuNUFFT::HostStackOfStarsOperator::performGpuNUFFTAdj(
+    Array<DType2> kspaceData, Array<CufftType> &imgData)
+{
+  IndType n_coils = kspaceData.dim.channels;
+  int n_threads = getPartitionThreadCount();
+  prepare(n_coils, kspaceData.count(), imgData.count(), n_threads);
+
+  transformPartitions(kspaceData.data, &hybridData[0], n_coils, true,
+                      HOST_FFT_INVERSE);
+
+  HostPartitionGriddingTask task(sliceOp, workspaces, &hybridData[0],
+                                 &coilImages[0], (DType2 *)imgData.data, sens,
+                                 n_coils, partitions, true);
+  hostParallelFor(partitions, task, n_threads);
+}
+
+gpuNUFFT::Array<CufftType>
+gpuNUFFT::HostStackOfStarsOperator::performGpuNUFFTAdj(
+    Array<DType2> kspaceData)
+{
+  Array<CufftType> imgData;
+  imgData.dim = imgDims;
+  imgData.dim.channels = sens.data != NULL ? 1 : kspaceData.dim.channels;
+  imgData.data = (CufftType *)calloc(imgData.count(), sizeof(CufftType));
+  if (imgData.data == NULL)
+    throw std::runtime_error("Allocation of stack-of-stars image failed!");
+  try
+  {
+    performGpuNUFFTAdj(kspaceData, imgData);
+  }
+  catch (...)
+  {
+    free(imgData.data);
+    throw;
+  }
+  return imgData;
+}
+
+void gpuNUFFT::HostStackOfStarsOperator::performForwardGpuNUFFT(
+    Array<DType2> imgData, Array<CufftType> &kspaceData)
+{
+  IndType n_coils = kspaceData.dim.channels;
+  int n_threads = getPartitionThreadCount();
+  prepare(n_coils, kspaceData.count(), imgData.count(), n_threads);
+
+  HostPartitionGriddingTask task(sliceOp, workspaces, &hybridData[0],
+                                 &coilImages[0], imgData.data, sens, n_coils,
+                                 partitions, false);
+  hostParallelFor(partitions, task, n_threads);
+
+  transformPartitions(&hybridData[0], (DType2 *)kspaceData.data, n_coils,
+                      false, HOST_FFT_FORWARD);
+}
+
+gpuNUFFT::Array<CufftType>
+gpuNUFFT::HostStackOfStarsOperator::performForwardGpuNUFFT(
+    Array<DType2> imgData)
+{
+  Array<CufftType> kspaceData;
+  kspaceData.dim.length = sampleCount * partitions;
+  kspaceData.dim.channels =
+      sens.data != NULL ? sens.dim.channels : imgData.dim.channels;
+  kspaceData.data =
+      (CufftType *)calloc(kspaceData.count(), sizeof(CufftType));
+  if (kspaceData.data == NULL)
+    throw std::runtime_error("Allocation of stack-of-stars k-space failed!");
+  try
+  {
+    performForwardGpuNUFFT(imgData, kspaceData);
+  }
+  catch (...)
+  {
+    free(kspaceData.data);
+    throw;
+  }
+  return kspaceData;
+}
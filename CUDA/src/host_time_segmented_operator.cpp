@@ -0,0 +1,522 @@
+#include "host_time_segmented_operator.hpp"
+#include "host_parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+// Least squares interpolators b_j = G^-1 r_j per sample with the Cholesky
+// factor G = C C^H, C lower triangular, r_jl = sum_h E_hl exp(-i w_h t_j)
+class HostSegmentInterpolatorTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostSegmentInterpolatorTask(const DType *readoutTimes, IndType sampleCount,
+                              IndType segments,
+                              const std::vector<double> &binFrequencies,
+                              const std::vector<double> &weightedPhases,
+                              const std::vector<double> &cholesky,
+                              double totalWeight, DType2 *interpolators,
+                              std::vector<double> &threadErrors)
+    : readoutTimes(readoutTimes), sampleCount(sampleCount),
+      segments(segments), binFrequencies(binFrequencies),
+      weightedPhases(weightedPhases), cholesky(cholesky),
+      totalWeight(totalWeight), interpolators(interpolators),
+      threadErrors(threadErrors)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    int L = (int)segments;
+    size_t bins = binFrequencies.size();
+    std::vector<double> r(2 * L), z(2 * L), b(2 * L);
+    double maxError = 0.0;
+
+    for (IndType j = begin; j < end; j++)
+    {
+      double t = readoutTimes[j];
+      std::fill(r.begin(), r.end(), 0.0);
+      for (size_t h = 0; h < bins; h++)
+      {
+        double er = std::cos(binFrequencies[h] * t);
+        double ei = -std::sin(binFrequencies[h] * t);
+        const double *E = &weightedPhases[2 * h * L];
+        for (int l = 0; l < L; l++)
+        {
+          r[2 * l] += E[2 * l] * er - E[2 * l + 1] * ei;
+          r[2 * l + 1] += E[2 * l] * ei + E[2 * l + 1] * er;
+        }
+      }
+
+      // C z = r
+      for (int i = 0; i < L; i++)
+      {
+        double zr = r[2 * i], zi = r[2 * i + 1];
+        for (int k = 0; k < i; k++)
+        {
+          double cr = cholesky[2 * (i * L + k)];
+          double ci = cholesky[2 * (i * L + k) + 1];
+          zr -= cr * z[2 * k] - ci * z[2 * k + 1];
+          zi -= cr * z[2 * k + 1] + ci * z[2 * k];
+        }
+        double d = cholesky[2 * (i * L + i)];
+        z[2 * i] = zr / d;
+        z[2 * i + 1] = zi / d;
+      }
+      // C^H b = z
+      for (int i = L - 1; i >= 0; i--)
+      {
+        double br = z[2 * i], bi = z[2 * i + 1];
+        for (int k = i + 1; k < L; k++)
+        {
+          double cr = cholesky[2 * (k * L + i)];
+          double ci = -cholesky[2 * (k * L + i) + 1];
+          br -= cr * b[2 * k] - ci * b[2 * k + 1];
+          bi -= cr * b[2 * k + 1] + ci * b[2 * k];
+        }
+        double d = cholesky[2 * (i * L + i)];
+        b[2 * i] = br / d;
+        b[2 * i + 1] = bi / d;
+      }
+
+      // residual sum_h w_h |e_h - A b|^2 = W - Re(r^H b) for G b = r
+      double fit = 0.0;
+      for (int l = 0; l < L; l++)
+      {
+        fit += r[2 * l] * b[2 * l] + r[2 * l + 1] * b[2 * l + 1];
+        interpolators[l * sampleCount + j].x = (DType)b[2 * l];
+        interpolators[l * sampleCount + j].y = (DType)b[2 * l + 1];
+      }
+      maxError = std::max(maxError, (totalWeight - fit) / totalWeight);
+    }
+    threadErrors[threadId] = std::max(threadErrors[threadId], maxError);
+  }
+
+ private:
+  const DType *readoutTimes;
+  IndType sampleCount;
+  IndType segments;
+  const std::vector<double> &binFrequencies;
+  const std::vector<double> &weightedPhases;
+  const std::vector<double> &cholesky;
+  double totalWeight;
+  DType2 *interpolators;
+  std::vector<double> &threadErrors;
+};
+
+// k-space side of one coil: conj(b_l) y of all segments (adjoint) resp.
+// y = sum_l b_l y_l (forward)
+class HostSegmentSampleTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostSegmentSampleTask(DType2 *data, DType2 *segmentData,
+                        const DType2 *interpolators, IndType sampleCount,
+                        IndType segments, bool adjoint)
+    : data(data), segmentData(segmentData), interpolators(interpolators),
+      sampleCount(sampleCount), segments(segments), adjoint(adjoint)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    if (adjoint)
+    {
+      for (IndType l = 0; l < segments; l++)
+      {
+        const DType2 *b = interpolators + l * sampleCount;
+        DType2 *out = segmentData + l * sampleCount;
+        for (IndType j = begin; j < end; j++)
+        {
+          out[j].x = b[j].x * data[j].x + b[j].y * data[j].y;
+          out[j].y = b[j].x * data[j].y - b[j].y * data[j].x;
+        }
+      }
+      return;
+    }
+    for (IndType j = begin; j < end; j++)
+    {
+      DType2 sum;
+      sum.x = (DType)0.0;
+      sum.y = (DType)0.0;
+      for (IndType l = 0; l < segments; l++)
+      {
+        DType2 b = interpolators[l * sampleCount + j];
+        DType2 v = segmentData[l * sampleCount + j];
+        sum.x += b.x * v.x - b.y * v.y;
+        sum.y += b.x * v.y + b.y * v.x;
+      }
+      data[j] = sum;
+    }
+  }
+
+ private:
+  DType2 *data;
+  DType2 *segmentData;
+  const DType2 *interpolators;
+  IndType sampleCount;
+  IndType segments;
+  bool adjoint;
+};
+
+// image side of one coil: sum_l exp(i w tau_l) I_l, multiplied by conj(S)
+// and accumulated if sensitivities are present (adjoint) resp.
+// I_l = exp(-i w tau_l) S img (forward)
+class HostSegmentImageTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostSegmentImageTask(DType2 *imgData, DType2 *segmentImages,
+                       const DType2 *phases, const DType2 *sens,
+                       IndType imgCount, IndType segments, bool adjoint)
+    : imgData(imgData), segmentImages(segmentImages), phases(phases),
+      sens(sens), imgCount(imgCount), segments(segments), adjoint(adjoint)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType i = begin; i < end; i++)
+    {
+      if (adjoint)
+      {
+        DType2 acc;
+        acc.x = (DType)0.0;
+        acc.y = (DType)0.0;
+        for (IndType l = 0; l < segments; l++)
+        {
+          DType2 p = phases[l * imgCount + i];
+          DType2 v = segmentImages[l * imgCount + i];
+          acc.x += p.x * v.x - p.y * v.y;
+          acc.y += p.x * v.y + p.y * v.x;
+        }
+        if (sens != NULL)
+        {
+          DType2 s = sens[i];
+          imgData[i].x += s.x * acc.x + s.y * acc.y;
+          imgData[i].y += s.x * acc.y - s.y * acc.x;
+        }
+        else
+          imgData[i] = acc;
+        continue;
+      }
+
+      DType2 v = imgData[i];
+      if (sens != NULL)
+      {
+        DType2 s = sens[i];
+        v.x = s.x * imgData[i].x - s.y * imgData[i].y;
+        v.y = s.x * imgData[i].y + s.y * imgData[i].x;
+      }
+      for (IndType l = 0; l < segments; l++)
+      {
+        DType2 p = phases[l * imgCount + i];
+        segmentImages[l * imgCount + i].x = p.x * v.x + p.y * v.y;
+        segmentImages[l * imgCount + i].y = p.x * v.y - p.y * v.x;
+      }
+    }
+  }
+
+ private:
+  DType2 *imgData;
+  DType2 *segmentImages;
+  const DType2 *phases;
+  const DType2 *sens;
+  IndType imgCount;
+  IndType segments;
+  bool adjoint;
+};
+}
+
+gpuNUFFT::HostTimeSegmentedOperator::HostTimeSegmentedOperator(
+    HostGpuNUFFTOperator *gpuNUFFTOp, Array<DType2> sensData,
+    Array<DType> fieldMap, Array<DType> readoutTimes, IndType segments)
+  : gpuNUFFTOp(gpuNUFFTOp), segments(segments),
+    sampleCount(gpuNUFFTOp->getKSpaceTraj().count()),
+    imgDims(gpuNUFFTOp->getImageDims()), sens(sensData), fieldMap(fieldMap),
+    interpolationError(0.0)
+{
+  if (gpuNUFFTOp->applySensData() || segments == 0 ||
+      fieldMap.data == NULL || fieldMap.count() != imgDims.count() ||
+      readoutTimes.data == NULL || readoutTimes.count() != sampleCount)
+  {
+    delete gpuNUFFTOp;
+    throw std::invalid_argument(
+        "Time segmentation requires an operator without sensitivities, a "
+        "field map per pixel, a readout time per sample and at least one "
+        "segment!");
+  }
+  if (!applySensData())
+    sens.data = NULL;
+
+  // the segments of a coil are gridded at once
+  gpuNUFFTOp->setCoilBatchSize((int)segments);
+
+  try
+  {
+    initInterpolators(readoutTimes);
+  }
+  catch (...)
+  {
+    delete gpuNUFFTOp;
+    throw;
+  }
+}
+
+gpuNUFFT::HostTimeSegmentedOperator::~HostTimeSegmentedOperator()
+{
+  delete gpuNUFFTOp;
+}
+
+void gpuNUFFT::HostTimeSegmentedOperator::initInterpolators(
+    Array<DType> readoutTimes)
+{
+  int L = (int)segments;
+  IndType imgCount = imgDims.count();
+
+  double tMin = readoutTimes.data[0], tMax = readoutTimes.data[0];
+  for (IndType j = 1; j < sampleCount; j++)
+  {
+    tMin = std::min(tMin, (double)readoutTimes.data[j]);
+    tMax = std::max(tMax, (double)readoutTimes.data[j]);
+  }
+  segmentTimes.resize(L);
+  for (int l = 0; l < L; l++)
+    segmentTimes[l] = L > 1 ? tMin + l * (tMax - tMin) / (L - 1)
+                            : 0.5 * (tMin + tMax);
+
+  // histogram of the field map, empty bins are dropped
+  double wMin = fieldMap.data[0], wMax = fieldMap.data[0];
+  for (IndType i = 1; i < imgCount; i++)
+  {
+    wMin = std::min(wMin, (double)fieldMap.data[i]);
+    wMax = std::max(wMax, (double)fieldMap.data[i]);
+  }
+  int bins = wMax > wMin ? HOST_TIME_SEGMENT_HISTOGRAM_BINS : 1;
+  double binWidth = (wMax - wMin) / bins;
+  std::vector<double> counts(bins, 0.0);
+  for (IndType i = 0; i < imgCount; i++)
+  {
+    int h = bins > 1 ? (int)((fieldMap.data[i] - wMin) / binWidth) : 0;
+    counts[std::min(h, bins - 1)] += 1.0;
+  }
+  std::vector<double> binFrequencies, binWeights;
+  for (int h = 0; h < bins; h++)
+    if (counts[h] > 0.0)
+    {
+      binFrequencies.push_back(wMin + (h + 0.5) * binWidth);
+      binWeights.push_back(counts[h]);
+    }
+  double totalWeight = (double)imgCount;
+
+  // E_hl = w_h exp(i w_h tau_l) and G = sum_h w_h exp(i w_h (tau_l - tau_m))
+  size_t H = binFrequencies.size();
+  std::vector<double> weightedPhases(2 * H * L);
+  for (size_t h = 0; h < H; h++)
+    for (int l = 0; l < L; l++)
+    {
+      double phi = binFrequencies[h] * segmentTimes[l];
+      weightedPhases[2 * (h * L + l)] = binWeights[h] * std::cos(phi);
+      weightedPhases[2 * (h * L + l) + 1] = binWeights[h] * std::sin(phi);
+    }
+  std::vector<double> G(2 * L * L, 0.0);
+  for (int l = 0; l < L; l++)
+    for (int m = 0; m < L; m++)
+      for (size_t h = 0; h < H; h++)
+      {
+        double phi = binFrequencies[h] * (segmentTimes[l] - segmentTimes[m]);
+        G[2 * (l * L + m)] += binWeights[h] * std::cos(phi);
+        G[2 * (l * L + m) + 1] += binWeights[h] * std::sin(phi);
+      }
+
+  // G is singular for more segments than distinct frequencies, the small
+  // ridge selects the minimum norm interpolators
+  for (int l = 0; l < L; l++)
+    G[2 * (l * L + l)] += 1e-9 * totalWeight;
+
+  // Cholesky factorization G = C C^H
+  std::vector<double> C(2 * L * L, 0.0);
+  for (int j = 0; j < L; j++)
+  {
+    double d = G[2 * (j * L + j)];
+    for (int k = 0; k < j; k++)
+      d -= C[2 * (j * L + k)] * C[2 * (j * L + k)] +
+           C[2 * (j * L + k) + 1] * C[2 * (j * L + k) + 1];
+    if (d <= 0.0)
+      throw std::runtime_error("Time segmentation Gram matrix is singular!");
+    d = std::sqrt(d);
+    C[2 * (j * L + j)] = d;
+    for (int i = j + 1; i < L; i++)
+    {
+      // G_ij - sum_k C_ik conj(C_jk)
+      double re = G[2 * (i * L + j)], im = G[2 * (i * L + j) + 1];
+      for (int k = 0; k < j; k++)
+      {
+        double ar = C[2 * (i * L + k)], ai = C[2 * (i * L + k) + 1];
+        double br = C[2 * (j * L + k)], bi = C[2 * (j * L + k) + 1];
+        re -= ar * br + ai * bi;
+        im -= ai * br - ar * bi;
+      }
+      C[2 * (i * L + j)] = re / d;
+      C[2 * (i * L + j) + 1] = im / d;
+    }
+  }
+
+  interpolators.resize((size_t)L * sampleCount);
+  int n_threads = getHostThreadCount();
+  std::vector<double> threadErrors(n_threads, 0.0);
+  HostSegmentInterpolatorTask task(readoutTimes.data, sampleCount, segments,
+                                   binFrequencies, weightedPhases, C,
+                                   totalWeight, &interpolators[0],
+                                   threadErrors);
+  hostParallelFor(sampleCount, task, n_threads);
+  double maxError = *std::max_element(threadErrors.begin(),
+                                      threadErrors.end());
+  interpolationError = std::sqrt(std::max(maxError, 0.0));
+
+  phases.resize((size_t)L * imgCount);
+  for (int l = 0; l < L; l++)
+    for (IndType i = 0; i < imgCount; i++)
+    {
+      double phi = fieldMap.data[i] * segmentTimes[l];
+      phases[l * imgCount + i].x = (DType)std::cos(phi);
+      phases[l * imgCount + i].y = (DType)std::sin(phi);
+    }
+}
+
+void gpuNUFFT::HostTimeSegmentedOperator::validate(IndType n_coils,
+                                                   IndType kspaceCount,
+                                                   IndType imgCount)
+{
+  if (n_coils == 0 || kspaceCount != n_coils * sampleCount)
+    throw std::invalid_argument(
+        "K-space data does not match the time-segmented operator!");
+  if (sens.data != NULL && sens.dim.channels != n_coils)
+    throw std::invalid_argument(
+        "Sensitivity channels do not match the k-space data!");
+  if (imgCount != (sens.data != NULL ? 1 : n_coils) * imgDims.count())
+    throw std::invalid_argument(
+        "Image data does not match the time-segmented operator!");
+
+  segmentData.resize((size_t)segments * sampleCount);
+  segmentImages.resize((size_t)segments * imgDims.count());
+}
+
+void gpuNUFFT::HostTimeSegmentedOperator::performGpuNUFFTAdj(
+    Array<DType2> kspaceData, Array<CufftType> &imgData)
+{
+  IndType n_coils = kspaceData.dim.channels;
+  IndType imgCount = imgDims.count();
+  validate(n_coils, kspaceData.count(), imgData.count());
+
+  Array<DType2> segmentArray;
+  segmentArray.data = &segmentData[0];
+  segmentArray.dim.length = sampleCount;
+  segmentArray.dim.channels = segments;
+  Array<CufftType> segmentImgArray;
+  segmentImgArray.data = (CufftType *)&segmentImages[0];
+  segmentImgArray.dim = imgDims;
+  segmentImgArray.dim.channels = segments;
+
+  if (sens.data != NULL)
+    memset(imgData.data, 0, imgCount * sizeof(CufftType));
+
+  for (IndType coil = 0; coil < n_coils; coil++)
+  {
+    HostSegmentSampleTask sampleTask(kspaceData.data + coil * sampleCount,
+                                     &segmentData[0], &interpolators[0],
+                                     sampleCount, segments, true);
+    hostParallelFor(sampleCount, sampleTask);
+
+    gpuNUFFTOp->performGpuNUFFTAdj(segmentArray, segmentImgArray);
+
+    HostSegmentImageTask imageTask(
+        (DType2 *)imgData.data + (sens.data != NULL ? 0 : coil * imgCount),
+        &segmentImages[0], &phases[0],
+        sens.data != NULL ? sens.data + coil * imgCount : NULL, imgCount,
+        segments, true);
+    hostParallelFor(imgCount, imageTask);
+  }
+}
+
+gpuNUFFT::Array<CufftType>
+gpuNUFFT::HostTimeSegmentedOperator::performGpuNUFFTAdj(
+    Array<DType2> kspaceData)
+{
+  Array<CufftType> imgData;
+  imgData.dim = imgDims;
+  imgData.dim.channels = sens.data != NULL ? 1 : kspaceData.dim.channels;
+  imgData.data = (CufftType *)calloc(imgData.count(), sizeof(CufftType));
+  if (imgData.data == NULL)
+    throw std::runtime_error("Allocation of time-segmented image failed!");
+  try
+  {
+    performGpuNUFFTAdj(kspaceData, imgData);
+  }
+  catch (...)
+  {
+    free(imgData.data);
+    throw;
+  }
+  return imgData;
+}
+
+void gpuNUFFT::HostTimeSegmentedOperator::performForwardGpuNUFFT(
+    Array<DType2> imgData, Array<CufftType> &kspaceData)
+{
+  IndType n_coils = kspaceData.dim.channels;
+  IndType imgCount = imgDims.count();
+  validate(n_coils, kspaceData.count(), imgData.count());
+
+  Array<DType2> segmentImgArray;
+  segmentImgArray.data = &segmentImages[0];
+  segmentImgArray.dim = imgDims;
+  segmentImgArray.dim.channels = segments;
+  Array<CufftType> segmentArray;
+  segmentArray.data = (CufftType *)&segmentData[0];
+  segmentArray.dim.length = sampleCount;
+  segmentArray.dim.channels = segments;
+
+  for (IndType coil = 0; coil < n_coils; coil++)
+  {
+    HostSegmentImageTask imageTask(
+        imgData.data + (sens.data != NULL ? 0 : coil * imgCount),
+        &segmentImages[0], &phases[0],
+        sens.data != NULL ? sens.data + coil * imgCount : NULL, imgCount,
+        segments, false);
+    hostParallelFor(imgCount, imageTask);
+
+    gpuNUFFTOp->performForwardGpuNUFFT(segmentImgArray, segmentArray);
+
+    HostSegmentSampleTask sampleTask(
+        (DType2 *)kspaceData.data + coil * sampleCount, &segmentData[0],
+        &interpolators[0], sampleCount, segments, false);
+    hostParallelFor(sampleCount, sampleTask);
+  }
+}
+
+gpuNUFFT::Array<CufftType>
+gpuNUFFT::HostTimeSegmentedOperator::performForwardGpuNUFFT(
+    Array<DType2> imgData)
+{
+  Array<CufftType> kspaceData;
+  kspaceData.dim.length = sampleCount;
+  kspaceData.dim.channels =
+      sens.data != NULL ? sens.dim.channels : imgData.dim.channels;
+  kspaceData.data =
+      (CufftType *)calloc(kspaceData.count(), sizeof(CufftType));
+  if (kspaceData.data == NULL)
+    throw std::runtime_error("Allocation of time-segmented k-space failed!");
+  try
+  {
+    performForwardGpuNUFFT(imgData, kspaceData);
+  }
+  catch (...)
+  {
+    free(kspaceData.data);
+    throw;
+  }
+  return kspaceData;
+}
@@ -0,0 +1,259 @@
+#include "host_toeplitz_operator.hpp"
+#include "gpuNUFFT_operator_factory.hpp"
+#include "host_parallel.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+// multiply the padded grid elementwise with the transformed PSF
+class HostToeplitzMultiplyTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  HostToeplitzMultiplyTask(CufftType *data, const CufftType *psf_fft)
+    : data(data), psf_fft(psf_fft)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType i = begin; i < end; i++)
+    {
+      CufftType v = data[i];
+      data[i].x = v.x * psf_fft[i].x - v.y * psf_fft[i].y;
+      data[i].y = v.x * psf_fft[i].y + v.y * psf_fft[i].x;
+    }
+  }
+
+ private:
+  CufftType *data;
+  const CufftType *psf_fft;
+};
+}
+
+gpuNUFFT::HostToeplitzNormalOperator::HostToeplitzNormalOperator(
+    GpuNUFFTOperator *gpuNUFFTOp)
+  : imgDims(gpuNUFFTOp->getImageDims()),
+    padDims(gpuNUFFTOp->getImageDims() * 2.0), sens(gpuNUFFTOp->getSens()),
+    fftPlan(gpuNUFFTOp->getImageDims() * 2.0), kernel_fft(NULL), padded(NULL)
+{
+  if (!gpuNUFFTOp->applySensData())
+    sens.data = NULL;
+
+  IndType padCount = padDims.count();
+  kernel_fft = (CufftType *)malloc(padCount * sizeof(CufftType));
+  padded = (CufftType *)malloc(padCount * sizeof(CufftType));
+  if (kernel_fft == NULL || padded == NULL)
+  {
+    free(kernel_fft);
+    free(padded);
+    throw std::runtime_error("Allocation of Toeplitz PSF failed!");
+  }
+
+  try
+  {
+    initKernel(gpuNUFFTOp);
+  }
+  catch (...)
+  {
+    free(kernel_fft);
+    free(padded);
+    throw;
+  }
+}
+
+gpuNUFFT::HostToeplitzNormalOperator::~HostToeplitzNormalOperator()
+{
+  free(kernel_fft);
+  free(padded);
+}
+
+void gpuNUFFT::HostToeplitzNormalOperator::initKernel(
+    GpuNUFFTOperator *gpuNUFFTOp)
+{
+  // The operator stores trajectory and density in sector order, which is as
+  // good as any other order for the PSF.
+  IndType dataCount = gpuNUFFTOp->getDataIndices().count();
+  Array<DType> kSpaceTraj = gpuNUFFTOp->getKSpaceTraj();
+  kSpaceTraj.dim = Dimensions();
+  kSpaceTraj.dim.length = dataCount;
+
+  Array<DType> densData;
+  if (gpuNUFFTOp->applyDensComp())
+  {
+    densData = gpuNUFFTOp->getDens();
+    densData.dim = Dimensions();
+    densData.dim.length = dataCount;
+  }
+
+  // The adjoint operator applies sqrt(dens) itself, thus sqrt(dens) as input
+  // yields the sum of dens weighted exponentials.
+  std::vector<DType2> unitData(dataCount);
+  for (IndType i = 0; i < dataCount; i++)
+  {
+    unitData[i].x = densData.data != NULL ? std::sqrt(densData.data[i])
+                                          : (DType)1.0;
+    unitData[i].y = (DType)0.0;
+  }
+  Array<DType2> dataArray;
+  dataArray.data = &unitData[0];
+  dataArray.dim.length = dataCount;
+
+  GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  Dimensions psfDims = padDims;
+  GpuNUFFTOperator *psfOp =
+      densData.data != NULL
+          ? factory.createGpuNUFFTOperator(
+                kSpaceTraj, densData, gpuNUFFTOp->getKernelWidth(),
+                gpuNUFFTOp->getSectorWidth(), gpuNUFFTOp->getOsf(), psfDims)
+          : factory.createGpuNUFFTOperator(
+                kSpaceTraj, gpuNUFFTOp->getKernelWidth(),
+                gpuNUFFTOp->getSectorWidth(), gpuNUFFTOp->getOsf(), psfDims);
+
+  Array<CufftType> psf;
+  try
+  {
+    psf = psfOp->performGpuNUFFTAdj(dataArray);
+  }
+  catch (...)
+  {
+    delete psfOp;
+    throw;
+  }
+  delete psfOp;
+
+  // psf[j] = 1/sqrt(|2N|) sum_m dens_m exp(2 pi i k_m (j - N)), j in [0,2N)
+  // whereas the normal operator convolves with the kernel
+  // T[d] = 1/|N| sum_m dens_m exp(2 pi i k_m d), d in (-N,N).
+  // Wrapping d periodically onto [0,2N) shifts psf by N along every axis.
+  IndType imgCount = imgDims.count();
+  IndType padCount = padDims.count();
+  IndType pw = padDims.width;
+  IndType ph = DEFAULT_VALUE(padDims.height);
+  IndType pd = DEFAULT_VALUE(padDims.depth);
+  IndType sw = pw / 2;
+  IndType sh = ph > 1 ? ph / 2 : 0;
+  IndType sd = pd > 1 ? pd / 2 : 0;
+
+  // scaling of psf, 1/|N| of the convolution kernel and the missing
+  // normalization 1/|2N| of the inverse FFT in apply
+  DType scale = (DType)(std::sqrt((double)padCount) / (double)imgCount /
+                        (double)padCount);
+
+  for (IndType z = 0; z < pd; z++)
+    for (IndType y = 0; y < ph; y++)
+      for (IndType x = 0; x < pw; x++)
+      {
+        IndType src = ((z + sd) % pd) * pw * ph + ((y + sh) % ph) * pw +
+                      (x + sw) % pw;
+        IndType dst = z * pw * ph + y * pw + x;
+        kernel_fft[dst].x = psf.data[src].x * scale;
+        kernel_fft[dst].y = psf.data[src].y * scale;
+      }
+  free(psf.data);
+
+  fftPlan.execute(kernel_fft, HOST_FFT_FORWARD);
+}
+
+void gpuNUFFT::HostToeplitzNormalOperator::convolve(DType2 *x,
+                                                    DType2 *sensData,
+                                                    CufftType *out)
+{
+  IndType padCount = padDims.count();
+  IndType w = imgDims.width;
+  IndType h = DEFAULT_VALUE(imgDims.height);
+  IndType d = DEFAULT_VALUE(imgDims.depth);
+  IndType pw = padDims.width;
+  IndType ph = DEFAULT_VALUE(padDims.height);
+
+  // zero padding, image placed at the origin of the padded grid
+  memset(padded, 0, padCount * sizeof(CufftType));
+  for (IndType z = 0; z < d; z++)
+    for (IndType y = 0; y < h; y++)
+    {
+      IndType img = (z * h + y) * w;
+      CufftType *dst = padded + (z * ph + y) * pw;
+      for (IndType i = 0; i < w; i++)
+      {
+        DType2 v = x[img + i];
+        if (sensData != NULL)
+        {
+          DType2 s = sensData[img + i];
+          dst[i].x = v.x * s.x - v.y * s.y;
+          dst[i].y = v.x * s.y + v.y * s.x;
+        }
+        else
+          dst[i] = v;
+      }
+    }
+
+  fftPlan.execute(padded, HOST_FFT_FORWARD);
+  HostToeplitzMultiplyTask multiplyTask(padded, kernel_fft);
+  hostParallelFor(padCount, multiplyTask);
+  fftPlan.execute(padded, HOST_FFT_INVERSE);
+
+  // crop and accumulate, multiplied with the conjugate sensitivities
+  for (IndType z = 0; z < d; z++)
+    for (IndType y = 0; y < h; y++)
+    {
+      IndType img = (z * h + y) * w;
+      const CufftType *src = padded + (z * ph + y) * pw;
+      for (IndType i = 0; i < w; i++)
+      {
+        CufftType v = src[i];
+        if (sensData != NULL)
+        {
+          DType2 s = sensData[img + i];
+          out[img + i].x += v.x * s.x + v.y * s.y;
+          out[img + i].y += v.y * s.x - v.x * s.y;
+        }
+        else
+        {
+          out[img + i].x += v.x;
+          out[img + i].y += v.y;
+        }
+      }
+    }
+}
+
+void gpuNUFFT::HostToeplitzNormalOperator::apply(Array<DType2> imgData,
+                                                 Array<CufftType> &outData)
+{
+  IndType imgCount = imgDims.count();
+  if (imgData.data == NULL || outData.data == NULL)
+    throw std::invalid_argument("Toeplitz operator: missing image data!");
+
+  memset(outData.data, 0, imgCount * sizeof(CufftType));
+
+  if (sens.data == NULL)
+  {
+    convolve(imgData.data, NULL, outData.data);
+    return;
+  }
+
+  IndType n_coils = sens.count() / imgCount;
+  for (IndType coil = 0; coil < n_coils; coil++)
+    convolve(imgData.data, sens.data + coil * imgCount, outData.data);
+}
+
+gpuNUFFT::Array<CufftType>
+gpuNUFFT::HostToeplitzNormalOperator::apply(Array<DType2> imgData)
+{
+  Array<CufftType> outData;
+  outData.dim = imgDims;
+  outData.data = (CufftType *)calloc(imgDims.count(), sizeof(CufftType));
+  if (outData.data == NULL)
+    throw std::runtime_error("Allocation of Toeplitz output failed!");
+  apply(imgData, outData);
+  return outData;
+}
+
+size_t gpuNUFFT::HostToeplitzNormalOperator::getAllocatedBytes()
+{
+  return 2 * (size_t)padDims.count() * sizeof(CufftType);
+}
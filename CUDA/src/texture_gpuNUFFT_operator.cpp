@@ -3,30 +3,21 @@
 
 void gpuNUFFT::TextureGpuNUFFTOperator::initKernel()
 {
-  IndType kernelSize = (interpolationType > 1)
-                           ? calculateKernelSizeLinInt(osf, kernelWidth)
-                           : calculateGrid3KernelSize(osf, kernelWidth);
+  IndType kernelSize = lookupTableSize > 0
+                           ? lookupTableSize
+                           : (interpolationType > 1)
+                                 ? calculateKernelSizeLinInt(osf, kernelWidth)
+                                 : calculateGrid3KernelSize(osf, kernelWidth);
+  int dimensionCount = (interpolationType == TEXTURE2D_LOOKUP)
+                           ? 2
+                           : (interpolationType == TEXTURE3D_LOOKUP) ? 3 : 1;
   this->kernel.dim.width = kernelSize;
-  this->kernel.dim.height = interpolationType > 1 ? kernelSize : 1;
-  this->kernel.dim.depth = interpolationType > 2 ? kernelSize : 1;
-  if (this->kernel.data != NULL)
-    free(this->kernel.data);
-  this->kernel.data = (DType *)calloc(this->kernel.count(), sizeof(DType));
-
-  switch (interpolationType)
-  {
-  case TEXTURE_LOOKUP:
-    load1DKernel(this->kernel.data, (int)kernelSize, (int)kernelWidth, osf);
-    break;
-  case TEXTURE2D_LOOKUP:
-    load2DKernel(this->kernel.data, (int)kernelSize, (int)kernelWidth, osf);
-    break;
-  case TEXTURE3D_LOOKUP:
-    load3DKernel(this->kernel.data, (int)kernelSize, (int)kernelWidth, osf);
-    break;
-  default:
-    load1DKernel(this->kernel.data, (int)kernelSize, (int)kernelWidth, osf);
-  }
+  this->kernel.dim.height = dimensionCount > 1 ? kernelSize : 1;
+  this->kernel.dim.depth = dimensionCount > 2 ? kernelSize : 1;
+  const DType *table = KernelLookupTableCache::acquire(
+      kernelWidth, osf, kernelSize, dimensionCount, kernelType);
+  KernelLookupTableCache::release(this->kernel.data);
+  this->kernel.data = const_cast<DType *>(table);
 }
 
 const char *gpuNUFFT::TextureGpuNUFFTOperator::getInterpolationTypeName()
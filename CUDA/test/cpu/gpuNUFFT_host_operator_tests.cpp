@@ -0,0 +1,2870 @@
+#include <limits.h>
+
+#include "gtest/gtest.h"
+#include "gpuNUFFT_operator_factory.hpp"
+#include "host_gpuNUFFT_operator.hpp"
+#include "host_gpuNUFFT_kernels.hpp"
+#include "gpuNUFFT_mapped_input.hpp"
+#include "host_toeplitz_operator.hpp"
+#include "host_cg_sense_solver.hpp"
+#include "host_coil_compression.hpp"
+#include "host_stack_operator.hpp"
+#include "host_time_segmented_operator.hpp"
+#include "host_parallel.hpp"
+#include "host_nudft.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#define EPS 0.0001
+
+// pseudo random trajectory in [-0.5,0.5)
+static std::vector<DType> createTestTrajectory(IndType coordCnt, int dimCount)
+{
+  std::vector<DType> coords(coordCnt * dimCount);
+  unsigned seed = 42;
+  for (unsigned i = 0; i < coords.size(); i++)
+  {
+    seed = seed * 1103515245u + 12345u;
+    coords[i] = (DType)((seed >> 8) % 10000) / (DType)10000.0 - (DType)0.5;
+  }
+  return coords;
+}
+
+static std::vector<DType2> createTestData(IndType count)
+{
+  std::vector<DType2> data(count);
+  for (unsigned i = 0; i < count; i++)
+  {
+    data[i].x = (DType)std::cos(0.37 * i);
+    data[i].y = (DType)std::sin(0.11 * i);
+  }
+  return data;
+}
+
+static double relativeError(const CufftType *a, const CufftType *b,
+                            IndType count)
+{
+  double diff = 0.0;
+  double norm = 0.0;
+  for (IndType i = 0; i < count; i++)
+  {
+    double dx = a[i].x - b[i].x;
+    double dy = a[i].y - b[i].y;
+    diff += dx * dx + dy * dy;
+    norm += (double)b[i].x * b[i].x + (double)b[i].y * b[i].y;
+  }
+  return std::sqrt(diff / norm);
+}
+
+template <typename T>
+static std::string writeTempFile(const T *data, size_t count)
+{
+  char fileName[] = "/tmp/gpuNUFFT_test_XXXXXX";
+  int fd = mkstemp(fileName);
+  EXPECT_TRUE(fd >= 0);
+  FILE *f = fdopen(fd, "wb");
+  fwrite(data, sizeof(T), count, f);
+  fclose(f);
+  return std::string(fileName);
+}
+
+TEST(HostOperatorTest, TestAdjointSingleCenterSample)
+{
+  IndType imageWidth = 16;
+  DType osf = 1.5;
+  IndType sectorWidth = 8;
+  IndType kernelWidth = 3;
+
+  DType coords[2] = { 0, 0 };
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = coords;
+  kSpaceTraj.dim.length = 1;
+
+  DType2 sample[1] = { { 1, 0 } };
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = sample;
+  dataArray.dim.length = 1;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, kernelWidth, sectorWidth, osf, imgDims);
+
+  EXPECT_EQ(gpuNUFFT::HOST, gpuNUFFTOp->getType());
+
+  gpuNUFFT::Array<CufftType> imgArray =
+      gpuNUFFTOp->performGpuNUFFTAdj(dataArray);
+
+  // deapodization exactly compensates the kernel of a centered sample
+  DType expected = (DType)1.0 / std::sqrt((DType)imgDims.count());
+  for (unsigned i = 0; i < imgArray.count(); i++)
+  {
+    DType absVal = std::sqrt(imgArray.data[i].x * imgArray.data[i].x +
+                             imgArray.data[i].y * imgArray.data[i].y);
+    EXPECT_NEAR(expected, absVal, EPS);
+  }
+
+  free(imgArray.data);
+  delete gpuNUFFTOp;
+}
+
+TEST(HostOperatorTest, TestForwardAdjointInnerProduct)
+{
+  IndType imageWidth = 16;
+  DType osf = 2.0;
+  IndType sectorWidth = 8;
+  IndType kernelWidth = 3;
+  IndType coordCnt = 200;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 3);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth, imageWidth);
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, kernelWidth, sectorWidth, osf, imgDims);
+
+  std::vector<DType2> x = createTestData(imgDims.count());
+  std::vector<DType2> y = createTestData(coordCnt);
+
+  gpuNUFFT::Array<DType2> xArray;
+  xArray.data = &x[0];
+  xArray.dim = imgDims;
+  gpuNUFFT::Array<DType2> yArray;
+  yArray.data = &y[0];
+  yArray.dim.length = coordCnt;
+
+  gpuNUFFT::Array<CufftType> Ax = gpuNUFFTOp->performForwardGpuNUFFT(xArray);
+  gpuNUFFT::Array<CufftType> AHy = gpuNUFFTOp->performGpuNUFFTAdj(yArray);
+
+  // <Ax,y> == <x,A^H y>
+  double re1 = 0, im1 = 0, re2 = 0, im2 = 0;
+  for (unsigned i = 0; i < coordCnt; i++)
+  {
+    re1 += Ax.data[i].x * y[i].x + Ax.data[i].y * y[i].y;
+    im1 += Ax.data[i].y * y[i].x - Ax.data[i].x * y[i].y;
+  }
+  for (unsigned i = 0; i < imgDims.count(); i++)
+  {
+    re2 += x[i].x * AHy.data[i].x + x[i].y * AHy.data[i].y;
+    im2 += x[i].y * AHy.data[i].x - x[i].x * AHy.data[i].y;
+  }
+  double norm = std::sqrt(re1 * re1 + im1 * im1);
+  EXPECT_NEAR(re1 / norm, re2 / norm, 1e-3);
+  EXPECT_NEAR(im1 / norm, im2 / norm, 1e-3);
+
+  free(Ax.data);
+  free(AHy.data);
+  delete gpuNUFFTOp;
+}
+
+TEST(HostOperatorTest, TestMappedInputInvalidFileSize)
+{
+  DType coords[5] = { 0, 0, 0, 0, 0 };
+  DType2 data[2] = { { 1, 0 }, { 1, 0 } };
+  std::string trajFile = writeTempFile(coords, 5);
+  std::string dataFile = writeTempFile(data, 2);
+
+  EXPECT_THROW(gpuNUFFT::MappedInputSource(trajFile, dataFile, 2),
+               std::invalid_argument);
+  EXPECT_THROW(gpuNUFFT::MappedInputSource(trajFile, dataFile, 4),
+               std::invalid_argument);
+
+  unlink(trajFile.c_str());
+  unlink(dataFile.c_str());
+}
+
+TEST(HostOperatorTest, TestMappedInputMatchesInMemory)
+{
+  IndType imageWidth = 16;
+  DType osf = 1.5;
+  IndType sectorWidth = 8;
+  IndType kernelWidth = 3;
+  IndType coordCnt = 300;
+  IndType coilCnt = 3;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  std::vector<DType> dens(coordCnt);
+  for (unsigned i = 0; i < coordCnt; i++)
+    dens[i] = (DType)(1.0 + i % 5);
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+
+  std::string trajFile = writeTempFile(&coords[0], coords.size());
+  std::string densFile = writeTempFile(&dens[0], dens.size());
+  std::string dataFile = writeTempFile(&data[0], data.size());
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+  gpuNUFFT::GpuNUFFTOperator *refOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, densArray, kernelWidth, sectorWidth, osf, imgDims);
+
+  gpuNUFFT::MappedInputSource input(trajFile, dataFile, 2, densFile);
+  EXPECT_EQ(coordCnt, input.getSampleCount());
+  EXPECT_EQ(coilCnt, input.getCoilCount());
+  // small blocks in order to test the block boundaries
+  input.setChunkSize(7);
+
+  gpuNUFFT::GpuNUFFTOperator *mappedOp = factory.createGpuNUFFTOperator(
+      input, kernelWidth, sectorWidth, osf, imgDims);
+
+  gpuNUFFT::Array<IndType> refIndices = refOp->getDataIndices();
+  gpuNUFFT::Array<IndType> mappedIndices = mappedOp->getDataIndices();
+  gpuNUFFT::Array<DType> refTraj = refOp->getKSpaceTraj();
+  gpuNUFFT::Array<DType> mappedTraj = mappedOp->getKSpaceTraj();
+  gpuNUFFT::Array<DType> refDens = refOp->getDens();
+  gpuNUFFT::Array<DType> mappedDens = mappedOp->getDens();
+  for (unsigned i = 0; i < coordCnt; i++)
+  {
+    EXPECT_EQ(refIndices.data[i], mappedIndices.data[i]);
+    EXPECT_EQ(refTraj.data[i], mappedTraj.data[i]);
+    EXPECT_EQ(refTraj.data[i + coordCnt], mappedTraj.data[i + coordCnt]);
+    EXPECT_EQ(refDens.data[i], mappedDens.data[i]);
+  }
+
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+
+  gpuNUFFT::Array<CufftType> refImg = refOp->performGpuNUFFTAdj(dataArray);
+  gpuNUFFT::Array<CufftType> mappedImg =
+      static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(mappedOp)
+          ->performGpuNUFFTAdj(input);
+
+  EXPECT_EQ(refImg.count(), mappedImg.count());
+  for (unsigned i = 0; i < refImg.count(); i++)
+  {
+    EXPECT_NEAR(refImg.data[i].x, mappedImg.data[i].x, EPS);
+    EXPECT_NEAR(refImg.data[i].y, mappedImg.data[i].y, EPS);
+  }
+
+  free(refImg.data);
+  free(mappedImg.data);
+  delete refOp;
+  delete mappedOp;
+
+  unlink(trajFile.c_str());
+  unlink(densFile.c_str());
+  unlink(dataFile.c_str());
+}
+
+TEST(HostOperatorTest, TestWorkspaceCoilBatches)
+{
+  IndType imageWidth = 16;
+  DType osf = 1.5;
+  IndType sectorWidth = 8;
+  IndType kernelWidth = 3;
+  IndType coordCnt = 250;
+  IndType coilCnt = 5;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *gpuNUFFTOp =
+      static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(
+          factory.createGpuNUFFTOperator(kSpaceTraj, kernelWidth, sectorWidth,
+                                         osf, imgDims));
+
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+
+  // reference: internal workspace, one coil at a time
+  gpuNUFFT::Array<CufftType> refImg = gpuNUFFTOp->performGpuNUFFTAdj(dataArray);
+
+  std::vector<DType2> img(refImg.count());
+  for (unsigned i = 0; i < img.size(); i++)
+    img[i] = refImg.data[i];
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  imgArray.dim.channels = coilCnt;
+  gpuNUFFT::Array<CufftType> refData =
+      gpuNUFFTOp->performForwardGpuNUFFT(imgArray);
+
+  // caller provided outputs
+  std::vector<CufftType> imgOut(refImg.count());
+  gpuNUFFT::Array<CufftType> imgOutArray;
+  imgOutArray.data = &imgOut[0];
+  imgOutArray.dim = refImg.dim;
+  std::vector<CufftType> dataOut(refData.count());
+  gpuNUFFT::Array<CufftType> dataOutArray;
+  dataOutArray.data = &dataOut[0];
+  dataOutArray.dim = refData.dim;
+
+  for (int batch = 1; batch <= 3; batch++)
+  {
+    gpuNUFFT::HostGpuNUFFTWorkspace *ws = gpuNUFFTOp->createWorkspace(batch);
+    EXPECT_EQ(batch, ws->getCoilBatchSize());
+    EXPECT_TRUE(ws->getAllocatedBytes() > 0);
+
+    // reuse workspace for subsequent calls
+    for (int rep = 0; rep < 2; rep++)
+    {
+      gpuNUFFTOp->performGpuNUFFTAdj(dataArray, imgOutArray, *ws);
+      for (unsigned i = 0; i < refImg.count(); i++)
+      {
+        EXPECT_NEAR(refImg.data[i].x, imgOut[i].x, EPS);
+        EXPECT_NEAR(refImg.data[i].y, imgOut[i].y, EPS);
+      }
+
+      gpuNUFFTOp->performForwardGpuNUFFT(imgArray, dataOutArray, *ws);
+      for (unsigned i = 0; i < refData.count(); i++)
+      {
+        EXPECT_NEAR(refData.data[i].x, dataOut[i].x, EPS);
+        EXPECT_NEAR(refData.data[i].y, dataOut[i].y, EPS);
+      }
+    }
+    delete ws;
+  }
+
+  free(refImg.data);
+  free(refData.data);
+  delete gpuNUFFTOp;
+}
+
+TEST(HostOperatorTest, TestWorkspaceMismatch)
+{
+  DType coords[4] = { 0, (DType)0.1, 0, (DType)0.2 };
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = coords;
+  kSpaceTraj.dim.length = 2;
+
+  gpuNUFFT::Dimensions imgDims(16, 16);
+  gpuNUFFT::Dimensions otherImgDims(8, 8);
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *gpuNUFFTOp =
+      static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(
+          factory.createGpuNUFFTOperator(kSpaceTraj, 3, 8, 2.0, imgDims));
+  gpuNUFFT::HostGpuNUFFTOperator *otherOp =
+      static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(
+          factory.createGpuNUFFTOperator(kSpaceTraj, 3, 8, 2.0, otherImgDims));
+
+  gpuNUFFT::HostGpuNUFFTWorkspace *ws = otherOp->createWorkspace();
+
+  DType2 data[2] = { { 1, 0 }, { 1, 0 } };
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = data;
+  dataArray.dim.length = 2;
+  std::vector<CufftType> img(imgDims.count());
+  gpuNUFFT::Array<CufftType> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+
+  EXPECT_THROW(gpuNUFFTOp->performGpuNUFFTAdj(dataArray, imgArray, *ws),
+               std::invalid_argument);
+  EXPECT_THROW(gpuNUFFTOp->createWorkspace(0), std::invalid_argument);
+
+  // output arrays of the wrong size are rejected before gridding
+  gpuNUFFT::HostGpuNUFFTWorkspace *own = gpuNUFFTOp->createWorkspace();
+  imgArray.dim = otherImgDims;
+  EXPECT_THROW(gpuNUFFTOp->performGpuNUFFTAdj(dataArray, imgArray, *own),
+               std::invalid_argument);
+  imgArray.dim = imgDims;
+  EXPECT_THROW(gpuNUFFTOp->performGpuNUFFTAdj(dataArray, imgArray, *own,
+                                              gpuNUFFT::CONVOLUTION),
+               std::invalid_argument);
+  EXPECT_NO_THROW(gpuNUFFTOp->performGpuNUFFTAdj(dataArray, imgArray, *own));
+
+  delete own;
+  delete ws;
+  delete gpuNUFFTOp;
+  delete otherOp;
+}
+
+TEST(HostOperatorTest, TestFFTThreadCountInvariant)
+{
+  gpuNUFFT::Dimensions gridDims(12, 10, 6);
+  std::vector<CufftType> ref = createTestData(gridDims.count());
+  std::vector<CufftType> data = ref;
+
+  gpuNUFFT::HostFFTPlan plan(gridDims);
+  gpuNUFFT::setHostThreadCount(1);
+  plan.execute(&ref[0], gpuNUFFT::HOST_FFT_FORWARD);
+  gpuNUFFT::setHostThreadCount(4);
+  plan.execute(&data[0], gpuNUFFT::HOST_FFT_FORWARD);
+  gpuNUFFT::setHostThreadCount(0);
+
+  for (unsigned i = 0; i < ref.size(); i++)
+  {
+    EXPECT_NEAR(ref[i].x, data[i].x, EPS);
+    EXPECT_NEAR(ref[i].y, data[i].y, EPS);
+  }
+}
+
+TEST(HostOperatorTest, TestPrunedFFT)
+{
+  // region wrapping around the x and z border
+  gpuNUFFT::Dimensions gridDims(12, 10, 6);
+  gpuNUFFT::Dimensions regionDims(5, 4, 3);
+  IndType3 offset;
+  offset.x = 9;
+  offset.y = 2;
+  offset.z = 4;
+
+  std::vector<CufftType> input = createTestData(gridDims.count());
+  std::vector<bool> inRegion(gridDims.count());
+  for (IndType z = 0; z < gridDims.depth; z++)
+    for (IndType y = 0; y < gridDims.height; y++)
+      for (IndType x = 0; x < gridDims.width; x++)
+      {
+        IndType i = x + gridDims.width * (y + gridDims.height * z);
+        inRegion[i] = (x + gridDims.width - offset.x) % gridDims.width <
+                          regionDims.width &&
+                      (y + gridDims.height - offset.y) % gridDims.height <
+                          regionDims.height &&
+                      (z + gridDims.depth - offset.z) % gridDims.depth <
+                          regionDims.depth;
+      }
+
+  gpuNUFFT::HostFFTPlan plan(gridDims);
+  plan.setPruningRegion(offset, regionDims);
+
+  // zero input outside of the region
+  std::vector<CufftType> ref = input;
+  for (IndType i = 0; i < ref.size(); i++)
+    if (!inRegion[i])
+      ref[i].x = ref[i].y = (DType)0.0;
+  std::vector<CufftType> data = ref;
+  plan.execute(&ref[0], gpuNUFFT::HOST_FFT_FORWARD);
+  plan.execute(&data[0], 1, gpuNUFFT::HOST_FFT_FORWARD,
+               gpuNUFFT::HOST_FFT_PRUNE_INPUT);
+  for (IndType i = 0; i < ref.size(); i++)
+  {
+    EXPECT_NEAR(ref[i].x, data[i].x, EPS);
+    EXPECT_NEAR(ref[i].y, data[i].y, EPS);
+  }
+
+  // output only needed inside of the region
+  ref = input;
+  data = input;
+  plan.execute(&ref[0], gpuNUFFT::HOST_FFT_INVERSE);
+  plan.execute(&data[0], 1, gpuNUFFT::HOST_FFT_INVERSE,
+               gpuNUFFT::HOST_FFT_PRUNE_OUTPUT);
+  for (IndType i = 0; i < ref.size(); i++)
+    if (inRegion[i])
+    {
+      EXPECT_NEAR(ref[i].x, data[i].x, EPS);
+      EXPECT_NEAR(ref[i].y, data[i].y, EPS);
+    }
+
+  EXPECT_THROW(plan.setPruningRegion(offset, gpuNUFFT::Dimensions(13, 4, 3)),
+               std::invalid_argument);
+}
+
+// compares the fused crop and padding passes with the separate shift, crop,
+// scaling, deapodization and sensitivity passes
+static void testFusedImagePass(gpuNUFFT::Dimensions imgDims)
+{
+  gpuNUFFT::Dimensions gridDims = imgDims * 2.0;
+  int coilCnt = 2;
+  IndType imgCnt = imgDims.count();
+  IndType gridCnt = gridDims.count();
+
+  gpuNUFFT::GpuNUFFTInfo gi_host;
+  gi_host.is2Dprocessing = imgDims.depth == 0;
+  gi_host.osr = 2.0;
+  gi_host.n_coils_cc = coilCnt;
+  gi_host.imgDims.x = imgDims.width;
+  gi_host.imgDims.y = imgDims.height;
+  gi_host.imgDims.z = imgDims.depth;
+  gi_host.im_width_dim = imgCnt;
+  gi_host.gridDims.x = gridDims.width;
+  gi_host.gridDims.y = gridDims.height;
+  gi_host.gridDims.z = gridDims.depth;
+  gi_host.gridDims_count = gridCnt;
+  EXPECT_TRUE(isHostFusedImagePassSupported(&gi_host));
+
+  std::vector<DType> deapo(imgCnt);
+  for (IndType i = 0; i < imgCnt; i++)
+    deapo[i] = (DType)(1.0 + 0.01 * i);
+  std::vector<DType2> sens = createTestData(imgCnt * coilCnt);
+  gpuNUFFT::HostFFTPlan plan(gridDims);
+
+  // adjoint
+  std::vector<CufftType> grid = createTestData(gridCnt * coilCnt);
+  std::vector<CufftType> refGrid = grid;
+  performHostFFTShift(&refGrid[0], gpuNUFFT::INVERSE, gridDims, &gi_host);
+  plan.execute(&refGrid[0], coilCnt, gpuNUFFT::HOST_FFT_INVERSE);
+  performHostFFTShift(&refGrid[0], gpuNUFFT::INVERSE, gridDims, &gi_host);
+  std::vector<CufftType> refImg(imgCnt * coilCnt);
+  performHostCrop(&refGrid[0], &refImg[0], &gi_host);
+  performHostFFTScaling(&refImg[0], imgCnt, &gi_host);
+  performHostDeapodization(&refImg[0], &deapo[0], &gi_host);
+  std::vector<CufftType> refSum(imgCnt, CufftType());
+  std::vector<CufftType> refSens = refImg;
+  performHostSensMul(&refSens[0], &sens[0], &gi_host, true);
+  performHostSensSum(&refSens[0], &refSum[0], &gi_host);
+
+  plan.execute(&grid[0], coilCnt, gpuNUFFT::HOST_FFT_INVERSE);
+  std::vector<CufftType> img(imgCnt * coilCnt);
+  performHostFusedCrop(&grid[0], &img[0], &deapo[0], NULL, NULL, &gi_host);
+  EXPECT_LT(relativeError(&img[0], &refImg[0], imgCnt * coilCnt), 1e-5);
+  std::vector<CufftType> sum(imgCnt, CufftType());
+  performHostFusedCrop(&grid[0], NULL, &deapo[0], &sens[0], &sum[0],
+                       &gi_host);
+  EXPECT_LT(relativeError(&sum[0], &refSum[0], imgCnt), 1e-5);
+
+  // forward, one image repeated for each coil sensitivity
+  std::vector<DType2> image = createTestData(imgCnt);
+  std::vector<DType2> refImage(imgCnt * coilCnt);
+  for (int c = 0; c < coilCnt; c++)
+    std::copy(image.begin(), image.end(), refImage.begin() + c * imgCnt);
+  performHostSensMul(&refImage[0], &sens[0], &gi_host, false);
+  performHostDeapodization(&refImage[0], &deapo[0], &gi_host);
+  std::vector<CufftType> refForward(gridCnt * coilCnt, CufftType());
+  performHostPadding(&refImage[0], &refForward[0], &gi_host);
+  performHostFFTShift(&refForward[0], gpuNUFFT::INVERSE, gridDims, &gi_host);
+  plan.execute(&refForward[0], coilCnt, gpuNUFFT::HOST_FFT_FORWARD);
+  performHostFFTShift(&refForward[0], gpuNUFFT::FORWARD, gridDims, &gi_host);
+
+  std::vector<CufftType> forward(gridCnt * coilCnt, CufftType());
+  performHostFusedPadding(&image[0], &forward[0], &deapo[0], &sens[0],
+                          &gi_host);
+  plan.execute(&forward[0], coilCnt, gpuNUFFT::HOST_FFT_FORWARD);
+  EXPECT_LT(relativeError(&forward[0], &refForward[0], gridCnt * coilCnt),
+            1e-5);
+}
+
+TEST(HostOperatorTest, TestFusedImagePass)
+{
+  // half grid widths even and odd
+  testFusedImagePass(gpuNUFFT::Dimensions(8, 6));
+  testFusedImagePass(gpuNUFFT::Dimensions(6, 8, 4));
+  testFusedImagePass(gpuNUFFT::Dimensions(5, 7, 3));
+}
+
+// compares A^H A x of the Toeplitz operator with adjoint(forward(x))
+static void testToeplitzNormalOperator(bool useDens, IndType coilCnt)
+{
+  IndType imageWidth = 16;
+  DType osf = 2.0;
+  IndType sectorWidth = 8;
+  IndType kernelWidth = 5;
+  IndType coordCnt = 400;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  std::vector<DType> dens(coordCnt);
+  for (unsigned i = 0; i < coordCnt; i++)
+    dens[i] = (DType)(0.5 + 0.5 * std::cos(0.7 * i) * std::cos(0.7 * i));
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+  IndType imgCnt = imgDims.count();
+
+  std::vector<DType2> sens = createTestData(imgCnt * coilCnt);
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coilCnt;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp;
+  if (useDens)
+    gpuNUFFTOp = factory.createGpuNUFFTOperator(
+        kSpaceTraj, densArray, sensArray, kernelWidth, sectorWidth, osf,
+        imgDims);
+  else
+    gpuNUFFTOp = factory.createGpuNUFFTOperator(kSpaceTraj, kernelWidth,
+                                                sectorWidth, osf, imgDims);
+
+  gpuNUFFT::HostToeplitzNormalOperator normalOp(gpuNUFFTOp);
+  EXPECT_EQ(2 * imageWidth, normalOp.getPaddedDims().width);
+  EXPECT_EQ(2 * imageWidth, normalOp.getPaddedDims().height);
+  EXPECT_EQ(0u, normalOp.getPaddedDims().depth);
+
+  std::vector<DType2> img = createTestData(imgCnt);
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+
+  gpuNUFFT::Array<CufftType> kspace =
+      gpuNUFFTOp->performForwardGpuNUFFT(imgArray);
+  gpuNUFFT::Array<CufftType> ref = gpuNUFFTOp->performGpuNUFFTAdj(kspace);
+
+  gpuNUFFT::Array<CufftType> result = normalOp.apply(imgArray);
+
+  double diff = 0.0;
+  double norm = 0.0;
+  for (unsigned i = 0; i < imgCnt; i++)
+  {
+    double dx = ref.data[i].x - result.data[i].x;
+    double dy = ref.data[i].y - result.data[i].y;
+    diff += dx * dx + dy * dy;
+    norm += ref.data[i].x * ref.data[i].x + ref.data[i].y * ref.data[i].y;
+  }
+  EXPECT_LT(std::sqrt(diff / norm), 1e-2);
+
+  free(kspace.data);
+  free(ref.data);
+  free(result.data);
+  delete gpuNUFFTOp;
+}
+
+TEST(HostOperatorTest, TestToeplitzNormalOperator)
+{
+  testToeplitzNormalOperator(false, 1);
+}
+
+TEST(HostOperatorTest, TestToeplitzNormalOperatorDensSens)
+{
+  testToeplitzNormalOperator(true, 3);
+}
+
+TEST(HostOperatorTest, TestCGSenseSolver)
+{
+  IndType imageWidth = 16;
+  IndType coordCnt = 600;
+  IndType coilCnt = 2;
+  DType alpha = 0.1;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  std::vector<DType> dens(coordCnt, (DType)0.5);
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+  IndType imgCnt = imgDims.count();
+
+  std::vector<DType2> sens = createTestData(imgCnt * coilCnt);
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coilCnt;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, densArray, sensArray, 5, 8, 2.0, imgDims);
+
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+
+  gpuNUFFT::HostCGSenseSolver solver(gpuNUFFTOp, alpha, (DType)1e-4, 100);
+  gpuNUFFT::Array<CufftType> x = solver.solve(dataArray);
+  EXPECT_TRUE(solver.getIterationCount() > 0);
+  EXPECT_LT(solver.getResidualNorm(), 1e-4);
+  EXPECT_TRUE(solver.getIterationsPerSecond() > 0.0);
+
+  // residual of the normal equations (A^H A + alpha I) x = A^H y
+  gpuNUFFT::Array<DType2> xArray;
+  xArray.data = x.data;
+  xArray.dim = imgDims;
+  gpuNUFFT::Array<CufftType> Ax = gpuNUFFTOp->performForwardGpuNUFFT(xArray);
+  gpuNUFFT::Array<CufftType> AhAx = gpuNUFFTOp->performGpuNUFFTAdj(Ax);
+  gpuNUFFT::Array<CufftType> rhs = gpuNUFFTOp->performGpuNUFFTAdj(dataArray);
+  double diff = 0.0;
+  double norm = 0.0;
+  for (unsigned i = 0; i < imgCnt; i++)
+  {
+    double dx = AhAx.data[i].x + alpha * x.data[i].x - rhs.data[i].x;
+    double dy = AhAx.data[i].y + alpha * x.data[i].y - rhs.data[i].y;
+    diff += dx * dx + dy * dy;
+    norm += rhs.data[i].x * rhs.data[i].x + rhs.data[i].y * rhs.data[i].y;
+  }
+  EXPECT_LT(std::sqrt(diff / norm), 1e-3);
+
+  // Toeplitz evaluation of A^H A converges to the same image
+  solver.setUseToeplitz(true);
+  EXPECT_TRUE(solver.getUseToeplitz());
+  gpuNUFFT::Array<CufftType> xToeplitz = solver.solve(dataArray);
+  diff = 0.0;
+  norm = 0.0;
+  for (unsigned i = 0; i < imgCnt; i++)
+  {
+    double dx = xToeplitz.data[i].x - x.data[i].x;
+    double dy = xToeplitz.data[i].y - x.data[i].y;
+    diff += dx * dx + dy * dy;
+    norm += x.data[i].x * x.data[i].x + x.data[i].y * x.data[i].y;
+  }
+  EXPECT_LT(std::sqrt(diff / norm), 1e-2);
+
+  free(x.data);
+  free(xToeplitz.data);
+  free(Ax.data);
+  free(AhAx.data);
+  free(rhs.data);
+  delete gpuNUFFTOp;
+}
+
+class CountingProfileSink : public gpuNUFFT::ProfileSink
+{
+ public:
+  CountingProfileSink() : stageCount(0), allocationCount(0)
+  {
+  }
+
+  void stageFinished(gpuNUFFT::ProfileStage stage,
+                     const gpuNUFFT::ProfileCounters &record)
+  {
+    EXPECT_EQ(1u, record.calls);
+    stageCount++;
+  }
+
+  void allocationPerformed(size_t bytes)
+  {
+    allocationCount++;
+  }
+
+  unsigned stageCount;
+  unsigned allocationCount;
+};
+
+TEST(HostOperatorTest, TestProfiler)
+{
+  IndType imageWidth = 16;
+  IndType coordCnt = 200;
+  IndType coilCnt = 2;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  std::vector<DType> dens(coordCnt, (DType)0.5);
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+
+  std::vector<DType2> sens = createTestData(imgDims.count() * coilCnt);
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coilCnt;
+
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+
+  // disabled profiler records nothing
+  gpuNUFFT::Profiler profiler;
+  EXPECT_FALSE(profiler.isEnabled());
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  factory.setProfiler(&profiler);
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, densArray, sensArray, 3, 8, 2.0, imgDims);
+  EXPECT_EQ(&profiler, gpuNUFFTOp->getProfiler());
+
+  gpuNUFFT::Array<CufftType> img = gpuNUFFTOp->performGpuNUFFTAdj(dataArray);
+  free(img.data);
+  for (int s = 0; s < gpuNUFFT::PROFILE_STAGE_COUNT; s++)
+    EXPECT_EQ(0u, profiler.getCounters((gpuNUFFT::ProfileStage)s).calls);
+  EXPECT_EQ(0u, profiler.getAllocationCount());
+  delete gpuNUFFTOp;
+
+  // enabled profiler records factory and operator stages
+  CountingProfileSink sink;
+  profiler.setEnabled(true);
+  profiler.setSink(&sink);
+  gpuNUFFTOp = factory.createGpuNUFFTOperator(kSpaceTraj, densArray, sensArray,
+                                              3, 8, 2.0, imgDims);
+  EXPECT_EQ(1u, profiler.getCounters(gpuNUFFT::PROFILE_FACTORY_ASSIGN).calls);
+  EXPECT_EQ(1u, profiler.getCounters(gpuNUFFT::PROFILE_FACTORY_SORT).calls);
+  EXPECT_EQ(coordCnt,
+            profiler.getCounters(gpuNUFFT::PROFILE_FACTORY_SORT).samples);
+  EXPECT_EQ(1u, profiler.getCounters(gpuNUFFT::PROFILE_FACTORY_COUNT).calls);
+  EXPECT_EQ(1u, profiler.getCounters(gpuNUFFT::PROFILE_FACTORY_CENTERS).calls);
+  EXPECT_EQ(1u, profiler.getCounters(gpuNUFFT::PROFILE_FACTORY_DEAPO).calls);
+
+  profiler.reset();
+  sink.stageCount = 0;
+  sink.allocationCount = 0;
+  img = gpuNUFFTOp->performGpuNUFFTAdj(dataArray);
+
+  // crop, deapodization and sensitivities are fused on the even grid
+  gpuNUFFT::ProfileStage stages[] = {
+    gpuNUFFT::PROFILE_SORT,        gpuNUFFT::PROFILE_DENSITY_COMPENSATION,
+    gpuNUFFT::PROFILE_CONVOLUTION, gpuNUFFT::PROFILE_FFT,
+    gpuNUFFT::PROFILE_FUSED_IMAGE
+  };
+  EXPECT_EQ(0u, profiler.getCounters(gpuNUFFT::PROFILE_CROP).calls);
+  EXPECT_EQ(0u, profiler.getCounters(gpuNUFFT::PROFILE_DEAPODIZATION).calls);
+  EXPECT_EQ(0u, profiler.getCounters(gpuNUFFT::PROFILE_SENSITIVITY).calls);
+  unsigned calls = 0;
+  unsigned long long samples = 0;
+  for (int s = 0; s < 5; s++)
+  {
+    gpuNUFFT::ProfileCounters c = profiler.getCounters(stages[s]);
+    EXPECT_TRUE(c.calls > 0) << gpuNUFFT::Profiler::getStageName(stages[s]);
+    EXPECT_TRUE(c.bytes > 0) << gpuNUFFT::Profiler::getStageName(stages[s]);
+    EXPECT_TRUE(c.wallTime >= 0.0);
+    calls += c.calls;
+    if (stages[s] == gpuNUFFT::PROFILE_SORT)
+      samples = c.samples;
+  }
+  EXPECT_EQ(calls, sink.stageCount);
+  EXPECT_EQ(coordCnt * coilCnt, samples);
+  EXPECT_EQ(0u, profiler.getCounters(gpuNUFFT::PROFILE_FACTORY_SORT).calls);
+  EXPECT_TRUE(profiler.getAllocationCount() > 0);
+  EXPECT_TRUE(profiler.getAllocatedBytes() >= imgDims.count() * sizeof(CufftType));
+  EXPECT_EQ(profiler.getAllocationCount(), sink.allocationCount);
+  EXPECT_STREQ("convolution",
+               gpuNUFFT::Profiler::getStageName(gpuNUFFT::PROFILE_CONVOLUTION));
+
+  free(img.data);
+  delete gpuNUFFTOp;
+}
+
+TEST(HostOperatorTest, TestNUDFTDirectSum)
+{
+  // odd and even sizes, more samples than one block
+  gpuNUFFT::Dimensions imgDims(7, 6, 5);
+  IndType coordCnt = 37;
+  IndType coilCnt = 2;
+  IndType imgCnt = imgDims.count();
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 3);
+  std::vector<DType2> img = createTestData(imgCnt * coilCnt);
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+
+  // reference by explicit evaluation of every term
+  std::vector<CufftType> forwardRef(coordCnt * coilCnt);
+  std::vector<CufftType> adjointRef(imgCnt * coilCnt);
+  double scale = 1.0 / std::sqrt((double)imgCnt);
+  for (IndType c = 0; c < coilCnt; c++)
+    for (IndType j = 0; j < coordCnt; j++)
+      for (IndType z = 0; z < imgDims.depth; z++)
+        for (IndType y = 0; y < imgDims.height; y++)
+          for (IndType x = 0; x < imgDims.width; x++)
+          {
+            IndType i = x + imgDims.width * (y + imgDims.height * z);
+            double phase =
+                2.0 * M_PI *
+                (coords[j] * ((double)x - imgDims.width / 2) +
+                 coords[j + coordCnt] * ((double)y - imgDims.height / 2) +
+                 coords[j + 2 * coordCnt] * ((double)z - imgDims.depth / 2));
+            double re = std::cos(phase) * scale;
+            double im = std::sin(phase) * scale;
+            DType2 v = img[i + c * imgCnt];
+            forwardRef[j + c * coordCnt].x += v.x * re + v.y * im;
+            forwardRef[j + c * coordCnt].y += v.y * re - v.x * im;
+            DType2 d = data[j + c * coordCnt];
+            adjointRef[i + c * imgCnt].x += d.x * re - d.y * im;
+            adjointRef[i + c * imgCnt].y += d.x * im + d.y * re;
+          }
+
+  for (int n_threads = 1; n_threads <= 3; n_threads += 2)
+  {
+    gpuNUFFT::setHostThreadCount(n_threads);
+    std::vector<CufftType> forward(coordCnt * coilCnt);
+    gpuNUFFT::performHostNUDFTForward(&img[0], &coords[0], coordCnt, coilCnt,
+                                      imgDims, &forward[0]);
+    EXPECT_LT(relativeError(&forward[0], &forwardRef[0], forward.size()),
+              1e-5);
+
+    std::vector<CufftType> adjoint(imgCnt * coilCnt);
+    gpuNUFFT::performHostNUDFTAdj(&data[0], &coords[0], coordCnt, coilCnt,
+                                  imgDims, &adjoint[0]);
+    EXPECT_LT(relativeError(&adjoint[0], &adjointRef[0], adjoint.size()),
+              1e-5);
+  }
+  gpuNUFFT::setHostThreadCount(0);
+}
+
+// relative error of the forward and adjoint host gridding operator with
+// respect to the exact NUDFT
+static void
+griddingError(IndType kernelWidth, DType osf, double &forwardErr,
+              double &adjointErr,
+              gpuNUFFT::KernelType kernelType = gpuNUFFT::KAISER_BESSEL,
+              bool linearInterpolation = false)
+{
+  IndType imageWidth = 32;
+  IndType coordCnt = 500;
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+  IndType imgCnt = imgDims.count();
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  factory.setKernelType(kernelType);
+  factory.setUseLinearKernelInterpolation(linearInterpolation);
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, kernelWidth, 8, osf, imgDims);
+  EXPECT_EQ(kernelType, gpuNUFFTOp->getKernelType());
+
+  std::vector<DType2> img = createTestData(imgCnt);
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  std::vector<DType2> data = createTestData(coordCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+
+  gpuNUFFT::Array<CufftType> forward =
+      gpuNUFFTOp->performForwardGpuNUFFT(imgArray);
+  gpuNUFFT::Array<CufftType> adjoint =
+      gpuNUFFTOp->performGpuNUFFTAdj(dataArray);
+
+  std::vector<CufftType> forwardRef(coordCnt);
+  gpuNUFFT::performHostNUDFTForward(&img[0], &coords[0], coordCnt, 1, imgDims,
+                                    &forwardRef[0]);
+  std::vector<CufftType> adjointRef(imgCnt);
+  gpuNUFFT::performHostNUDFTAdj(&data[0], &coords[0], coordCnt, 1, imgDims,
+                                &adjointRef[0]);
+
+  forwardErr = relativeError(forward.data, &forwardRef[0], coordCnt);
+  adjointErr = relativeError(adjoint.data, &adjointRef[0], imgCnt);
+
+  free(forward.data);
+  free(adjoint.data);
+  delete gpuNUFFTOp;
+}
+
+TEST(HostOperatorTest, TestNUDFTAccuracyOracle)
+{
+  double forwardErr3, adjointErr3, forwardErr7, adjointErr7;
+  griddingError(3, 2.0, forwardErr3, adjointErr3);
+  griddingError(7, 2.0, forwardErr7, adjointErr7);
+
+  EXPECT_LT(forwardErr3, 5e-2);
+  EXPECT_LT(adjointErr3, 5e-2);
+  EXPECT_LT(forwardErr7, 5e-3);
+  EXPECT_LT(adjointErr7, 5e-3);
+  EXPECT_LT(forwardErr7, forwardErr3);
+  EXPECT_LT(adjointErr7, adjointErr3);
+}
+
+TEST(HostOperatorTest, TestNUDFTSampleLimit)
+{
+  gpuNUFFT::Dimensions imgDims(16, 16);
+  IndType counts[2] = { HOST_NUDFT_CROSSOVER_SAMPLES,
+                        HOST_NUDFT_CROSSOVER_SAMPLES + 1 };
+  gpuNUFFT::OperatorType types[2] = { gpuNUFFT::HOST_NUDFT, gpuNUFFT::HOST };
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  factory.setHostNUDFTSampleLimit(HOST_NUDFT_CROSSOVER_SAMPLES);
+  for (int n = 0; n < 2; n++)
+  {
+    std::vector<DType> coords = createTestTrajectory(counts[n], 2);
+    gpuNUFFT::Array<DType> kSpaceTraj;
+    kSpaceTraj.data = &coords[0];
+    kSpaceTraj.dim.length = counts[n];
+    gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp =
+        factory.createGpuNUFFTOperator(kSpaceTraj, 3, 8, 2.0, imgDims);
+    EXPECT_EQ(types[n], gpuNUFFTOp->getType());
+    delete gpuNUFFTOp;
+  }
+
+  // disabled by default
+  std::vector<DType> coords = createTestTrajectory(16, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = 16;
+  factory.setHostNUDFTSampleLimit(0);
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp =
+      factory.createGpuNUFFTOperator(kSpaceTraj, 3, 8, 2.0, imgDims);
+  EXPECT_EQ(gpuNUFFT::HOST, gpuNUFFTOp->getType());
+  delete gpuNUFFTOp;
+}
+
+TEST(HostOperatorTest, TestESKernelLowOversampling)
+{
+  // error level of the Kaiser-Bessel kernel at osf 2
+  double forwardErrKB, adjointErrKB;
+  griddingError(3, 2.0, forwardErrKB, adjointErrKB);
+
+  // reached by the ES kernel at osf 1.25 with the tuned width
+  DType tolerance = (DType)std::min(forwardErrKB, adjointErrKB);
+  IndType kernelWidth = esKernelWidth(tolerance, (DType)1.25);
+  EXPECT_LE(kernelWidth, 6u);
+
+  double forwardErrES, adjointErrES;
+  griddingError(kernelWidth, 1.25, forwardErrES, adjointErrES,
+                gpuNUFFT::EXPONENTIAL_OF_SEMICIRCLE);
+  EXPECT_LT(forwardErrES, forwardErrKB);
+  EXPECT_LT(adjointErrES, adjointErrKB);
+
+  // numerical Fourier transform against the sampled sum of the kernel
+  double sum = 0.0;
+  for (int x = -2; x <= 2; x++)
+    sum += evaluateKernel(std::fabs(x) / 2.5, 5, (DType)1.25,
+                          gpuNUFFT::EXPONENTIAL_OF_SEMICIRCLE);
+  EXPECT_NEAR(sum,
+              kernelFourierTransform(0.0, 5, (DType)1.25,
+                                     gpuNUFFT::EXPONENTIAL_OF_SEMICIRCLE),
+              1e-2 * sum);
+  EXPECT_DOUBLE_EQ(1.0, evaluateKernel(0.0, 5, (DType)1.25,
+                                       gpuNUFFT::EXPONENTIAL_OF_SEMICIRCLE));
+  EXPECT_DOUBLE_EQ(0.0, evaluateKernel(1.0, 5, (DType)1.25,
+                                       gpuNUFFT::EXPONENTIAL_OF_SEMICIRCLE));
+}
+
+TEST(HostOperatorTest, TestLinearKernelInterpolation)
+{
+  // compact table interpolated linearly reaches the accuracy of the
+  // nearest neighbor lookup in the default table
+  double forwardErrNN, adjointErrNN, forwardErrLin, adjointErrLin;
+  griddingError(3, 2.0, forwardErrNN, adjointErrNN);
+  griddingError(3, 2.0, forwardErrLin, adjointErrLin, gpuNUFFT::KAISER_BESSEL,
+                true);
+  EXPECT_LT(forwardErrLin, 1.5 * forwardErrNN);
+  EXPECT_LT(adjointErrLin, 1.5 * adjointErrNN);
+
+  IndType imageWidth = 16;
+  IndType coordCnt = 100;
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *hostOp =
+      static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(
+          factory.createGpuNUFFTOperator(kSpaceTraj, 3, 8, 2.0, imgDims));
+  EXPECT_FALSE(hostOp->getLinearKernelInterpolation());
+  IndType nnSize = hostOp->getKernel().count();
+  gpuNUFFT::HostGpuNUFFTWorkspace *ws = hostOp->createWorkspace();
+
+  std::vector<DType2> data = createTestData(coordCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  std::vector<CufftType> nnImg(imgDims.count());
+  std::vector<CufftType> linImg(imgDims.count());
+  gpuNUFFT::Array<CufftType> imgArray;
+  imgArray.dim = imgDims;
+  imgArray.data = &nnImg[0];
+  hostOp->performGpuNUFFTAdj(dataArray, imgArray, *ws);
+
+  // switching reloads the table, workspaces created for the old table are
+  // rejected
+  hostOp->setLinearKernelInterpolation(true);
+  EXPECT_TRUE(hostOp->getLinearKernelInterpolation());
+  EXPECT_EQ(calculateKernelSizeLinInt(2.0, 3), hostOp->getKernel().count());
+  EXPECT_LT(hostOp->getKernel().count(), nnSize);
+  imgArray.data = &linImg[0];
+  EXPECT_THROW(hostOp->performGpuNUFFTAdj(dataArray, imgArray, *ws),
+               std::invalid_argument);
+
+  hostOp->performGpuNUFFTAdj(dataArray, imgArray);
+  EXPECT_LT(relativeError(&linImg[0], &nnImg[0], imgDims.count()), 1e-2);
+
+  delete ws;
+  delete hostOp;
+}
+
+TEST(HostOperatorTest, TestTolerancePlanner)
+{
+  IndType imageWidth = 32;
+  IndType coordCnt = 500;
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+  IndType imgCnt = imgDims.count();
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::GpuNUFFTPlan loosePlan =
+      factory.planGpuNUFFTOperator(1e-2, coordCnt, imgDims);
+  gpuNUFFT::GpuNUFFTPlan tightPlan =
+      factory.planGpuNUFFTOperator(1e-3, coordCnt, imgDims);
+  EXPECT_LE(loosePlan.estimatedError, 1e-2);
+  EXPECT_LE(tightPlan.estimatedError, 1e-3);
+  EXPECT_LT(loosePlan.estimatedCost, tightPlan.estimatedCost);
+  EXPECT_GE(loosePlan.osf, (DType)1.5);
+  EXPECT_LE(tightPlan.lookupTableSize, 10000u);
+
+  EXPECT_THROW(factory.planGpuNUFFTOperator(0.0, coordCnt, imgDims),
+               std::invalid_argument);
+  EXPECT_THROW(factory.planGpuNUFFTOperator(1e-7, coordCnt, imgDims),
+               std::invalid_argument);
+
+  // the operator created for the tolerance reaches it against the NUDFT
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp =
+      factory.createGpuNUFFTOperator(kSpaceTraj, 1e-3, 8, imgDims);
+  EXPECT_EQ(tightPlan.kernelWidth, gpuNUFFTOp->getKernelWidth());
+  EXPECT_EQ(tightPlan.osf, gpuNUFFTOp->getOsf());
+  EXPECT_EQ(tightPlan.lookupTableSize, gpuNUFFTOp->getKernel().count());
+
+  std::vector<DType2> img = createTestData(imgCnt);
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  gpuNUFFT::Array<CufftType> forward =
+      gpuNUFFTOp->performForwardGpuNUFFT(imgArray);
+  std::vector<CufftType> forwardRef(coordCnt);
+  gpuNUFFT::performHostNUDFTForward(&img[0], &coords[0], coordCnt, 1, imgDims,
+                                    &forwardRef[0]);
+  EXPECT_LT(relativeError(forward.data, &forwardRef[0], coordCnt), 1e-3);
+
+  free(forward.data);
+  delete gpuNUFFTOp;
+}
+
+TEST(HostOperatorTest, TestNUDFTOperator)
+{
+  IndType imageWidth = 16;
+  IndType coordCnt = 300;
+  IndType coilCnt = 2;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  std::vector<DType> dens(coordCnt);
+  for (IndType i = 0; i < coordCnt; i++)
+    dens[i] = (DType)(0.25 + 0.5 * i / coordCnt);
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+  IndType imgCnt = imgDims.count();
+
+  std::vector<DType2> sens = createTestData(imgCnt * coilCnt);
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coilCnt;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::GpuNUFFTOperator *griddingOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, densArray, sensArray, 7, 8, 2.0, imgDims);
+  factory.setUseHostNUDFT(true);
+  gpuNUFFT::GpuNUFFTOperator *nudftOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, densArray, sensArray, 7, 8, 2.0, imgDims);
+  EXPECT_EQ(gpuNUFFT::HOST_NUDFT, nudftOp->getType());
+
+  std::vector<DType2> img = createTestData(imgCnt);
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+
+  gpuNUFFT::Array<CufftType> forward = nudftOp->performForwardGpuNUFFT(imgArray);
+  gpuNUFFT::Array<CufftType> forwardRef =
+      griddingOp->performForwardGpuNUFFT(imgArray);
+  EXPECT_EQ(coordCnt * coilCnt, forward.count());
+  EXPECT_LT(relativeError(forward.data, forwardRef.data, forward.count()),
+            5e-3);
+
+  gpuNUFFT::Array<CufftType> adjoint = nudftOp->performGpuNUFFTAdj(dataArray);
+  gpuNUFFT::Array<CufftType> adjointRef =
+      griddingOp->performGpuNUFFTAdj(dataArray);
+  EXPECT_EQ(imgCnt, adjoint.count());
+  EXPECT_LT(relativeError(adjoint.data, adjointRef.data, imgCnt), 5e-3);
+
+  EXPECT_THROW(nudftOp->performGpuNUFFTAdj(dataArray, gpuNUFFT::CONVOLUTION),
+               std::invalid_argument);
+
+  free(forward.data);
+  free(forwardRef.data);
+  free(adjoint.data);
+  free(adjointRef.data);
+  delete griddingOp;
+  delete nudftOp;
+}
+
+// odd grid dimensions place the image region at different offsets before
+// and after the inverse FFT shift, the pruned FFTs have to follow both
+static void testOddGridAdjoint(int dimCount)
+{
+  IndType coordCnt = 300;
+  IndType coilCnt = 2;
+  gpuNUFFT::Dimensions imgDims(14, 14);
+  if (dimCount == 3)
+    imgDims.depth = 14;
+  IndType imgCnt = imgDims.count();
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, dimCount);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  // grid of 21 per dimension
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::GpuNUFFTOperator *gpuNUFFTOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, 7, 8, (DType)1.5, imgDims);
+  gpuNUFFT::Dimensions gridDims = gpuNUFFTOp->getGridDims();
+  EXPECT_EQ(21u, gridDims.width);
+  IndType gridCnt = gridDims.count();
+
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+
+  // unpruned transform of the convolution output
+  gpuNUFFT::GpuNUFFTInfo gi_host;
+  gi_host.is2Dprocessing = dimCount == 2;
+  gi_host.osr = 1.5;
+  gi_host.n_coils_cc = coilCnt;
+  gi_host.imgDims.x = imgDims.width;
+  gi_host.imgDims.y = imgDims.height;
+  gi_host.imgDims.z = imgDims.depth;
+  gi_host.im_width_dim = imgCnt;
+  gi_host.gridDims.x = gridDims.width;
+  gi_host.gridDims.y = gridDims.height;
+  gi_host.gridDims.z = gridDims.depth;
+  gi_host.gridDims_count = gridCnt;
+  gpuNUFFT::Array<CufftType> grid =
+      gpuNUFFTOp->performGpuNUFFTAdj(dataArray, gpuNUFFT::CONVOLUTION);
+  gpuNUFFT::HostFFTPlan plan(gridDims);
+  performHostFFTShift(grid.data, gpuNUFFT::INVERSE, gridDims, &gi_host);
+  plan.execute(grid.data, coilCnt, gpuNUFFT::HOST_FFT_INVERSE);
+  performHostFFTShift(grid.data, gpuNUFFT::INVERSE, gridDims, &gi_host);
+  std::vector<CufftType> ref(imgCnt * coilCnt);
+  performHostCrop(grid.data, &ref[0], &gi_host);
+  performHostFFTScaling(&ref[0], imgCnt, &gi_host);
+
+  gpuNUFFT::Array<CufftType> img =
+      gpuNUFFTOp->performGpuNUFFTAdj(dataArray, gpuNUFFT::FFT);
+  EXPECT_LT(relativeError(img.data, &ref[0], imgCnt * coilCnt), 1e-5);
+
+  // the deapodization is computed by a pruned adjoint as well
+  gpuNUFFT::Array<CufftType> adjoint =
+      gpuNUFFTOp->performGpuNUFFTAdj(dataArray);
+  bool finite = true;
+  for (IndType i = 0; i < adjoint.count(); i++)
+    finite = finite && std::isfinite(adjoint.data[i].x) &&
+             std::isfinite(adjoint.data[i].y);
+  EXPECT_TRUE(finite);
+
+  free(grid.data);
+  free(img.data);
+  free(adjoint.data);
+  delete gpuNUFFTOp;
+}
+
+TEST(HostOperatorTest, TestOddGridAdjoint)
+{
+  testOddGridAdjoint(2);
+  testOddGridAdjoint(3);
+}
+
+TEST(HostOperatorTest, TestKernelLookupTableCache)
+{
+  gpuNUFFT::Dimensions imgDims(16, 16, 16);
+  gpuNUFFT::KernelLookupTableCacheStats before =
+      gpuNUFFT::KernelLookupTableCache::getStats();
+
+  gpuNUFFT::TextureGpuNUFFTOperator *op1 =
+      new gpuNUFFT::TextureGpuNUFFTOperator(5, 8, (DType)1.75, imgDims,
+                                            gpuNUFFT::TEXTURE3D_LOOKUP);
+  gpuNUFFT::TextureGpuNUFFTOperator *op2 =
+      new gpuNUFFT::TextureGpuNUFFTOperator(5, 8, (DType)1.75, imgDims,
+                                            gpuNUFFT::TEXTURE3D_LOOKUP);
+
+  // identical operators share one table
+  gpuNUFFT::Array<DType> kern = op1->getKernel();
+  EXPECT_TRUE(kern.data != NULL);
+  EXPECT_EQ(kern.data, op2->getKernel().data);
+  IndType size = kern.dim.width;
+  EXPECT_EQ(size * size * size, kern.count());
+
+  std::vector<DType> ref(kern.count());
+  load3DKernel(&ref[0], size, 5, (DType)1.75);
+  for (IndType i = 0; i < kern.count(); i++)
+    EXPECT_EQ(ref[i], kern.data[i]);
+
+  gpuNUFFT::KernelLookupTableCacheStats after =
+      gpuNUFFT::KernelLookupTableCache::getStats();
+  EXPECT_EQ(before.misses + 1, after.misses);
+  EXPECT_EQ(before.hits + 1, after.hits);
+  EXPECT_EQ(before.savedBytes + kern.count() * sizeof(DType),
+            after.savedBytes);
+
+  // a different lookup table size is a different key
+  op2->setKernelLookupTableSize(size + 1);
+  EXPECT_NE(kern.data, op2->getKernel().data);
+  EXPECT_EQ((size + 1) * (size + 1) * (size + 1), op2->getKernel().count());
+
+  delete op1;
+  delete op2;
+
+  // unreferenced tables stay cached until released explicitly
+  gpuNUFFT::TextureGpuNUFFTOperator *op3 =
+      new gpuNUFFT::TextureGpuNUFFTOperator(5, 8, (DType)1.75, imgDims,
+                                            gpuNUFFT::TEXTURE3D_LOOKUP);
+  EXPECT_EQ(kern.data, op3->getKernel().data);
+  delete op3;
+
+  gpuNUFFT::KernelLookupTableCache::releaseUnused();
+  gpuNUFFT::KernelLookupTableCacheStats released =
+      gpuNUFFT::KernelLookupTableCache::getStats();
+  EXPECT_LT(released.bytes, after.bytes);
+
+  EXPECT_THROW(gpuNUFFT::KernelLookupTableCache::acquire(5, 2.0, 1, 1),
+               std::invalid_argument);
+  EXPECT_THROW(gpuNUFFT::KernelLookupTableCache::acquire(5, 2.0, 100, 4),
+               std::invalid_argument);
+}
+
+namespace
+{
+class AcquireKernelTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  AcquireKernelTask(std::vector<const DType *> &tables) : tables(tables)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType i = begin; i < end; i++)
+      tables[i] = gpuNUFFT::KernelLookupTableCache::acquire(3, (DType)1.6,
+                                                            777, 2);
+  }
+
+ private:
+  std::vector<const DType *> &tables;
+};
+}
+
+TEST(HostOperatorTest, TestKernelLookupTableCacheConcurrent)
+{
+  int oldThreadCount = gpuNUFFT::getHostThreadCount();
+  gpuNUFFT::setHostThreadCount(4);
+
+  std::vector<const DType *> tables(16, (const DType *)NULL);
+  AcquireKernelTask task(tables);
+  gpuNUFFT::hostParallelFor(tables.size(), task);
+
+  for (IndType i = 0; i < tables.size(); i++)
+  {
+    EXPECT_TRUE(tables[i] != NULL);
+    EXPECT_EQ(tables[0], tables[i]);
+    gpuNUFFT::KernelLookupTableCache::release(tables[i]);
+  }
+
+  gpuNUFFT::setHostThreadCount(oldThreadCount);
+}
+
+namespace
+{
+// sums the indices of each range and counts the executions of each index
+class RangeSumTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  RangeSumTask(std::vector<int> &visits, std::vector<double> &sums)
+    : visits(visits), sums(sums)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    for (IndType i = begin; i < end; i++)
+    {
+      visits[i]++;
+      sums[threadId] += (double)i;
+    }
+  }
+
+ private:
+  std::vector<int> &visits;
+  std::vector<double> &sums;
+};
+
+class ThrowingTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  void run(IndType begin, IndType end, int threadId)
+  {
+    if (threadId == 2)
+      throw std::runtime_error("range failed");
+  }
+};
+
+// starts a loop per range, which has to run serially on the same thread
+class NestedTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  NestedTask(std::vector<int> &nestedRanges) : nestedRanges(nestedRanges)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    std::vector<int> visits(100, 0);
+    std::vector<double> sums(4, 0.0);
+    RangeSumTask inner(visits, sums);
+    gpuNUFFT::hostParallelFor(visits.size(), inner, 4);
+    nestedRanges[threadId] = (sums[0] == 4950.0) ? 1 : 0;
+  }
+
+ private:
+  std::vector<int> &nestedRanges;
+};
+
+// forwards to a pool and counts the calls
+class CountingExecutor : public gpuNUFFT::HostExecutor
+{
+ public:
+  CountingExecutor() : pool(2), calls(0)
+  {
+  }
+
+  void execute(IndType count, gpuNUFFT::HostParallelTask &task, int n_ranges)
+  {
+    calls++;
+    pool.execute(count, task, n_ranges);
+  }
+
+  gpuNUFFT::HostThreadPool pool;
+  int calls;
+};
+
+struct PoolCaller
+{
+  PoolCaller(gpuNUFFT::HostThreadPool &pool, bool &valid)
+    : pool(pool), valid(valid)
+  {
+  }
+
+  void operator()()
+  {
+    for (int n = 0; n < 50; n++)
+    {
+      std::vector<int> visits(1000, 0);
+      std::vector<double> sums(5, 0.0);
+      RangeSumTask task(visits, sums);
+      pool.execute(visits.size(), task, 5);
+      for (IndType i = 0; i < visits.size(); i++)
+        valid = valid && visits[i] == 1;
+    }
+  }
+
+  gpuNUFFT::HostThreadPool &pool;
+  bool &valid;
+};
+}
+
+TEST(HostOperatorTest, TestHostThreadPool)
+{
+  for (int pin = 0; pin < 2; pin++)
+  {
+    gpuNUFFT::HostThreadPool pool(3, pin == 1);
+    EXPECT_EQ(3, pool.getWorkerCount());
+    EXPECT_GE(pool.getNodeCount(), 1);
+    for (int w = 0; w < 3; w++)
+      EXPECT_LT(pool.getWorkerNode(w), pool.getNodeCount());
+
+    IndType count = 1003;
+    for (int n_ranges = 2; n_ranges <= 7; n_ranges++)
+    {
+      std::vector<int> visits(count, 0);
+      std::vector<double> sums(n_ranges, 0.0);
+      RangeSumTask task(visits, sums);
+      pool.execute(count, task, n_ranges);
+
+      for (IndType i = 0; i < count; i++)
+        EXPECT_EQ(1, visits[i]);
+      for (int r = 0; r < n_ranges; r++)
+      {
+        IndType begin, end;
+        gpuNUFFT::HostExecutor::getRange(count, n_ranges, r, begin, end);
+        EXPECT_EQ(0.5 * (begin + end - 1) * (end - begin), sums[r]);
+      }
+    }
+
+    ThrowingTask throwing;
+    EXPECT_THROW(pool.execute(count, throwing, 4), std::runtime_error);
+  }
+
+  // several callers share the workers
+  gpuNUFFT::HostThreadPool pool(2);
+  bool valid0 = true, valid1 = true, valid2 = true;
+  std::thread t0((PoolCaller(pool, valid0)));
+  std::thread t1((PoolCaller(pool, valid1)));
+  PoolCaller(pool, valid2)();
+  t0.join();
+  t1.join();
+  EXPECT_TRUE(valid0 && valid1 && valid2);
+
+  // growing the pool keeps the workers
+  pool.reserveWorkers(4);
+  EXPECT_EQ(4, pool.getWorkerCount());
+  pool.reserveWorkers(1);
+  EXPECT_EQ(4, pool.getWorkerCount());
+}
+
+TEST(HostOperatorTest, TestHostParallelForNestedSerial)
+{
+  int oldThreadCount = gpuNUFFT::getHostThreadCount();
+  gpuNUFFT::setHostThreadCount(4);
+
+  std::vector<int> nestedRanges(4, 0);
+  NestedTask task(nestedRanges);
+  gpuNUFFT::hostParallelFor(4, task);
+  for (int r = 0; r < 4; r++)
+    EXPECT_EQ(1, nestedRanges[r]);
+
+  gpuNUFFT::setHostThreadCount(oldThreadCount);
+}
+
+TEST(HostOperatorTest, TestHostExecutorFactoryThreadCountInvariant)
+{
+  int oldThreadCount = gpuNUFFT::getHostThreadCount();
+  IndType coordCnt = 20000;
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 3);
+  std::vector<DType> dens(coordCnt);
+  for (unsigned i = 0; i < coordCnt; i++)
+    dens[i] = (DType)(1.0 + i % 7);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+  gpuNUFFT::Dimensions imgDims(16, 16, 16);
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+
+  gpuNUFFT::setHostThreadCount(1);
+  gpuNUFFT::GpuNUFFTOperator *refOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, densArray, 3, 8, (DType)2.0, imgDims);
+
+  // all host stages of the factory run on the injected executor
+  gpuNUFFT::setHostThreadCount(4);
+  CountingExecutor executor;
+  gpuNUFFT::setHostExecutor(&executor);
+  EXPECT_EQ(&executor, &gpuNUFFT::getHostExecutor());
+  gpuNUFFT::GpuNUFFTOperator *op = factory.createGpuNUFFTOperator(
+      kSpaceTraj, densArray, 3, 8, (DType)2.0, imgDims);
+  gpuNUFFT::setHostExecutor(NULL);
+  EXPECT_NE(&executor, &gpuNUFFT::getHostExecutor());
+  EXPECT_GE(executor.calls, 5);
+
+  gpuNUFFT::Array<IndType> refIndices = refOp->getDataIndices();
+  gpuNUFFT::Array<IndType> indices = op->getDataIndices();
+  gpuNUFFT::Array<DType> refTraj = refOp->getKSpaceTraj();
+  gpuNUFFT::Array<DType> traj = op->getKSpaceTraj();
+  gpuNUFFT::Array<DType> refDens = refOp->getDens();
+  gpuNUFFT::Array<DType> opDens = op->getDens();
+  for (unsigned i = 0; i < coordCnt; i++)
+  {
+    EXPECT_EQ(refIndices.data[i], indices.data[i]);
+    for (int d = 0; d < 3; d++)
+      EXPECT_EQ(refTraj.data[i + d * coordCnt], traj.data[i + d * coordCnt]);
+    EXPECT_EQ(refDens.data[i], opDens.data[i]);
+  }
+
+  gpuNUFFT::Array<IndType> refCount = refOp->getSectorDataCount();
+  gpuNUFFT::Array<IndType> count = op->getSectorDataCount();
+  ASSERT_EQ(refCount.count(), count.count());
+  for (unsigned s = 0; s < count.count(); s++)
+  {
+    EXPECT_EQ(refCount.data[s], count.data[s]);
+    // stable sort, the samples of a sector keep their input order
+    if (s + 1 < count.count())
+    {
+      for (IndType i = refCount.data[s] + 1; i < refCount.data[s + 1]; i++)
+      {
+        EXPECT_LT(refIndices.data[i - 1], refIndices.data[i]);
+      }
+    }
+  }
+
+  gpuNUFFT::Array<IndType> refCenters = refOp->getSectorCenters();
+  gpuNUFFT::Array<IndType> centers = op->getSectorCenters();
+  for (unsigned i = 0; i < 3 * op->getGridSectorDims().count(); i++)
+    EXPECT_EQ(refCenters.data[i], centers.data[i]);
+
+  gpuNUFFT::setHostThreadCount(oldThreadCount);
+  delete refOp;
+  delete op;
+}
+
+TEST(HostOperatorTest, TestKernelWidthsPerDimension)
+{
+  IndType coordCnt = 300;
+  gpuNUFFT::Dimensions imgDims(16, 16, 8);
+  IndType imgCnt = imgDims.count();
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 3);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  std::vector<DType2> data = createTestData(coordCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  std::vector<CufftType> adjointRef(imgCnt);
+  gpuNUFFT::performHostNUDFTAdj(&data[0], &coords[0], coordCnt, 1, imgDims,
+                                &adjointRef[0]);
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::GpuNUFFTOperator *isoOp =
+      factory.createGpuNUFFTOperator(kSpaceTraj, 4, 8, 2.0, imgDims);
+  gpuNUFFT::Array<CufftType> isoImg = isoOp->performGpuNUFFTAdj(dataArray);
+
+  // explicit widths equal to the kernel width reproduce the operator
+  factory.setKernelWidths(gpuNUFFT::Dimensions(4, 4, 4));
+  gpuNUFFT::GpuNUFFTOperator *sameOp =
+      factory.createGpuNUFFTOperator(kSpaceTraj, 4, 8, 2.0, imgDims);
+  gpuNUFFT::Array<CufftType> sameImg = sameOp->performGpuNUFFTAdj(dataArray);
+  EXPECT_LT(relativeError(sameImg.data, isoImg.data, imgCnt), 1e-6);
+
+  // narrow kernel along z
+  factory.setKernelWidths(gpuNUFFT::Dimensions(0, 0, 3));
+  gpuNUFFT::GpuNUFFTOperator *anisoOp =
+      factory.createGpuNUFFTOperator(kSpaceTraj, 4, 8, 2.0, imgDims);
+  gpuNUFFT::Dimensions widths = anisoOp->getKernelWidths();
+  EXPECT_EQ(4u, widths.width);
+  EXPECT_EQ(4u, widths.height);
+  EXPECT_EQ(3u, widths.depth);
+  EXPECT_EQ(4u, anisoOp->getKernelWidth());
+  gpuNUFFT::Array<CufftType> anisoImg =
+      anisoOp->performGpuNUFFTAdj(dataArray);
+
+  // the operator holds the cached z table instead of a copy, thus it
+  // survives releaseUnused
+  gpuNUFFT::KernelLookupTableCache::releaseUnused();
+  gpuNUFFT::KernelLookupTableCacheStats before =
+      gpuNUFFT::KernelLookupTableCache::getStats();
+  const DType *zTable = gpuNUFFT::KernelLookupTableCache::acquire(
+      3, (DType)2.0, (IndType)calculateGrid3KernelSize(2.0, 3), 1);
+  EXPECT_EQ(before.misses,
+            gpuNUFFT::KernelLookupTableCache::getStats().misses);
+  gpuNUFFT::KernelLookupTableCache::release(zTable);
+
+  double isoErr = relativeError(isoImg.data, &adjointRef[0], imgCnt);
+  double anisoErr = relativeError(anisoImg.data, &adjointRef[0], imgCnt);
+  EXPECT_LT(isoErr, 1e-2);
+  EXPECT_LT(anisoErr, 3e-2);
+  EXPECT_GT(relativeError(anisoImg.data, isoImg.data, imgCnt), 0.0);
+
+  free(isoImg.data);
+  free(sameImg.data);
+  free(anisoImg.data);
+  delete isoOp;
+  delete sameOp;
+  delete anisoOp;
+
+#ifndef GPUNUFFT_HOST_ONLY
+  // the gpu kernels use a single width
+  gpuNUFFT::GpuNUFFTOperatorFactory gpuFactory(false, false, false);
+  gpuFactory.setKernelWidths(gpuNUFFT::Dimensions(4, 4, 2));
+  EXPECT_THROW(
+      gpuFactory.createGpuNUFFTOperator(kSpaceTraj, 4, 8, 2.0, imgDims),
+      std::invalid_argument);
+#endif
+}
+
+TEST(HostOperatorTest, TestCoilCompression)
+{
+  IndType imageWidth = 16;
+  IndType coordCnt = 600;
+  IndType coilCnt = 8;
+  IndType rank = 3;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  std::vector<DType> dens(coordCnt, (DType)0.5);
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+  IndType imgCnt = imgDims.count();
+
+  // sensitivities spanning a subspace of rank channels
+  std::vector<DType2> base = createTestData(imgCnt * rank);
+  std::vector<DType2> sens(imgCnt * coilCnt);
+  for (IndType c = 0; c < coilCnt; c++)
+    for (IndType i = 0; i < imgCnt; i++)
+    {
+      sens[c * imgCnt + i].x = 0.0;
+      sens[c * imgCnt + i].y = 0.0;
+      for (IndType r = 0; r < rank; r++)
+      {
+        DType mx = (DType)std::cos(1.3 * c + 0.7 * r);
+        DType my = (DType)std::sin(0.5 * c * r + 0.2);
+        DType2 b = base[r * imgCnt + i];
+        sens[c * imgCnt + i].x += mx * b.x - my * b.y;
+        sens[c * imgCnt + i].y += mx * b.y + my * b.x;
+      }
+    }
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coilCnt;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *hostOp =
+      (gpuNUFFT::HostGpuNUFFTOperator *)factory.createGpuNUFFTOperator(
+          kSpaceTraj, densArray, sensArray, 3, 8, 2.0, imgDims);
+
+  std::vector<DType2> img = createTestData(imgCnt);
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  gpuNUFFT::Array<CufftType> kspace = hostOp->performForwardGpuNUFFT(imgArray);
+  ASSERT_EQ(coilCnt, kspace.dim.channels);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = kspace.data;
+  dataArray.dim = kspace.dim;
+  gpuNUFFT::Array<CufftType> ref = hostOp->performGpuNUFFTAdj(dataArray);
+
+  gpuNUFFT::HostCoilCompression compression(dataArray, rank);
+  EXPECT_EQ(coilCnt, compression.getPhysicalCoils());
+  EXPECT_EQ(rank, compression.getVirtualCoils());
+  const std::vector<double> &sv = compression.getSingularValues();
+  ASSERT_EQ(coilCnt, sv.size());
+  for (IndType c = 1; c < coilCnt; c++)
+    EXPECT_LE(sv[c], sv[c - 1] * (1.0 + 1e-9));
+  EXPECT_LT(sv[rank] / sv[0], 1e-3);
+  EXPECT_NEAR(1.0, compression.getRetainedEnergy(), 1e-5);
+
+  // orthonormal rows
+  const std::vector<DType2> &A = compression.getCompressionMatrix();
+  for (IndType k = 0; k < rank; k++)
+    for (IndType l = 0; l < rank; l++)
+    {
+      double re = 0.0, im = 0.0;
+      for (IndType c = 0; c < coilCnt; c++)
+      {
+        DType2 a = A[k * coilCnt + c], b = A[l * coilCnt + c];
+        re += a.x * b.x + a.y * b.y;
+        im += a.y * b.x - a.x * b.y;
+      }
+      EXPECT_NEAR(k == l ? 1.0 : 0.0, re, 1e-5);
+      EXPECT_NEAR(0.0, im, 1e-5);
+    }
+
+  // the data lies in the rank dimensional channel subspace, thus gridding the
+  // virtual coils yields the adjoint of all physical coils
+  hostOp->setCoilCompression(&compression);
+  EXPECT_EQ(rank, hostOp->getSens().dim.channels);
+  gpuNUFFT::Array<CufftType> compressedImg =
+      hostOp->performGpuNUFFTAdj(dataArray);
+  EXPECT_LT(relativeError(compressedImg.data, ref.data, imgCnt), 1e-4);
+
+  gpuNUFFT::Array<DType2> compressedData = compression.compress(dataArray);
+  EXPECT_EQ(rank, compressedData.dim.channels);
+  gpuNUFFT::HostGpuNUFFTWorkspace *ws = hostOp->createWorkspace(2);
+  gpuNUFFT::Array<CufftType> wsImg;
+  wsImg.dim = imgDims;
+  wsImg.data = (CufftType *)calloc(imgCnt, sizeof(CufftType));
+  hostOp->performGpuNUFFTAdj(compressedData, wsImg, *ws);
+  EXPECT_LT(relativeError(wsImg.data, ref.data, imgCnt), 1e-4);
+  EXPECT_THROW(hostOp->performGpuNUFFTAdj(dataArray, wsImg, *ws),
+               std::invalid_argument);
+
+  // forward results are virtual coil data
+  gpuNUFFT::Array<CufftType> compressedKspace =
+      hostOp->performForwardGpuNUFFT(imgArray);
+  EXPECT_EQ(rank, compressedKspace.dim.channels);
+  EXPECT_LT(relativeError(compressedKspace.data, compressedData.data,
+                          coordCnt * rank),
+            1e-4);
+
+  // restore the physical coils
+  hostOp->setCoilCompression(NULL);
+  EXPECT_EQ(coilCnt, hostOp->getSens().dim.channels);
+  gpuNUFFT::Array<CufftType> physicalImg = hostOp->performGpuNUFFTAdj(dataArray);
+  EXPECT_LT(relativeError(physicalImg.data, ref.data, imgCnt), 1e-6);
+
+  EXPECT_THROW(gpuNUFFT::HostCoilCompression(dataArray, coilCnt + 1),
+               std::invalid_argument);
+
+  free(kspace.data);
+  free(ref.data);
+  free(compressedImg.data);
+  free(compressedData.data);
+  free(wsImg.data);
+  free(compressedKspace.data);
+  free(physicalImg.data);
+  delete ws;
+  delete hostOp;
+}
+
+TEST(HostOperatorTest, TestStackOfStarsOperator)
+{
+  IndType imageWidth = 16;
+  IndType partitions = 6;
+  IndType coordCnt = 300;
+  IndType coilCnt = 2;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  std::vector<DType> dens(coordCnt);
+  for (IndType i = 0; i < coordCnt; i++)
+    dens[i] = (DType)(0.25 + 0.5 * i / coordCnt);
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+
+  // stacked 3-d trajectory with Cartesian kz = (p - P/2) / P as reference
+  IndType stackCnt = coordCnt * partitions;
+  std::vector<DType> stackCoords(3 * stackCnt);
+  std::vector<DType> stackDens(stackCnt);
+  for (IndType p = 0; p < partitions; p++)
+    for (IndType i = 0; i < coordCnt; i++)
+    {
+      IndType j = p * coordCnt + i;
+      stackCoords[j] = coords[i];
+      stackCoords[j + stackCnt] = coords[i + coordCnt];
+      stackCoords[j + 2 * stackCnt] =
+          (DType)((double)p - partitions / 2) / (DType)partitions;
+      stackDens[j] = dens[i];
+    }
+  gpuNUFFT::Array<DType> stackTraj;
+  stackTraj.data = &stackCoords[0];
+  stackTraj.dim.length = stackCnt;
+  gpuNUFFT::Array<DType> stackDensArray;
+  stackDensArray.data = &stackDens[0];
+  stackDensArray.dim.length = stackCnt;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth, partitions);
+  IndType imgCnt = imgDims.count();
+
+  std::vector<DType2> sens = createTestData(imgCnt * coilCnt);
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coilCnt;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  gpuNUFFT::HostStackOfStarsOperator *stackOp =
+      factory.createStackOfStarsOperator(kSpaceTraj, densArray, sensArray, 7,
+                                         8, 2.0, imgDims);
+  EXPECT_FALSE(stackOp->getSliceOperator()->is3DProcessing());
+  EXPECT_EQ(partitions, stackOp->getImageDims().depth);
+  EXPECT_EQ(coordCnt, stackOp->getSampleCount());
+
+  factory.setUseHostBackend(true);
+  factory.setUseHostNUDFT(true);
+  gpuNUFFT::GpuNUFFTOperator *nudftOp = factory.createGpuNUFFTOperator(
+      stackTraj, stackDensArray, sensArray, 7, 8, 2.0, imgDims);
+
+  std::vector<DType2> img = createTestData(imgCnt);
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  std::vector<DType2> data = createTestData(stackCnt * coilCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = stackCnt;
+  dataArray.dim.channels = coilCnt;
+
+  gpuNUFFT::Array<CufftType> forward = stackOp->performForwardGpuNUFFT(imgArray);
+  gpuNUFFT::Array<CufftType> forwardRef =
+      nudftOp->performForwardGpuNUFFT(imgArray);
+  EXPECT_EQ(stackCnt * coilCnt, forward.count());
+  EXPECT_LT(relativeError(forward.data, forwardRef.data, forward.count()),
+            5e-3);
+
+  gpuNUFFT::Array<CufftType> adjoint = stackOp->performGpuNUFFTAdj(dataArray);
+  gpuNUFFT::Array<CufftType> adjointRef =
+      nudftOp->performGpuNUFFTAdj(dataArray);
+  EXPECT_EQ(imgCnt, adjoint.count());
+  EXPECT_LT(relativeError(adjoint.data, adjointRef.data, imgCnt), 5e-3);
+
+  // partitions distributed over threads and processed one after another
+  // with parallel gridding steps yield the same result
+  gpuNUFFT::Array<CufftType> adjointThreads;
+  adjointThreads.data = (CufftType *)calloc(imgCnt, sizeof(CufftType));
+  adjointThreads.dim = imgDims;
+  gpuNUFFT::setHostThreadCount(3);
+  stackOp->performGpuNUFFTAdj(dataArray, adjointThreads);
+  EXPECT_LT(relativeError(adjointThreads.data, adjoint.data, imgCnt), 1e-5);
+  gpuNUFFT::setHostThreadCount(partitions + 1);
+  stackOp->performGpuNUFFTAdj(dataArray, adjointThreads);
+  EXPECT_LT(relativeError(adjointThreads.data, adjoint.data, imgCnt), 1e-5);
+  gpuNUFFT::setHostThreadCount(0);
+
+  dataArray.dim.length = coordCnt;
+  EXPECT_THROW(stackOp->performGpuNUFFTAdj(dataArray, adjointThreads),
+               std::invalid_argument);
+
+  free(forward.data);
+  free(forwardRef.data);
+  free(adjoint.data);
+  free(adjointRef.data);
+  free(adjointThreads.data);
+  delete stackOp;
+  delete nudftOp;
+}
+
+// partitioned operator matches the operator of all samples for any amount of
+// slabs and threads
+static void testPartitionedOperator(int dimCount)
+{
+  IndType coordCnt = 800;
+  IndType coilCnt = 2;
+  gpuNUFFT::Dimensions imgDims(16, 16);
+  if (dimCount == 3)
+    imgDims.depth = 16;
+  IndType imgCnt = imgDims.count();
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, dimCount);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+  std::vector<DType> dens(coordCnt);
+  for (IndType i = 0; i < coordCnt; i++)
+    dens[i] = (DType)(0.25 + 0.5 * i / coordCnt);
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+  std::vector<DType2> sens = createTestData(imgCnt * coilCnt);
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coilCnt;
+
+  // grid of 24 planes, 6 sector planes of width 4, halo of 2 planes
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::GpuNUFFTOperator *refOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, densArray, sensArray, 5, 4, (DType)1.5, imgDims);
+
+  std::vector<DType2> img = createTestData(imgCnt);
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+
+  gpuNUFFT::Array<CufftType> adjointRef = refOp->performGpuNUFFTAdj(dataArray);
+  gpuNUFFT::Array<CufftType> gridRef =
+      refOp->performGpuNUFFTAdj(dataArray, gpuNUFFT::CONVOLUTION);
+  gpuNUFFT::Array<CufftType> forwardRef =
+      refOp->performForwardGpuNUFFT(imgArray);
+
+  EXPECT_THROW(factory.createPartitionedOperator(kSpaceTraj, densArray,
+                                                 sensArray, 0, 5, 4,
+                                                 (DType)1.5, imgDims),
+               std::invalid_argument);
+  EXPECT_THROW(factory.createPartitionedOperator(kSpaceTraj, densArray,
+                                                 sensArray, 7, 5, 4,
+                                                 (DType)1.5, imgDims),
+               std::invalid_argument);
+
+  IndType partitionCounts[4] = { 1, 2, 3, 6 };
+  for (int n = 0; n < 4; n++)
+  {
+    IndType partitions = partitionCounts[n];
+    gpuNUFFT::HostPartitionedOperator *partOp =
+        factory.createPartitionedOperator(kSpaceTraj, densArray, sensArray,
+                                          partitions, 5, 4, (DType)1.5,
+                                          imgDims);
+    partOp->setCoilBatchSize(2);
+    EXPECT_EQ(partitions, partOp->getPartitionCount());
+    EXPECT_EQ(2u, partOp->getHalo());
+
+    // the slabs cover the grid planes and the backends all samples, the
+    // grids of the backends hold the slab and halo planes only
+    IndType samples = 0, last = 0;
+    for (IndType p = 0; p < partitions; p++)
+    {
+      IndType first, previous = last;
+      partOp->getSlabPlanes(p, first, last);
+      EXPECT_EQ(previous, first);
+      EXPECT_LT(first, last);
+      gpuNUFFT::HostGpuNUFFTOperator *backend = partOp->getBackend(p);
+      if (backend == NULL)
+        continue;
+      samples += backend->getKSpaceTraj().count();
+      gpuNUFFT::Dimensions gridDims = backend->getConvolutionGridDims();
+      EXPECT_EQ(std::min(last - first + 4, (IndType)24),
+                dimCount == 3 ? gridDims.depth : gridDims.height);
+      EXPECT_EQ((first + 22) % 24, backend->getGridPlaneOffset());
+
+      // the FFT of the main operator needs the full grid
+      std::vector<CufftType> backendData(backend->getKSpaceTraj().count());
+      gpuNUFFT::Array<CufftType> backendArray;
+      backendArray.data = &backendData[0];
+      backendArray.dim.length = backendData.size();
+      EXPECT_THROW(backend->performForwardGpuNUFFT(imgArray, backendArray),
+                   std::invalid_argument);
+    }
+    EXPECT_EQ(24u, last);
+    EXPECT_EQ(coordCnt, samples);
+
+    gpuNUFFT::Array<CufftType> grid =
+        partOp->performGpuNUFFTAdj(dataArray, gpuNUFFT::CONVOLUTION);
+    EXPECT_LT(relativeError(grid.data, gridRef.data, gridRef.count()), 1e-5);
+
+    // backends distributed over threads and processed one after another
+    for (int threads = 1; threads <= 7; threads += 6)
+    {
+      gpuNUFFT::setHostThreadCount(threads);
+      gpuNUFFT::Array<CufftType> adjoint =
+          partOp->performGpuNUFFTAdj(dataArray);
+      EXPECT_EQ(imgCnt, adjoint.count());
+      EXPECT_LT(relativeError(adjoint.data, adjointRef.data, imgCnt), 1e-5);
+      gpuNUFFT::Array<CufftType> forward =
+          partOp->performForwardGpuNUFFT(imgArray);
+      EXPECT_EQ(coordCnt * coilCnt, forward.count());
+      EXPECT_LT(relativeError(forward.data, forwardRef.data, forward.count()),
+                1e-5);
+      free(adjoint.data);
+      free(forward.data);
+    }
+    gpuNUFFT::setHostThreadCount(0);
+
+    dataArray.dim.length = coordCnt / 2;
+    EXPECT_THROW(partOp->performGpuNUFFTAdj(dataArray, grid),
+                 std::invalid_argument);
+    dataArray.dim.length = coordCnt;
+
+    free(grid.data);
+    delete partOp;
+  }
+
+  free(adjointRef.data);
+  free(gridRef.data);
+  free(forwardRef.data);
+  delete refOp;
+}
+
+TEST(HostOperatorTest, TestPartitionedOperator)
+{
+  testPartitionedOperator(2);
+  testPartitionedOperator(3);
+}
+
+TEST(HostOperatorTest, TestTimeSegmentedOperator)
+{
+  IndType imageWidth = 16;
+  IndType coordCnt = 400;
+  IndType coilCnt = 2;
+  IndType segments = 6;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  // 10 ms readout, off-resonance up to +-50 Hz
+  std::vector<DType> times(coordCnt);
+  for (IndType j = 0; j < coordCnt; j++)
+    times[j] = (DType)(0.01 * j / coordCnt);
+  gpuNUFFT::Array<DType> timeArray;
+  timeArray.data = &times[0];
+  timeArray.dim.length = coordCnt;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+  IndType imgCnt = imgDims.count();
+  std::vector<DType> field(imgCnt);
+  for (IndType y = 0; y < imageWidth; y++)
+    for (IndType x = 0; x < imageWidth; x++)
+      field[y * imageWidth + x] =
+          (DType)(2.0 * M_PI * 50.0 * std::sin(0.3 * x) * std::cos(0.2 * y));
+  gpuNUFFT::Array<DType> fieldArray;
+  fieldArray.data = &field[0];
+  fieldArray.dim = imgDims;
+
+  std::vector<DType2> sens = createTestData(imgCnt * coilCnt);
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coilCnt;
+  gpuNUFFT::Array<DType> densArray;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  gpuNUFFT::HostTimeSegmentedOperator *segOp =
+      factory.createTimeSegmentedOperator(kSpaceTraj, densArray, sensArray,
+                                          fieldArray, timeArray, segments, 7,
+                                          8, 2.0, imgDims);
+  EXPECT_EQ(segments, segOp->getSegmentCount());
+  EXPECT_EQ(segments, (IndType)segOp->getOperator()->getCoilBatchSize());
+  EXPECT_LT(segOp->getInterpolationError(), 1e-3);
+
+  std::vector<DType2> img = createTestData(imgCnt);
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+
+  // direct evaluation of the off-resonance signal model
+  std::vector<CufftType> forwardRef(coordCnt * coilCnt);
+  std::vector<CufftType> adjointRef(imgCnt);
+  double scale = 1.0 / std::sqrt((double)imgCnt);
+  for (IndType c = 0; c < coilCnt; c++)
+    for (IndType j = 0; j < coordCnt; j++)
+    {
+      double fr = 0.0, fi = 0.0;
+      for (IndType i = 0; i < imgCnt; i++)
+      {
+        double px = (double)(i % imageWidth) - imageWidth / 2;
+        double py = (double)(i / imageWidth) - imageWidth / 2;
+        double phi = -2.0 * M_PI * (coords[j] * px + coords[coordCnt + j] * py) -
+                     field[i] * times[j];
+        double er = std::cos(phi), ei = std::sin(phi);
+        DType2 s = sens[c * imgCnt + i];
+        double vr = s.x * img[i].x - s.y * img[i].y;
+        double vi = s.x * img[i].y + s.y * img[i].x;
+        fr += vr * er - vi * ei;
+        fi += vr * ei + vi * er;
+        // conj(S) exp(-i phi) y
+        DType2 y = data[c * coordCnt + j];
+        double ar = y.x * er + y.y * ei, ai = y.y * er - y.x * ei;
+        adjointRef[i].x += (DType)(scale * (s.x * ar + s.y * ai));
+        adjointRef[i].y += (DType)(scale * (s.x * ai - s.y * ar));
+      }
+      forwardRef[c * coordCnt + j].x = (DType)(scale * fr);
+      forwardRef[c * coordCnt + j].y = (DType)(scale * fi);
+    }
+
+  gpuNUFFT::Array<CufftType> forward = segOp->performForwardGpuNUFFT(imgArray);
+  EXPECT_EQ(coordCnt * coilCnt, forward.count());
+  EXPECT_LT(relativeError(forward.data, &forwardRef[0], forward.count()),
+            5e-3);
+
+  gpuNUFFT::Array<CufftType> adjoint = segOp->performGpuNUFFTAdj(dataArray);
+  EXPECT_EQ(imgCnt, adjoint.count());
+  EXPECT_LT(relativeError(adjoint.data, &adjointRef[0], imgCnt), 5e-3);
+
+  // a single segment without off-resonance equals the plain operator
+  std::vector<DType> zeroField(imgCnt, (DType)0.0);
+  fieldArray.data = &zeroField[0];
+  gpuNUFFT::HostTimeSegmentedOperator *plainOp =
+      factory.createTimeSegmentedOperator(kSpaceTraj, densArray, sensArray,
+                                          fieldArray, timeArray, 1, 7, 8, 2.0,
+                                          imgDims);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::GpuNUFFTOperator *griddingOp = factory.createGpuNUFFTOperator(
+      kSpaceTraj, densArray, sensArray, 7, 8, 2.0, imgDims);
+  gpuNUFFT::Array<CufftType> plain = plainOp->performGpuNUFFTAdj(dataArray);
+  gpuNUFFT::Array<CufftType> plainRef =
+      griddingOp->performGpuNUFFTAdj(dataArray);
+  EXPECT_LT(relativeError(plain.data, plainRef.data, imgCnt), 1e-5);
+
+  timeArray.dim.length = coordCnt - 1;
+  EXPECT_THROW(factory.createTimeSegmentedOperator(
+                   kSpaceTraj, densArray, sensArray, fieldArray, timeArray,
+                   segments, 7, 8, 2.0, imgDims),
+               std::invalid_argument);
+
+  free(forward.data);
+  free(adjoint.data);
+  free(plain.data);
+  free(plainRef.data);
+  delete segOp;
+  delete plainOp;
+  delete griddingOp;
+}
+
+TEST(HostOperatorTest, TestRegionCropShiftedGrid)
+{
+  // odd grid dimensions, the grids are shifted before and after the FFT
+  gpuNUFFT::Dimensions imgDims(5, 7, 3);
+  gpuNUFFT::Dimensions gridDims(7, 9, 5);
+  int coilCnt = 2;
+  IndType imgCnt = imgDims.count();
+  IndType gridCnt = gridDims.count();
+
+  gpuNUFFT::GpuNUFFTInfo gi_host;
+  gi_host.is2Dprocessing = false;
+  gi_host.osr = 1.4;
+  gi_host.n_coils_cc = coilCnt;
+  gi_host.imgDims.x = imgDims.width;
+  gi_host.imgDims.y = imgDims.height;
+  gi_host.imgDims.z = imgDims.depth;
+  gi_host.im_width_dim = imgCnt;
+  gi_host.gridDims.x = gridDims.width;
+  gi_host.gridDims.y = gridDims.height;
+  gi_host.gridDims.z = gridDims.depth;
+  gi_host.gridDims_count = gridCnt;
+  EXPECT_FALSE(isHostFusedImagePassSupported(&gi_host));
+
+  std::vector<DType> deapo(imgCnt);
+  for (IndType i = 0; i < imgCnt; i++)
+    deapo[i] = (DType)(1.0 + 0.01 * i);
+  std::vector<DType2> sens = createTestData(imgCnt * coilCnt);
+  gpuNUFFT::HostFFTPlan plan(gridDims);
+
+  std::vector<CufftType> grid = createTestData(gridCnt * coilCnt);
+  performHostFFTShift(&grid[0], gpuNUFFT::INVERSE, gridDims, &gi_host);
+  plan.execute(&grid[0], coilCnt, gpuNUFFT::HOST_FFT_INVERSE);
+  performHostFFTShift(&grid[0], gpuNUFFT::INVERSE, gridDims, &gi_host);
+  std::vector<CufftType> refImg(imgCnt * coilCnt);
+  performHostCrop(&grid[0], &refImg[0], &gi_host);
+  performHostFFTScaling(&refImg[0], imgCnt, &gi_host);
+  performHostDeapodization(&refImg[0], &deapo[0], &gi_host);
+  std::vector<CufftType> refSum(imgCnt, CufftType());
+  std::vector<CufftType> refSens = refImg;
+  performHostSensMul(&refSens[0], &sens[0], &gi_host, true);
+  performHostSensSum(&refSens[0], &refSum[0], &gi_host);
+
+  IndType3 roiOffset;
+  roiOffset.x = 1;
+  roiOffset.y = 2;
+  roiOffset.z = 1;
+  gpuNUFFT::Dimensions roiDims(3, 4, 2);
+  IndType roiCnt = roiDims.count();
+  std::vector<CufftType> roi(roiCnt * coilCnt);
+  std::vector<CufftType> roiSum(roiCnt, CufftType());
+  performHostRegionCrop(&grid[0], &roi[0], &deapo[0], NULL, NULL, roiOffset,
+                        roiDims, true, &gi_host);
+  performHostRegionCrop(&grid[0], NULL, &deapo[0], &sens[0], &roiSum[0],
+                        roiOffset, roiDims, true, &gi_host);
+
+  for (int c = 0; c < coilCnt; c++)
+    for (IndType r = 0; r < roiCnt; r++)
+    {
+      IndType x = r % roiDims.width;
+      IndType y = (r / roiDims.width) % roiDims.height;
+      IndType z = r / (roiDims.width * roiDims.height);
+      IndType t = roiOffset.x + x +
+                  imgDims.width * (roiOffset.y + y +
+                                   imgDims.height * (roiOffset.z + z));
+      EXPECT_NEAR(refImg[t + c * imgCnt].x, roi[r + c * roiCnt].x, EPS);
+      EXPECT_NEAR(refImg[t + c * imgCnt].y, roi[r + c * roiCnt].y, EPS);
+      if (c == 0)
+      {
+        EXPECT_NEAR(refSum[t].x, roiSum[r].x, EPS);
+        EXPECT_NEAR(refSum[t].y, roiSum[r].y, EPS);
+      }
+    }
+}
+
+// compares the adjoint of a box (region of interest) with the box cropped from
+// the full adjoint, with and without sensitivities
+static void testRegionAdjoint(gpuNUFFT::Dimensions imgDims, DType osf,
+                              IndType3 roiOffset, gpuNUFFT::Dimensions roiDims)
+{
+  IndType sectorWidth = 8;
+  IndType kernelWidth = 3;
+  IndType coordCnt = 300;
+  IndType coilCnt = 3;
+  bool is2D = imgDims.depth == 0;
+  IndType imgCnt = imgDims.count();
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, is2D ? 2 : 3);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  std::vector<DType> dens(coordCnt, (DType)1.0);
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+
+  std::vector<DType2> sens = createTestData(imgCnt * coilCnt);
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coilCnt;
+
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  for (int useSens = 0; useSens < 2; useSens++)
+  {
+    gpuNUFFT::HostGpuNUFFTOperator *gpuNUFFTOp =
+        static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(
+            useSens ? factory.createGpuNUFFTOperator(
+                          kSpaceTraj, densArray, sensArray, kernelWidth,
+                          sectorWidth, osf, imgDims)
+                    : factory.createGpuNUFFTOperator(kSpaceTraj, kernelWidth,
+                                                     sectorWidth, osf,
+                                                     imgDims));
+    gpuNUFFTOp->setCoilBatchSize(2);
+    IndType channels = useSens ? 1 : coilCnt;
+    IndType roiCnt = roiDims.count();
+
+    gpuNUFFT::Array<CufftType> img = gpuNUFFTOp->performGpuNUFFTAdj(dataArray);
+    std::vector<CufftType> refRoi(roiCnt * channels);
+    IndType r = 0;
+    for (IndType c = 0; c < channels; c++)
+      for (IndType z = 0; z < DEFAULT_VALUE(roiDims.depth); z++)
+        for (IndType y = 0; y < roiDims.height; y++)
+          for (IndType x = 0; x < roiDims.width; x++, r++)
+            refRoi[r] =
+                img.data[c * imgCnt + roiOffset.x + x +
+                         imgDims.width * (roiOffset.y + y +
+                                          imgDims.height * (roiOffset.z + z))];
+
+    // repeated calls restore the full image pruning region in between
+    for (int rep = 0; rep < 2; rep++)
+    {
+      gpuNUFFT::Array<CufftType> roi =
+          gpuNUFFTOp->performGpuNUFFTAdj(dataArray, roiOffset, roiDims);
+      EXPECT_EQ(roiCnt * channels, roi.count());
+      EXPECT_LT(relativeError(roi.data, &refRoi[0], roi.count()), 1e-5);
+      free(roi.data);
+
+      gpuNUFFT::Array<CufftType> full =
+          gpuNUFFTOp->performGpuNUFFTAdj(dataArray);
+      EXPECT_LT(relativeError(full.data, img.data, img.count()), 1e-6);
+      free(full.data);
+    }
+
+    // box exceeding the image
+    IndType3 outside = roiOffset;
+    outside.x = imgDims.width - roiDims.width + 1;
+    EXPECT_THROW(gpuNUFFTOp->performGpuNUFFTAdj(dataArray, outside, roiDims),
+                 std::invalid_argument);
+
+    free(img.data);
+    delete gpuNUFFTOp;
+  }
+}
+
+TEST(HostOperatorTest, TestRegionAdjoint)
+{
+  IndType3 offset;
+  offset.x = 3;
+  offset.y = 5;
+  offset.z = 0;
+  testRegionAdjoint(gpuNUFFT::Dimensions(16, 16), 2.0, offset,
+                    gpuNUFFT::Dimensions(6, 9));
+  offset.z = 2;
+  testRegionAdjoint(gpuNUFFT::Dimensions(16, 12, 8), 2.0, offset,
+                    gpuNUFFT::Dimensions(5, 7, 3));
+  // odd grid of 21 per dimension
+  offset.z = 0;
+  testRegionAdjoint(gpuNUFFT::Dimensions(14, 14), 1.5, offset,
+                    gpuNUFFT::Dimensions(6, 9));
+  offset.z = 2;
+  testRegionAdjoint(gpuNUFFT::Dimensions(14, 14, 14), 1.5, offset,
+                    gpuNUFFT::Dimensions(5, 7, 3));
+  // whole image
+  offset.x = offset.y = offset.z = 0;
+  testRegionAdjoint(gpuNUFFT::Dimensions(16, 12, 8), 1.5, offset,
+                    gpuNUFFT::Dimensions(16, 12, 8));
+}
+
+// compares the subset operations with the operations on all samples, the
+// unselected samples zero filled
+static void testSampleSubset(int dimCount)
+{
+  IndType imageWidth = 16;
+  DType osf = 1.5;
+  IndType sectorWidth = 8;
+  IndType kernelWidth = 3;
+  IndType coordCnt = 400;
+  IndType coilCnt = 3;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, dimCount);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  std::vector<DType> dens(coordCnt);
+  for (unsigned i = 0; i < coordCnt; i++)
+    dens[i] = (DType)(0.5 + 0.5 * std::cos(0.7 * i) * std::cos(0.7 * i));
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+  if (dimCount == 3)
+    imgDims.depth = imageWidth / 2;
+  IndType imgCnt = imgDims.count();
+  std::vector<DType2> sens = createTestData(imgCnt * coilCnt);
+  gpuNUFFT::Array<DType2> sensArray;
+  sensArray.data = &sens[0];
+  sensArray.dim = imgDims;
+  sensArray.dim.channels = coilCnt;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *gpuNUFFTOp =
+      static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(
+          factory.createGpuNUFFTOperator(kSpaceTraj, densArray, sensArray,
+                                         kernelWidth, sectorWidth, osf,
+                                         imgDims));
+  gpuNUFFTOp->setCoilBatchSize(2);
+
+  // every third sample and the first quarter, i.e. sectors without samples
+  std::vector<unsigned char> mask(coordCnt);
+  for (IndType i = 0; i < coordCnt; i++)
+    mask[i] = (i % 3 == 0 || i < coordCnt / 4) ? 1 : 0;
+  gpuNUFFT::Array<unsigned char> maskArray;
+  maskArray.data = &mask[0];
+  maskArray.dim.length = coordCnt;
+  gpuNUFFT::Array<IndType> indices =
+      gpuNUFFT::HostGpuNUFFTOperator::createSampleIndices(maskArray);
+  IndType subsetCnt = indices.count();
+  EXPECT_EQ(coordCnt / 4 + (3 * coordCnt / 4 + 2) / 3, subsetCnt);
+
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+  std::vector<DType2> subsetData(subsetCnt * coilCnt);
+  for (IndType c = 0; c < coilCnt; c++)
+    for (IndType i = 0; i < coordCnt; i++)
+      if (!mask[i])
+        data[i + c * coordCnt] = DType2();
+  for (IndType c = 0; c < coilCnt; c++)
+    for (IndType j = 0; j < subsetCnt; j++)
+      subsetData[j + c * subsetCnt] =
+          data[indices.data[j] + c * coordCnt];
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+  gpuNUFFT::Array<DType2> subsetArray;
+  subsetArray.data = &subsetData[0];
+  subsetArray.dim.length = subsetCnt;
+  subsetArray.dim.channels = coilCnt;
+
+  // adjoint
+  gpuNUFFT::Array<CufftType> refImg = gpuNUFFTOp->performGpuNUFFTAdj(dataArray);
+  for (int rep = 0; rep < 2; rep++)
+  {
+    gpuNUFFT::Array<CufftType> img =
+        gpuNUFFTOp->performGpuNUFFTAdj(subsetArray, indices);
+    EXPECT_EQ(refImg.count(), img.count());
+    EXPECT_LT(relativeError(img.data, refImg.data, img.count()), 1e-5);
+    free(img.data);
+  }
+
+  // forward
+  std::vector<DType2> image(refImg.data, refImg.data + imgCnt);
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &image[0];
+  imgArray.dim = imgDims;
+  gpuNUFFT::Array<CufftType> refData =
+      gpuNUFFTOp->performForwardGpuNUFFT(imgArray);
+  std::vector<CufftType> refSubset(subsetCnt * coilCnt);
+  for (IndType c = 0; c < coilCnt; c++)
+    for (IndType j = 0; j < subsetCnt; j++)
+      refSubset[j + c * subsetCnt] =
+          refData.data[indices.data[j] + c * coordCnt];
+  gpuNUFFT::Array<CufftType> subsetOut =
+      gpuNUFFTOp->performForwardGpuNUFFT(imgArray, indices);
+  EXPECT_EQ(subsetCnt * coilCnt, subsetOut.count());
+  EXPECT_LT(relativeError(subsetOut.data, &refSubset[0], subsetOut.count()),
+            1e-5);
+
+  // the full trajectory operations are not affected by the subset buffers
+  gpuNUFFT::Array<CufftType> fullImg =
+      gpuNUFFTOp->performGpuNUFFTAdj(dataArray);
+  EXPECT_LT(relativeError(fullImg.data, refImg.data, refImg.count()), 1e-6);
+
+  // indices not ascending
+  std::swap(indices.data[0], indices.data[1]);
+  EXPECT_THROW(gpuNUFFTOp->performForwardGpuNUFFT(imgArray, subsetOut, indices),
+               std::invalid_argument);
+
+  free(fullImg.data);
+  free(subsetOut.data);
+  free(refData.data);
+  free(refImg.data);
+  free(indices.data);
+  delete gpuNUFFTOp;
+}
+
+TEST(HostOperatorTest, TestSampleSubset)
+{
+  testSampleSubset(2);
+  testSampleSubset(3);
+}
+
+// compares the derivatives of the forward operation with respect to the
+// trajectory with the derivatives of the exact NUDFT
+static void testForwardGradient(int dimCount, bool linearInterpolation)
+{
+  IndType imageWidth = 16;
+  IndType coordCnt = 300;
+  IndType coilCnt = 2;
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, dimCount);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  gpuNUFFT::Dimensions imgDims(imageWidth, imageWidth);
+  if (dimCount == 3)
+    imgDims.depth = imageWidth / 2;
+  IndType imgCnt = imgDims.count();
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  factory.setUseLinearKernelInterpolation(linearInterpolation);
+  gpuNUFFT::HostGpuNUFFTOperator *gpuNUFFTOp =
+      static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(
+          factory.createGpuNUFFTOperator(kSpaceTraj, 6, 8, 2.0, imgDims));
+  gpuNUFFTOp->setCoilBatchSize(2);
+
+  std::vector<DType2> img = createTestData(imgCnt * coilCnt);
+  gpuNUFFT::Array<DType2> imgArray;
+  imgArray.data = &img[0];
+  imgArray.dim = imgDims;
+  imgArray.dim.channels = coilCnt;
+
+  // d/dk of exp(-2 pi i k (x - n/2)) is -2 pi i (x - n/2) exp(...)
+  IndType n[3] = { imgDims.width, imgDims.height,
+                   dimCount == 3 ? imgDims.depth : 1 };
+  std::vector<CufftType> gradientRef(dimCount * coordCnt * coilCnt);
+  double scale = 1.0 / std::sqrt((double)imgCnt);
+  for (IndType c = 0; c < coilCnt; c++)
+    for (IndType j = 0; j < coordCnt; j++)
+      for (IndType i = 0; i < imgCnt; i++)
+      {
+        double pos[3] = { (double)(i % n[0]) - n[0] / 2,
+                          (double)(i / n[0] % n[1]) - n[1] / 2,
+                          (double)(i / (n[0] * n[1])) - n[2] / 2 };
+        double phase = 0.0;
+        for (int d = 0; d < dimCount; d++)
+          phase += 2.0 * M_PI * coords[j + d * coordCnt] * pos[d];
+        double re = std::cos(phase) * scale;
+        double im = std::sin(phase) * scale;
+        DType2 v = img[i + c * imgCnt];
+        for (int d = 0; d < dimCount; d++)
+        {
+          CufftType &g = gradientRef[j + (c + d * coilCnt) * coordCnt];
+          g.x += 2.0 * M_PI * pos[d] * (v.y * re - v.x * im);
+          g.y -= 2.0 * M_PI * pos[d] * (v.x * re + v.y * im);
+        }
+      }
+
+  gpuNUFFT::Array<CufftType> refData =
+      gpuNUFFTOp->performForwardGpuNUFFT(imgArray);
+  std::vector<CufftType> data(coordCnt * coilCnt);
+  gpuNUFFT::Array<CufftType> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+  std::vector<CufftType> gradient(dimCount * coordCnt * coilCnt);
+  gpuNUFFT::Array<CufftType> gradientArray;
+  gradientArray.data = &gradient[0];
+  gradientArray.dim = dataArray.dim;
+  gradientArray.dim.frames = dimCount;
+
+  for (int rep = 0; rep < 2; rep++)
+  {
+    gpuNUFFTOp->performForwardGpuNUFFTGradient(imgArray, dataArray,
+                                               gradientArray);
+    EXPECT_LT(relativeError(&data[0], refData.data, data.size()), 1e-6);
+    EXPECT_LT(relativeError(&gradient[0], &gradientRef[0], gradient.size()),
+              5e-3);
+  }
+
+  // the gradient covers every dimension
+  gradientArray.dim.frames = dimCount - 1;
+  EXPECT_THROW(gpuNUFFTOp->performForwardGpuNUFFTGradient(
+                   imgArray, dataArray, gradientArray),
+               std::invalid_argument);
+
+  free(refData.data);
+  delete gpuNUFFTOp;
+}
+
+TEST(HostOperatorTest, TestForwardGradient)
+{
+  testForwardGradient(2, false);
+  testForwardGradient(2, true);
+  testForwardGradient(3, true);
+}
+
+#ifdef GPUNUFFT_HOST_ONLY
+// gather adjoint convolution matches the scatter and is bit identical for any
+// thread count
+static void testGatherConvolution(int dimCount, bool linear)
+{
+  IndType coordCnt = 400;
+  IndType coilCnt = 3;
+  // 3 tiles per dimension, the kernel radius reaches the neighbor tiles and
+  // wraps around the grid
+  gpuNUFFT::Dimensions imgDims(8, 8);
+  if (dimCount == 3)
+    imgDims.depth = 8;
+  std::vector<DType> coords = createTestTrajectory(coordCnt, dimCount);
+  std::vector<DType> dens(coordCnt);
+  for (unsigned i = 0; i < coordCnt; i++)
+    dens[i] = (DType)(0.5 + i % 3);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+  gpuNUFFT::Array<DType> densArray;
+  densArray.data = &dens[0];
+  densArray.dim.length = coordCnt;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *hostOp =
+      static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(
+          factory.createGpuNUFFTOperator(kSpaceTraj, densArray, 5, 4,
+                                         (DType)1.5, imgDims));
+  hostOp->setLinearKernelInterpolation(linear);
+  hostOp->setCoilBatchSize(2);
+  EXPECT_FALSE(hostOp->getGatherConvolution());
+
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+
+  IndType gridCount = hostOp->getGridDims().count() * coilCnt;
+  std::vector<CufftType> scatter(gridCount);
+  gpuNUFFT::Array<CufftType> gridArray;
+  gridArray.data = &scatter[0];
+  gridArray.dim = hostOp->getGridDims();
+  gridArray.dim.channels = coilCnt;
+  hostOp->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+
+  hostOp->setGatherConvolution(true);
+  EXPECT_TRUE(hostOp->getGatherConvolution());
+  int oldThreadCount = gpuNUFFT::getHostThreadCount();
+  std::vector<CufftType> gather[3];
+  for (int n = 0; n < 3; n++)
+  {
+    gpuNUFFT::setHostThreadCount(2 * n + 1);
+    gather[n].resize(gridCount);
+    gridArray.data = &gather[n][0];
+    hostOp->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+  }
+  gpuNUFFT::setHostThreadCount(oldThreadCount);
+
+  EXPECT_LT(relativeError(&gather[0][0], &scatter[0], gridCount), 1e-6);
+  for (int n = 1; n < 3; n++)
+    EXPECT_EQ(0, memcmp(&gather[0][0], &gather[n][0],
+                        gridCount * sizeof(CufftType)));
+
+  // the tiles of a subset replace the reused tiles of all samples
+  std::vector<IndType> subset;
+  for (IndType i = 0; i < coordCnt; i += 2)
+    subset.push_back(i);
+  gpuNUFFT::Array<IndType> subsetArray;
+  subsetArray.data = &subset[0];
+  subsetArray.dim.length = subset.size();
+  gpuNUFFT::Array<DType2> subsetData = dataArray;
+  subsetData.dim.length = subset.size();
+  gpuNUFFT::Array<CufftType> subsetImg =
+      hostOp->performGpuNUFFTAdj(subsetData, subsetArray);
+  free(subsetImg.data);
+  gridArray.data = &gather[1][0];
+  hostOp->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+  EXPECT_EQ(0, memcmp(&gather[0][0], &gather[1][0],
+                      gridCount * sizeof(CufftType)));
+
+  // the image output passes the gathered grid on
+  gpuNUFFT::Array<CufftType> img = hostOp->performGpuNUFFTAdj(dataArray);
+  hostOp->setGatherConvolution(false);
+  gpuNUFFT::Array<CufftType> imgRef = hostOp->performGpuNUFFTAdj(dataArray);
+  EXPECT_LT(relativeError(img.data, imgRef.data, img.count()), 1e-6);
+
+  free(img.data);
+  free(imgRef.data);
+  delete hostOp;
+}
+
+TEST(HostOperatorTest, TestGatherConvolution)
+{
+  testGatherConvolution(2, false);
+  testGatherConvolution(2, true);
+  testGatherConvolution(3, false);
+  testGatherConvolution(3, true);
+}
+
+// sharded adjoint convolution started by the first range of a loop
+class ShardedAdjointTask : public gpuNUFFT::HostParallelTask
+{
+ public:
+  ShardedAdjointTask(gpuNUFFT::HostGpuNUFFTOperator *op,
+                     gpuNUFFT::Array<DType2> dataArray,
+                     gpuNUFFT::Array<CufftType> gridArray)
+    : op(op), dataArray(dataArray), gridArray(gridArray), inside(false)
+  {
+  }
+
+  void run(IndType begin, IndType end, int threadId)
+  {
+    if (begin != 0)
+      return;
+    inside = gpuNUFFT::isInsideHostParallelFor();
+    op->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+  }
+
+  gpuNUFFT::HostGpuNUFFTOperator *op;
+  gpuNUFFT::Array<DType2> dataArray;
+  gpuNUFFT::Array<CufftType> gridArray;
+  bool inside;
+};
+
+// sharded adjoint convolution over processes matches the single process
+// convolution and is reproducible for a fixed amount of processes
+TEST(HostOperatorTest, TestShardedConvolution)
+{
+  IndType coordCnt = 600;
+  IndType coilCnt = 3;
+  gpuNUFFT::Dimensions imgDims(8, 8, 8);
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 3);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  gpuNUFFT::GpuNUFFTOperatorFactory factory(false, false, false);
+  factory.setUseHostBackend(true);
+  gpuNUFFT::HostGpuNUFFTOperator *hostOp =
+      static_cast<gpuNUFFT::HostGpuNUFFTOperator *>(
+          factory.createGpuNUFFTOperator(kSpaceTraj, 5, 4, (DType)1.5,
+                                         imgDims));
+  hostOp->setCoilBatchSize(2);
+  EXPECT_EQ(1, hostOp->getShardProcessCount());
+  EXPECT_THROW(hostOp->setShardProcessCount(0), std::invalid_argument);
+  EXPECT_THROW(hostOp->setShardProcessCount(HOST_SHARD_MAX_PROCESSES + 1),
+               std::invalid_argument);
+
+  std::vector<DType2> data = createTestData(coordCnt * coilCnt);
+  gpuNUFFT::Array<DType2> dataArray;
+  dataArray.data = &data[0];
+  dataArray.dim.length = coordCnt;
+  dataArray.dim.channels = coilCnt;
+
+  IndType gridCount = hostOp->getGridDims().count() * coilCnt;
+  std::vector<CufftType> reference(gridCount);
+  gpuNUFFT::Array<CufftType> gridArray;
+  gridArray.data = &reference[0];
+  gridArray.dim = hostOp->getGridDims();
+  gridArray.dim.channels = coilCnt;
+  hostOp->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+  gpuNUFFT::Array<CufftType> imgRef = hostOp->performGpuNUFFTAdj(dataArray);
+
+  // more processes than sectors holding samples leave shards empty
+  int processCounts[4] = { 2, 3, 5, 64 };
+  std::vector<CufftType> sharded(gridCount), repeated(gridCount);
+  for (int n = 0; n < 4; n++)
+  {
+    hostOp->setShardProcessCount(processCounts[n]);
+    EXPECT_EQ(processCounts[n], hostOp->getShardProcessCount());
+    gridArray.data = &sharded[0];
+    hostOp->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+    EXPECT_LT(relativeError(&sharded[0], &reference[0], gridCount), 1e-5);
+
+    gridArray.data = &repeated[0];
+    hostOp->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+    EXPECT_EQ(0, memcmp(&sharded[0], &repeated[0],
+                        gridCount * sizeof(CufftType)));
+  }
+
+  // within a loop of the executor the shards are gridded in process with the
+  // same summation order
+  int oldThreadCount = gpuNUFFT::getHostThreadCount();
+  gpuNUFFT::setHostThreadCount(2);
+  EXPECT_FALSE(gpuNUFFT::isInsideHostParallelFor());
+  gridArray.data = &repeated[0];
+  ShardedAdjointTask nested(hostOp, dataArray, gridArray);
+  gpuNUFFT::hostParallelFor(2, nested, 2);
+  gpuNUFFT::setHostThreadCount(oldThreadCount);
+  EXPECT_TRUE(nested.inside);
+  EXPECT_EQ(0,
+            memcmp(&sharded[0], &repeated[0], gridCount * sizeof(CufftType)));
+
+  // the shards use the gather convolution and pass the grid on to the FFT
+  hostOp->setShardProcessCount(3);
+  hostOp->setGatherConvolution(true);
+  gridArray.data = &sharded[0];
+  hostOp->performGpuNUFFTAdj(dataArray, gridArray, gpuNUFFT::CONVOLUTION);
+  EXPECT_LT(relativeError(&sharded[0], &reference[0], gridCount), 1e-5);
+  gpuNUFFT::Array<CufftType> img = hostOp->performGpuNUFFTAdj(dataArray);
+  EXPECT_LT(relativeError(img.data, imgRef.data, img.count()), 1e-5);
+
+  free(img.data);
+  free(imgRef.data);
+  delete hostOp;
+}
+
+TEST(HostOperatorTest, TestHostOnlyFactory)
+{
+  IndType coordCnt = 100;
+  gpuNUFFT::Dimensions imgDims(16, 16);
+
+  std::vector<DType> coords = createTestTrajectory(coordCnt, 2);
+  gpuNUFFT::Array<DType> kSpaceTraj;
+  kSpaceTraj.data = &coords[0];
+  kSpaceTraj.dim.length = coordCnt;
+
+  // default arguments select the gpu precomputation and operators
+  gpuNUFFT::GpuNUFFTOperatorFactory factory;
+  gpuNUFFT::GpuNUFFTOperator *op =
+      factory.createGpuNUFFTOperator(kSpaceTraj, 3, 8, 2.0, imgDims);
+  EXPECT_EQ(gpuNUFFT::HOST, op->getType());
+  delete op;
+
+  EXPECT_THROW(factory.setUseHostBackend(false), std::invalid_argument);
+  EXPECT_THROW(initConstSymbol("KERNEL", NULL, 0), std::runtime_error);
+}
+#endif